@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -50,7 +51,14 @@ public:
 	FlexisipAuthModuleBase(su_root_t *root, const std::string &domain, int nonceExpire, bool qopAuth);
 	~FlexisipAuthModuleBase() override = default;
 
-	NonceStore &nonceStore() {return mNonceStore;}
+	NonceStore &nonceStore() {return *mNonceStore;}
+	/**
+	 * Replace the default, process-local, nonce store. The store may be shared with other modules.
+	 */
+	void setNonceStore(const std::shared_ptr<NonceStore> &nonceStore) {
+		nonceStore->setNonceExpires(mNonceStore->getNonceExpires());
+		mNonceStore = nonceStore;
+	}
 
 protected:
 	void onCheck(AuthStatus &as, msg_auth_t *credentials, auth_challenger_t const *ach) override;
@@ -70,7 +78,7 @@ protected:
 	void notify(FlexisipAuthStatus &as);
 	void onError(FlexisipAuthStatus &as);
 
-	NonceStore mNonceStore;
+	std::shared_ptr<NonceStore> mNonceStore = std::make_shared<NonceStore>();
 	bool mQOPAuth = false;
 };
 
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <ctime>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <string>
@@ -27,15 +28,36 @@
 
 namespace flexisip {
 
+/**
+ * Nonces issued in digest challenges, with the last nonce count used by the client.
+ */
 class NonceStore {
 public:
+	/**
+	 * Called with the last nonce count of the nonce (-1 if unknown) and whether the new nonce count was accepted.
+	 */
+	using NcCheckCb = std::function<void(int previousNc, bool accepted)>;
+
+	virtual ~NonceStore() = default;
+
 	void setNonceExpires(int value) {mNonceExpires = value;}
+	int getNonceExpires() const {return mNonceExpires;}
 	int getNc(const std::string &nonce);
 	void insert(const msg_auth_t *response);
-	void insert(const std::string &nonce);
+	virtual void insert(const std::string &nonce);
 	void updateNc(const std::string &nonce, int newnc);
-	void erase(const std::string &nonce);
+	virtual void erase(const std::string &nonce);
 	void cleanExpired();
+	/**
+	 * Accept the nonce count if the nonce is known and the nonce count is greater than the last one, then store it.
+	 * The callback may be called synchronously or later, from the main loop.
+	 */
+	virtual void checkAndUpdateNc(const std::string &nonce, int newnc, NcCheckCb &&cb);
+
+protected:
+	void insert(const std::string &nonce, int nc, std::time_t expires);
+	// Insert the nonce, or replace its nonce count and expiration date if it is already known.
+	void setNc(const std::string &nonce, int nc, std::time_t expires);
 
 private:
 	struct NonceCount {
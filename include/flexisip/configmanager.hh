@@ -19,6 +19,7 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdlib>
 #include <cxxabi.h>
@@ -352,6 +353,12 @@ public:
 	void set(uint64_t val) {
 		mValue = val;
 	}
+	void add(uint64_t val) {
+		mValue += val;
+	}
+	void sub(uint64_t val) {
+		mValue -= val;
+	}
 	void operator++() {
 		++mValue;
 	}
@@ -369,7 +376,8 @@ public:
 	}
 
 private:
-	uint64_t mValue;
+	// Atomic, as some counters are shared by threads.
+	std::atomic<uint64_t> mValue;
 };
 
 struct StatPair {
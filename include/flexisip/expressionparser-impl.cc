@@ -25,6 +25,8 @@
 #include <cstring>
 #include <regex>
 #include <sstream>
+#include <unordered_set>
+#include <vector>
 
 #include "flexisip/expressionparser.hh"
 #include "flexisip/logmanager.hh"
@@ -82,30 +84,42 @@ class LogicalNot : public BooleanExpression<_valuesT> {
 	shared_ptr<Expr> mExp;
 };
 
-template <typename _valuesT>
-class EqualsOp : public BooleanExpression<_valuesT> {
-  public:
+/*
+ * Base class of the operators comparing two variables.
+ * Values are read through Variable::getView() so that no string is copied when variables provide a view on their
+ * value. The derived class provides the comparison as a static apply() method, so that it can also be computed once
+ * at parsing time when both operands are constants (see makeComparison()).
+ */
+template <typename _valuesT, typename _derivedT>
+class ComparisonOp : public BooleanExpression<_valuesT> {
+public:
 	using Var = Variable<_valuesT>;
-	EqualsOp(const shared_ptr<Var> &var1, const shared_ptr<Var> &var2) : mVar1(var1), mVar2(var2) {
+	ComparisonOp(const shared_ptr<Var> &var1, const shared_ptr<Var> &var2) : mVar1(var1), mVar2(var2) {
 	}
 	virtual bool eval(const _valuesT &args) override{
-		return mVar1->get(args) == mVar2->get(args);
+		string buffer1, buffer2;
+		return _derivedT::apply(mVar1->getView(args, buffer1), mVar2->getView(args, buffer2));
 	}
-  private:
+protected:
 	shared_ptr<Var> mVar1, mVar2;
 };
 
 template <typename _valuesT>
-class UnEqualsOp : public BooleanExpression<_valuesT> {
+class EqualsOp : public ComparisonOp<_valuesT, EqualsOp<_valuesT>> {
   public:
-	using Var = Variable<_valuesT>;
-	UnEqualsOp(const shared_ptr<Var> &var1, const shared_ptr<Var> &var2) : mVar1(var1), mVar2(var2) {
+	using ComparisonOp<_valuesT, EqualsOp<_valuesT>>::ComparisonOp;
+	static bool apply(string_view value1, string_view value2) {
+		return value1 == value2;
 	}
-	virtual bool eval(const _valuesT &args) override{
-		return mVar1->get(args) != mVar2->get(args);
+};
+
+template <typename _valuesT>
+class UnEqualsOp : public ComparisonOp<_valuesT, UnEqualsOp<_valuesT>> {
+  public:
+	using ComparisonOp<_valuesT, UnEqualsOp<_valuesT>>::ComparisonOp;
+	static bool apply(string_view value1, string_view value2) {
+		return value1 != value2;
 	}
-  private:
-	shared_ptr<Var> mVar1, mVar2;
 };
 
 /*
@@ -118,15 +132,9 @@ public:
 	NumericOp(const shared_ptr<Var> &var) : mVar(var) {
 	}
 	virtual bool eval(const _valuesT &args) override{
-		string var = mVar->get(args);
-		bool res = true;
-		for (auto it = var.begin(); it != var.end(); ++it) {
-			if (!isdigit(*it)) {
-				res = false;
-				break;
-			}
-		}
-		return res;
+		string buffer;
+		auto var = mVar->getView(args, buffer);
+		return all_of(var.begin(), var.end(), [](char c) { return isdigit(c); });
 	}
 private:
 	shared_ptr<Var> mVar;
@@ -158,10 +166,9 @@ template <typename _valuesT> class RegexpOp : public BooleanExpression<_valuesT>
 	}
 
 	virtual bool eval(const _valuesT& args) {
-		if (regex_match(mInput->get(args), mRegex)) {
-			return true;
-		}
-		return false;
+		string buffer;
+		auto input = mInput->getView(args, buffer);
+		return regex_match(input.begin(), input.end(), mRegex);
 	}
 
   private:
@@ -170,46 +177,81 @@ template <typename _valuesT> class RegexpOp : public BooleanExpression<_valuesT>
 };
 
 template <typename _valuesT>
-class ContainsOp : public BooleanExpression<_valuesT> {
+class ContainsOp : public ComparisonOp<_valuesT, ContainsOp<_valuesT>> {
 public:
-	using Var = Variable<_valuesT>;
-	ContainsOp(const shared_ptr<Var> &var1, const shared_ptr<Var> &var2) : mVar1(var1), mVar2(var2) {
-	}
-	virtual bool eval(const _valuesT &args) override{
-		string var1 = mVar1->get(args);
-		string var2 = mVar2->get(args);
-		return var1.find(var2) != string::npos;
+	using ComparisonOp<_valuesT, ContainsOp<_valuesT>>::ComparisonOp;
+	static bool apply(string_view value1, string_view value2) {
+		return value1.find(value2) != string_view::npos;
 	}
-private:
-	shared_ptr<Var> mVar1, mVar2;
 };
 
 /*
  * Evaluates whether a variable has its value equal to an element of a list of other variables.
  */
 template <typename _valuesT>
-class InOp : public BooleanExpression<_valuesT> {
+class InOp : public ComparisonOp<_valuesT, InOp<_valuesT>> {
 public:
 	using Var = Variable<_valuesT>;
-	InOp(const shared_ptr<Var> &var1, const shared_ptr<Var> &var2) : mVar1(var1), mVar2(var2) {
+	using ComparisonOp<_valuesT, InOp<_valuesT>>::ComparisonOp;
+	virtual bool eval(const _valuesT &args) override{
+		string buffer;
+		auto varValue = this->mVar1->getView(args, buffer);
+		for (const auto &value : this->mVar2->getAsList(args)) {
+			if (varValue == value) return true;
+		}
+		return false;
 	}
-	virtual bool eval(const _valuesT &args) {
-		bool res = false;
-		list<string> values = mVar2->getAsList(args);
-		string varValue = mVar1->get(args);
-
-		for (auto it = values.begin(); it != values.end(); ++it) {
-			if (varValue == *it) {
-				res = true;
-				break;
-			}
+	static bool apply(string_view value, string_view list) {
+		for (const auto &item : Var::split(string(list))) {
+			if (value == item) return true;
 		}
-		return res;
+		return false;
+	}
+};
+
+/*
+ * InOp whose list is a constant: the list is split once and for all, and looked up in a hash set.
+ */
+template <typename _valuesT>
+class InConstantListOp : public BooleanExpression<_valuesT> {
+public:
+	using Var = Variable<_valuesT>;
+	InConstantListOp(const shared_ptr<Var> &var, const shared_ptr<Constant<_valuesT>> &list)
+	    : mVar(var), mValues(toVector(Var::split(list->get()))) {
+		for (const auto &value : mValues) mIndex.emplace(value);
+	}
+	InConstantListOp(const InConstantListOp &) = delete; // mIndex holds views on mValues
+	virtual bool eval(const _valuesT &args) override{
+		string buffer;
+		return mIndex.count(mVar->getView(args, buffer)) != 0;
 	}
 private:
-	shared_ptr<Var> mVar1, mVar2;
+	static vector<string> toVector(list<string> &&values) {
+		return vector<string>(make_move_iterator(values.begin()), make_move_iterator(values.end()));
+	}
+
+	shared_ptr<Var> mVar;
+	const vector<string> mValues;
+	unordered_set<string_view> mIndex;
 };
 
+/*
+ * Builds the comparison of two variables, which is evaluated at once if both of them are constants.
+ */
+template <typename _valuesT, template <typename> class _opT>
+shared_ptr<BooleanExpression<_valuesT>> makeComparison(const shared_ptr<Variable<_valuesT>> &var1,
+                                                       const shared_ptr<Variable<_valuesT>> &var2) {
+	auto const1 = dynamic_pointer_cast<Constant<_valuesT>>(var1);
+	auto const2 = dynamic_pointer_cast<Constant<_valuesT>>(var2);
+	if (const1 && const2) {
+		return make_shared<ConstantBooleanExpression<_valuesT>>(_opT<_valuesT>::apply(const1->get(), const2->get()));
+	}
+	if constexpr (is_same_v<_opT<_valuesT>, InOp<_valuesT>>) {
+		if (const2) return make_shared<InConstantListOp<_valuesT>>(var1, const2);
+	}
+	return make_shared<_opT<_valuesT>>(var1, var2);
+}
+
 template< typename _valuesT>
 size_t BooleanExpressionBuilder<_valuesT>::findFirstNonWord(const string &expr, size_t offset) {
 	size_t i;
@@ -260,9 +302,12 @@ std::shared_ptr<ExpressionElement> BooleanExpressionBuilder<_valuesT>::buildElem
 		size_t len = eow - *newpos;
 		auto word = expr.substr(*newpos, len);
 		*newpos += len;
+		auto viewIt = mRules.views.find(word);
 		auto varIt = mRules.variables.find(word);
 		auto opIt = mRules.operators.find(word);
-		if (varIt != mRules.variables.end()){
+		if (viewIt != mRules.views.end()){
+			return make_shared<ViewVariable<_valuesT>>((*viewIt).second);
+		}else if (varIt != mRules.variables.end()){
 			return make_shared<Variable<_valuesT>>((*varIt).second);
 		}else if (opIt != mRules.operators.end()){
 			return make_shared<NamedOperator<_valuesT>>((*opIt).second);
@@ -310,7 +355,8 @@ bool BooleanExpressionBuilder<_valuesT>::isKeyword(const string &expr, size_t *n
 template< typename _valuesT>
 void BooleanExpressionBuilder<_valuesT>::checkRulesOverlap(){
 	for(const string & builtin :  sBuiltinOperators){
-		if (mRules.variables.find(builtin) != mRules.variables.end()){
+		if (mRules.variables.find(builtin) != mRules.variables.end() ||
+		    mRules.views.find(builtin) != mRules.views.end()){
 			LOGF("BooleanExpressionBuilder: variable name '%s' conflicts with builtin operator name.", builtin.c_str());
 		}
 		if (mRules.operators.find(builtin) != mRules.operators.end()){
@@ -318,10 +364,16 @@ void BooleanExpressionBuilder<_valuesT>::checkRulesOverlap(){
 		}
 	}
 	for (auto p : mRules.operators){
-		if (mRules.variables.find(p.first) != mRules.variables.end()){
+		if (mRules.variables.find(p.first) != mRules.variables.end() ||
+		    mRules.views.find(p.first) != mRules.views.end()){
 			LOGF("BooleanExpressionBuilder: variable name '%s' conflicts with operator name.", p.first.c_str());
 		}
 	}
+	for (const auto &p : mRules.views){
+		if (mRules.variables.find(p.first) != mRules.variables.end()){
+			LOGF("BooleanExpressionBuilder: variable name '%s' is declared twice.", p.first.c_str());
+		}
+	}
 }
 
 template< typename _valuesT>
@@ -392,7 +444,7 @@ shared_ptr<BooleanExpression<_valuesT>> BooleanExpressionBuilder<_valuesT>::pars
 						throw invalid_argument("!= operator expects first variable or const operand.");
 					}
 					i += 2;
-					cur_exp = make_shared<UnEqualsOp<_valuesT>>(cur_var, buildVariable(expr.substr(i), &j));
+					cur_exp = makeComparison<_valuesT, UnEqualsOp>(cur_var, buildVariable(expr.substr(i), &j));
 				} else {
 					if (cur_exp) {
 						throw invalid_argument("Parsing error around '!'");
@@ -408,7 +460,7 @@ shared_ptr<BooleanExpression<_valuesT>> BooleanExpressionBuilder<_valuesT>::pars
 						throw invalid_argument("== operator expects first variable or const operand.");
 					}
 					i += 2;
-					cur_exp = make_shared<EqualsOp<_valuesT>>(cur_var, buildVariable(expr.substr(i), &j));
+					cur_exp = makeComparison<_valuesT, EqualsOp>(cur_var, buildVariable(expr.substr(i), &j));
 					i += j;
 				} else {
 					throw invalid_argument("Bad operator =");
@@ -423,7 +475,7 @@ shared_ptr<BooleanExpression<_valuesT>> BooleanExpressionBuilder<_valuesT>::pars
 					j = 0;
 					if (cur_var == nullptr) throw invalid_argument("'contains' operator has no left-hand operand.");
 					auto rightVar = buildVariable(expr.substr(i), &j);
-					cur_exp = make_shared<ContainsOp<_valuesT>>(cur_var, rightVar);
+					cur_exp = makeComparison<_valuesT, ContainsOp>(cur_var, rightVar);
 					i += j;
 				}
 				break;
@@ -450,7 +502,7 @@ shared_ptr<BooleanExpression<_valuesT>> BooleanExpressionBuilder<_valuesT>::pars
 					i += j;
 					j = 0;
 					auto rightVar = buildVariable(expr.substr(i), &j);
-					cur_exp = make_shared<InOp<_valuesT>>(cur_var, rightVar);
+					cur_exp = makeComparison<_valuesT, InOp>(cur_var, rightVar);
 					i += j;
 				}
 				break;
@@ -469,7 +521,7 @@ shared_ptr<BooleanExpression<_valuesT>> BooleanExpressionBuilder<_valuesT>::pars
 					i += j;
 					j = 0;
 					auto rightVar = buildVariable(expr.substr(i), &j);
-					auto in = make_shared<InOp<_valuesT>>(cur_var, rightVar);
+					auto in = makeComparison<_valuesT, InOp>(cur_var, rightVar);
 					cur_exp = make_shared<LogicalNot<_valuesT>>(in);
 					i += j;
 				}
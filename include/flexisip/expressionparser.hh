@@ -20,6 +20,7 @@
 
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <map>
 #include <list>
@@ -46,14 +47,28 @@ public:
 	virtual std::string get(const _valuesT &args){
 		return mFunc(args);
 	}
+	/*
+	 * Same as get(), without copy when the variable can provide a view on its value.
+	 * Otherwise, the value is stored in the supplied buffer, which must outlive the returned view.
+	 */
+	virtual std::string_view getView(const _valuesT &args, std::string &buffer){
+		buffer = get(args);
+		return buffer;
+	}
 	virtual bool defined(const _valuesT &args){
-		if (get(args).empty()) return false;
+		std::string buffer;
+		if (getView(args, buffer).empty()) return false;
 		return true;
 	}
 	virtual std::list<std::string> getAsList(const _valuesT &args) {
+		return split(get(args));
+	}
+	/*
+	 * Split a list of space-separated values.
+	 */
+	static std::list<std::string> split(const std::string &s) {
 		std::list<std::string> valueList;
-		std::string s = get(args);
-		
+
 		size_t pos1 = 0;
 		size_t pos2 = 0;
 		for (pos2 = 0; pos2 < s.size(); ++pos2) {
@@ -81,6 +96,29 @@ protected:
 	Variable() = default;
 };
 
+/*
+ * A Variable whose value is read in place, e.g. from a field of the _valuesT argument, avoiding a copy on each
+ * evaluation. The returned view must remain valid as long as the _valuesT argument does.
+ */
+template <typename _valuesT>
+class ViewVariable : public Variable<_valuesT>{
+public:
+	ViewVariable(const std::function< std::string_view (const _valuesT &)> &func)
+		: Variable<_valuesT>(), mViewFunc(func){
+	}
+	std::string get(const _valuesT &args) override{
+		return std::string(mViewFunc(args));
+	}
+	std::string_view getView(const _valuesT &args, [[maybe_unused]] std::string &buffer) override{
+		return mViewFunc(args);
+	}
+	bool defined(const _valuesT &args) override{
+		return !mViewFunc(args).empty();
+	}
+private:
+	std::function< std::string_view (const _valuesT &)> mViewFunc;
+};
+
 /*
  * Constant can be seen as a special kind of variable that always evaluates to the same thing, regardless of _valuesT argument contains.
  * They are enclosed by single quotes in the boolean expression.
@@ -94,7 +132,10 @@ class Constant : public Variable<_valuesT>{
 	virtual std::string get([[maybe_unused]] const _valuesT &arg) override{
 		return mVal;
 	}
-	std::string get()const{
+	std::string_view getView([[maybe_unused]] const _valuesT &args, [[maybe_unused]] std::string &buffer) override{
+		return mVal;
+	}
+	const std::string &get()const{
 		return mVal;
 	}
 };
@@ -144,6 +185,8 @@ struct ExpressionRules{
 public:
 	std::map<std::string, std::function< std::string (const _valuesT &)>> variables; // the map of variables with their function to evaluate
 	std::map<std::string, std::function< bool (const _valuesT &)>> operators; // the named operators, with their function to evaluate.
+	// the map of variables whose value is read without copy, see ViewVariable.
+	std::map<std::string, std::function< std::string_view (const _valuesT &)>> views{};
 };
 
 /*
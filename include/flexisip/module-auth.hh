@@ -26,6 +26,7 @@ namespace flexisip {
 
 class Agent;
 class AuthDb;
+class NonceStore;
 
 class Authentication : public ModuleAuthenticationBase {
 	friend std::shared_ptr<Module> ModuleInfo<Authentication>::create(Agent*);
@@ -65,6 +66,8 @@ private:
 	bool mRejectWrongClientCertificates = false;
 	bool mTrustDomainCertificates = false;
 	AuthDb& mAuthDb;
+	// Nonce store shared by the modules of all the domains, when nonces are shared with other proxies through Redis.
+	std::shared_ptr<NonceStore> mRedisNonceStore;
 };
 
 } // namespace flexisip
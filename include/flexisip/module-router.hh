@@ -38,6 +38,7 @@ struct RouterStats {
 };
 
 class OnContactRegisteredListener;
+class ForkMessageContextDb;
 class Injector;
 class Agent;
 class Record;
@@ -54,7 +55,7 @@ public:
 
 	void onLoad(const GenericStruct* mc) override;
 
-	void onUnload() override{};
+	void onUnload() override;
 
 	void onRequest(std::shared_ptr<RequestSipEvent>& ev) override;
 
@@ -161,7 +162,12 @@ protected:
 
 private:
 #if ENABLE_SOCI
-	void restoreForksFromDatabase();
+	/**
+	 * Load, in a DB thread, the page of fork messages that follows afterUuid, and restore it in the main loop.
+	 * Restoration goes on page by page, so the proxy serves traffic while previous messages are being restored.
+	 */
+	void restoreForksFromDatabase(const std::string& afterUuid = "");
+	void onForkPageRestored(std::vector<ForkMessageContextDb>& page);
 #endif
 
 	static ModuleInfo<ModuleRouter> sInfo;
@@ -170,6 +176,13 @@ private:
 	std::shared_ptr<OnContactRegisteredListener> mOnContactRegisteredListener{nullptr};
 	std::unique_ptr<Injector> mInjector;
 	std::vector<SipUri> mStaticTargets;
+#if ENABLE_SOCI
+	unsigned int mRestorePageSize{1};
+	unsigned int mDbThreadNumber{1};
+	size_t mRestoredForkCount{0};
+	// Last message to restore, see ForkMessageContextSociRepository::findForkMessagePage().
+	std::string mRestoreLastUuid{};
+#endif
 };
 
 class OnContactRegisteredListener : public ContactRegisteredListener,
@@ -43,14 +43,21 @@ void Agent::startLogWriter() {
 		if (cr->get<ConfigString>("logger")->read() == "database") {
 #if ENABLE_SOCI
 
-			DataBaseEventLogWriter* dbw =
-			    new DataBaseEventLogWriter(cr->get<ConfigString>("database-backend")->read(),
-			                               cr->get<ConfigString>("database-connection-string")->read(),
-			                               cr->get<ConfigInt>("database-max-queue-size")->read(),
-			                               cr->get<ConfigInt>("database-nb-threads-max")->read());
+			DataBaseEventLogWriter* dbw = new DataBaseEventLogWriter(
+			    cr->get<ConfigString>("database-backend")->read(),
+			    cr->get<ConfigString>("database-connection-string")->read(),
+			    cr->get<ConfigInt>("database-max-queue-size")->read(),
+			    cr->get<ConfigInt>("database-nb-threads-max")->read());
+			if (const auto batchSize = cr->get<ConfigInt>("database-batch-size")->read(); batchSize > 1) {
+				dbw->enableBatching(mRoot, batchSize,
+				                    cr->get<ConfigDuration<chrono::milliseconds>>("database-batch-max-delay")->read());
+			}
 			if (!dbw->isReady()) {
 				LOGF("DataBaseEventLogWriter: unable to use database.");
 			} else {
+				dbw->setStatCounters(cr->getStat("count-database-events-queued"),
+				                     cr->getStat("count-database-events-flushed"),
+				                     cr->getStat("count-database-events-dropped"));
 				mLogWriter.reset(dbw);
 			}
 #else
@@ -62,7 +69,14 @@ void Agent::startLogWriter() {
 			auto port = cr->get<ConfigInt>("flexiapi-port")->read();
 			const auto& prefix = cr->get<ConfigString>("flexiapi-prefix")->read();
 			const auto& apiKey = cr->get<ConfigString>("flexiapi-api-key")->read();
-			mLogWriter = make_unique<FlexiStatsEventLogWriter>(*mRoot, host, to_string(port), prefix, apiKey);
+			auto flexiStatsWriter =
+			    make_unique<FlexiStatsEventLogWriter>(*mRoot, host, to_string(port), prefix, apiKey);
+			const auto batchWindow = cr->get<ConfigDuration<chrono::milliseconds>>("flexiapi-batch-window")->read();
+			if (batchWindow.count() > 0) {
+				flexiStatsWriter->enableBatching(mRoot, batchWindow,
+				                                 cr->get<ConfigInt>("flexiapi-batch-max-pending-requests")->read());
+			}
+			mLogWriter = std::move(flexiStatsWriter);
 #else
 			LOGF("This version of Flexisip was built without ENABLE_FLEXIAPI. Value 'flexiapi' for 'event-logs/logger' "
 			     "is unsupported.");
@@ -70,6 +84,12 @@ void Agent::startLogWriter() {
 		} else {
 			const auto& logdir = cr->get<ConfigString>("filesystem-directory")->read();
 			unique_ptr<FilesystemEventLogWriter> lw(new FilesystemEventLogWriter(logdir));
+			if (cr->get<ConfigBoolean>("filesystem-background-writer")->read()) {
+				lw->enableBackgroundWriter(
+				    cr->get<ConfigInt>("filesystem-max-open-files")->read(),
+				    cr->get<ConfigDuration<chrono::milliseconds>>("filesystem-flush-interval")->read(),
+				    cr->get<ConfigDuration<chrono::milliseconds>>("filesystem-fsync-interval")->read());
+			}
 			if (lw->isReady()) mLogWriter = std::move(lw);
 		}
 	}
@@ -0,0 +1,37 @@
+/** Copyright (C) 2010-2024 Belledonne Communications SARL
+    SPDX-License-Identifier: AGPL-3.0-or-later
+
+	You can set your editor to Lua for this file to get syntax highlighting.
+
+	Brief:
+		Redis script to check and update the nonce count of a digest
+		authentication nonce shared by several proxies.
+
+	KEYS:
+		1: Nonce. Last nonce count used with the nonce, expiring with the
+		   nonce. [string]
+	ARGV:
+		1: New nonce count. [integer]
+
+	Implementation:
+		The nonce count is only updated if it increases, keeping the time to
+		live of the nonce. Returns {-1, 0} if the nonce is unknown (never issued
+		or expired), otherwise {previous nonce count, remaining time to live
+		in milliseconds}. The new nonce count is accepted if the previous one
+		is lower.
+*/
+
+R"lua(
+local nc = redis.call("GET", KEYS[1])
+if not nc then return {-1, 0} end
+nc = tonumber(nc)
+local ttl = redis.call("PTTL", KEYS[1])
+if nc < tonumber(ARGV[1]) then
+	if 0 < ttl then
+		redis.call("SET", KEYS[1], ARGV[1], "PX", ttl)
+	else
+		redis.call("SET", KEYS[1], ARGV[1])
+	end
+end
+return {nc, ttl}
+)lua"
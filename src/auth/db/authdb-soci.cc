@@ -145,6 +145,27 @@ void SociAuthDB::declareConfig(GenericStruct* mc) {
 	     "On the other hand, you should not keep too many open connections to your DB at the same time.",
 	     "100"},
 
+	    {String, "soci-password-batch-request",
+	     "Soci SQL request used to obtain the passwords of several users at once. When set, password requests that "
+	     "are not in the cache are gathered for 'soci-password-batch-delay' and resolved by a single request instead "
+	     "of one 'soci-password-request' each.\n"
+	     "The string MUST contain the ':ids' keyword which will be replaced by the list of users to look for, as "
+	     "bound parameters separated by a comma character (e.g. :id0,:id1).\n"
+	     "The request MUST return a table of three or four columns: the user, its domain, the password and "
+	     "optionally the algorithm (MD5 if absent). The authorization username is not used to match the results.\n"
+	     "Example: select login, domain, password, algorithm from accounts where login in (:ids)",
+	     ""},
+
+	    {DurationMS, "soci-password-batch-delay",
+	     "Time during which password requests are gathered before sending them to the database. Only used if "
+	     "'soci-password-batch-request' is set.",
+	     "5"},
+
+	    {Integer, "soci-password-batch-max-size",
+	     "Maximum number of password requests in a batch. A batch is sent as soon as it reaches this size. Only used "
+	     "if 'soci-password-batch-request' is set.",
+	     "100"},
+
 	    // Deprecated
 	    {String, "soci-user-with-phone-request",
 	     "WARNING: This parameter is used by the presence server only.\n"
@@ -187,7 +208,7 @@ void SociAuthDB::declareConfig(GenericStruct* mc) {
 #endif
 }
 
-SociAuthDB::SociAuthDB(const GenericStruct& cr) : AuthDbBackend(cr) {
+SociAuthDB::SociAuthDB(const GenericStruct& cr, const std::shared_ptr<sofiasip::SuRoot>& root) : AuthDbBackend(cr) {
 	auto* ma = cr.get<GenericStruct>("module::Authentication");
 	auto* ps = cr.get<GenericStruct>("presence-server");
 
@@ -199,6 +220,17 @@ SociAuthDB::SociAuthDB(const GenericStruct& cr) : AuthDbBackend(cr) {
 
 	auto max_queue_size = (unsigned int)ma->get<ConfigInt>("soci-max-queue-size")->read();
 
+	mGetPasswordsRequest = ma->get<ConfigString>("soci-password-batch-request")->read();
+	mPasswordBatchDelay = ma->get<ConfigDuration<chrono::milliseconds>>("soci-password-batch-delay")->read();
+	mPasswordBatchMaxSize = max(ma->get<ConfigInt>("soci-password-batch-max-size")->read(), 1);
+	if (!mGetPasswordsRequest.empty() && mGetPasswordsRequest.find(":ids") == string::npos) {
+		LOGF("[SOCI] 'soci-password-batch-request' must contain the ':ids' keyword");
+	}
+	if (!mGetPasswordsRequest.empty()) {
+		if (!root) LOGF("[SOCI] 'soci-password-batch-request' is not available without a main loop");
+		mPasswordBatchTimer = make_unique<sofiasip::Timer>(root, mPasswordBatchDelay);
+	}
+
 	get_user_with_phone_request = ps->get<ConfigString>("soci-user-with-phone-request")->read();
 	get_users_with_phones_request = ps->get<ConfigString>("soci-users-with-phones-request")->read();
 
@@ -241,11 +273,39 @@ void SociAuthDB::closeOpenedSessions() {
 	_connected = false;
 }
 
-void SociAuthDB::getPasswordWithPool(const string& id,
-                                     const string& domain,
-                                     const string& authid,
-                                     AuthDbListener* listener) {
-	vector<passwd_algo_t> passwd{};
+bool SociAuthDB::addPassword(
+    PwList& passwd, const string& password, const string& algo, const string& unescapedId, const string& domain) {
+	if (algo == "CLRTXT") {
+		auto input = unescapedId + ":" + domain + ":" + password;
+		passwd.clear();
+		passwd.emplace_back(password, algo);
+		passwd.emplace_back(Md5{}.compute<string>(input), "MD5");
+		passwd.emplace_back(Sha256{}.compute<string>(input), "SHA-256");
+		return true;
+	}
+	passwd.emplace_back(StringUtils::toLower(password), algo);
+	return false;
+}
+
+void SociAuthDB::notifyPasswordListeners(const PasswordKey& key, AuthDbResult result, const PwList& passwd) {
+	const auto& [id, domain, authid] = key;
+	if (result == PASSWORD_FOUND) cachePassword(createPasswordKey(id, authid), domain, passwd, mCacheExpire);
+
+	vector<AuthDbListener*> listeners{};
+	{
+		const lock_guard<mutex> lock(mPendingPasswordMutex);
+		auto pending = mPendingPasswordRequests.find(key);
+		if (pending == mPendingPasswordRequests.end()) return;
+		listeners = std::move(pending->second);
+		mPendingPasswordRequests.erase(pending);
+	}
+	for (auto* listener : listeners) {
+		if (listener) listener->onResult(result, passwd);
+	}
+}
+
+void SociAuthDB::getPasswordWithPool(const string& id, const string& domain, const string& authid) {
+	PwList passwd{};
 	auto unescapedIdStr = urlUnescape(id);
 
 	SociHelper sociHelper{*conn_pool};
@@ -256,27 +316,80 @@ void SociAuthDB::getPasswordWithPool(const string& id,
 			for (const auto& r : results) {
 				/* If size == 1 then we only have the password so we assume MD5 */
 				auto algo = r.size() > 1 ? r.get<string>(1) : "MD5";
-				if (algo == "CLRTXT") {
-					const auto& password = r.get<string>(0);
-					auto input = unescapedIdStr + ":" + domain + ":" + password;
-					passwd.clear();
-					passwd.emplace_back(password, algo);
-					passwd.emplace_back(Md5{}.compute<string>(input), "MD5");
-					passwd.emplace_back(Sha256{}.compute<string>(input), "SHA-256");
-					break;
-				} else {
-					auto hash = StringUtils::toLower(r.get<string>(0));
-					passwd.emplace_back(std::move(hash), algo);
-				}
+				if (addPassword(passwd, r.get<string>(0), algo, unescapedIdStr, domain)) break;
 			}
 		});
 
-		if (!passwd.empty()) cachePassword(createPasswordKey(id, authid), domain, passwd, mCacheExpire);
-		if (listener) {
-			listener->onResult(passwd.empty() ? PASSWORD_NOT_FOUND : PASSWORD_FOUND, passwd);
+		notifyPasswordListeners({id, domain, authid}, passwd.empty() ? PASSWORD_NOT_FOUND : PASSWORD_FOUND, passwd);
+	} catch (SociHelper::DatabaseException& e) {
+		notifyPasswordListeners({id, domain, authid}, AUTH_ERROR, passwd);
+	}
+}
+
+void SociAuthDB::sendPasswordBatch() {
+	vector<PasswordKey> batch{};
+	{
+		const lock_guard<mutex> lock(mPendingPasswordMutex);
+		batch.swap(mPasswordBatch);
+	}
+	if (batch.empty()) return;
+
+	if (!thread_pool->run([this, batch] { getPasswordBatchWithPool(batch); })) {
+		// Enqueue() can fail when the queue is full, so we have to act on that
+		SLOGE << "[SOCI] Auth queue is full, cannot fullfil a batch of " << batch.size() << " password requests";
+		for (const auto& key : batch) {
+			notifyPasswordListeners(key, AUTH_ERROR, PwList());
 		}
+	}
+}
+
+void SociAuthDB::getPasswordBatchWithPool(const vector<PasswordKey>& batch) {
+	// The users are bound as parameters, they come from the requests and must never be part of the SQL text.
+	vector<string> ids{};
+	for (const auto& key : batch) {
+		auto unescapedId = urlUnescape(std::get<0>(key));
+		if (find(ids.begin(), ids.end(), unescapedId) == ids.end()) ids.push_back(std::move(unescapedId));
+	}
+	ostringstream placeholders;
+	for (size_t i = 0; i < ids.size(); ++i) {
+		placeholders << (i == 0 ? "" : ",") << ":id" << i;
+	}
+	auto request = mGetPasswordsRequest;
+	StringUtils::searchAndReplace(request, ":ids", placeholders.str());
+
+	// Passwords by (unescaped id, domain). A user is complete once a CLRTXT password has been found.
+	map<pair<string, string>, PwList> passwords{};
+	try {
+		SociHelper sociHelper{*conn_pool};
+		sociHelper.execute([&](session& sql) {
+			passwords.clear();
+			set<pair<string, string>> complete{};
+			auto prepared = (sql.prepare << request);
+			for (size_t i = 0; i < ids.size(); ++i) {
+				prepared, use(ids[i], "id" + to_string(i));
+			}
+			rowset<row> results{prepared};
+			for (const auto& r : results) {
+				auto user = make_pair(r.get<string>(0), r.get<string>(1));
+				if (complete.count(user) != 0) continue;
+				auto algo = r.size() > 3 ? r.get<string>(3) : "MD5";
+				auto& passwd = passwords[user];
+				if (addPassword(passwd, r.get<string>(2), algo, user.first, user.second)) complete.insert(user);
+			}
+		});
 	} catch (SociHelper::DatabaseException& e) {
-		if (listener) listener->onResult(AUTH_ERROR, passwd);
+		SLOGE << "[SOCI] MySQL request causing the error was : " << request;
+		for (const auto& key : batch) {
+			notifyPasswordListeners(key, AUTH_ERROR, {});
+		}
+		return;
+	}
+
+	SLOGD << "[SOCI] " << batch.size() << " password requests resolved by a single query";
+	for (const auto& key : batch) {
+		auto found = passwords.find({urlUnescape(std::get<0>(key)), std::get<1>(key)});
+		if (found == passwords.end() || found->second.empty()) notifyPasswordListeners(key, PASSWORD_NOT_FOUND, {});
+		else notifyPasswordListeners(key, PASSWORD_FOUND, found->second);
 	}
 }
 
@@ -406,15 +519,41 @@ void SociAuthDB::getPasswordFromBackend(const string& id,
 		return;
 	}
 
-	// create a thread to grab a pool connection and use it to retrieve the auth information
-	auto func = bind(&SociAuthDB::getPasswordWithPool, this, id, domain, authid, listener);
+	PasswordKey key{id, domain, authid};
+	const auto batching = !mGetPasswordsRequest.empty();
+	auto batchSize = size_t{0};
+	{
+		const lock_guard<mutex> lock(mPendingPasswordMutex);
+		auto& listeners = mPendingPasswordRequests[key];
+		listeners.push_back(listener);
+		if (1 < listeners.size()) {
+			SLOGD << "[SOCI] Password request for " << id << " / " << domain << " / " << authid
+			      << " joins a pending request";
+			return;
+		}
+		if (batching) {
+			mPasswordBatch.push_back(key);
+			batchSize = mPasswordBatch.size();
+		}
+	}
 
-	bool success = thread_pool->run(func);
-	if (!success) {
+	if (batching) {
+		// the first request of a batch waits for the following ones, unless the batch is already full
+		if (mPasswordBatchMaxSize <= batchSize) {
+			mPasswordBatchTimer->reset();
+			sendPasswordBatch();
+		} else if (batchSize == 1) {
+			mPasswordBatchTimer->set([this] { sendPasswordBatch(); });
+		}
+		return;
+	}
+
+	// create a thread to grab a pool connection and use it to retrieve the auth information
+	if (!thread_pool->run(bind(&SociAuthDB::getPasswordWithPool, this, id, domain, authid))) {
 		// Enqueue() can fail when the queue is full, so we have to act on that
 		SLOGE << "[SOCI] Auth queue is full, cannot fullfil password request for " << id << " / " << domain << " / "
 		      << authid;
-		if (listener) listener->onResult(AUTH_ERROR, PwList());
+		notifyPasswordListeners(key, AUTH_ERROR, PwList());
 	}
 }
 
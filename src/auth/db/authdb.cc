@@ -70,17 +70,30 @@ void AuthDb::createAuthDbBackend() {
 		mBackend = make_unique<FileAuthDb>(rootConfig);
 #if ENABLE_SOCI
 	} else if (impl == "soci") {
-		mBackend = make_unique<SociAuthDB>(rootConfig);
+		mBackend = make_unique<SociAuthDB>(rootConfig, mRoot);
 #endif
 	} else throw std::runtime_error("Cannot build Authentication Backend, unknown db-implementation: "s + impl);
 }
 
-AuthDbBackend::AuthDbBackend(const GenericStruct& root) {
+AuthDbBackend::AuthDbBackend(const GenericStruct& root, bool cacheIsStorage) {
 	GenericStruct* ma = root.get<GenericStruct>("module::Authentication");
 	list<string> domains = ma->get<ConfigStringList>("auth-domains")->read();
 	mCacheExpire =
 	    chrono::duration_cast<chrono::seconds>(ma->get<ConfigDuration<chrono::seconds>>("cache-expire")->read())
 	        .count();
+
+	mCountCacheHits = ma->getStat("count-password-cache-hits");
+	mCountCacheMisses = ma->getStat("count-password-cache-misses");
+	mCountCacheRefreshes = ma->getStat("count-password-cache-refreshes");
+	if (cacheIsStorage) {
+		mCachedPasswords = make_unique<PasswordCache>(0, chrono::seconds{0});
+	} else {
+		const auto maxSize = max(ma->get<ConfigInt>("cache-max-size")->read(), 0);
+		const auto refreshAhead = chrono::duration_cast<chrono::seconds>(
+		    ma->get<ConfigDuration<chrono::seconds>>("cache-refresh-ahead")->read());
+		mCachedPasswords =
+		    make_unique<PasswordCache>(maxSize, refreshAhead, ma->getStat("count-password-cache-evictions"));
+	}
 }
 
 AuthDbBackend::~AuthDbBackend() {
@@ -107,24 +120,21 @@ string AuthDbBackend::createPasswordKey(string_view user, string_view auth_usern
 
 AuthDbBackend::CacheResult
 AuthDbBackend::getCachedPassword(const string& key, const string& domain, vector<passwd_algo_t>& pass) {
-	time_t now = getCurrentTime();
-	auto& passwords = mCachedPasswords[domain];
-	unique_lock<mutex> lck(mCachedPasswordMutex);
-	auto it = passwords.find(key);
-	if (it != passwords.end()) {
-		pass = it->second.pass;
-		if (now < it->second.expire_date) {
+	switch (mCachedPasswords->find(key, domain, pass, getCurrentTime())) {
+		case PasswordCache::Result::VALID:
 			return VALID_PASS_FOUND;
-		} else {
-			passwords.erase(it);
+		case PasswordCache::Result::EXPIRING:
+			return EXPIRING_PASS_FOUND;
+		case PasswordCache::Result::EXPIRED:
 			return EXPIRED_PASS_FOUND;
-		}
+		case PasswordCache::Result::MISSING:
+			break;
 	}
 	return NO_PASS_FOUND;
 }
 
 void AuthDbBackend::clearCache() {
-	mCachedPasswords.clear();
+	mCachedPasswords->clear();
 }
 
 bool AuthDbBackend::cachePassword(const string& key,
@@ -132,17 +142,8 @@ bool AuthDbBackend::cachePassword(const string& key,
                                   const vector<passwd_algo_t>& pass,
                                   int expires) {
 	if (pass.empty()) throw invalid_argument("empty password list");
-	time_t now = getCurrentTime();
-	map<string, CachedPassword>& passwords = mCachedPasswords[domain];
-	unique_lock<mutex> lck(mCachedPasswordMutex);
-	map<string, CachedPassword>::iterator it = passwords.find(key);
 	if (expires == -1) expires = mCacheExpire;
-	if (it != passwords.end()) {
-		it->second.pass = pass;
-		it->second.expire_date = now + expires;
-	} else {
-		passwords.insert(make_pair(key, CachedPassword(pass, now + expires)));
-	}
+	mCachedPasswords->insert(key, domain, pass, getCurrentTime() + expires);
 	return true;
 }
 
@@ -169,14 +170,22 @@ void AuthDbBackend::getPassword(const std::string& user,
 	vector<passwd_algo_t> pass;
 	switch (getCachedPassword(key, domain, pass)) {
 		case VALID_PASS_FOUND:
+			if (mCountCacheHits) mCountCacheHits->incr();
 			if (listener) listener->onResult(AuthDbResult::PASSWORD_FOUND, pass);
 			return;
+		case EXPIRING_PASS_FOUND:
+			// The cached password is used while it is fetched again, so that a busy user never misses the cache.
+			if (mCountCacheHits) mCountCacheHits->incr();
+			if (mCountCacheRefreshes) mCountCacheRefreshes->incr();
+			if (listener) listener->onResult(AuthDbResult::PASSWORD_FOUND, pass);
+			getPasswordFromBackend(user, domain, auth_username, nullptr);
+			return;
 		case EXPIRED_PASS_FOUND:
 			// Might check here if connection is failing
 			// If it is the case use fallback password and
 			// return AuthDbResult::PASSWORD_FOUND;
-			break;
 		case NO_PASS_FOUND:
+			if (mCountCacheMisses) mCountCacheMisses->incr();
 			break;
 	}
 
@@ -254,6 +263,7 @@ void AuthDbBackend::getUserWithPhone(const string& phone, const string& domain,
 		case VALID_PASS_FOUND:
 			if (listener) listener->onResult(AuthDbResult::PASSWORD_FOUND, user);
 			return;
+		case EXPIRING_PASS_FOUND:
 		case EXPIRED_PASS_FOUND:
 		case NO_PASS_FOUND:
 			break;
@@ -275,6 +285,7 @@ void AuthDbBackend::getUsersWithPhone(list<tuple<string, string, AuthDbListener*
 			case VALID_PASS_FOUND:
 				if (cred_listener) cred_listener->onResult(AuthDbResult::PASSWORD_FOUND, user);
 				break;
+			case EXPIRING_PASS_FOUND:
 			case EXPIRED_PASS_FOUND:
 			case NO_PASS_FOUND:
 				needed_creds.push_back(cred);
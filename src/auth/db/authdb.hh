@@ -20,15 +20,20 @@
 
 #include <stdio.h>
 
+#include <array>
+#include <chrono>
 #include <functional>
+#include <list>
 #include <map>
 #include <mutex>
 #include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "flexisip/configmanager.hh"
+#include "flexisip/sofia-wrapper/su-root.hh"
 
 namespace belr {
 template <typename _parserElementT>
@@ -50,6 +55,51 @@ struct passwd_algo_t {
 // Fw declaration
 struct AuthDbTimings;
 
+/**
+ * Thread-safe cache of passwords, indexed by domain and password key (see AuthDbBackend::createPasswordKey()).
+ *
+ * Entries are spread over shards, each one with its own lock, so that lookups from the main loop do not contend with
+ * database threads writing results for other users. When `maxSize` is not 0, the least recently used entries of a
+ * shard are evicted once it holds its share of `maxSize` entries.
+ * An entry found less than `refreshAhead` before its expiration is reported as EXPIRING once, so that the caller
+ * can fetch it again while still using the cached value.
+ */
+class PasswordCache {
+public:
+	enum class Result { MISSING, EXPIRED, VALID, EXPIRING };
+
+	PasswordCache(size_t maxSize, std::chrono::seconds refreshAhead, StatCounter64* evictions = nullptr);
+
+	Result find(const std::string& key, const std::string& domain, std::vector<passwd_algo_t>& pass, time_t now);
+	void
+	insert(const std::string& key, const std::string& domain, const std::vector<passwd_algo_t>& pass, time_t expire);
+	void clear();
+	size_t size();
+
+private:
+	static constexpr size_t kShardCount = 16;
+
+	struct Entry {
+		std::string id;
+		std::vector<passwd_algo_t> pass;
+		time_t expireDate;
+		bool refreshing;
+	};
+	using EntryList = std::list<Entry>;
+	struct Shard {
+		std::mutex mutex{};
+		EntryList entries{}; // Most recently used first.
+		std::unordered_map<std::string, EntryList::iterator> index{};
+		size_t maxSize{0}; // 0 when unbounded
+	};
+
+	Shard& getShard(const std::string& id);
+
+	const time_t mRefreshAhead;
+	StatCounter64* const mEvictions;
+	std::array<Shard, kShardCount> mShards{};
+};
+
 class AuthDbListener : public StatFinishListener {
 public:
 	virtual void onResult(AuthDbResult result, const std::string& passwd) = 0;
@@ -86,9 +136,11 @@ public:
 	static void declareConfig(GenericStruct* mc);
 
 protected:
-	enum CacheResult { VALID_PASS_FOUND, EXPIRED_PASS_FOUND, NO_PASS_FOUND };
+	// EXPIRING_PASS_FOUND: the password is still valid but should be fetched again from the backend.
+	enum CacheResult { VALID_PASS_FOUND, EXPIRING_PASS_FOUND, EXPIRED_PASS_FOUND, NO_PASS_FOUND };
 
-	AuthDbBackend(const GenericStruct&);
+	// Backends that use the cache as their own storage have to disable its size limit and refresh-ahead.
+	AuthDbBackend(const GenericStruct&, bool cacheIsStorage = false);
 
 	virtual void getUserWithPhoneFromBackend(const std::string&, const std::string&, AuthDbListener* listener) = 0;
 	virtual void getUsersWithPhonesFromBackend(std::list<std::tuple<std::string, std::string, AuthDbListener*>>& creds);
@@ -118,13 +170,6 @@ protected:
 	int mCacheExpire;
 
 private:
-	struct CachedPassword {
-		std::vector<passwd_algo_t> pass;
-		time_t expire_date;
-		CachedPassword(const std::vector<passwd_algo_t>& ipass, time_t idate) : pass(ipass), expire_date(idate) {
-		}
-	};
-
 	struct ListenerToFunctionWrapper : public AuthDbListener {
 	public:
 		ListenerToFunctionWrapper() = default;
@@ -138,8 +183,10 @@ private:
 		ResultCb mCb;
 	};
 
-	std::map<std::string, std::map<std::string, CachedPassword>> mCachedPasswords;
-	std::mutex mCachedPasswordMutex;
+	std::unique_ptr<PasswordCache> mCachedPasswords;
+	StatCounter64* mCountCacheHits = nullptr;
+	StatCounter64* mCountCacheMisses = nullptr;
+	StatCounter64* mCountCacheRefreshes = nullptr;
 	std::mutex mCachedUserWithPhoneMutex;
 	std::map<std::string, std::string> mPhone2User;
 };
@@ -150,7 +197,9 @@ private:
  **/
 class AuthDb {
 public:
-	AuthDb(const std::shared_ptr<ConfigManager>& cfg) : mConfigManager{cfg} {
+	// The main loop is needed by backends that defer their requests, see 'soci-password-batch-request'.
+	AuthDb(const std::shared_ptr<ConfigManager>& cfg, const std::shared_ptr<sofiasip::SuRoot>& root = nullptr)
+	    : mConfigManager{cfg}, mRoot{root} {
 	}
 	// Accessor to the database backend
 	AuthDbBackend& db() {
@@ -162,6 +211,7 @@ private:
 	void createAuthDbBackend();
 	std::unique_ptr<AuthDbBackend> mBackend;
 	std::shared_ptr<ConfigManager> mConfigManager;
+	std::shared_ptr<sofiasip::SuRoot> mRoot;
 };
 
 // Base root type needed by belr
@@ -291,6 +341,10 @@ public:
 #include "soci/session.h"
 #include "soci/soci.h"
 
+#include <chrono>
+#include <tuple>
+
+#include "flexisip/sofia-wrapper/timer.hh"
 #include "utils/thread/thread-pool.hh"
 
 namespace flexisip {
@@ -307,18 +361,28 @@ public:
 
 	static void declareConfig(GenericStruct* mc);
 
-	SociAuthDB(const GenericStruct&);
+	// The main loop is mandatory when 'soci-password-batch-request' is set: it gathers the requests of a batch.
+	SociAuthDB(const GenericStruct&, const std::shared_ptr<sofiasip::SuRoot>& root = nullptr);
 
 private:
+	// (id, domain, authid) of a password request.
+	using PasswordKey = std::tuple<std::string, std::string, std::string>;
+
 	void connectDatabase();
 	void closeOpenedSessions();
 
+	void sendPasswordBatch();
+	void getPasswordBatchWithPool(const std::vector<PasswordKey>& batch);
+	void notifyPasswordListeners(const PasswordKey& key, AuthDbResult result, const PwList& passwd);
+	static bool addPassword(PwList& passwd,
+	                        const std::string& password,
+	                        const std::string& algo,
+	                        const std::string& unescapedId,
+	                        const std::string& domain);
+
 	void getUserWithPhoneWithPool(const std::string& phone, const std::string& domain, AuthDbListener* listener);
 	void getUsersWithPhonesWithPool(std::list<std::tuple<std::string, std::string, AuthDbListener*>>& creds);
-	void getPasswordWithPool(const std::string& id,
-	                         const std::string& domain,
-	                         const std::string& authid,
-	                         AuthDbListener* listener);
+	void getPasswordWithPool(const std::string& id, const std::string& domain, const std::string& authid);
 
 	void notifyAllListeners(std::list<std::tuple<std::string, std::string, AuthDbListener*>>& creds,
 	                        const std::set<std::pair<std::string, std::string>>& presences);
@@ -335,6 +399,16 @@ private:
 	// Will bind only known parameters detected in the query string
 	std::function<soci::rowset<soci::row>(soci::session&, const std::string&, const std::string&, const std::string&)>
 	    mGetPassword;
+	// Requests being fetched from the database, with the listeners waiting for their result. Any request for the same
+	// key while a query is in progress is answered by this query.
+	std::map<PasswordKey, std::vector<AuthDbListener*>> mPendingPasswordRequests;
+	std::mutex mPendingPasswordMutex;
+	// Micro-batching of password requests, see 'soci-password-batch-request'.
+	std::string mGetPasswordsRequest;
+	std::chrono::milliseconds mPasswordBatchDelay{};
+	std::size_t mPasswordBatchMaxSize = 0;
+	std::vector<PasswordKey> mPasswordBatch; // protected by mPendingPasswordMutex
+	std::unique_ptr<sofiasip::Timer> mPasswordBatchTimer; // main loop only
 	bool check_domain_in_presence_results = false;
 	bool _connected = false;
 
@@ -0,0 +1,101 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "authdb.hh"
+
+using namespace std;
+
+namespace flexisip {
+
+PasswordCache::PasswordCache(size_t maxSize, chrono::seconds refreshAhead, StatCounter64* evictions)
+    : mRefreshAhead{static_cast<time_t>(refreshAhead.count())}, mEvictions{evictions} {
+	if (maxSize == 0) return;
+	// The remainder goes to the first shards so that the sum matches maxSize. Each shard holds at least one entry.
+	for (size_t i = 0; i < kShardCount; ++i) {
+		mShards[i].maxSize = max(maxSize / kShardCount + (i < maxSize % kShardCount ? 1 : 0), size_t{1});
+	}
+}
+
+PasswordCache::Shard& PasswordCache::getShard(const string& id) {
+	return mShards[hash<string>{}(id) % kShardCount];
+}
+
+PasswordCache::Result
+PasswordCache::find(const string& key, const string& domain, vector<passwd_algo_t>& pass, time_t now) {
+	const auto id = domain + '\n' + key;
+	auto& shard = getShard(id);
+	const lock_guard<mutex> lock(shard.mutex);
+	const auto indexIt = shard.index.find(id);
+	if (indexIt == shard.index.end()) return Result::MISSING;
+
+	const auto entryIt = indexIt->second;
+	pass = entryIt->pass;
+	if (entryIt->expireDate <= now) {
+		shard.index.erase(indexIt);
+		shard.entries.erase(entryIt);
+		return Result::EXPIRED;
+	}
+
+	shard.entries.splice(shard.entries.begin(), shard.entries, entryIt);
+	if (0 < mRefreshAhead && entryIt->expireDate - mRefreshAhead <= now && !entryIt->refreshing) {
+		entryIt->refreshing = true;
+		return Result::EXPIRING;
+	}
+	return Result::VALID;
+}
+
+void PasswordCache::insert(const string& key, const string& domain, const vector<passwd_algo_t>& pass, time_t expire) {
+	auto id = domain + '\n' + key;
+	auto& shard = getShard(id);
+	const lock_guard<mutex> lock(shard.mutex);
+	if (const auto indexIt = shard.index.find(id); indexIt != shard.index.end()) {
+		auto& entry = *indexIt->second;
+		entry.pass = pass;
+		entry.expireDate = expire;
+		entry.refreshing = false;
+		shard.entries.splice(shard.entries.begin(), shard.entries, indexIt->second);
+		return;
+	}
+
+	while (shard.maxSize != 0 && shard.maxSize <= shard.entries.size()) {
+		shard.index.erase(shard.entries.back().id);
+		shard.entries.pop_back();
+		if (mEvictions) mEvictions->incr();
+	}
+	shard.entries.push_front({id, pass, expire, false});
+	shard.index.emplace(std::move(id), shard.entries.begin());
+}
+
+void PasswordCache::clear() {
+	for (auto& shard : mShards) {
+		const lock_guard<mutex> lock(shard.mutex);
+		shard.index.clear();
+		shard.entries.clear();
+	}
+}
+
+size_t PasswordCache::size() {
+	size_t size = 0;
+	for (auto& shard : mShards) {
+		const lock_guard<mutex> lock(shard.mutex);
+		size += shard.entries.size();
+	}
+	return size;
+}
+
+} // namespace flexisip
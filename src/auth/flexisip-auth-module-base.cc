@@ -44,7 +44,7 @@ AuthModule(root,
 		   TAG_END()
 ),
 	mQOPAuth(qopAuth) {
-	mNonceStore.setNonceExpires(nonceExpire);
+	mNonceStore->setNonceExpires(nonceExpire);
 }
 
 void FlexisipAuthModuleBase::onCheck(AuthStatus &as, msg_auth_t *au, auth_challenger_t const *ach) {
@@ -127,7 +127,7 @@ void FlexisipAuthModuleBase::onChallenge(AuthStatus &as, auth_challenger_t const
 		as.status(500);
 		as.phrase("Internal error");
 	} else {
-		mNonceStore.insert(as.response()->sh_auth);
+		mNonceStore->insert(as.response()->sh_auth);
 	}
 }
 
@@ -181,19 +181,26 @@ void FlexisipAuthModule::checkAuthHeader(FlexisipAuthStatus& as, msg_auth_t* au,
 	}
 
 	if (mQOPAuth) {
-		int pnc = mNonceStore.getNc(ar->ar_nonce);
 		int nnc = (int)strtoul(ar->ar_nc, NULL, 16);
-		if (pnc == -1 || pnc >= nnc) {
-			LOGW("Bad nonce count %d -> %d for %s", pnc, nnc, ar->ar_nonce);
-			as.blacklist(mAm->am_blacklist);
-			challenge(as, ach);
-			notify(as);
-			return;
-		} else {
-			mNonceStore.updateNc(ar->ar_nonce, nnc);
-		}
+		// The nonce store may answer asynchronously (e.g. when shared between several proxies).
+		as.status(100);
+		mNonceStore->checkAndUpdateNc(ar->ar_nonce, nnc, [this, &as, ar, ach, nnc](int pnc, bool accepted) {
+			if (!accepted) {
+				LOGW("Bad nonce count %d -> %d for %s", pnc, nnc, ar->ar_nonce);
+				as.blacklist(mAm->am_blacklist);
+				challenge(as, ach);
+				notify(as);
+				return;
+			}
+			fetchPassword(as, ar, ach);
+		});
+		return;
 	}
 
+	fetchPassword(as, ar, ach);
+}
+
+void FlexisipAuthModule::fetchPassword(FlexisipAuthStatus& as, auth_response_t* ar, auth_challenger_t const* ach) {
 	auto* listener = new GenericAuthListener(
 	    getRoot(), [this, &as, ar, ach](AuthDbResult result, const AuthDbBackend::PwList& passwords) {
 		    this->processResponse(as, *ar, *ach, result, passwords);
@@ -76,6 +76,7 @@ private:
 	void makeChallenge(AuthStatus& as, const auth_challenger_t& ach);
 
 	void checkAuthHeader(FlexisipAuthStatus& as, msg_auth_t* credentials, auth_challenger_t const* ach) override;
+	void fetchPassword(FlexisipAuthStatus& as, auth_response_t* ar, auth_challenger_t const* ach);
 
 	void processResponse(FlexisipAuthStatus& as,
 	                     const auth_response_t& ar,
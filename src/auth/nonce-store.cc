@@ -46,18 +46,26 @@ void NonceStore::insert(const msg_auth_t *response) {
 }
 
 void NonceStore::insert(const string &nonce) {
+	insert(nonce, 0, getCurrentTime() + mNonceExpires);
+}
+
+void NonceStore::insert(const string &nonce, int nc, time_t expires) {
 	unique_lock<mutex> lck(mMutex);
-	time_t expiration = getCurrentTime() + mNonceExpires;
 	auto it = mNc.find(nonce);
 	if (it != mNc.end()) {
 		LOGE("Replacing nonce count for %s", nonce.c_str());
-		it->second.nc = 0;
-		it->second.expires = expiration;
+		it->second.nc = nc;
+		it->second.expires = expires;
 	} else {
-		mNc.insert(make_pair(nonce, NonceCount(0, expiration)));
+		mNc.insert(make_pair(nonce, NonceCount(nc, expires)));
 	}
 }
 
+void NonceStore::setNc(const string &nonce, int nc, time_t expires) {
+	unique_lock<mutex> lck(mMutex);
+	mNc.insert_or_assign(nonce, NonceCount(nc, expires));
+}
+
 void NonceStore::updateNc(const string &nonce, int newnc) {
 	unique_lock<mutex> lck(mMutex);
 	auto it = mNc.find(nonce);
@@ -69,6 +77,16 @@ void NonceStore::updateNc(const string &nonce, int newnc) {
 	}
 }
 
+void NonceStore::checkAndUpdateNc(const string &nonce, int newnc, NcCheckCb &&cb) {
+	int pnc = getNc(nonce);
+	if (pnc == -1 || pnc >= newnc) {
+		cb(pnc, false);
+		return;
+	}
+	updateNc(nonce, newnc);
+	cb(pnc, true);
+}
+
 void NonceStore::erase(const string &nonce) {
 	unique_lock<mutex> lck(mMutex);
 	LOGD("Erasing nonce %s", nonce.c_str());
@@ -0,0 +1,117 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "redis-nonce-store.hh"
+
+#include "flexisip/common.hh"
+#include "flexisip/logmanager.hh"
+
+#include "libhiredis-wrapper/redis-async-script.hh"
+#include "libhiredis-wrapper/redis-reply.hh"
+#include "utils/variant-utils.hh"
+
+using namespace std;
+
+namespace flexisip {
+using namespace redis::async;
+
+namespace {
+
+const Script CHECK_NONCE_COUNT_SCRIPT{
+#include "check-nonce-count.lua.hh"
+    , // ❯ sed -n '/R"lua(/,/)lua"/p' check-nonce-count.lua.hh | sed 's/R"lua(//' | head -n-1 | sha1sum
+    "a52b666456998adb8797def0c9a11331ddff1652"};
+
+} // namespace
+
+RedisNonceStore::RedisNonceStore(const sofiasip::SuRoot& root, const RedisParameters& redisParams)
+    : mRedisClient{root, redisParams, {}} {
+	mRedisClient.connect();
+}
+
+string RedisNonceStore::makeKey(const string& nonce) {
+	return "fs-nonce:" + nonce;
+}
+
+void RedisNonceStore::insert(const string& nonce) {
+	NonceStore::insert(nonce);
+	const auto* session = mRedisClient.tryGetCmdSession();
+	if (!session) {
+		SLOGW << "RedisNonceStore: Redis not available, nonce " << nonce << " only known by this proxy";
+		return;
+	}
+	session->command({"SET", makeKey(nonce), "0", "EX", to_string(getNonceExpires())}, [nonce](auto&, Reply reply) {
+		if (holds_alternative<reply::Error>(reply)) SLOGE << "RedisNonceStore: failed to store nonce " << nonce;
+	});
+}
+
+void RedisNonceStore::erase(const string& nonce) {
+	NonceStore::erase(nonce);
+	if (const auto* session = mRedisClient.tryGetCmdSession()) {
+		session->command({"DEL", makeKey(nonce)}, [](auto&, auto&&) {});
+	}
+}
+
+void RedisNonceStore::checkAndUpdateNc(const string& nonce, int newnc, NcCheckCb&& cb) {
+	const auto* session = mRedisClient.tryGetCmdSession();
+	if (!session) {
+		NonceStore::checkAndUpdateNc(nonce, newnc, std::move(cb));
+		return;
+	}
+
+	// The near-cache may lag behind the nonce count used with another proxy, so it is only trusted to reject.
+	const auto localNc = getNc(nonce);
+	if (newnc <= localNc) {
+		cb(localNc, false);
+		return;
+	}
+
+	CHECK_NONCE_COUNT_SCRIPT.call(
+	    *session, {makeKey(nonce)}, {to_string(newnc)},
+	    [this, nonce, newnc, localNc, cb = std::move(cb)](auto&, Reply reply) mutable {
+		    auto* array = get_if<reply::Array>(&reply);
+		    if (!array || array->size() != 2) {
+			    SLOGE << "RedisNonceStore: unexpected reply to nonce count check of " << nonce << ": "
+			          << StreamableVariant(reply);
+			    cb(-1, false);
+			    return;
+		    }
+		    const auto previous = (*array)[0];
+		    const auto ttl = (*array)[1];
+		    const auto* previousNc = get_if<reply::Integer>(&previous);
+		    const auto* ttlMs = get_if<reply::Integer>(&ttl);
+		    if (!previousNc || !ttlMs) {
+			    cb(-1, false);
+			    return;
+		    }
+		    if (*previousNc == -1) {
+			    // Nonce issued by this proxy while Redis was not available.
+			    if (localNc != -1) NonceStore::checkAndUpdateNc(nonce, newnc, std::move(cb));
+			    else cb(-1, false);
+			    return;
+		    }
+
+		    const auto accepted = *previousNc < newnc;
+		    // Keep the nonce in the near-cache, with the nonce count now in Redis.
+		    const auto expires = 0 < *ttlMs ? getCurrentTime() + *ttlMs / 1000 : getCurrentTime() + getNonceExpires();
+		    setNc(nonce, accepted ? newnc : static_cast<int>(*previousNc), expires);
+		    cb(static_cast<int>(*previousNc), accepted);
+	    });
+}
+
+} // namespace flexisip
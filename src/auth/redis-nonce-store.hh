@@ -0,0 +1,58 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "flexisip/auth/nonce-store.hh"
+#include "flexisip/configmanager.hh"
+#include "flexisip/sofia-wrapper/su-root.hh"
+
+#include "libhiredis-wrapper/replication/redis-client.hh"
+
+namespace flexisip {
+
+/**
+ * NonceStore shared by all the proxies connected to the same Redis server, so that a nonce issued by one of them is
+ * accepted by the others.
+ *
+ * Each nonce is stored in Redis with its last nonce count, and expires with the nonce thanks to Redis TTL. Nonce counts
+ * are checked (and updated) atomically in Redis. The local store is used as a near-cache of the last nonce count seen
+ * by this proxy, only to reject replayed nonce counts without querying Redis.
+ * If Redis is not available, the store behaves as a process-local one.
+ */
+class RedisNonceStore : public NonceStore {
+public:
+	RedisNonceStore(const sofiasip::SuRoot& root, const redis::async::RedisParameters& redisParams);
+	RedisNonceStore(const sofiasip::SuRoot& root, const GenericStruct* registrarConf)
+	    : RedisNonceStore(root, redis::async::RedisParameters::fromRegistrarConf(registrarConf)) {
+	}
+
+	using NonceStore::insert;
+	void insert(const std::string& nonce) override;
+	void erase(const std::string& nonce) override;
+	void checkAndUpdateNc(const std::string& nonce, int newnc, NcCheckCb&& cb) override;
+
+private:
+	static std::string makeKey(const std::string& nonce);
+
+	redis::async::RedisClient mRedisClient;
+};
+
+} // namespace flexisip
@@ -35,7 +35,8 @@ namespace flexisip::b2bua {
 
 using namespace std;
 
-shared_ptr<B2buaCore> B2buaCore::create(linphone::Factory& factory, const GenericStruct& config) {
+shared_ptr<B2buaCore>
+B2buaCore::create(linphone::Factory& factory, const GenericStruct& config, unsigned shardIndex, unsigned shardCount) {
 	const auto& configLinphone = factory.createConfig("");
 	configLinphone->setBool("misc", "conference_server_enabled", true);
 	configLinphone->setInt("misc", "max_calls", 1000);
@@ -65,7 +66,7 @@ shared_ptr<B2buaCore> B2buaCore::create(linphone::Factory& factory, const Generi
 	configLinphone->setInt("sip", "terminate_call_upon_transfer_completion", 0);
 
 	const auto& core = factory.createCoreWithConfig(configLinphone, nullptr);
-	core->setLabel("Flexisip B2BUA");
+	core->setLabel(shardCount == 1 ? "Flexisip B2BUA"s : "Flexisip B2BUA #"s + to_string(shardIndex));
 	core->getConfig()->setString("storage", "backend", "sqlite3");
 	core->getConfig()->setString("storage", "uri", ":memory:");
 	// No sound card shall be used in calls.
@@ -136,12 +137,14 @@ shared_ptr<B2buaCore> B2buaCore::create(linphone::Factory& factory, const Generi
 	// Expected config format: <codec>
 	forceCodec("video-codec", "video", &linphone::Core::getVideoPayloadTypes, regex("([a-zA-Z-0-9-]+)"));
 
-	const int audioPortMin = config.get<ConfigIntRange>("audio-port")->readMin();
-	const int audioPortMax = config.get<ConfigIntRange>("audio-port")->readMax();
+	const auto [audioPortMin, audioPortMax] = shardPortRange(config.get<ConfigIntRange>("audio-port")->readMin(),
+	                                                         config.get<ConfigIntRange>("audio-port")->readMax(),
+	                                                         shardIndex, shardCount);
 	setMediaPort(audioPortMin, audioPortMax, *core, &linphone::Core::setAudioPort, &linphone::Core::setAudioPortRange);
 
-	const int videoPortMin = config.get<ConfigIntRange>("video-port")->readMin();
-	const int videoPortMax = config.get<ConfigIntRange>("video-port")->readMax();
+	const auto [videoPortMin, videoPortMax] = shardPortRange(config.get<ConfigIntRange>("video-port")->readMin(),
+	                                                         config.get<ConfigIntRange>("video-port")->readMax(),
+	                                                         shardIndex, shardCount);
 	setMediaPort(videoPortMin, videoPortMax, *core, &linphone::Core::setVideoPort, &linphone::Core::setVideoPortRange);
 
 	const auto* noRTPTimeoutParameter = config.get<ConfigDuration<chrono::seconds>>("no-rtp-timeout");
@@ -173,7 +176,13 @@ shared_ptr<B2buaCore> B2buaCore::create(linphone::Factory& factory, const Generi
 			const auto transportParam = urlTransport.getParam("transport");
 			auto listeningPort = stoi(urlTransport.getPort(true));
 			if (listeningPort == 0) {
+				if (shardCount != 1) {
+					throw BadConfiguration{"the port of " + config.get<ConfigString>("transport")->getCompleteName() +
+					                       " can't be chosen by the kernel when the server runs several cores"};
+				}
 				listeningPort = LC_SIP_TRANSPORT_RANDOM;
+			} else {
+				listeningPort += static_cast<int>(shardIndex);
 			}
 			if (scheme == "sip") {
 				if (transportParam.empty() || transportParam == "udp") {
@@ -210,6 +219,24 @@ shared_ptr<B2buaCore> B2buaCore::create(linphone::Factory& factory, const Generi
 	return reinterpret_pointer_cast<B2buaCore>(core);
 }
 
+pair<int, int> shardPortRange(int min, int max, unsigned shardIndex, unsigned shardCount) {
+	if (shardCount == 1 || (min == 0 && max == 0)) return {min, max};
+
+	const auto portCount = max - min + 1;
+	if (portCount < static_cast<int>(shardCount)) {
+		throw BadConfiguration{"the media port range " + to_string(min) + "-" + to_string(max) +
+		                       " is too small to be shared by " + to_string(shardCount) + " cores"};
+	}
+	const auto portsPerShard = portCount / static_cast<int>(shardCount);
+	const auto shardMin = min + static_cast<int>(shardIndex) * portsPerShard;
+	// The last core also gets the remainder of the division.
+	return {shardMin, shardIndex + 1 == shardCount ? max : shardMin + portsPerShard - 1};
+}
+
+unsigned shardOf(string_view callId, unsigned shardCount) {
+	return static_cast<unsigned>(hash<string_view>{}(callId) % shardCount);
+}
+
 pair<string, string> parseUserAgentFromConfig(const string& value) {
 	smatch res{};
 	if (regex_match(value, res, regex(R"(^([a-zA-Z0-9-.!%*_+`'~]+)(?:\/([a-zA-Z0-9-.!%*_+`'~]+|\{version\}))?$)"))) {
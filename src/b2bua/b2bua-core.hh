@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <string_view>
+#include <utility>
+
 #include "linphone++/linphone.hh"
 
 #include "flexisip/configmanager.hh"
@@ -36,9 +39,25 @@ public:
 	B2buaCore() = delete;
 
 	// Instanciate and configure a linphone::Core for use in a B2BUA
-	static std::shared_ptr<B2buaCore> create(linphone::Factory&, const GenericStruct&);
+	// When the server runs several cores ('nb-cores' parameter), shardIndex is the index of the one to create: it
+	// listens on the configured port + shardIndex, and uses its own share of the media port ranges.
+	static std::shared_ptr<B2buaCore>
+	create(linphone::Factory&, const GenericStruct&, unsigned shardIndex = 0, unsigned shardCount = 1);
 };
 
+/**
+ * Split the port range [min, max] evenly between shardCount cores and return the part of the core shardIndex.
+ * A null range (ports chosen by the kernel) is shared as is.
+ *
+ * @throw BadConfiguration if the range has fewer ports than cores
+ */
+std::pair<int, int> shardPortRange(int min, int max, unsigned shardIndex, unsigned shardCount);
+
+/**
+ * Index of the core, among shardCount, that handles the call with this Call-ID.
+ */
+unsigned shardOf(std::string_view callId, unsigned shardCount);
+
 /**
  * Parse "user-agent" parameter from configuration.
  *
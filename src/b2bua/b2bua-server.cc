@@ -18,7 +18,13 @@
 
 #include "b2bua-server.hh"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <memory>
+#include <thread>
+#include <utility>
 
 #include <mediastreamer2/ms_srtp.h>
 
@@ -54,10 +60,108 @@ shared_ptr<linphone::Call> B2buaServer::getPeerCall(const shared_ptr<linphone::C
 	return peerCallEntry->second.lock();
 }
 
+class B2buaServer::Shard {
+public:
+	/**
+	 * Create and start the core in a new thread.
+	 *
+	 * @throw the exceptions thrown while starting the core
+	 */
+	Shard(const shared_ptr<ConfigManager>& cfg, unsigned shardIndex, unsigned shardCount)
+	    : mServer{new B2buaServer{cfg, shardIndex, shardCount}} {
+		promise<void> started{};
+		auto startedFuture = started.get_future();
+		mThread = thread{[this, started = std::move(started)]() mutable { run(started); }};
+		try {
+			startedFuture.get();
+		} catch (...) {
+			mThread.join();
+			throw;
+		}
+	}
+	~Shard() {
+		requestStop();
+		if (mThread.joinable()) mThread.join();
+	}
+
+	/**
+	 * Ask the thread to stop the core, without waiting for it.
+	 */
+	void requestStop() {
+		mRunning = false;
+	}
+	/**
+	 * @return true once the core is stopped and destroyed, so the thread is about to end
+	 */
+	bool stopped() const {
+		return mStopped;
+	}
+
+private:
+	static constexpr chrono::milliseconds kIterationInterval{10};
+
+	void run(promise<void>& started) {
+		try {
+			mServer->init();
+		} catch (...) {
+			mServer.reset();
+			started.set_exception(current_exception());
+			return;
+		}
+		started.set_value();
+
+		while (mRunning) {
+			mServer->_run();
+			this_thread::sleep_for(kIterationInterval);
+		}
+		const auto cleanup = mServer->stop();
+		while (cleanup && !cleanup->finished()) {
+			this_thread::sleep_for(kIterationInterval);
+		}
+		// The core is destroyed by the thread that used it.
+		mServer.reset();
+		mStopped = true;
+	}
+
+	shared_ptr<B2buaServer> mServer;
+	atomic_bool mRunning{true};
+	atomic_bool mStopped{false};
+	thread mThread{};
+};
+
+class B2buaServer::AsyncStopShards : public AsyncCleanup {
+public:
+	AsyncStopShards(unique_ptr<AsyncCleanup>&& stopCore, vector<unique_ptr<Shard>>&& shards)
+	    : mStopCore{std::move(stopCore)}, mShards{std::move(shards)} {
+		for (const auto& shard : mShards) {
+			shard->requestStop();
+		}
+	}
+
+	bool finished() override {
+		if (mStopCore && mStopCore->finished()) mStopCore.reset();
+		// Threads of stopped cores are about to end, joining them doesn't block.
+		mShards.erase(remove_if(mShards.begin(), mShards.end(), [](const auto& shard) { return shard->stopped(); }),
+		              mShards.end());
+		return mStopCore == nullptr && mShards.empty();
+	}
+
+private:
+	unique_ptr<AsyncCleanup> mStopCore;
+	vector<unique_ptr<Shard>> mShards;
+};
+
 B2buaServer::B2buaServer(const shared_ptr<sofiasip::SuRoot>& root, const std::shared_ptr<ConfigManager>& cfg)
     : ServiceServer(root), mConfigManager(cfg), mCli("b2bua", cfg, root) {
 }
 
+B2buaServer::B2buaServer(const shared_ptr<ConfigManager>& cfg, unsigned shardIndex, unsigned shardCount)
+    : ServiceServer(nullptr), mConfigManager(cfg), mCli("b2bua", cfg, nullptr), mShardIndex(shardIndex),
+      mShardCount(shardCount) {
+}
+
+B2buaServer::~B2buaServer() = default;
+
 void B2buaServer::onCallStateChanged(const shared_ptr<linphone::Core>&,
                                      const shared_ptr<linphone::Call>& call,
                                      linphone::Call::State state,
@@ -435,8 +539,32 @@ void B2buaServer::onMessageWaitingIndicationChanged(
 }
 
 void B2buaServer::_init() {
-	// Parse configuration for Data directory. Handle the case where the directory is not created.
 	const auto* config = mConfigManager->getRoot()->get<GenericStruct>(b2bua::configSection);
+	auto applicationType = config->get<ConfigString>("application")->read();
+	const auto& factory = linphone::Factory::get();
+	if (mShardIndex != 0) {
+		// Additional core of the server, the main one did the common initialization.
+		mCore = b2bua::B2buaCore::create(*factory, *config, mShardIndex, mShardCount);
+		mCore->addListener(shared_from_this());
+		mApplication = make_unique<b2bua::trenscrypter::Trenscrypter>();
+		mApplication->init(mCore, *mConfigManager);
+		mCore->start();
+		SLOGI << kLogPrefix << ": core #" << mShardIndex << " started successfully";
+		return;
+	}
+
+	const auto* nbCoresParameter = config->get<ConfigInt>("nb-cores");
+	if (nbCoresParameter->read() < 1) {
+		throw BadConfiguration{"invalid value for '" + nbCoresParameter->getCompleteName() +
+		                       "', the server needs at least one core"};
+	}
+	mShardCount = static_cast<unsigned>(nbCoresParameter->read());
+	if (mShardCount != 1 && applicationType != "trenscrypter") {
+		throw BadConfiguration{"'" + nbCoresParameter->getCompleteName() +
+		                       "' can't be greater than 1 with the '" + applicationType + "' application"};
+	}
+
+	// Parse configuration for Data directory. Handle the case where the directory is not created.
 	auto dataDirPath = config->get<ConfigString>("data-directory")->read();
 	if (!bctbx_directory_exists(dataDirPath.c_str())) {
 		SLOGI << kLogPrefix << ": creating data directory " << dataDirPath;
@@ -452,14 +580,12 @@ void B2buaServer::_init() {
 		}
 	}
 	SLOGI << kLogPrefix << ": data directory set to " << dataDirPath;
-	const auto& factory = linphone::Factory::get();
 	factory->setDataDir(dataDirPath + "/");
 
-	mCore = b2bua::B2buaCore::create(*factory, *config);
+	mCore = b2bua::B2buaCore::create(*factory, *config, 0, mShardCount);
 
 	mCore->addListener(shared_from_this());
 
-	auto applicationType = config->get<ConfigString>("application")->read();
 	SLOGI << kLogPrefix << ": starting with '" << applicationType << "' application";
 	if (applicationType == "trenscrypter") {
 		mApplication = make_unique<b2bua::trenscrypter::Trenscrypter>();
@@ -474,7 +600,10 @@ void B2buaServer::_init() {
 
 	mCore->start();
 	mCli.start();
-	SLOGI << kLogPrefix << ": started successfully";
+	for (auto shardIndex = 1u; shardIndex < mShardCount; ++shardIndex) {
+		mShards.push_back(make_unique<Shard>(mConfigManager, shardIndex, mShardCount));
+	}
+	SLOGI << kLogPrefix << ": started successfully with " << mShardCount << " core(s)";
 }
 
 void B2buaServer::_run() {
@@ -482,11 +611,16 @@ void B2buaServer::_run() {
 }
 
 std::unique_ptr<AsyncCleanup> B2buaServer::_stop() {
-	if (mCore == nullptr) return nullptr;
+	unique_ptr<AsyncCleanup> stopCore{};
+	if (mCore != nullptr) {
+		mCore->removeListener(shared_from_this());
+		mCli.stop();
+		stopCore = std::make_unique<b2bua::AsyncStopCore>(mCore);
+	}
+	if (mShards.empty()) return stopCore;
 
-	mCore->removeListener(shared_from_this());
-	mCli.stop();
-	return std::make_unique<b2bua::AsyncStopCore>(mCore);
+	// Each additional core is stopped by its own thread.
+	return std::make_unique<AsyncStopShards>(std::move(stopCore), exchange(mShards, {}));
 }
 
 void b2bua::CallTransferListener::onTransferStateChanged(const std::shared_ptr<linphone::Call>& call,
@@ -626,6 +760,17 @@ auto& defineConfig = ConfigManager::defaultInit().emplace_back([](GenericStruct&
 	        "Example: H264",
 	        "",
 	    },
+	    {
+	        Integer,
+	        "nb-cores",
+	        "Number of linphone cores run by the server, each one in its own thread, to bridge calls using several "
+	        "CPU cores. Core N (from 0) listens on the port of 'transport' + N, and uses the Nth part of the "
+	        "'audio-port' and 'video-port' ranges, so the port of 'transport' must not be 0 and the ranges must be "
+	        "large enough to be shared. The B2bua module of the proxy reads this parameter to dispatch each call to "
+	        "one of the cores by hash of its Call-ID.\n"
+	        "Only supported by the 'trenscrypter' application.",
+	        "1",
+	    },
 	    {
 	        Boolean,
 	        "one-connection-per-account",
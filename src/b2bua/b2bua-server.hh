@@ -21,6 +21,7 @@
 #include <memory>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 #include "b2bua/b2bua-core.hh"
 #include "linphone++/linphone.hh"
@@ -130,7 +131,7 @@ public:
 	static constexpr auto& kLogPrefix = "B2buaServer";
 
 	B2buaServer(const std::shared_ptr<sofiasip::SuRoot>& root, const std::shared_ptr<ConfigManager>& cfg);
-	~B2buaServer() override = default;
+	~B2buaServer() override;
 
 	void onCallStateChanged(const std::shared_ptr<linphone::Core>& core,
 	                        const std::shared_ptr<linphone::Call>& call,
@@ -183,10 +184,25 @@ private:
 		bool isLegA;
 	};
 
+	/**
+	 * An additional core of the server, with its own application, iterated by its own thread.
+	 */
+	class Shard;
+	/**
+	 * Stop the main core and wait, without blocking, for the end of the threads of the additional ones.
+	 */
+	class AsyncStopShards;
+
+	// Server of the additional core shardIndex, only iterated by its Shard.
+	B2buaServer(const std::shared_ptr<ConfigManager>& cfg, unsigned shardIndex, unsigned shardCount);
+
 	std::shared_ptr<linphone::Call> getPeerCall(const std::shared_ptr<linphone::Call>& call) const;
 
 	std::shared_ptr<ConfigManager> mConfigManager;
 	CommandLineInterface mCli;
+	const unsigned mShardIndex{0};
+	unsigned mShardCount{1};
+	std::vector<std::unique_ptr<Shard>> mShards{};
 	std::shared_ptr<b2bua::B2buaCore> mCore;
 	std::unordered_map<std::shared_ptr<linphone::Call>, std::weak_ptr<linphone::Call>> mPeerCalls;
 	std::unordered_map<std::shared_ptr<linphone::Event>, EventInfo> mPeerEvents;
@@ -0,0 +1,159 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "trenscrypter-rule-matcher.hh"
+
+#include <algorithm>
+#include <cctype>
+
+#include "utils/string-utils.hh"
+
+using namespace std;
+
+namespace flexisip::b2bua::trenscrypter {
+
+namespace {
+
+constexpr string_view kUriParametersGroup{"(;.*)?"};
+
+bool isSpecial(char c) {
+	return string_view{"^$\\.*+?()[]{}|"}.find(c) != string_view::npos;
+}
+
+bool isQuantifier(char c) {
+	return c == '*' || c == '+' || c == '?' || c == '{';
+}
+
+// Number of backslashes just before position.
+size_t backslashesBefore(string_view pattern, size_t position) {
+	size_t count = 0;
+	while (count < position && pattern[position - 1 - count] == '\\') {
+		++count;
+	}
+	return count;
+}
+
+} // namespace
+
+RuleMatcher::RuleMatcher(size_t cacheSize) : mCacheSize{cacheSize}, mCache{cacheSize} {
+}
+
+void RuleMatcher::add(const string& pattern) {
+	mRules.push_back({regex{pattern}, literalAffixes(pattern)});
+	const auto index = mRules.size() - 1;
+	const auto& suffix = mRules.back().affixes.suffix;
+	if (suffix.empty()) {
+		mUnindexedRules.push_back(index);
+	} else {
+		mRulesBySuffix[suffix].push_back(index);
+		if (const auto length = lower_bound(mSuffixLengths.begin(), mSuffixLengths.end(), suffix.size());
+		    length == mSuffixLengths.end() || *length != suffix.size()) {
+			mSuffixLengths.insert(length, suffix.size());
+		}
+	}
+	mCache = decltype(mCache){mCacheSize};
+}
+
+optional<size_t> RuleMatcher::match(const string& uri) {
+	if (const auto cached = mCache.find(uri); cached != mCache.end()) return cached->second;
+
+	auto candidates = mUnindexedRules;
+	addCandidates(uri, candidates);
+	// The suffix of a rule accepting URI parameters may end right before any of them.
+	for (auto parameter = uri.find(';'); parameter != string::npos; parameter = uri.find(';', parameter + 1)) {
+		addCandidates(string_view{uri}.substr(0, parameter), candidates);
+	}
+	sort(candidates.begin(), candidates.end());
+	candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+	optional<size_t> result{};
+	for (const auto index : candidates) {
+		const auto& rule = mRules[index];
+		if (!string_utils::startsWith(uri, rule.affixes.prefix)) continue;
+		++mRegexMatchCount;
+		if (regex_match(uri, rule.regex)) {
+			result = index;
+			break;
+		}
+	}
+	mCache.try_emplace(uri, result);
+	return result;
+}
+
+void RuleMatcher::addCandidates(string_view uri, vector<size_t>& candidates) const {
+	for (const auto length : mSuffixLengths) {
+		if (uri.size() < length) break;
+		const auto rules = mRulesBySuffix.find(string{uri.substr(uri.size() - length)});
+		if (rules == mRulesBySuffix.end()) continue;
+		candidates.insert(candidates.end(), rules->second.begin(), rules->second.end());
+	}
+}
+
+RuleMatcher::LiteralAffixes RuleMatcher::literalAffixes(string_view pattern) {
+	LiteralAffixes affixes{};
+	// Any literal may be bypassed by an alternative.
+	if (pattern.find('|') != string_view::npos) return affixes;
+
+	if (!pattern.empty() && pattern.front() == '^') pattern.remove_prefix(1);
+	if (!pattern.empty() && pattern.back() == '$' && backslashesBefore(pattern, pattern.size() - 1) % 2 == 0) {
+		pattern.remove_suffix(1);
+	}
+
+	for (size_t i = 0; i < pattern.size();) {
+		char literal{};
+		if (pattern[i] == '\\') {
+			// Escaped letters and digits are character classes or back-references.
+			if (i + 1 == pattern.size() || isalnum(static_cast<unsigned char>(pattern[i + 1]))) break;
+			literal = pattern[i + 1];
+			i += 2;
+		} else if (isSpecial(pattern[i])) {
+			break;
+		} else {
+			literal = pattern[i];
+			i += 1;
+		}
+		if (i < pattern.size() && isQuantifier(pattern[i])) {
+			if (pattern[i] == '+') affixes.prefix += literal;
+			break;
+		}
+		affixes.prefix += literal;
+	}
+
+	if (pattern.size() >= kUriParametersGroup.size() &&
+	    pattern.substr(pattern.size() - kUriParametersGroup.size()) == kUriParametersGroup) {
+		affixes.uriParameters = true;
+		pattern.remove_suffix(kUriParametersGroup.size());
+	}
+	for (auto end = pattern.size(); end != 0;) {
+		const auto c = pattern[end - 1];
+		if (backslashesBefore(pattern, end - 1) % 2 == 1) {
+			if (isalnum(static_cast<unsigned char>(c))) break;
+			affixes.suffix += c;
+			end -= 2;
+		} else if (isSpecial(c)) {
+			break;
+		} else {
+			affixes.suffix += c;
+			end -= 1;
+		}
+	}
+	reverse(affixes.suffix.begin(), affixes.suffix.end());
+	return affixes;
+}
+
+} // namespace flexisip::b2bua::trenscrypter
@@ -0,0 +1,97 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/limited-unordered-map.hh"
+
+namespace flexisip::b2bua::trenscrypter {
+
+/**
+ * Find the first of a list of regular expressions that matches a whole callee URI.
+ *
+ * The literal prefix and suffix of each expression are extracted when it is added. The expressions are indexed by
+ * suffix, so only the ones whose literals fit the URI are run. The results are cached for the most recent URIs.
+ */
+class RuleMatcher {
+public:
+	/**
+	 * Literals that any string matched by an expression starts and ends with.
+	 */
+	struct LiteralAffixes {
+		std::string prefix{};
+		std::string suffix{};
+		// The expression ends with '(;.*)?': the suffix may be followed by URI parameters.
+		bool uriParameters{false};
+	};
+
+	explicit RuleMatcher(std::size_t cacheSize = 1024);
+
+	/**
+	 * Append a rule, with a lower priority than the previous ones.
+	 *
+	 * @throw std::regex_error if the pattern is not a valid regular expression
+	 */
+	void add(const std::string& pattern);
+
+	/**
+	 * @return the index of the first rule, in the order they were added, that matches the whole URI, if any
+	 */
+	std::optional<std::size_t> match(const std::string& uri);
+
+	std::size_t size() const {
+		return mRules.size();
+	}
+	// Number of regular expressions run so far, for tests.
+	std::uint64_t getRegexMatchCount() const {
+		return mRegexMatchCount;
+	}
+
+	/**
+	 * Extract the literals of an ECMAScript regular expression. They may be shorter than the actual ones, or empty,
+	 * when the expression is too complex to be analyzed.
+	 */
+	static LiteralAffixes literalAffixes(std::string_view pattern);
+
+private:
+	struct Rule {
+		std::regex regex;
+		LiteralAffixes affixes;
+	};
+
+	void addCandidates(std::string_view uri, std::vector<std::size_t>& candidates) const;
+
+	const std::size_t mCacheSize;
+	std::vector<Rule> mRules{};
+	std::unordered_map<std::string, std::vector<std::size_t>> mRulesBySuffix{};
+	std::vector<std::size_t> mSuffixLengths{};   // Distinct lengths of the keys of mRulesBySuffix, sorted.
+	std::vector<std::size_t> mUnindexedRules{}; // Rules without literal suffix.
+	LimitedUnorderedMap<std::string, std::optional<std::size_t>> mCache;
+	std::uint64_t mRegexMatchCount{0};
+};
+
+} // namespace flexisip::b2bua::trenscrypter
@@ -144,33 +144,25 @@ Trenscrypter::onCallCreate(const linphone::Call& incomingCall, linphone::CallPar
 	const auto calleeAddressUriOnly = callee->asStringUriOnly();
 	outgoingCallParams.setFromHeader(incomingCall.getRemoteAddress()->asString());
 
-	// Select an outgoing encryption.
-	bool outgoingEncryptionSet = false;
-	for (auto& outEncSetting : mOutgoingEncryption) {
-		if (std::regex_match(calleeAddressUriOnly, outEncSetting.pattern)) {
-			SLOGD << FUNC_LOG_PREFIX << ": call to " << calleeAddressUriOnly << " matches regex "
-			      << outEncSetting.stringPattern << " assign encryption mode "
-			      << MediaEncryption2string(outEncSetting.mode);
-			outgoingCallParams.setMediaEncryption(outEncSetting.mode);
-			outgoingEncryptionSet = true;
-			// Stop at the first matching regexp.
-			break;
-		}
-	}
-	if (outgoingEncryptionSet == false) {
+	// Select an outgoing encryption, from the first matching regexp.
+	if (const auto rule = mOutgoingEncryptionMatcher.match(calleeAddressUriOnly)) {
+		const auto& outEncSetting = mOutgoingEncryption[*rule];
+		SLOGD << FUNC_LOG_PREFIX << ": call to " << calleeAddressUriOnly << " matches regex "
+		      << outEncSetting.stringPattern << " assign encryption mode "
+		      << MediaEncryption2string(outEncSetting.mode);
+		outgoingCallParams.setMediaEncryption(outEncSetting.mode);
+	} else {
 		SLOGD << FUNC_LOG_PREFIX << ": call to " << calleeAddressUriOnly << " uses incoming encryption setting";
 	}
 
 	// When outgoing encryption mode is sdes, select a crypto suite list setting if a pattern matches.
 	if (outgoingCallParams.getMediaEncryption() == linphone::MediaEncryption::SRTP) {
-		for (auto& outSrtpSetting : mSrtpConf) {
-			if (std::regex_match(calleeAddressUriOnly, outSrtpSetting.pattern)) {
-				SLOGD << FUNC_LOG_PREFIX << ": call to " << calleeAddressUriOnly << " matches SRTP suite regex "
-				      << outSrtpSetting.stringPattern << " assign Srtp Suites to "
-				      << SrtpSuite2string(outSrtpSetting.suites);
-				outgoingCallParams.setSrtpSuites(outSrtpSetting.suites);
-				break; // stop at the first matching regexp
-			}
+		if (const auto rule = mSrtpConfMatcher.match(calleeAddressUriOnly)) {
+			const auto& outSrtpSetting = mSrtpConf[*rule];
+			SLOGD << FUNC_LOG_PREFIX << ": call to " << calleeAddressUriOnly << " matches SRTP suite regex "
+			      << outSrtpSetting.stringPattern << " assign Srtp Suites to "
+			      << SrtpSuite2string(outSrtpSetting.suites);
+			outgoingCallParams.setSrtpSuites(outSrtpSetting.suites);
 		}
 	}
 
@@ -210,6 +202,7 @@ void Trenscrypter::init(const std::shared_ptr<B2buaCore>& core, const flexisip::
 		if (const auto outgoingEncryption = StringUtils::string2MediaEncryption(outgoingEncryptionList.front())) {
 			outgoingEncryptionList.pop_front();
 			try {
+				mOutgoingEncryptionMatcher.add(outgoingEncryptionList.front());
 				mOutgoingEncryption.emplace_back(*outgoingEncryption, outgoingEncryptionList.front());
 			} catch (const std::exception& e) {
 				SLOGW << mLogPrefix << ": configuration error, outgoing-enc-regex contains invalid regex ("
@@ -242,6 +235,7 @@ void Trenscrypter::init(const std::shared_ptr<B2buaCore>& core, const flexisip::
 			outgoingSrptSuiteList.pop_front();
 			// Get the associated regex.
 			try {
+				mSrtpConfMatcher.add(outgoingSrptSuiteList.front());
 				mSrtpConf.emplace_back(srtpCryptoSuites, outgoingSrptSuiteList.front());
 			} catch (std::exception& e) {
 				BCTBX_SLOGE << "b2bua configuration error: outgoing-srtp-regex contains invalid regex : "
@@ -17,7 +17,10 @@
 */
 #pragma once
 
+#include <vector>
+
 #include "b2bua-server.hh"
+#include "trenscrypter-rule-matcher.hh"
 
 namespace flexisip::b2bua::trenscrypter {
 
@@ -25,28 +28,24 @@ class encryptionConfiguration {
 	friend class Trenscrypter;
 
 	linphone::MediaEncryption mode;
-	std::regex pattern; /**< regular expression applied on the callee sip address, when matched, the associated
-	                       mediaEncryption mode is used on the output call */
-	std::string
-	    stringPattern; /**< a string version of the pattern for log purpose as the std::regex does not carry it*/
+	std::string stringPattern; /**< regular expression applied on the callee sip address, when matched, the associated
+	                              mediaEncryption mode is used on the output call (compiled in a RuleMatcher) */
 
 public:
 	encryptionConfiguration(linphone::MediaEncryption p_mode, std::string p_pattern)
-	    : mode(p_mode), pattern(p_pattern), stringPattern(p_pattern){};
+	    : mode(p_mode), stringPattern(p_pattern){};
 };
 
 class srtpConfiguration {
 	friend class Trenscrypter;
 
 	std::list<linphone::SrtpSuite> suites;
-	std::regex pattern; /**< regular expression applied on the callee sip address, when matched, the associated SRTP
-	                       suites are used */
-	std::string
-	    stringPattern; /**< a string version of the pattern for log purposes as the std::regex does not carry it */
+	std::string stringPattern; /**< regular expression applied on the callee sip address, when matched, the associated
+	                              SRTP suites are used (compiled in a RuleMatcher) */
 
 public:
 	srtpConfiguration(std::list<linphone::SrtpSuite> p_suites, std::string p_pattern)
-	    : suites(p_suites), pattern(p_pattern), stringPattern(p_pattern){};
+	    : suites(p_suites), stringPattern(p_pattern){};
 };
 
 /**
@@ -54,8 +53,11 @@ public:
  */
 class Trenscrypter : public b2bua::Application {
 	std::shared_ptr<linphone::Core> mCore;
-	std::list<encryptionConfiguration> mOutgoingEncryption;
-	std::list<srtpConfiguration> mSrtpConf;
+	// Rule i of a matcher is the element i of the corresponding vector.
+	std::vector<encryptionConfiguration> mOutgoingEncryption;
+	RuleMatcher mOutgoingEncryptionMatcher{};
+	std::vector<srtpConfiguration> mSrtpConf;
+	RuleMatcher mSrtpConfMatcher{};
 
 public:
 	void init(const std::shared_ptr<B2buaCore>& core, const flexisip::ConfigManager& cfg) override;
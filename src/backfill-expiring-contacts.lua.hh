@@ -0,0 +1,49 @@
+/** Copyright (C) 2010-2024 Belledonne Communications SARL
+    SPDX-License-Identifier: AGPL-3.0-or-later
+
+	You can set your editor to Lua for this file to get syntax highlighting.
+
+	Brief:
+		Redis script to add the contacts with push parameters of some Records
+		to the expiry index, for Records written before the index existed.
+
+	KEYS:
+		1: Expiry index of the contacts with push parameters. [string]
+		2: Lifetimes of the contacts of the expiry index. [string]
+		3..: Records to index. [strings]
+	ARGV:
+		1: Current time. [Unix timestamp]
+
+	Implementation:
+		Loop on the contacts of each Record with HGETALL, and parse the SIP
+		URI parameters of the ones with push parameters, as
+		ExtendedContact::serializeAsUrlEncodedParams() writes them.
+		Contacts that are already indexed are left untouched, as they may have
+		been updated by a bind since the Record was read.
+		/!\ Lua string patterns are not POSIX regexps
+		Returns the number of contacts added to the index.
+*/
+
+R"lua(
+local indexKey, lifetimesKey = KEYS[1], KEYS[2]
+local now = tonumber(ARGV[1])
+local added = 0
+for i = 3, #KEYS do
+	local fields = redis.call("HGETALL", KEYS[i])
+	for j = 1, #fields, 2 do
+		local contact = fields[j + 1]
+		if contact:find(";pn%-provider=") or contact:find(";pn%-type=") then
+			local updatedAt, lifetime = contact:match(";updatedAt=(%d+)"), contact:match(";expires=(%d+)")
+			local sipExpireTime = updatedAt and lifetime and tonumber(updatedAt) + tonumber(lifetime)
+			if sipExpireTime and 0 < tonumber(lifetime) and now < sipExpireTime then
+				added = added + redis.call("ZADD", indexKey, "NX", sipExpireTime, KEYS[i] .. "\n" .. fields[j])
+				local lifetimeExpireTime = redis.call("ZSCORE", lifetimesKey, lifetime)
+				if not lifetimeExpireTime or tonumber(lifetimeExpireTime) < sipExpireTime then
+					redis.call("ZADD", lifetimesKey, sipExpireTime, lifetime)
+				end
+			end
+		end
+	end
+end
+return added
+)lua"
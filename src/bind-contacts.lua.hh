@@ -0,0 +1,164 @@
+/** Copyright (C) 2010-2024 Belledonne Communications SARL
+    SPDX-License-Identifier: AGPL-3.0-or-later
+
+	You can set your editor to Lua for this file to get syntax highlighting.
+
+	Brief:
+		Redis script to bind contacts to a Record in a single round trip.
+		Mirrors Record::insertOrUpdateBinding() and Record::applyMaxAor() for
+		contacts that are identified by a unique id (+sip.instance), i.e. when
+		no RFC 3261 URI comparison is needed.
+
+	KEYS:
+		1: Record. Hash of the serialized contacts by unique id. [string]
+		2: Metadata of the contacts of the Record, by unique id. [string]
+		3: Expiry index of the contacts with push parameters. [string]
+		4: Lifetimes of the contacts of the expiry index, scored by the latest
+		   expiration time of the contacts with this lifetime. [string]
+	ARGV:
+		1: Current time. [Unix timestamp]
+		2: Maximum number of contacts of a Record. [integer]
+		3..: Contacts to bind, as triplets of their unique id, their
+		     serialized form and their metadata. [strings]
+
+	Metadata:
+		A first line made of the time of registration, the expiration time
+		(including message-expires), the expiration time of the SIP binding,
+		the lifetime, and 1 if the contact has to be in the expiry index (0
+		otherwise), separated by spaces. Then, one line per push parameter of
+		the contact, made of the provider, the prid and the param. Two contacts
+		have the same push parameters if they have at least one such line in
+		common.
+
+	Implementation:
+		Existing contacts are loaded from their metadata only. If any of them has
+		none (i.e. it was written by a version without this script), nothing is
+		done and {0} is returned so that the caller falls back to the regular
+		bind.
+		Otherwise, expired contacts are removed, each new contact replaces the
+		ones with the same unique id or push parameters, and the oldest contacts
+		are removed beyond the maximum. Returns {1, replaced, record} where
+		replaced is the flattened unique ids and serialized forms of the
+		contacts replaced because of their unique id, and record the content of
+		the Record once updated (as HGETALL).
+*/
+
+R"lua(
+local recordKey, metadataKey, indexKey, lifetimesKey = KEYS[1], KEYS[2], KEYS[3], KEYS[4]
+local now, maxContacts = tonumber(ARGV[1]), tonumber(ARGV[2])
+
+local function parseMetadata(raw)
+	local metadata = nil
+	for line in raw:gmatch("[^\n]+") do
+		if not metadata then
+			local updatedAt, expireTime, sipExpireTime, lifetime, indexed =
+				line:match("^(%-?%d+) (%-?%d+) (%-?%d+) (%-?%d+) ([01])$")
+			if not updatedAt then return nil end
+			metadata = {
+				updatedAt = tonumber(updatedAt),
+				expireTime = tonumber(expireTime),
+				sipExpireTime = tonumber(sipExpireTime),
+				lifetime = tonumber(lifetime),
+				indexed = indexed == "1",
+				pushParams = {},
+			}
+		else
+			metadata.pushParams[line] = true
+		end
+	end
+	return metadata
+end
+
+local function haveSamePushParams(a, b)
+	for pushParam in pairs(a.pushParams) do
+		if b.pushParams[pushParam] then return true end
+	end
+	return false
+end
+
+local contacts, deleted, upserted = {}, {}, {}
+local uids = redis.call("HKEYS", recordKey)
+if 0 < #uids then
+	local metadatas = redis.call("HMGET", metadataKey, unpack(uids))
+	for i, uid in ipairs(uids) do
+		local metadata = metadatas[i] and parseMetadata(metadatas[i])
+		if not metadata then return {0} end
+		if metadata.expireTime <= now then
+			deleted[uid] = true
+		else
+			contacts[uid] = metadata
+		end
+	end
+end
+
+local replaced = {}
+for i = 3, #ARGV - 2, 3 do
+	local uid, serialized = ARGV[i], ARGV[i + 1]
+	local metadata = parseMetadata(ARGV[i + 2])
+	if not metadata then return redis.error_reply("Invalid metadata for contact " .. uid) end
+
+	for existingUid, existing in pairs(contacts) do
+		local erase = false
+		if haveSamePushParams(existing, metadata) and existing.updatedAt <= metadata.updatedAt then
+			erase = true
+		elseif existingUid == uid then
+			if not upserted[uid] then
+				table.insert(replaced, uid)
+				table.insert(replaced, redis.call("HGET", recordKey, uid))
+			end
+			erase = true
+		end
+		if erase then
+			contacts[existingUid] = nil
+			upserted[existingUid] = nil
+			deleted[existingUid] = true
+		end
+	end
+
+	if now < metadata.expireTime then
+		contacts[uid] = metadata
+		upserted[uid] = {serialized, ARGV[i + 2]}
+	end
+end
+
+while true do
+	local count, oldestUid, oldest = 0, nil, nil
+	for uid, metadata in pairs(contacts) do
+		count = count + 1
+		if not oldest or metadata.updatedAt < oldest.updatedAt then oldestUid, oldest = uid, metadata end
+	end
+	if count <= maxContacts then break end
+	contacts[oldestUid] = nil
+	upserted[oldestUid] = nil
+	deleted[oldestUid] = true
+end
+
+for uid in pairs(deleted) do
+	redis.call("HDEL", recordKey, uid)
+	redis.call("HDEL", metadataKey, uid)
+	redis.call("ZREM", indexKey, recordKey .. "\n" .. uid)
+end
+for uid, values in pairs(upserted) do
+	redis.call("HMSET", recordKey, uid, values[1])
+	redis.call("HMSET", metadataKey, uid, values[2])
+	local metadata, member = contacts[uid], recordKey .. "\n" .. uid
+	if metadata.indexed then
+		redis.call("ZADD", indexKey, metadata.sipExpireTime, member)
+		local lifetimeExpireTime = redis.call("ZSCORE", lifetimesKey, metadata.lifetime)
+		if not lifetimeExpireTime or tonumber(lifetimeExpireTime) < metadata.sipExpireTime then
+			redis.call("ZADD", lifetimesKey, metadata.sipExpireTime, metadata.lifetime)
+		end
+	else
+		redis.call("ZREM", indexKey, member)
+	end
+end
+
+local latestExpire = 0
+for _, metadata in pairs(contacts) do
+	latestExpire = math.max(latestExpire, metadata.expireTime)
+end
+redis.call("EXPIREAT", recordKey, latestExpire)
+redis.call("EXPIREAT", metadataKey, latestExpire)
+
+return {1, replaced, redis.call("HGETALL", recordKey)}
+)lua"
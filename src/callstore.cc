@@ -17,6 +17,7 @@
 */
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 
 #include "callstore.hh"
@@ -28,6 +29,7 @@ CallContextBase::CallContextBase(sip_t *sip) {
 	su_home_init(&mHome);
 	mFrom = sip_from_dup(&mHome, sip->sip_from);
 	mCallHash = sip->sip_call_id->i_hash;
+	mCallId = sip->sip_call_id->i_id;
 	mInvCseq = sip->sip_cseq->cs_seq;
 	mResCseq = (uint32_t)-1;
 	mInvite = NULL;
@@ -138,51 +140,121 @@ CallStore::CallStore() : mCountCalls(NULL), mCountCallsFinished(NULL) {
 CallStore::~CallStore() {
 }
 
+string CallStore::makeDialogKey(const string &callId, const char *tag1, const char *tag2) {
+	// Tags are sorted, as from and to tags are inverted in requests sent by the callee.
+	if (strcmp(tag1, tag2) > 0) swap(tag1, tag2);
+	string key{callId};
+	key.append(1, '\n').append(tag1).append(1, '\n').append(tag2);
+	return key;
+}
+
+const vector<CallStore::CallList::iterator> *CallStore::getCallIdBucket(const sip_t *sip) const {
+	if (sip->sip_call_id == NULL || sip->sip_call_id->i_id == NULL)
+		return nullptr;
+	auto it = mByCallId.find(sip->sip_call_id->i_id);
+	return it != mByCallId.end() ? &it->second : nullptr;
+}
+
+void CallStore::indexDialog(CallList::iterator it) {
+	const auto &ctx = *it;
+	if (!ctx->isDialogEstablished())
+		return;
+	mByDialog.emplace(makeDialogKey(ctx->getCallId(), ctx->getCallerTag().c_str(), ctx->getCalleeTag().c_str()), it);
+}
+
+CallStore::CallList::iterator CallStore::erase(CallList::iterator it) {
+	const auto &ctx = *it;
+	auto bucket = mByCallId.find(ctx->getCallId());
+	if (bucket != mByCallId.end()) {
+		auto &candidates = bucket->second;
+		candidates.erase(std::find(candidates.begin(), candidates.end(), it));
+		if (candidates.empty())
+			mByCallId.erase(bucket);
+	}
+	if (ctx->isDialogEstablished()) {
+		auto dialog =
+		    mByDialog.find(makeDialogKey(ctx->getCallId(), ctx->getCallerTag().c_str(), ctx->getCalleeTag().c_str()));
+		if (dialog != mByDialog.end() && dialog->second == it)
+			mByDialog.erase(dialog);
+	}
+	return mCalls.erase(it);
+}
+
 void CallStore::store(const shared_ptr<CallContextBase> &ctx) {
 	if (mCountCalls)
 		++(*mCountCalls);
-	mCalls.push_back(ctx);
+	auto it = mCalls.insert(mCalls.end(), ctx);
+	mByCallId[ctx->getCallId()].push_back(it);
+	indexDialog(it);
 }
 
 shared_ptr<CallContextBase> CallStore::find(Agent *ag, sip_t *sip, bool match_call_id_only) {
-	for (auto it = mCalls.begin(); it != mCalls.end(); ++it) {
-		if ((*it)->match(ag, sip, match_call_id_only))
+	const auto *candidates = getCallIdBucket(sip);
+	if (candidates == nullptr)
+		return shared_ptr<CallContextBase>();
+	for (const auto &it : *candidates) {
+		if ((*it)->match(ag, sip, match_call_id_only)) {
+			// Matching a response may have established the dialog.
+			indexDialog(it);
 			return *it;
+		}
 	}
 	return shared_ptr<CallContextBase>();
 }
 
 shared_ptr<CallContextBase> CallStore::findEstablishedDialog(Agent *ag, sip_t *sip) {
-	for (auto it = mCalls.begin(); it != mCalls.end(); ++it) {
-		if ((*it)->match(ag, sip, false, true))
+	if (sip->sip_call_id && sip->sip_call_id->i_id && sip->sip_from && sip->sip_from->a_tag && sip->sip_to &&
+	    sip->sip_to->a_tag) {
+		auto dialog = mByDialog.find(makeDialogKey(sip->sip_call_id->i_id, sip->sip_from->a_tag, sip->sip_to->a_tag));
+		if (dialog != mByDialog.end() && (*dialog->second)->match(ag, sip, false, true))
+			return *dialog->second;
+	}
+	// Fall back to the contexts sharing the Call-ID, in case the dialog was established but not indexed yet.
+	const auto *candidates = getCallIdBucket(sip);
+	if (candidates == nullptr)
+		return shared_ptr<CallContextBase>();
+	for (const auto &it : *candidates) {
+		if ((*it)->match(ag, sip, false, true)) {
+			indexDialog(it);
 			return *it;
+		}
 	}
 	return shared_ptr<CallContextBase>();
 }
 
 void CallStore::findAndRemoveExcept(Agent *ag, sip_t *sip, const shared_ptr<CallContextBase> &ctx, bool stateful) {
 	int removed = 0;
-	for (auto it = mCalls.begin(); it != mCalls.end();) {
-		if (*it != ctx && (*it)->match(ag, sip, stateful)) {
-			if (mCountCallsFinished)
-				++(*mCountCallsFinished);
-			LOGD("CallStore::findAndRemoveExcept() removing CallContext %p", ctx.get());
-			it = mCalls.erase(it);
-			++removed;
-		} else
-			++it;
+	const auto *candidates = getCallIdBucket(sip);
+	if (candidates != nullptr) {
+		// The bucket is modified, and possibly destroyed, by erase().
+		const auto matching = *candidates;
+		for (const auto &it : matching) {
+			if (*it != ctx && (*it)->match(ag, sip, stateful)) {
+				if (mCountCallsFinished)
+					++(*mCountCallsFinished);
+				LOGD("CallStore::findAndRemoveExcept() removing CallContext %p", ctx.get());
+				erase(it);
+				++removed;
+			}
+		}
 	}
 	LOGD("Removed %d maching call contexts from store", removed);
 }
 
 void CallStore::remove(const shared_ptr<CallContextBase> &ctx) {
-	auto it = std::find(mCalls.begin(), mCalls.end(), ctx);
-	if (it != mCalls.end()) {
+	auto bucket = mByCallId.find(ctx->getCallId());
+	if (bucket == mByCallId.end())
+		return;
+	const auto &candidates = bucket->second;
+	auto it = std::find_if(candidates.begin(), candidates.end(),
+	                       [&ctx](const auto &candidate) { return *candidate == ctx; });
+	if (it != candidates.end()) {
 		LOGD("CallStore::remove() removing CallContext %p", ctx.get());
 		if (mCountCallsFinished)
 			++(*mCountCallsFinished);
-		(*it)->terminate();
-		mCalls.erase(it);
+		auto callIt = *it;
+		(*callIt)->terminate();
+		erase(callIt);
 	}
 }
 
@@ -194,7 +266,7 @@ void CallStore::removeAndDeleteInactives(time_t inactivityPeriod) {
 			if (mCountCallsFinished)
 				++(*mCountCallsFinished);
 			(*it)->terminate();
-			it = mCalls.erase(it);
+			it = erase(it);
 		} else
 			++it;
 	}
@@ -19,6 +19,9 @@
 #pragma once
 
 #include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "agent.hh"
 #include "eventlogs/writers/event-log-writer.hh"
@@ -51,12 +54,16 @@ public:
 	uint32_t getViaCount() const {
 		return mViaCount;
 	}
+	const std::string& getCallId() const {
+		return mCallId;
+	}
 
 private:
 	su_home_t mHome;
 	sip_from_t* mFrom;
 	msg_t* mInvite;
 	uint32_t mCallHash;
+	std::string mCallId;
 	uint32_t mInvCseq;
 	uint32_t mResCseq;
 	std::string mCallerTag;
@@ -66,8 +73,14 @@ private:
 	time_t mLastSIPActivity;
 };
 
+/**
+ * Holds the call contexts of a module, indexed by Call-ID so that in-dialog messages are matched in constant time
+ * whatever the number of calls. Established dialogs are additionally indexed by Call-ID and from/to tags.
+ */
 class CallStore {
 public:
+	using CallList = std::list<std::shared_ptr<CallContextBase>>;
+
 	CallStore();
 	~CallStore();
 	void store(const std::shared_ptr<CallContextBase>& ctx);
@@ -84,14 +97,24 @@ public:
 		mCountCallsFinished = invFinishedCount;
 	}
 	void dump();
-	const std::list<std::shared_ptr<CallContextBase>>& getList() const {
+	/// Iterating over all calls is O(n), only use it for stats and maintenance.
+	const CallList& getList() const {
 		return mCalls;
 	}
 	/// Returns the number of calls registered in the CallStore.
 	int size();
 
 private:
-	std::list<std::shared_ptr<CallContextBase>> mCalls;
+	static std::string makeDialogKey(const std::string& callId, const char* tag1, const char* tag2);
+	/* Candidates for the Call-ID of the message, in the order they were stored. */
+	const std::vector<CallList::iterator>* getCallIdBucket(const sip_t* sip) const;
+	void indexDialog(CallList::iterator it);
+	CallList::iterator erase(CallList::iterator it);
+
+	CallList mCalls;
+	std::unordered_map<std::string, std::vector<CallList::iterator>> mByCallId;
+	/* Established dialogs, see makeDialogKey(). */
+	std::unordered_map<std::string, CallList::iterator> mByDialog;
 	StatCounter64* mCountCalls;
 	StatCounter64* mCountCallsFinished;
 };
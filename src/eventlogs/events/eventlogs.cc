@@ -38,6 +38,22 @@ auto& defineConfig = ConfigManager::defaultInit().emplace_back([](GenericStruct&
 	    {String, "filesystem-directory",
 	     "Directory where event logs are written as a filesystem (case when filesystem output is chosen).",
 	     "/var/log/flexisip"},
+	    {Boolean, "filesystem-background-writer",
+	     "Write event logs from a background thread instead of the main one. The lines of each file are buffered and "
+	     "appended every 'filesystem-flush-interval', to files kept open between writes.",
+	     "false"},
+	    {Integer, "filesystem-max-open-files",
+	     "Maximum number of log files kept open by the background writer. The least recently used file is closed "
+	     "when another one must be opened. Only used if 'filesystem-background-writer' is enabled.",
+	     "100"},
+	    {DurationMS, "filesystem-flush-interval",
+	     "Interval between two writes of the buffered lines by the background writer. Only used if "
+	     "'filesystem-background-writer' is enabled.",
+	     "1000"},
+	    {DurationMS, "filesystem-fsync-interval",
+	     "Interval between two syncs to disk of the files written by the background writer. 0 lets the system decide "
+	     "when to write them to disk. Only used if 'filesystem-background-writer' is enabled.",
+	     "10000"},
 	    ////////////////// Database //////////////////
 	    {String, "database-backend",
 	     "Type of backend that Soci will use for the connection.\n"
@@ -62,6 +78,15 @@ auto& defineConfig = ConfigManager::defaultInit().emplace_back([](GenericStruct&
 	     "Maximum number of threads for writing in database.\n"
 	     "If you get a `database is locked` error with sqlite3, you must set this variable to 1.",
 	     "10"},
+	    {Integer, "database-batch-size",
+	     "Maximum number of events written in database by a single transaction, with multi-row inserts.\n"
+	     "A batch is written as soon as it is full, or 'database-batch-max-delay' after its first event otherwise. "
+	     "A value of 1 writes each event by its own transaction, as soon as it is queued.",
+	     "1"},
+	    {DurationMS, "database-batch-max-delay",
+	     "Maximum time an event waits for the following ones to be written in the same batch. Only used if "
+	     "'database-batch-size' is greater than 1.",
+	     "100"},
 	    ////////////////// Flexiapi //////////////////
 	    {String, "flexiapi-host",
 	     "Domain name or IP address of the FlexiAPI host. This setting will be used in combination with flexiapi-port "
@@ -71,6 +96,17 @@ auto& defineConfig = ConfigManager::defaultInit().emplace_back([](GenericStruct&
 	    {String, "flexiapi-prefix", "Path prefix for FlexiAPI requests. See `flexiapi-host` for details.",
 	     "/api/stats/"},
 	    {String, "flexiapi-api-key", "API authentication key for the FlexiAPI", ""},
+	    {DurationMS, "flexiapi-batch-window",
+	     "Time during which requests to the FlexiAPI are accumulated before being sent together, in a single request "
+	     "to <flexiapi-prefix>batch. Updates of the same call or message received meanwhile are merged into a single "
+	     "request. If the server doesn't support batches, the requests are sent one by one at the end of each "
+	     "window. Requests that fail are sent again later, with an increasing delay.\n"
+	     "A value of 0 sends each request as soon as the event occurs.",
+	     "0"},
+	    {Integer, "flexiapi-batch-max-pending-requests",
+	     "Maximum number of requests waiting to be sent to the FlexiAPI. Beyond this limit, the oldest ones are "
+	     "dropped. Only used if 'flexiapi-batch-window' is greater than 0.",
+	     "10000"},
 
 	    // Deprecated parameters
 	    {String, "dir",
@@ -89,6 +125,10 @@ auto& defineConfig = ConfigManager::defaultInit().emplace_back([](GenericStruct&
 
 	auto* ev = root.addChild(std::move(uEv));
 	ev->addChildrenValues(items);
+	ev->createStat("count-database-events-queued", "Number of event logs waiting to be written in database.");
+	ev->createStat("count-database-events-flushed", "Number of event logs written in database.");
+	ev->createStat("count-database-events-dropped",
+	               "Number of event logs dropped because the queue was full or their batch could not be written.");
 	ev->get<ConfigString>("dir")->setDeprecated({"2020-02-19", "2.0.0", "Replaced by 'filesystem-directory'"});
 
 	auto* flexiapiToken = ev->get<ConfigString>("flexiapi-token");
@@ -4,11 +4,16 @@
 
 #include "database-event-log-writer.hh"
 
+#include <algorithm>
+
 #include <sofia-sip/sip_protos.h>
 
+#include "flexisip/configmanager.hh"
+
 #include "db/db-transaction.hh"
 #include "eventlogs/events/event-log-write-dispatcher.hh"
 #include "eventlogs/events/eventlogs.hh"
+#include "soci-helper.hh"
 #include "utils/thread/auto-thread-pool.hh"
 
 using namespace std;
@@ -21,6 +26,59 @@ constexpr int SqlCallEventLogId = 1;
 constexpr int SqlMessageEventLogId = 2;
 constexpr int SqlAuthEventLogId = 3;
 constexpr int SqlCallQualityEventLogId = 4;
+
+// Values of the rows of a batch, as types soci can bind. 'event' is the position of the event in the batch, 'id' is
+// the id of its event_log row once inserted.
+struct EventRow {
+	size_t event;
+	long long id;
+	int typeId;
+	string from;
+	string to;
+	string userAgent;
+	tm date;
+	int statusCode;
+	string reason;
+	string completed;
+	string callId;
+	string priority;
+};
+struct RegistrationRow {
+	size_t event;
+	long long id;
+	int typeId;
+	string contacts;
+};
+struct CallRow {
+	size_t event;
+	long long id;
+	string cancelled;
+};
+struct MessageRow {
+	size_t event;
+	long long id;
+	int typeId;
+	string uri;
+};
+struct AuthRow {
+	size_t event;
+	long long id;
+	string method;
+	string origin;
+	string userExists;
+};
+struct CallQualityRow {
+	size_t event;
+	long long id;
+	string report;
+};
+
+template <typename Row>
+void setIds(vector<Row>& rows, const vector<EventRow>& events) {
+	for (auto& row : rows) {
+		row.id = events[row.event].id;
+	}
+}
 } // namespace
 
 // redundant declaration (required for C++14 compatibility)
@@ -87,12 +145,71 @@ static string boolToSqlString(bool value) {
 	return value ? "Y" : "N";
 }
 
+/**
+ * Gathers the rows of a batch of events instead of writing them.
+ */
+class DataBaseEventLogWriter::BatchBuilder : public EventLogWriter {
+public:
+	using EventLogWriter::write;
+
+	size_t size() const {
+		return mEvents.size();
+	}
+
+	// Give the ids of the event_log rows to the rows of the specialized tables.
+	void propagateIds() {
+		setIds(mRegistrations, mEvents);
+		setIds(mCalls, mEvents);
+		setIds(mMessages, mEvents);
+		setIds(mAuths, mEvents);
+		setIds(mCallQualities, mEvents);
+	}
+
+	vector<EventRow> mEvents{};
+	vector<RegistrationRow> mRegistrations{};
+	vector<CallRow> mCalls{};
+	vector<MessageRow> mMessages{};
+	vector<AuthRow> mAuths{};
+	vector<CallQualityRow> mCallQualities{};
+
+protected:
+	void write(const RegistrationLog& evLog) override {
+		mRegistrations.push_back({addEvent(evLog, SqlRegistrationEventLogId), 0, int(evLog.getType()),
+		                          sipDataToString(evLog.getContacts())});
+	}
+	void write(const CallLog& evLog) override {
+		mCalls.push_back({addEvent(evLog, SqlCallEventLogId), 0, boolToSqlString(evLog.isCancelled())});
+	}
+	void write(const MessageLog& evLog) override {
+		mMessages.push_back({addEvent(evLog, SqlMessageEventLogId), 0, int(evLog.getReportType()),
+		                     sipDataToString(evLog.getUri())});
+	}
+	void write(const AuthLog& evLog) override {
+		mAuths.push_back({addEvent(evLog, SqlAuthEventLogId), 0, evLog.getMethod(),
+		                  sipDataToString(evLog.getOrigin()), boolToSqlString(evLog.userExists())});
+	}
+	void write(const CallQualityStatisticsLog& evLog) override {
+		mCallQualities.push_back({addEvent(evLog, SqlCallQualityEventLogId), 0, evLog.getReport()});
+	}
+
+private:
+	size_t addEvent(const EventLog& evLog, int typeId) {
+		tm date;
+		mEvents.push_back({mEvents.size(), 0, typeId, sipDataToString(evLog.getFrom()), sipDataToString(evLog.getTo()),
+		                   sipDataToString(evLog.getUserAgent()), *gmtime_r(&evLog.getDate(), &date),
+		                   evLog.getStatusCode(), evLog.getReason(), boolToSqlString(evLog.isCompleted()),
+		                   evLog.getCallId(), evLog.getPriority()});
+		return mEvents.back().event;
+	}
+};
+
 DataBaseEventLogWriter::BackendInfo::BackendInfo() noexcept : mInsertPrefix{"INSERT INTO"} {
 }
 
 DataBaseEventLogWriter::Sqlite3Info::Sqlite3Info() noexcept : BackendInfo{} {
 	mInsertPrefix = "INSERT OR IGNORE INTO";
 	mLastIdFunction = "last_insert_rowid()";
+	mBatchIds = BatchIds::LastIdIsLastRow;
 	mTableNamesQuery = "SELECT name AS \"TABLE_NAME\" FROM sqlite_master WHERE type = 'table'";
 }
 
@@ -107,6 +224,7 @@ DataBaseEventLogWriter::MysqlInfo::MysqlInfo() noexcept : BackendInfo{} {
 DataBaseEventLogWriter::PostgresqlInfo::PostgresqlInfo() noexcept : BackendInfo{} {
 	mPrimaryKeyIncrementType = "AUTO_INCREMENT";
 	mLastIdFunction = "lastval()";
+	mBatchIds = BatchIds::Returning;
 	mOnConflictType = "ON CONFLICT (id) DO UPDATE SET type = EXCLUDED.type";
 	mTableNamesQuery =
 	    "SELECT table_name AS \"TABLE_NAME\"FROM information_schema.tables WHERE table_schema = 'public'";
@@ -294,6 +412,13 @@ DataBaseEventLogWriter::DataBaseEventLogWriter(const std::string& backendString,
 
 		// Build insert requests.
 		const auto& lastIdFunction = backend->lastIdFunction();
+		mLastIdFunction = lastIdFunction;
+		mBatchIds = backend->batchIds();
+		if (backendString == "mysql") {
+			// Ids of a multi-row insert are separated by this increment, which is not 1 on some replicated setups.
+			soci::session session(*mConnectionPool);
+			session << "SELECT @@auto_increment_increment", soci::into(mIdIncrement);
+		}
 		mInsertReq[SqlRegistrationEventLogId] =
 		    "INSERT INTO event_registration_log VALUES (" + lastIdFunction + ", :typeId, :contacts)";
 
@@ -397,8 +522,173 @@ void DataBaseEventLogWriter::writeEventFromQueue() {
 	mMutex.lock();
 	auto evLog = mListLogs.front();
 	mListLogs.pop();
+	if (mCountQueued) mCountQueued->set(mListLogs.size());
 	mMutex.unlock();
 	EventLogWriter::write(evLog);
+	countEvents(mCountFlushed, 1);
+}
+
+void DataBaseEventLogWriter::writeBatchesFromQueue(bool untilEmpty) {
+	do {
+		vector<shared_ptr<const EventLogWriteDispatcher>> events{};
+		{
+			lock_guard<mutex> lock{mMutex};
+			for (; !mListLogs.empty() && events.size() < mBatchSize; mListLogs.pop()) {
+				events.push_back(std::move(mListLogs.front()));
+			}
+			if (mCountQueued) mCountQueued->set(mListLogs.size());
+		}
+		if (events.empty()) return;
+
+		BatchBuilder batch{};
+		for (const auto& evLog : events) {
+			batch.write(evLog);
+		}
+		if (writeBatch(batch)) {
+			countEvents(mCountFlushed, events.size());
+		} else {
+			SLOGE << "DataBaseEventLogWriter: failed to write a batch of " << events.size() << " events";
+			countEvents(mCountDropped, events.size());
+		}
+	} while (untilEmpty);
+}
+
+bool DataBaseEventLogWriter::writeBatch(BatchBuilder& batch) {
+	if (batch.size() == 0) return true;
+
+	soci::session session{*mConnectionPool};
+	// A transient error, a deadlock for instance, is retried once.
+	for (auto attempt = 0; attempt < 2; ++attempt) {
+		const bool written = DB_TRANSACTION(&session) {
+			writeEventRows(session, batch);
+			executeMultiRow(session, "INSERT INTO event_registration_log (id, type_id, contacts) VALUES ",
+			                "(:id, :typeId, :contacts)", "", batch.mRegistrations,
+			                [](soci::statement& st, const RegistrationRow& row, const string& suffix) {
+				                st.exchange(soci::use(row.id, "id" + suffix));
+				                st.exchange(soci::use(row.typeId, "typeId" + suffix));
+				                st.exchange(soci::use(row.contacts, "contacts" + suffix));
+				                return row.contacts.size();
+			                });
+			executeMultiRow(session, "INSERT INTO event_call_log (id, cancelled) VALUES ", "(:id, :cancelled)", "",
+			                batch.mCalls, [](soci::statement& st, const CallRow& row, const string& suffix) {
+				                st.exchange(soci::use(row.id, "id" + suffix));
+				                st.exchange(soci::use(row.cancelled, "cancelled" + suffix));
+				                return row.cancelled.size();
+			                });
+			executeMultiRow(session, "INSERT INTO event_message_log (id, type_id, uri) VALUES ",
+			                "(:id, :typeId, :uri)", "", batch.mMessages,
+			                [](soci::statement& st, const MessageRow& row, const string& suffix) {
+				                st.exchange(soci::use(row.id, "id" + suffix));
+				                st.exchange(soci::use(row.typeId, "typeId" + suffix));
+				                st.exchange(soci::use(row.uri, "uri" + suffix));
+				                return row.uri.size();
+			                });
+			executeMultiRow(session, "INSERT INTO event_auth_log (id, method, origin, user_exists) VALUES ",
+			                "(:id, :method, :origin, :userExists)", "", batch.mAuths,
+			                [](soci::statement& st, const AuthRow& row, const string& suffix) {
+				                st.exchange(soci::use(row.id, "id" + suffix));
+				                st.exchange(soci::use(row.method, "method" + suffix));
+				                st.exchange(soci::use(row.origin, "origin" + suffix));
+				                st.exchange(soci::use(row.userExists, "userExists" + suffix));
+				                return row.method.size() + row.origin.size();
+			                });
+			executeMultiRow(session, "INSERT INTO event_call_quality_statistics_log (id, report) VALUES ",
+			                "(:id, :report)", "", batch.mCallQualities,
+			                [](soci::statement& st, const CallQualityRow& row, const string& suffix) {
+				                st.exchange(soci::use(row.id, "id" + suffix));
+				                st.exchange(soci::use(row.report, "report" + suffix));
+				                return row.report.size();
+			                });
+			tr.commit();
+		};
+		if (written) return true;
+	}
+	return false;
+}
+
+void DataBaseEventLogWriter::writeEventRows(soci::session& session, BatchBuilder& batch) {
+	static const string kColumns{
+	    "INSERT INTO event_log (type_id, sip_from, sip_to, user_agent, date, status_code, reason, completed, call_id, "
+	    "priority) VALUES "};
+	static const string kRowTemplate{
+	    "(:typeId, :sipFrom, :sipTo, :userAgent, :date, :statusCode, :reason, :completed, :callId, :priority)"};
+	const auto bind = [](soci::statement& st, const EventRow& row, const string& suffix) {
+		st.exchange(soci::use(row.typeId, "typeId" + suffix));
+		st.exchange(soci::use(row.from, "sipFrom" + suffix));
+		st.exchange(soci::use(row.to, "sipTo" + suffix));
+		st.exchange(soci::use(row.userAgent, "userAgent" + suffix));
+		st.exchange(soci::use(row.date, "date" + suffix));
+		st.exchange(soci::use(row.statusCode, "statusCode" + suffix));
+		st.exchange(soci::use(row.reason, "reason" + suffix));
+		st.exchange(soci::use(row.completed, "completed" + suffix));
+		st.exchange(soci::use(row.callId, "callId" + suffix));
+		st.exchange(soci::use(row.priority, "priority" + suffix));
+		return row.from.size() + row.to.size() + row.userAgent.size() + row.reason.size() + row.callId.size();
+	};
+
+	auto& events = batch.mEvents;
+	if (mBatchIds == BatchIds::Returning) {
+		for (auto& row : events) {
+			soci::statement st{session};
+			bind(st, row, "");
+			st.exchange(soci::into(row.id));
+			st.alloc();
+			st.prepare(kColumns + kRowTemplate + " RETURNING id");
+			st.define_and_bind();
+			st.execute(true);
+		}
+	} else {
+		// Ids of a multi-row insert are consecutive, whatever the concurrent inserts of other writers.
+		executeMultiRow(session, kColumns, kRowTemplate, "", events, bind,
+		                [this, &session, &events](size_t firstRow, size_t rowCount) {
+			                long long lastId{};
+			                session << "SELECT " + mLastIdFunction, soci::into(lastId);
+			                const auto firstId = mBatchIds == BatchIds::LastIdIsFirstRow
+			                                         ? lastId
+			                                         : lastId - static_cast<long long>(rowCount - 1) * mIdIncrement;
+			                for (size_t i = 0; i < rowCount; ++i) {
+				                events[firstRow + i].id = firstId + static_cast<long long>(i) * mIdIncrement;
+			                }
+		                });
+	}
+	batch.propagateIds();
+}
+
+void DataBaseEventLogWriter::countEvents(StatCounter64* counter, size_t count) {
+	if (counter) counter->add(count);
+}
+
+void DataBaseEventLogWriter::setStatCounters(StatCounter64* queued, StatCounter64* flushed, StatCounter64* dropped) {
+	lock_guard<mutex> lock{mMutex};
+	mCountQueued = queued;
+	mCountFlushed = flushed;
+	mCountDropped = dropped;
+}
+
+void DataBaseEventLogWriter::enableBatching(const std::shared_ptr<sofiasip::SuRoot>& root,
+                                            unsigned int batchSize,
+                                            std::chrono::milliseconds batchMaxDelay) {
+	lock_guard<mutex> lock{mMutex};
+	mBatchSize = max(batchSize, 1u);
+	mRoot = root;
+	mBatchFlushTimer = make_shared<sofiasip::Timer>(root, batchMaxDelay);
+}
+
+void DataBaseEventLogWriter::scheduleBatchFlush() {
+	// Events may be written from any thread, the timer is run by the main loop.
+	mRoot->addToMainLoop([this, weakTimer = weak_ptr<sofiasip::Timer>{mBatchFlushTimer}] {
+		const auto timer = weakTimer.lock();
+		if (!timer) return;
+		timer->set([this] {
+			{
+				lock_guard<mutex> lock{mMutex};
+				mBatchFlushScheduled = false;
+			}
+			if (!mThreadPool->run([this] { writeBatchesFromQueue(true); })) {
+				LOGE("DataBaseEventLogWriter: unable to enqueue batch flush!");
+			}
+		});
+	});
 }
 
 void DataBaseEventLogWriter::write(const std::shared_ptr<const EventLogWriteDispatcher>& evLog) {
@@ -406,13 +696,31 @@ void DataBaseEventLogWriter::write(const std::shared_ptr<const EventLogWriteDisp
 
 	if (mListLogs.size() < mMaxQueueSize) {
 		mListLogs.push(evLog);
+		if (mCountQueued) mCountQueued->set(mListLogs.size());
+
+		if (mBatchSize <= 1) {
+			mMutex.unlock();
+
+			// Save event in database.
+			if (!mThreadPool->run(bind(&DataBaseEventLogWriter::writeEventFromQueue, this))) {
+				LOGE("DataBaseEventLogWriter: unable to enqueue event!");
+			}
+			return;
+		}
+
+		// A full batch is written right away. Otherwise, the first event queued since the last flush waits for the
+		// following ones, then the flush empties the queue.
+		const auto batchIsFull = mListLogs.size() % mBatchSize == 0;
+		const auto scheduleFlush = !mBatchFlushScheduled;
+		mBatchFlushScheduled = true;
 		mMutex.unlock();
 
-		// Save event in database.
-		if (!mThreadPool->run(bind(&DataBaseEventLogWriter::writeEventFromQueue, this))) {
-			LOGE("DataBaseEventLogWriter: unable to enqueue event!");
+		if (batchIsFull && !mThreadPool->run([this] { writeBatchesFromQueue(false); })) {
+			LOGE("DataBaseEventLogWriter: unable to enqueue batch!");
 		}
+		if (scheduleFlush) scheduleBatchFlush();
 	} else {
+		if (mCountDropped) ++(*mCountDropped);
 		mMutex.unlock();
 		LOGE("DataBaseEventLogWriter: too many events in queue! (%i)", (int)mMaxQueueSize);
 	}
@@ -7,18 +7,24 @@
 #include "event-log-writer.hh"
 
 #include <array>
+#include <chrono>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <vector>
 
 #include <soci/soci.h>
 
+#include "flexisip/sofia-wrapper/su-root.hh"
+#include "flexisip/sofia-wrapper/timer.hh"
+
 #include "eventlogs/events/event-log-write-dispatcher.hh"
 #include "utils/thread/thread-pool.hh"
 
 namespace flexisip {
 
 class EventLog;
+class StatCounter64;
 
 class DataBaseEventLogWriter : public EventLogWriter {
 public:
@@ -27,12 +33,35 @@ public:
 	                       unsigned int maxQueueSize,
 	                       unsigned int nbThreadsMax);
 
+	/**
+	 * If batchSize is greater than 1, queued events are written by batches of up to batchSize events, with multi-row
+	 * inserts in a single transaction. A batch is written as soon as it is full, or batchMaxDelay after its first
+	 * event otherwise, by a timer of the main loop.
+	 */
+	void enableBatching(const std::shared_ptr<sofiasip::SuRoot>& root,
+	                    unsigned int batchSize,
+	                    std::chrono::milliseconds batchMaxDelay);
+
 	void write(const std::shared_ptr<const EventLogWriteDispatcher>&) override;
 	bool isReady() const {
 		return mIsReady;
 	}
 
+	/**
+	 * @param queued number of events waiting to be written.
+	 * @param flushed number of events written in database.
+	 * @param dropped number of events that could not be queued or written.
+	 */
+	void setStatCounters(StatCounter64* queued, StatCounter64* flushed, StatCounter64* dropped);
+
 private:
+	// How the ids given by the database to the event_log rows of a batch are found.
+	enum class BatchIds {
+		LastIdIsFirstRow, // The last id function returns the id of the first row of a multi-row insert.
+		LastIdIsLastRow,  // The last id function returns the id of the last row of a multi-row insert.
+		Returning,        // Rows are inserted one by one, with a RETURNING clause.
+	};
+
 	class BackendInfo {
 	public:
 		BackendInfo() noexcept;
@@ -50,6 +79,9 @@ private:
 		const std::string& lastIdFunction() const noexcept {
 			return mLastIdFunction;
 		}
+		BatchIds batchIds() const noexcept {
+			return mBatchIds;
+		}
 		const std::string& onConfflictType() const noexcept {
 			return mOnConflictType;
 		}
@@ -70,6 +102,7 @@ private:
 		std::string mInsertPrefix{};
 		std::string mPrimaryKeyIncrementType{};
 		std::string mLastIdFunction{};
+		BatchIds mBatchIds{BatchIds::LastIdIsFirstRow};
 		std::string mOnConflictType{};
 		std::string mTableNamesQuery{};
 	};
@@ -89,6 +122,8 @@ private:
 		PostgresqlInfo() noexcept;
 	};
 
+	class BatchBuilder;
+
 	static void writeEventLog(soci::session& session, const EventLog&, int typeId);
 
 	void write(const RegistrationLog&) override;
@@ -98,15 +133,34 @@ private:
 	void write(const CallQualityStatisticsLog&) override;
 
 	void writeEventFromQueue();
+	/**
+	 * Write the queued events by batches, until the queue is empty or, if untilEmpty is false, after one batch.
+	 */
+	void writeBatchesFromQueue(bool untilEmpty);
+	bool writeBatch(BatchBuilder& batch);
+	// Insert the event_log rows of a batch, and set the ids the database gave them to all the rows of the batch.
+	void writeEventRows(soci::session& session, BatchBuilder& batch);
+	void scheduleBatchFlush();
+	void countEvents(StatCounter64* counter, std::size_t count);
 
 	bool mIsReady{false};
 	std::mutex mMutex{};
 	std::queue<std::shared_ptr<const EventLogWriteDispatcher>> mListLogs{};
+	bool mBatchFlushScheduled{false}; // protected by mMutex
+	StatCounter64* mCountQueued{nullptr};
+	StatCounter64* mCountFlushed{nullptr};
+	StatCounter64* mCountDropped{nullptr};
 
 	std::unique_ptr<soci::connection_pool> mConnectionPool{};
 	std::unique_ptr<ThreadPool> mThreadPool{};
 
 	unsigned int mMaxQueueSize{0};
+	unsigned int mBatchSize{1};
+	std::shared_ptr<sofiasip::SuRoot> mRoot{};
+	std::shared_ptr<sofiasip::Timer> mBatchFlushTimer{}; // main loop only
+	std::string mLastIdFunction{};
+	BatchIds mBatchIds{BatchIds::LastIdIsFirstRow};
+	long long mIdIncrement{1};
 
 	std::array<std::string, 5> mInsertReq{};
 
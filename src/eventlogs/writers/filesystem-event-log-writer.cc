@@ -4,7 +4,18 @@
 
 #include "filesystem-event-log-writer.hh"
 
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "eventlogs/events/eventlogs.hh"
 #include "flexisip/logmanager.hh"
@@ -24,6 +35,45 @@ bool createDirectoryIfNotExist(const char* path) {
 	return true;
 }
 
+/**
+ * Open a log file for appending, after creating the directories of its path under root that are not known yet.
+ */
+int openLogFile(const string& root, const string& path, unordered_set<string>& knownDirectories) {
+	const auto createDirectories = [&]() {
+		for (auto slash = path.find('/', root.size() + 1); slash != string::npos; slash = path.find('/', slash + 1)) {
+			auto directory = path.substr(0, slash);
+			if (knownDirectories.count(directory)) continue;
+			if (!createDirectoryIfNotExist(directory.c_str())) return false;
+			knownDirectories.insert(std::move(directory));
+		}
+		return true;
+	};
+	if (!createDirectories()) return -1;
+	auto fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	if (fd == -1 && errno == ENOENT) {
+		// A known directory was removed meanwhile, e.g. by a cleanup of old logs.
+		knownDirectories.clear();
+		if (!createDirectories()) return -1;
+		fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	}
+	if (fd == -1) {
+		LOGE("Cannot open %s: %s", path.c_str(), strerror(errno));
+	}
+	return fd;
+}
+
+bool writeAll(int fd, const string& data) {
+	for (size_t written = 0; written < data.size();) {
+		const auto result = ::write(fd, data.data() + written, data.size() - written);
+		if (result == -1) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		written += result;
+	}
+	return true;
+}
+
 struct PrettyTime {
 	PrettyTime(time_t t) : _t(t) {
 	}
@@ -89,6 +139,135 @@ std::ostream& operator<<(std::ostream& ostr, MessageLog::ReportType type) {
 
 } // namespace
 
+/**
+ * Appends the lines of all the log files from a thread of its own, in one write per file and per flush interval.
+ */
+class FilesystemEventLogWriter::BackgroundWriter {
+public:
+	BackgroundWriter(const std::string& rootPath,
+	                 unsigned int maxOpenFiles,
+	                 std::chrono::milliseconds flushInterval,
+	                 std::chrono::milliseconds fsyncInterval)
+	    : mRootPath{rootPath}, mMaxOpenFiles{max(maxOpenFiles, 1u)}, mFlushInterval{flushInterval},
+	      mFsyncInterval{fsyncInterval}, mThread{[this] { run(); }} {
+	}
+	~BackgroundWriter() {
+		{
+			lock_guard<mutex> lock{mMutex};
+			mStopping = true;
+		}
+		mCondition.notify_one();
+		mThread.join();
+	}
+
+	void append(const std::string& path, const std::string& line) {
+		bool wakeUp = false;
+		{
+			lock_guard<mutex> lock{mMutex};
+			mPending.emplace_back(path, line);
+			mPendingSize += line.size();
+			wakeUp = kMaxPendingSize <= mPendingSize;
+		}
+		if (wakeUp) mCondition.notify_one();
+	}
+
+private:
+	// Lines waiting for the next flush beyond this size are written right away.
+	static constexpr size_t kMaxPendingSize = 1024 * 1024;
+
+	struct OpenFile {
+		int fd;
+		std::string buffer;
+		bool needsSync;
+		std::list<std::string>::iterator lruPosition;
+	};
+
+	void run() {
+		auto nextSync = chrono::steady_clock::now() + mFsyncInterval;
+		unique_lock<mutex> lock{mMutex};
+		while (true) {
+			mCondition.wait_for(lock, mFlushInterval, [this] { return mStopping || kMaxPendingSize <= mPendingSize; });
+			auto pending = std::move(mPending);
+			mPending.clear();
+			mPendingSize = 0;
+			const auto stopping = mStopping;
+			lock.unlock();
+
+			for (const auto& [path, line] : pending) {
+				if (auto* file = getFile(path)) file->buffer += line;
+			}
+			for (auto& [path, file] : mFiles) {
+				flush(path, file);
+			}
+			if ((mFsyncInterval.count() != 0 && nextSync <= chrono::steady_clock::now()) || stopping) {
+				for (auto& [path, file] : mFiles) {
+					sync(file);
+				}
+				nextSync = chrono::steady_clock::now() + mFsyncInterval;
+			}
+			if (stopping) break;
+			lock.lock();
+		}
+		for (auto& [path, file] : mFiles) {
+			close(file.fd);
+		}
+	}
+
+	OpenFile* getFile(const std::string& path) {
+		if (auto it = mFiles.find(path); it != mFiles.end()) {
+			mLru.splice(mLru.begin(), mLru, it->second.lruPosition);
+			return &it->second;
+		}
+		if (mMaxOpenFiles <= mFiles.size()) {
+			auto& evicted = mFiles.at(mLru.back());
+			flush(mLru.back(), evicted);
+			sync(evicted);
+			close(evicted.fd);
+			mFiles.erase(mLru.back());
+			mLru.pop_back();
+		}
+		const auto fd = openLogFile(mRootPath, path, mKnownDirectories);
+		if (fd == -1) return nullptr;
+		mLru.push_front(path);
+		return &mFiles.emplace(path, OpenFile{fd, {}, false, mLru.begin()}).first->second;
+	}
+
+	void flush(const std::string& path, OpenFile& file) {
+		if (file.buffer.empty()) return;
+		if (!writeAll(file.fd, file.buffer)) {
+			LOGE("Fail to write event logs to %s: %s", path.c_str(), strerror(errno));
+		}
+		file.buffer.clear();
+		file.needsSync = true;
+	}
+
+	void sync(OpenFile& file) {
+		if (!file.needsSync || mFsyncInterval.count() == 0) return;
+		if (fdatasync(file.fd) == -1) {
+			LOGE("Fail to sync event logs: %s", strerror(errno));
+		}
+		file.needsSync = false;
+	}
+
+	const std::string mRootPath;
+	const size_t mMaxOpenFiles;
+	const std::chrono::milliseconds mFlushInterval;
+	const std::chrono::milliseconds mFsyncInterval;
+
+	std::mutex mMutex{};
+	std::condition_variable mCondition{};
+	std::vector<std::pair<std::string, std::string>> mPending{}; // protected by mMutex
+	size_t mPendingSize{0};                                       // protected by mMutex
+	bool mStopping{false};                                        // protected by mMutex
+
+	// Only used by the thread.
+	std::unordered_map<std::string, OpenFile> mFiles{};
+	std::list<std::string> mLru{}; // Paths of mFiles, most recently used first.
+	std::unordered_set<std::string> mKnownDirectories{};
+
+	std::thread mThread;
+};
+
 FilesystemEventLogWriter::FilesystemEventLogWriter(const std::string& rootpath) : mRootPath(rootpath) {
 	if (rootpath[0] != '/') {
 		LOGE("Path for event log writer must be absolute.");
@@ -99,67 +278,66 @@ FilesystemEventLogWriter::FilesystemEventLogWriter(const std::string& rootpath)
 	mIsReady = true;
 }
 
-int FilesystemEventLogWriter::openPath(const url_t* uri, const char* kind, time_t curtime, int errorcode) {
+// Flushes the logs of the background writer, if any.
+FilesystemEventLogWriter::~FilesystemEventLogWriter() = default;
+
+void FilesystemEventLogWriter::enableBackgroundWriter(unsigned int maxOpenFiles,
+                                                      std::chrono::milliseconds flushInterval,
+                                                      std::chrono::milliseconds fsyncInterval) {
+	mBackgroundWriter = make_unique<BackgroundWriter>(mRootPath, maxOpenFiles, flushInterval, fsyncInterval);
+}
+
+string FilesystemEventLogWriter::getPath(const url_t* uri, const char* kind, time_t curtime, int errorcode) {
 	ostringstream path;
 
 	if (errorcode == 0) {
 		const char* username = uri->url_user;
-		const char* domain = uri->url_host;
-
-		path << mRootPath << "/users";
-
-		if (!createDirectoryIfNotExist(path.str().c_str())) return -1;
-
-		path << "/" << domain;
-
-		if (!createDirectoryIfNotExist(path.str().c_str())) return -1;
-
 		if (!username) username = "anonymous";
-
-		path << "/" << username;
-
-		if (!createDirectoryIfNotExist(path.str().c_str())) return -1;
-		path << "/" << kind;
-
-		if (!createDirectoryIfNotExist(path.str().c_str())) return -1;
+		path << mRootPath << "/users/" << uri->url_host << "/" << username << "/" << kind;
 	} else {
-		path << mRootPath << "/"
-		     << "errors/";
-		if (!createDirectoryIfNotExist(path.str().c_str())) return -1;
-		path << kind;
-		if (!createDirectoryIfNotExist(path.str().c_str())) return -1;
-		path << "/" << errorcode;
-		if (!createDirectoryIfNotExist(path.str().c_str())) return -1;
+		path << mRootPath << "/errors/" << kind << "/" << errorcode;
 	}
 
-	struct tm tm;
-	localtime_r(&curtime, &tm);
-	path << "/" << 1900 + tm.tm_year << "-" << std::setfill('0') << std::setw(2) << tm.tm_mon + 1 << "-"
-	     << std::setfill('0') << std::setw(2) << tm.tm_mday << ".log";
+	if (curtime < mDayStart || mDayEnd <= curtime) {
+		struct tm tm;
+		localtime_r(&curtime, &tm);
+		ostringstream day;
+		day << 1900 + tm.tm_year << "-" << std::setfill('0') << std::setw(2) << tm.tm_mon + 1 << "-"
+		    << std::setfill('0') << std::setw(2) << tm.tm_mday;
+		mDay = day.str();
+		tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+		tm.tm_isdst = -1;
+		mDayStart = mktime(&tm);
+		tm.tm_mday++;
+		tm.tm_isdst = -1;
+		mDayEnd = mktime(&tm);
+	}
+	path << "/" << mDay << ".log";
+	return path.str();
+}
 
-	int fd = open(path.str().c_str(), O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR);
-	if (fd == -1) {
-		LOGE("Cannot open %s: %s", path.str().c_str(), strerror(errno));
-		return -1;
+void FilesystemEventLogWriter::append(const std::string& path, const std::string& line, const char* kind) {
+	if (mBackgroundWriter) {
+		mBackgroundWriter->append(path, line);
+		return;
 	}
-	return fd;
+	const auto fd = openLogFile(mRootPath, path, mKnownDirectories);
+	if (fd == -1) return;
+	if (!writeAll(fd, line)) {
+		LOGE("Fail to write %s log: %s", kind, strerror(errno));
+	}
+	close(fd);
 }
 
 void FilesystemEventLogWriter::write(const RegistrationLog& rlog) {
 	const char* label = "registers";
-	int fd = openPath(rlog.getFrom()->a_url, label, rlog.getDate());
-	if (fd == -1) return;
-
 	ostringstream msg;
 	msg << PrettyTime(rlog.getDate()) << ": " << rlog.getType() << " " << rlog.getFrom();
 	if (rlog.getContacts()) msg << " (" << rlog.getContacts()->m_url << ") ";
 	if (rlog.getUserAgent()) msg << rlog.getUserAgent();
 	msg << endl;
 
-	if (::write(fd, msg.str().c_str(), msg.str().size()) == -1) {
-		LOGE("Fail to write registration log: %s", strerror(errno));
-	}
-	close(fd);
+	append(getPath(rlog.getFrom()->a_url, label, rlog.getDate()), msg.str(), "registration");
 	if (rlog.getStatusCode() >= 300) {
 		writeErrorLog(rlog, label, msg.str());
 	}
@@ -167,9 +345,6 @@ void FilesystemEventLogWriter::write(const RegistrationLog& rlog) {
 
 void FilesystemEventLogWriter::write(const CallLog& calllog) {
 	const char* label = "calls";
-	int fd1 = openPath(calllog.getFrom()->a_url, label, calllog.getDate());
-	int fd2 = openPath(calllog.getTo()->a_url, label, calllog.getDate());
-
 	ostringstream msg;
 
 	msg << PrettyTime(calllog.getDate()) << ": " << calllog.getFrom() << " --> " << calllog.getTo() << " ";
@@ -177,18 +352,12 @@ void FilesystemEventLogWriter::write(const CallLog& calllog) {
 	else msg << calllog.getStatusCode() << " " << calllog.getReason();
 	msg << endl;
 
-	if (fd1 == -1 || ::write(fd1, msg.str().c_str(), msg.str().size()) == -1) {
-		LOGE("Fail to write registration log: %s", strerror(errno));
-	}
+	append(getPath(calllog.getFrom()->a_url, label, calllog.getDate()), msg.str(), "call");
 	// Avoid to write logs for users that possibly do not exist.
 	// However the error will be reported in the errors directory.
 	if (calllog.getStatusCode() != 404) {
-		if (fd2 == -1 || ::write(fd2, msg.str().c_str(), msg.str().size()) == -1) {
-			LOGE("Fail to write registration log: %s", strerror(errno));
-		}
+		append(getPath(calllog.getTo()->a_url, label, calllog.getDate()), msg.str(), "call");
 	}
-	if (fd1 != -1) close(fd1);
-	if (fd2 != -1) close(fd2);
 	if (calllog.getStatusCode() >= 300) {
 		writeErrorLog(calllog, label, msg.str());
 	}
@@ -204,34 +373,12 @@ void FilesystemEventLogWriter::write(const MessageLog& mlog) {
 	if (mlog.getUri()) msg << " (" << mlog.getUri() << ") ";
 	msg << mlog.getStatusCode() << " " << mlog.getReason() << endl;
 
-	if (mlog.getReportType() == MessageLog::ReportType::ResponseToSender) {
-		int fd = openPath(mlog.getFrom()->a_url, label, mlog.getDate());
-		if (fd != -1) {
-			if (::write(fd, msg.str().c_str(), msg.str().size()) == -1) {
-				LOGE("Fail to write message log: %s", strerror(errno));
-			}
-			close(fd);
-		}
-	} else { // MessageLog::DeliveredToUser
-		/*the event is added into the sender's log file and the receiver's log file, for convenience*/
-		int fd = openPath(mlog.getFrom()->a_url, label, mlog.getDate());
-		if (fd != -1) {
-			if (::write(fd, msg.str().c_str(), msg.str().size()) == -1) {
-				LOGE("Fail to write message log: %s", strerror(errno));
-			}
-			close(fd);
-		}
-		// Avoid to write logs for users that possibly do not exist.
-		// However the error will be reported in the errors directory.
-		if (mlog.getStatusCode() != 404) {
-			fd = openPath(mlog.getTo()->a_url, label, mlog.getDate());
-			if (fd != -1) {
-				if (::write(fd, msg.str().c_str(), msg.str().size()) == -1) {
-					LOGE("Fail to write message log: %s", strerror(errno));
-				}
-				close(fd);
-			}
-		}
+	append(getPath(mlog.getFrom()->a_url, label, mlog.getDate()), msg.str(), "message");
+	/*when delivered to user, the event is added into the receiver's log file too, for convenience*/
+	// Avoid to write logs for users that possibly do not exist.
+	// However the error will be reported in the errors directory.
+	if (mlog.getReportType() == MessageLog::ReportType::ResponseFromRecipient && mlog.getStatusCode() != 404) {
+		append(getPath(mlog.getTo()->a_url, label, mlog.getDate()), msg.str(), "message");
 	}
 	if (mlog.getStatusCode() >= 300) {
 		writeErrorLog(mlog, label, msg.str());
@@ -240,8 +387,6 @@ void FilesystemEventLogWriter::write(const MessageLog& mlog) {
 
 void FilesystemEventLogWriter::write(const CallQualityStatisticsLog& mlog) {
 	const char* label = "statistics_reports";
-	int fd = openPath(mlog.getFrom()->a_url, label, mlog.getDate());
-	if (fd == -1) return;
 	ostringstream msg;
 
 	msg << PrettyTime(mlog.getDate()) << " ";
@@ -249,11 +394,7 @@ void FilesystemEventLogWriter::write(const CallQualityStatisticsLog& mlog) {
 	msg << mlog.getStatusCode() << " " << mlog.getReason() << ": ";
 	msg << mlog.getReport() << endl;
 
-	if (::write(fd, msg.str().c_str(), msg.str().size()) == -1) {
-		LOGE("Fail to write registration log: %s", strerror(errno));
-	}
-
-	close(fd);
+	append(getPath(mlog.getFrom()->a_url, label, mlog.getDate()), msg.str(), "call quality statistics");
 	if (mlog.getStatusCode() >= 300) {
 		writeErrorLog(mlog, label, msg.str());
 	}
@@ -269,24 +410,13 @@ void FilesystemEventLogWriter::write(const AuthLog& alog) {
 	msg << alog.getStatusCode() << " " << alog.getReason() << endl;
 
 	if (alog.userExists()) {
-		int fd = openPath(alog.getFrom()->a_url, label, alog.getDate());
-		if (fd != -1) {
-			if (::write(fd, msg.str().c_str(), msg.str().size()) == -1) {
-				LOGE("Fail to write auth log: %s", strerror(errno));
-			}
-			close(fd);
-		}
+		append(getPath(alog.getFrom()->a_url, label, alog.getDate()), msg.str(), "auth");
 	}
 	writeErrorLog(alog, "auth", msg.str());
 }
 
 void FilesystemEventLogWriter::writeErrorLog(const EventLog& log, const char* kind, const std::string& logstr) {
-	int fd = openPath(NULL, kind, log.getDate(), log.getStatusCode());
-	if (fd == -1) return;
-	if (::write(fd, logstr.c_str(), logstr.size()) == -1) {
-		LOGE("Fail to write error log: %s", strerror(errno));
-	}
-	close(fd);
+	append(getPath(nullptr, kind, log.getDate(), log.getStatusCode()), logstr, "error");
 }
 
 } // namespace flexisip
@@ -6,7 +6,11 @@
 
 #include "event-log-writer.hh"
 
+#include <chrono>
+#include <ctime>
+#include <memory>
 #include <string>
+#include <unordered_set>
 
 #include <sofia-sip/sip.h>
 
@@ -17,13 +21,32 @@ class EventLog;
 class FilesystemEventLogWriter : public EventLogWriter {
 public:
 	FilesystemEventLogWriter(const std::string& rootpath);
+	~FilesystemEventLogWriter() override;
 
 	bool isReady() const {
 		return mIsReady;
 	}
 
+	/**
+	 * Write the logs from a background thread instead of the calling one. The lines of each file are buffered and
+	 * appended every flushInterval, to files kept open in a cache of maxOpenFiles files. Files are synced to disk every
+	 * fsyncInterval, or never if it is zero.
+	 */
+	void enableBackgroundWriter(unsigned int maxOpenFiles,
+	                            std::chrono::milliseconds flushInterval,
+	                            std::chrono::milliseconds fsyncInterval);
+
 private:
-	int openPath(const url_t* uri, const char* kind, time_t curtime, int errorcode = 0);
+	class BackgroundWriter;
+
+	/**
+	 * @return the path of the file of the day of curtime, for a user or for errors.
+	 */
+	std::string getPath(const url_t* uri, const char* kind, time_t curtime, int errorcode = 0);
+	/**
+	 * Append a line to the file, from the background thread if it is enabled.
+	 */
+	void append(const std::string& path, const std::string& line, const char* kind);
 
 	void write(const RegistrationLog&) override;
 	void write(const CallLog&) override;
@@ -35,6 +58,12 @@ private:
 
 	std::string mRootPath{};
 	bool mIsReady{false};
+	// Name of the file of the current day, computed again only when an event is out of [mDayStart, mDayEnd).
+	std::string mDay{};
+	time_t mDayStart{0};
+	time_t mDayEnd{0};
+	std::unordered_set<std::string> mKnownDirectories{}; // Only used without background writer.
+	std::unique_ptr<BackgroundWriter> mBackgroundWriter{};
 };
 
 } // namespace flexisip
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <optional>
 #include <string_view>
 
@@ -20,6 +22,15 @@ public:
 	                         const std::string& apiPrefix,
 	                         const std::string& token);
 
+	/**
+	 * Send the requests by batches instead of one by one, see flexiapi::FlexiStats::enableBatching().
+	 */
+	void enableBatching(const std::shared_ptr<sofiasip::SuRoot>& root,
+	                    std::chrono::milliseconds batchWindow,
+	                    std::size_t maxPendingRequests) {
+		mRestClient.enableBatching(root, batchWindow, maxPendingRequests);
+	}
+
 private:
 	void write(const CallStartedEventLog&) override;
 	void write(const CallRingingEventLog&) override;
@@ -1,59 +1,37 @@
-/** Copyright (C) 2010-2022 Belledonne Communications SARL
+/** Copyright (C) 2010-2024 Belledonne Communications SARL
     SPDX-License-Identifier: AGPL-3.0-or-later
 
 	You can set your editor to Lua for this file to get syntax highlighting.
 
 	Brief:
-		Redis script to return all ExtendedContacts that are about to expire.	
-	
+		Redis script to return the ExtendedContacts of one page of the expiry
+		index of the contacts with push parameters.
+
 	KEYS:
-		1: Records to match (usually equal to "fs:*" to match everything)
-		   Could arguably be hardcoded, but Redis's doc says a script should
-		   declare all the keys it accesses. [string]
-		   https://redis.io/docs/manual/programmability/eval-intro/#script-parameterization
+		1: Expiry index. A sorted set whose members are made of the Redis key
+		   of a Record and the unique id of one of its contacts, separated by a
+		   line feed, scored by the expiration time of the contact. [string]
+		2..: Records of the members of the page. [strings]
 	ARGV:
-		1: Target time (usually the current time). [Unix timestamp]
-		2: Threshold. Only ExtendedContacts that have passed that amount of their
-		   lifetime at ARGV[1] will be returned. [ratio between 0.0 and 1.0]
-	
+		1..: Unique ids of the contacts, ARGV[i] being a contact of the Record
+		     KEYS[i + 1]. [strings]
+
 	Implementation:
-		Loop on all redis keys (Records), then loop on the hash fields 2 by 2 to
-		get the ExtendedContacts (skipping the unique ids).
-		Parse SIP URI fields and keep contacts above target threshold.
-		/!\ Lua string patterns are not POSIX regexps
+		Fetch each contact with HGET. Members whose contact (or Record) no
+		longer exists are removed from the index.
+		Returns the contacts found. The caller reads the page of the index
+		beforehand, and filters the contacts on their lifetime.
 */
 
 R"lua(
-local current_time = tonumber(ARGV[1])
-local threshold_ratio = tonumber(ARGV[2])
-local expiring_contacts = {}
-local function insert_if_expiring(contact)
-	if not contact:find("pn%-provider=") and not contact:find("pn%-type=") then
-		return
-	end
-	local updatedAt = contact:match("updatedAt=(%d+)")
-	if not updatedAt then
-		return
-	end
-	local expires = contact:match("expires=(%d+)")
-	if not expires then
-		return
-	end
-	updatedAt, expires = tonumber(updatedAt), tonumber(expires)
-	local expiration_time = updatedAt + expires
-	local threshold_time = updatedAt + threshold_ratio * expires
-	if threshold_time < current_time and current_time < expiration_time then
-		table.insert(expiring_contacts, contact)
+local result = {}
+for i = 2, #KEYS do
+	local contact = redis.call("HGET", KEYS[i], ARGV[i - 1])
+	if contact then
+		table.insert(result, contact)
+	else
+		redis.call("ZREM", KEYS[1], KEYS[i] .. "\n" .. ARGV[i - 1])
 	end
 end
-
-local all_records = redis.call("KEYS", KEYS[1])
-for _, record in ipairs(all_records) do
-	local pairs = redis.call("HGETALL", record)
-	for i = 2, #pairs, 2 do
-		insert_if_expiring(pairs[i]);
-	end
-end
-
-return expiring_contacts
-)lua"
\ No newline at end of file
+return result
+)lua"
@@ -16,15 +16,202 @@
     along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <filesystem>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "flexi-stats.hh"
 
+#include "flexisip/sofia-wrapper/timer.hh"
+
+#include "utils/transport/http/http-response.hh"
+
 using namespace std;
 using namespace flexisip;
 using namespace flexiapi;
 using namespace nlohmann;
 
+/**
+ * Requests waiting to be sent by batches, see FlexiStats::enableBatching().
+ * A single batch is in flight at a time.
+ */
+class FlexiStats::Batcher : public enable_shared_from_this<Batcher> {
+public:
+	struct Request {
+		string method;
+		string path;
+		json body;
+		// Identifies the resource created or updated by the request, to coalesce its following updates. Empty if the
+		// request can't be coalesced.
+		string key;
+	};
+
+	Batcher(const shared_ptr<sofiasip::SuRoot>& root,
+	        const RestClient& restClient,
+	        const string& batchPath,
+	        chrono::milliseconds batchWindow,
+	        size_t maxPendingRequests)
+	    : mRestClient{restClient}, mBatchPath{batchPath}, mBatchWindow{batchWindow},
+	      mMaxPendingRequests{max<size_t>(maxPendingRequests, 1)}, mTimer{root, batchWindow} {
+	}
+
+	/**
+	 * Queue a request, or merge its body into the body of the pending request of the same key. If there is none, and
+	 * the request updates a part of a resource whose creation is pending (POST of parentKey), its body is merged into
+	 * the fields of that part instead.
+	 */
+	void add(Request&& request, const string& parentKey = "", const vector<string>& fieldsInParent = {}) {
+		if (!request.key.empty()) {
+			if (const auto pending = mPendingByKey.find(request.key); pending != mPendingByKey.end()) {
+				pending->second->body.merge_patch(request.body);
+				return;
+			}
+			// The pending request of the parent may be an update of the resource, which doesn't accept its parts.
+			if (const auto parent = mPendingByKey.find(parentKey);
+			    !parentKey.empty() && parent != mPendingByKey.end() && parent->second->method == "POST") {
+				auto* target = &parent->second->body;
+				for (const auto& field : fieldsInParent) {
+					target = &(*target)[field];
+				}
+				target->merge_patch(request.body);
+				return;
+			}
+		}
+		queue(std::move(request), mPendingRequests.end());
+		if (!mInFlight && !mTimer.isRunning()) {
+			mTimer.set([this] { flush(); }, mRetryDelay.count() != 0 ? mRetryDelay : mBatchWindow);
+		}
+	}
+
+private:
+	static constexpr chrono::milliseconds kMaxRetryDelay{60000};
+
+	void queue(Request&& request, list<Request>::iterator position) {
+		if (mMaxPendingRequests <= mPendingRequests.size()) {
+			const auto& oldest = mPendingRequests.front();
+			SLOGW << "FlexiStats: too many pending requests, dropping " << oldest.method << " " << oldest.path;
+			if (const auto indexed = mPendingByKey.find(oldest.key);
+			    indexed != mPendingByKey.end() && indexed->second == mPendingRequests.begin()) {
+				mPendingByKey.erase(indexed);
+			}
+			mPendingRequests.pop_front();
+		}
+		const auto key = request.key;
+		const auto inserted = mPendingRequests.insert(position, std::move(request));
+		// A request sent again must not receive the updates that follow a more recent request of the same key.
+		if (!key.empty()) mPendingByKey.emplace(key, inserted);
+	}
+
+	void flush() {
+		if (mInFlight || mPendingRequests.empty()) return;
+		vector<Request> batch{make_move_iterator(mPendingRequests.begin()), make_move_iterator(mPendingRequests.end())};
+		mPendingRequests.clear();
+		mPendingByKey.clear();
+		mInFlight = true;
+		if (mBulkSupported) sendBatch(std::move(batch));
+		else sendOneByOne(std::move(batch));
+	}
+
+	void sendBatch(vector<Request>&& batch) {
+		auto requests = json::array();
+		for (const auto& request : batch) {
+			requests.push_back({{"method", request.method}, {"path", request.path}, {"body", request.body}});
+		}
+		auto sharedBatch = make_shared<vector<Request>>(std::move(batch));
+		mRestClient.post(
+		    mBatchPath, requests,
+		    [weak = weak_from_this(), sharedBatch](const auto&, const shared_ptr<HttpResponse>& response) {
+			    const auto thiz = weak.lock();
+			    if (!thiz) return;
+			    const auto status = response->getStatusCode();
+			    if (status / 100 == 2) {
+				    SLOGI << "FlexiStats: batch of " << sharedBatch->size() << " requests successful";
+				    thiz->onSent();
+			    } else if (status == 404 || status == 405 || status == 501) {
+				    SLOGW << "FlexiStats: the server doesn't support batches (" << status
+				          << "), sending requests one by one";
+				    thiz->mBulkSupported = false;
+				    thiz->sendOneByOne(std::move(*sharedBatch));
+			    } else if (isRetriable(status)) {
+				    thiz->retry(std::move(*sharedBatch));
+			    } else {
+				    SLOGE << "FlexiStats: batch of " << sharedBatch->size() << " requests rejected (" << status << ")";
+				    thiz->onSent();
+			    }
+		    },
+		    [weak = weak_from_this(), sharedBatch](const auto&) {
+			    if (const auto thiz = weak.lock()) thiz->retry(std::move(*sharedBatch));
+		    });
+	}
+
+	void sendOneByOne(vector<Request>&& batch) {
+		auto remaining = make_shared<size_t>(batch.size());
+		auto failed = make_shared<map<size_t, Request>>(); // By position in the batch, to send them again in order.
+		for (size_t i = 0; i < batch.size(); ++i) {
+			auto request = make_shared<Request>(std::move(batch[i]));
+			const auto onDone = [weak = weak_from_this(), remaining, failed, request, i](bool sendAgain) {
+				const auto thiz = weak.lock();
+				if (!thiz) return;
+				if (sendAgain) failed->emplace(i, std::move(*request));
+				if (--*remaining != 0) return;
+				if (failed->empty()) return thiz->onSent();
+				vector<Request> requests{};
+				for (auto& [_, failedRequest] : *failed) {
+					requests.push_back(std::move(failedRequest));
+				}
+				thiz->retry(std::move(requests));
+			};
+			const auto onResponse = [onDone, request](const auto&, const shared_ptr<HttpResponse>& response) {
+				const auto status = response->getStatusCode();
+				if (status / 100 == 2)
+					SLOGI << "FlexiStats: " << request->method << " " << request->path << " successful";
+				else SLOGE << "FlexiStats: " << request->method << " " << request->path << " error (" << status << ")";
+				onDone(isRetriable(status));
+			};
+			const auto onError = [onDone](const auto&) { onDone(true); };
+			if (request->method == "POST") mRestClient.post(request->path, request->body, onResponse, onError);
+			else mRestClient.patch(request->path, request->body, onResponse, onError);
+		}
+	}
+
+	static bool isRetriable(int status) {
+		return status == 429 || 500 <= status;
+	}
+
+	void onSent() {
+		mInFlight = false;
+		mRetryDelay = chrono::milliseconds{0};
+		if (!mPendingRequests.empty()) mTimer.set([this] { flush(); }, mBatchWindow);
+	}
+
+	void retry(vector<Request>&& batch) {
+		mInFlight = false;
+		mRetryDelay = min(max(mRetryDelay * 2, max(mBatchWindow, chrono::milliseconds{100})), kMaxRetryDelay);
+		SLOGW << "FlexiStats: failed to send " << batch.size() << " requests, trying again in " << mRetryDelay.count()
+		      << "ms";
+		// Before the requests queued meanwhile, that may depend on them.
+		const auto position = mPendingRequests.begin();
+		for (auto& request : batch) {
+			queue(std::move(request), position);
+		}
+		mTimer.set([this] { flush(); }, mRetryDelay);
+	}
+
+	RestClient mRestClient;
+	const string mBatchPath;
+	const chrono::milliseconds mBatchWindow;
+	const size_t mMaxPendingRequests;
+	sofiasip::Timer mTimer;
+	list<Request> mPendingRequests{};
+	unordered_map<string, list<Request>::iterator> mPendingByKey{};
+	bool mInFlight{false};
+	bool mBulkSupported{true};
+	chrono::milliseconds mRetryDelay{0};
+};
+
 FlexiStats::FlexiStats(sofiasip::SuRoot& root,
                        const std::string& host,
                        const std::string& port,
@@ -40,7 +227,14 @@ FlexiStats::FlexiStats(sofiasip::SuRoot& root,
       mApiPrefix{filesystem::path{"/" + apiPrefix + "/."}.lexically_normal().string()} {
 }
 
+void FlexiStats::enableBatching(const shared_ptr<sofiasip::SuRoot>& root,
+                                chrono::milliseconds batchWindow,
+                                size_t maxPendingRequests) {
+	mBatcher = make_shared<Batcher>(root, mRestClient, toApiPath("batch"), batchWindow, maxPendingRequests);
+}
+
 void FlexiStats::postMessage(const Message& message) {
+	if (mBatcher) return mBatcher->add({"POST", toApiPath("messages"), message, "messages/" + message.id});
 	mRestClient.post(toApiPath("messages"), message,
 	                 "FlexiStats::postMessage request successful for id["s + message.id + "]",
 	                 "FlexiStats::postMessage request error for id["s + message.id + "]");
@@ -49,35 +243,50 @@ void FlexiStats::notifyMessageDeviceResponse(const string& messageId,
                                              const ApiFormattedUri& sipUri,
                                              const std::string deviceId,
                                              const MessageDeviceResponse& messageDeviceResponse) {
-	mRestClient.patch(toApiPath("messages/" + messageId + "/to/" + string(sipUri) + "/devices/" + deviceId),
-	                  messageDeviceResponse,
+	const auto path = "messages/" + messageId + "/to/" + string(sipUri) + "/devices/" + deviceId;
+	if (mBatcher)
+		return mBatcher->add({"PATCH", toApiPath(path), messageDeviceResponse, path}, "messages/" + messageId,
+		                     {"to", string(sipUri), deviceId});
+	mRestClient.patch(toApiPath(path), messageDeviceResponse,
 	                  "FlexiStats::notifyMessageDeviceResponse request successful for id["s + messageId + "]",
 	                  "FlexiStats::notifyMessageDeviceResponse request error for id["s + messageId + "]");
 }
 
 void FlexiStats::postCall(const Call& call) {
+	if (mBatcher) return mBatcher->add({"POST", toApiPath("calls"), call, "calls/" + call.id});
 	mRestClient.post(toApiPath("calls"), call, "FlexiStats::postCall request successful for id["s + call.id + "]",
 	                 "FlexiStats::postCall request error for id["s + call.id + "]");
 }
 void FlexiStats::updateCallDeviceState(const string& callId,
                                        const string& deviceId,
                                        const CallDeviceState& callDeviceState) {
-	mRestClient.patch(toApiPath("calls/" + callId + "/devices/" + deviceId), callDeviceState,
+	const auto path = "calls/" + callId + "/devices/" + deviceId;
+	if (mBatcher)
+		return mBatcher->add({"PATCH", toApiPath(path), callDeviceState, path}, "calls/" + callId,
+		                     {"devices", deviceId});
+	mRestClient.patch(toApiPath(path), callDeviceState,
 	                  "FlexiStats::updateCallDeviceState request successful for id["s + callId + "]",
 	                  "FlexiStats::updateCallDeviceState request error for id["s + callId + "]");
 }
 void FlexiStats::updateCallState(const string& callId, const ISO8601Date& endedAt) {
+	if (mBatcher)
+		return mBatcher->add({"PATCH", toApiPath("calls/" + callId), json{{"ended_at", endedAt}}, "calls/" + callId});
 	mRestClient.patch(toApiPath("calls/" + callId), optional<json>{json{{"ended_at", endedAt}}},
 	                  "FlexiStats::updateCallState request successful for id["s + callId + "]",
 	                  "FlexiStats::updateCallState request error for id["s + callId + "]");
 }
 
 void FlexiStats::postConference(const Conference& conference) {
+	if (mBatcher)
+		return mBatcher->add({"POST", toApiPath("conferences"), conference, "conferences/" + conference.id});
 	mRestClient.post(toApiPath("conferences"), conference,
 	                 "FlexiStats::postConference request successful for id["s + conference.id + "]",
 	                 "FlexiStats::postConference request error for id["s + conference.id + "]");
 }
 void FlexiStats::notifyConferenceEnded(const string& conferenceId, const ISO8601Date& endedAt) {
+	if (mBatcher)
+		return mBatcher->add({"PATCH", toApiPath("conferences/" + conferenceId), json{{"ended_at", endedAt}},
+		                      "conferences/" + conferenceId});
 	mRestClient.patch(toApiPath("conferences/" + conferenceId), optional<json>{json{{"ended_at", endedAt}}},
 	                  "FlexiStats::notifyConferenceEnded request successful for id["s + conferenceId + "]",
 	                  "FlexiStats::notifyConferenceEnded request error for id["s + conferenceId + "]");
@@ -85,8 +294,10 @@ void FlexiStats::notifyConferenceEnded(const string& conferenceId, const ISO8601
 void FlexiStats::conferenceAddParticipantEvent(const string& conferenceId,
                                                const ApiFormattedUri& sipUri,
                                                const ParticipantEvent& participantEvent) {
-	mRestClient.post(toApiPath("conferences/" + conferenceId + "/participants/" + string(sipUri) + "/events"),
-	                 participantEvent,
+	const auto path = toApiPath("conferences/" + conferenceId + "/participants/" + string(sipUri) + "/events");
+	// Events are appended, they are never coalesced.
+	if (mBatcher) return mBatcher->add({"POST", path, participantEvent, ""});
+	mRestClient.post(path, participantEvent,
 	                 "FlexiStats::conferenceAddParticipantEvent request successful for id["s + conferenceId + "]",
 	                 "FlexiStats::conferenceAddParticipantEvent request error for id["s + conferenceId + "]");
 }
@@ -94,9 +305,10 @@ void FlexiStats::conferenceAddParticipantDeviceEvent(const string& conferenceId,
                                                      const ApiFormattedUri& sipUri,
                                                      const string& deviceId,
                                                      const ParticipantDeviceEvent& participantDeviceEvent) {
-	mRestClient.post(toApiPath("conferences/" + conferenceId + "/participants/" + string(sipUri) + "/devices/" +
-	                           deviceId + "/events"),
-	                 participantDeviceEvent,
+	const auto path = toApiPath("conferences/" + conferenceId + "/participants/" + string(sipUri) + "/devices/" +
+	                            deviceId + "/events");
+	if (mBatcher) return mBatcher->add({"POST", path, participantDeviceEvent, ""});
+	mRestClient.post(path, participantDeviceEvent,
 	                 "FlexiStats::conferenceAddParticipantDeviceEvent request successful for id["s + conferenceId + "]",
 	                 "FlexiStats::conferenceAddParticipantDeviceEvent request error for id["s + conferenceId + "]");
 }
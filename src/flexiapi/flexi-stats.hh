@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <chrono>
+#include <memory>
+
 #include "flexiapi/schemas/call/call.hh"
 #include "flexiapi/schemas/conference/conference.hh"
 #include "flexiapi/schemas/conference/participant-device-event.hh"
@@ -36,6 +39,16 @@ public:
 	           const std::string& apiPrefix,
 	           const std::string& token);
 
+	/**
+	 * Gather the requests for batchWindow and send them by a single request to the 'batch' endpoint of the API, or one
+	 * by one if the server doesn't support it. Successive updates of a call, message or conference are coalesced into
+	 * a single request while they wait. Requests that fail because of the server are sent again, after a delay that
+	 * doubles on each failure. At most maxPendingRequests requests wait, the oldest ones are dropped beyond.
+	 */
+	void enableBatching(const std::shared_ptr<sofiasip::SuRoot>& root,
+	                    std::chrono::milliseconds batchWindow,
+	                    std::size_t maxPendingRequests);
+
 	/********** MESSAGES **********/
 	void postMessage(const Message& message);
 	void notifyMessageDeviceResponse(const std::string& messageId,
@@ -60,10 +73,13 @@ public:
 	                                         const ParticipantDeviceEvent& participantDeviceEvent);
 
 private:
+	class Batcher;
+
 	std::string toApiPath(const std::string& methodPath);
 
 	RestClient mRestClient;
 	std::string mApiPrefix;
+	std::shared_ptr<Batcher> mBatcher{};
 };
 
 } // namespace flexiapi
@@ -42,6 +42,9 @@ ForkContextBase::ForkContextBase(const std::shared_ptr<ModuleRouterInterface>& r
     : mCurrentPriority(-1), mAgent(agent), mRouter(router), mEvent(event), mCfg(cfg), mLateTimer(mAgent->getRoot()),
       mFinishTimer(mAgent->getRoot()), mNextBranchesTimer(mAgent->getRoot()), mMsgPriority(priority),
       mListener(listener), mStatCounter(counter) {
+	const auto* wrapper = dynamic_cast<const ForkContext*>(listener.lock().get());
+	mPtrForEquality = wrapper ? wrapper : this;
+
 	if (auto sharedCounter = mStatCounter.lock()) {
 		sharedCounter->incrStart();
 	} else {
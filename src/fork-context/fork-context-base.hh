@@ -153,7 +153,7 @@ protected:
 	void sendResponse(int status, char const* phrase, bool addToTag = false);
 
 	const ForkContext* getPtrForEquality() const override {
-		return this;
+		return mPtrForEquality;
 	}
 
 	// Protected attributes
@@ -173,6 +173,9 @@ protected:
 	sofiasip::Timer mNextBranchesTimer;
 	sofiasip::MsgSipPriority mMsgPriority = sofiasip::MsgSipPriority::Normal;
 	std::weak_ptr<ForkContextListener> mListener;
+	// The ForkContext wrapping this one when there is one (e.g. ForkMessageContextDbProxy), so that both compare
+	// equal, and this otherwise. Stable for the whole life of the ForkContext.
+	const ForkContext* mPtrForEquality;
 
 private:
 	// Set the next branches to try and process them
@@ -89,6 +89,11 @@ ForkMessageContextDbProxy::~ForkMessageContextDbProxy() {
 	if (!mForkUuidInDb.empty() && mIsFinished) {
 		// Destructor is called because the ForkContext is finished, removing info from database
 		LOGD("ForkMessageContextDbProxy[%p] was present in DB, cleaning UUID[%s]", this, mForkUuidInDb.c_str());
+		const auto& repository = ForkMessageContextSociRepository::getInstance();
+		if (repository->isWriteBehindEnabled()) {
+			repository->queueDelete(mForkUuidInDb);
+			return;
+		}
 		AutoThreadPool::getDbThreadPool(mMaxThreadNumber)->run([uuid = mForkUuidInDb]() {
 			ForkMessageContextSociRepository::getInstance()->deleteByUuid(uuid);
 		});
@@ -168,6 +173,11 @@ void ForkMessageContextDbProxy::onUselessRegisterNotification([[maybe_unused]] c
 }
 
 void ForkMessageContextDbProxy::runSavingThread() {
+	if (ForkMessageContextSociRepository::getInstance()->isWriteBehindEnabled()) {
+		queueSave();
+		return;
+	}
+
 	const auto dbFork = mForkMessage->getDbObject();
 	AutoThreadPool::getDbThreadPool(mMaxThreadNumber)
 	    ->run([thiz = shared_from_this(), dbFork, dbForkVersion = mCurrentVersion.load()]() {
@@ -188,6 +198,38 @@ void ForkMessageContextDbProxy::runSavingThread() {
 	    });
 }
 
+void ForkMessageContextDbProxy::queueSave() {
+	const auto router = mSavedRouter.lock();
+	if (!router) {
+		SLOGE << errorLogPrefix() << "weak_ptr mSavedRouter should be present here (queueSave).";
+		return;
+	}
+
+	bool isNew{};
+	{
+		lock_guard<mutex> lock(mDbAccessMutex);
+		isNew = mForkUuidInDb.empty();
+		if (isNew) mForkUuidInDb = ForkMessageContextSociRepository::generateUuid();
+	}
+	LOGD("ForkMessageContextDbProxy[%p] queuing save of UUID[%s]", this, mForkUuidInDb.c_str());
+	ForkMessageContextSociRepository::getInstance()->queueSave(
+	    mForkUuidInDb, mForkMessage->getDbObject(), isNew,
+	    [weak = weak_ptr<ForkMessageContextDbProxy>{shared_from_this()},
+	     weakRoot = weak_ptr<sofiasip::SuRoot>{router->getAgent()->getRoot()},
+	     dbForkVersion = mCurrentVersion.load()](bool saved) {
+		    // If not saved, the message remains in memory, as when a direct save fails.
+		    if (!saved) return;
+		    if (auto root = weakRoot.lock()) {
+			    root->addToMainLoop([weak, dbForkVersion]() {
+				    if (auto shared = weak.lock()) {
+					    if (shared->mLastSavedVersion < dbForkVersion) shared->mLastSavedVersion = dbForkVersion;
+					    shared->clearMemoryIfPossible();
+				    }
+			    });
+		    }
+	    });
+}
+
 void ForkMessageContextDbProxy::onResponse(const shared_ptr<BranchInfo>& br,
                                            const shared_ptr<ResponseSipEvent>& event) {
 	LOGD("ForkMessageContextDbProxy[%p] onResponse", this);
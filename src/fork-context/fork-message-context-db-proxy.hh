@@ -160,10 +160,8 @@ protected:
 		return CLASS_NAME;
 	};
 
+	// The inner ForkMessageContext takes this identity too, see ForkContextBase::mPtrForEquality.
 	const ForkContext* getPtrForEquality() const override {
-		if (mForkMessage) {
-			return mForkMessage.get();
-		}
 		return this;
 	}
 
@@ -194,6 +192,10 @@ private:
 	 */
 	bool restoreForkIfNeeded();
 	void runSavingThread();
+	/**
+	 * Save through the write-behind queue of the repository, see ForkMessageContextSociRepository::setWriteBehind().
+	 */
+	void queueSave();
 
 	State getState() const;
 	void setState(State mState);
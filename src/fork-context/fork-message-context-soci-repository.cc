@@ -19,6 +19,15 @@
 
 #include "fork-message-context-soci-repository.hh"
 
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <tuple>
+
+#include "utils/thread/auto-thread-pool.hh"
+
 using namespace flexisip;
 using namespace std;
 using namespace soci;
@@ -28,6 +37,45 @@ std::string ForkMessageContextSociRepository::sConnectionString{};
 unsigned int ForkMessageContextSociRepository::sNbThreadsMax = 1;
 std::unique_ptr<ForkMessageContextSociRepository> ForkMessageContextSociRepository::singleton{};
 
+namespace {
+const std::string kNilUuid{"00000000-0000-0000-0000-000000000000"};
+// Retry delay of the operations that failed to be written while the write-behind queue is disabled.
+constexpr std::chrono::milliseconds kWriteBehindRetryDelay{1000};
+
+// Values of a fork_message_context row, as types soci can bind.
+struct ForkRow {
+	string uuid;
+	double currentPriority;
+	int deliveredCount;
+	int isFinished;
+	int isMessage;
+	std::tm expirationDate;
+	string request;
+	int msgPriority;
+};
+
+// Row aliases replace the VALUES() function, deprecated since MySQL 8.0.20. MariaDB only supports the latter.
+bool supportsRowAlias(const string& version) {
+	if (version.find("MariaDB") != string::npos) return false;
+	int major{}, minor{}, patch{};
+	char dot{};
+	istringstream{version} >> major >> dot >> minor >> dot >> patch;
+	return make_tuple(major, minor, patch) >= make_tuple(8, 0, 19);
+}
+
+// The 'on duplicate key update' clause of a multi-row insert, setting columns to the values of the inserted row.
+string onDuplicateKeyUpdate(const vector<string>& columns, bool rowAlias) {
+	ostringstream clause{};
+	clause << (rowAlias ? " as incoming" : "") << " on duplicate key update ";
+	for (size_t i = 0; i < columns.size(); ++i) {
+		const auto& column = columns[i];
+		clause << (i == 0 ? "" : ", ") << column << " = "
+		       << (rowAlias ? "incoming." + column : "values(" + column + ")");
+	}
+	return clause.str();
+}
+} // namespace
+
 const std::unique_ptr<ForkMessageContextSociRepository>& ForkMessageContextSociRepository::getInstance() {
 	if (singleton) {
 		return singleton;
@@ -51,6 +99,9 @@ ForkMessageContextSociRepository::ForkMessageContextSociRepository(const string&
 		}
 
 		session sql(mConnectionPool);
+		string version{};
+		sql << "select version()", into(version);
+		mRowAlias = supportsRowAlias(version);
 		// Database creation, modify existing request only in case of emergency.
 		// Only add request so the database can be created/updated from any version.
 		sql << R"sql(CREATE TABLE IF NOT EXISTS fork_message_context (
@@ -229,6 +280,60 @@ std::vector<ForkMessageContextDb> ForkMessageContextSociRepository::findAllForkM
 	return allForkMessages;
 }
 
+string ForkMessageContextSociRepository::findLastForkMessageUuid() {
+	string lastUuid{};
+	SociHelper helper{mConnectionPool};
+	helper.execute([&lastUuid](auto& sql) {
+		indicator uuidIndicator{};
+		sql << "select UuidFromBin(max(uuid)) from fork_message_context", into(lastUuid, uuidIndicator);
+		if (uuidIndicator != i_ok) lastUuid.clear();
+	});
+	return lastUuid;
+}
+
+std::vector<ForkMessageContextDb> ForkMessageContextSociRepository::findForkMessagePage(const std::string& afterUuid,
+                                                                                     const std::string& lastUuid,
+                                                                                     unsigned int pageSize) {
+	vector<ForkMessageContextDb> page{};
+	page.reserve(pageSize);
+
+	SociHelper helper{mConnectionPool};
+	helper.execute([&afterUuid, &lastUuid, pageSize, &page](auto& sql) {
+		page.clear();
+		string uuid{};
+		std::tm expirationDate{};
+		int msgPriority{};
+		string key{};
+		indicator keyIndicator{};
+
+		// UUID() never generates the nil uuid, so it comes before all the stored ones.
+		const auto& after = afterUuid.empty() ? kNilUuid : afterUuid;
+		const auto limit = static_cast<int>(pageSize);
+		// The page is selected first so that the limit applies to forks and not to (fork, key) pairs.
+		soci::statement st =
+		    (sql.prepare << "select UuidFromBin(page.uuid), page.expiration_date, page.msg_priority, "
+		                    "fork_key.key_value from (select uuid, expiration_date, msg_priority "
+		                    "from fork_message_context where uuid > UuidToBin(:after) and uuid <= UuidToBin(:last) "
+		                    "order by uuid limit :limit) as page "
+		                    "left join fork_key on fork_key.fork_uuid = page.uuid order by page.uuid",
+		     use(after, "after"), use(lastUuid, "last"), use(limit, "limit"), into(uuid), into(expirationDate),
+		     into(msgPriority), into(key, keyIndicator));
+
+		st.execute();
+		while (st.fetch()) {
+			if (page.empty() || page.back().uuid != uuid) {
+				auto& fork = page.emplace_back();
+				fork.uuid = uuid;
+				fork.expirationDate = expirationDate;
+				fork.msgPriority = static_cast<sofiasip::MsgSipPriority>(msgPriority);
+			}
+			if (keyIndicator == i_ok) page.back().dbKeys.push_back(key);
+		}
+	});
+
+	return page;
+}
+
 void ForkMessageContextSociRepository::findAndPushBackKeys(const string& uuid,
                                                            ForkMessageContextDb& dbFork,
                                                            session& sql) {
@@ -275,6 +380,277 @@ void ForkMessageContextSociRepository::deleteByUuid(const string& uuid) {
 	}
 }
 
+void ForkMessageContextSociRepository::setWriteBehind(const std::shared_ptr<sofiasip::SuRoot>& root,
+                                                      std::chrono::milliseconds delay,
+                                                      unsigned int maxBatchSize) {
+	{
+		lock_guard<mutex> lock(mQueueMutex);
+		mRoot = root;
+		mWriteBehindDelay = delay;
+		mWriteBehindMaxBatchSize = max(maxBatchSize, 1u);
+	}
+	// Even when the queue is disabled, the timer retries the operations that failed to be written.
+	mFlushTimer = make_unique<sofiasip::Timer>(root, delay != 0ms ? delay : kWriteBehindRetryDelay);
+	// Operations queued before the queue was disabled are still written.
+	if (delay == 0ms) scheduleFlush(true);
+}
+
+void ForkMessageContextSociRepository::stopWriteBehind() {
+	{
+		lock_guard<mutex> lock(mQueueMutex);
+		// Nothing is scheduled anymore: failed operations are not retried.
+		mRoot.reset();
+		mWriteBehindDelay = 0ms;
+	}
+	mFlushTimer.reset();
+	// Waits for the flushes already running in the thread pool.
+	flushWriteBehindQueue();
+
+	map<string, PendingSave> saves{};
+	set<string> deletes{};
+	{
+		lock_guard<mutex> lock(mQueueMutex);
+		saves.swap(mPendingSaves);
+		deletes.swap(mPendingDeletes);
+	}
+	if (saves.empty() && deletes.empty()) return;
+	SLOGW << "ForkMessageContextSociRepository - Dropping " << saves.size() << " saves and " << deletes.size()
+	      << " deletes that could not be written before stopping";
+	for (const auto& [uuid, pending] : saves) {
+		for (const auto& onSaved : pending.onSaved) {
+			onSaved(false);
+		}
+	}
+}
+
+bool ForkMessageContextSociRepository::isWriteBehindEnabled() const {
+	lock_guard<mutex> lock(mQueueMutex);
+	return mWriteBehindDelay != 0ms;
+}
+
+string ForkMessageContextSociRepository::generateUuid() {
+	static mutex generatorMutex{};
+	static mt19937_64 generator{random_device{}()};
+	// Count of 100ns intervals since the start of the Gregorian calendar, as in version 1 uuids.
+	constexpr uint64_t kGregorianOffset = 0x01B21DD213814000;
+	const auto now = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch());
+	const uint64_t timestamp = kGregorianOffset + now.count() / 100;
+	uint64_t random{};
+	{
+		lock_guard<mutex> lock(generatorMutex);
+		random = generator();
+	}
+	// Random clock sequence and node (with the multicast bit set, as required for a node that is not a MAC address).
+	const auto clockSequence = (random >> 48 & 0x3FFF) | 0x8000;
+	const auto node = (random & 0xFFFFFFFFFFFF) | 0x010000000000;
+
+	ostringstream uuid{};
+	uuid << hex << setfill('0') << setw(8) << (timestamp & 0xFFFFFFFF) << '-' << setw(4) << (timestamp >> 32 & 0xFFFF)
+	     << '-' << setw(4) << ((timestamp >> 48 & 0x0FFF) | 0x1000) << '-' << setw(4) << clockSequence << '-'
+	     << setw(12) << node;
+	return uuid.str();
+}
+
+void ForkMessageContextSociRepository::queueSave(const string& uuid,
+                                                 const ForkMessageContextDb& dbFork,
+                                                 bool isNew,
+                                                 OnSaved&& onSaved) {
+	bool full{};
+	bool first{};
+	{
+		lock_guard<mutex> lock(mQueueMutex);
+		first = mPendingSaves.empty() && mPendingDeletes.empty();
+		auto& pending = mPendingSaves[uuid];
+		pending.dbFork = dbFork;
+		pending.isNew = pending.isNew || isNew;
+		pending.onSaved.push_back(std::move(onSaved));
+		full = mWriteBehindMaxBatchSize <= mPendingSaves.size() + mPendingDeletes.size();
+	}
+	if (first || full) scheduleFlush(full);
+}
+
+void ForkMessageContextSociRepository::queueDelete(const string& uuid) {
+	bool full{};
+	bool first{};
+	vector<OnSaved> cancelled{};
+	{
+		lock_guard<mutex> lock(mQueueMutex);
+		auto pending = mPendingSaves.find(uuid);
+		const auto neverWritten = pending != mPendingSaves.end() && pending->second.isNew;
+		if (pending != mPendingSaves.end()) {
+			cancelled = std::move(pending->second.onSaved);
+			mPendingSaves.erase(pending);
+		}
+		if (neverWritten) {
+			// Delivered before being written: nothing to write at all.
+			SLOGD << "ForkMessageContextSociRepository - Fork message [" << uuid << "] deleted before being saved";
+		} else {
+			first = mPendingSaves.empty() && mPendingDeletes.empty();
+			mPendingDeletes.insert(uuid);
+			full = mWriteBehindMaxBatchSize <= mPendingSaves.size() + mPendingDeletes.size();
+		}
+	}
+	for (const auto& onSaved : cancelled) {
+		onSaved(false);
+	}
+	if (first || full) scheduleFlush(full);
+}
+
+void ForkMessageContextSociRepository::scheduleFlush(bool now) {
+	if (now) {
+		runFlush();
+		return;
+	}
+	// The first operation of a batch waits for the following ones, the timer is run by the main loop.
+	shared_ptr<sofiasip::SuRoot> root{};
+	{
+		lock_guard<mutex> lock(mQueueMutex);
+		root = mRoot;
+	}
+	if (!root) return;
+	root->addToMainLoop([this] {
+		if (mFlushTimer && !mFlushTimer->isRunning()) mFlushTimer->set([this] { runFlush(); });
+	});
+}
+
+void ForkMessageContextSociRepository::runFlush() {
+	// Same thread pool as the one used by ForkMessageContextDbProxy.
+	AutoThreadPool::getDbThreadPool(sNbThreadsMax * 2)->run([this] { flushWriteBehindQueue(); });
+}
+
+void ForkMessageContextSociRepository::flushWriteBehindQueue() {
+	lock_guard<mutex> flushLock(mFlushMutex);
+	map<string, PendingSave> saves{};
+	set<string> deletes{};
+	{
+		lock_guard<mutex> lock(mQueueMutex);
+		saves.swap(mPendingSaves);
+		deletes.swap(mPendingDeletes);
+	}
+	if (saves.empty() && deletes.empty()) return;
+
+	try {
+		SociHelper helper{mConnectionPool};
+		helper.execute([this, &saves, &deletes](session& sql) { writeBatch(sql, saves, deletes, mRowAlias); });
+		SLOGD << "ForkMessageContextSociRepository - " << saves.size() << " saves and " << deletes.size()
+		      << " deletes written in one transaction";
+	} catch (const exception& e) {
+		SLOGE << "ForkMessageContextSociRepository - Failed to write " << saves.size() << " saves and "
+		      << deletes.size() << " deletes, they will be retried with the next batch: " << e.what();
+		requeue(saves, deletes);
+		scheduleFlush(false);
+		return;
+	}
+
+	for (const auto& [uuid, pending] : saves) {
+		for (const auto& onSaved : pending.onSaved) {
+			onSaved(true);
+		}
+	}
+}
+
+void ForkMessageContextSociRepository::requeue(map<string, PendingSave>& saves, const set<string>& deletes) {
+	vector<OnSaved> cancelled{};
+	{
+		lock_guard<mutex> lock(mQueueMutex);
+		for (auto& [uuid, failed] : saves) {
+			if (mPendingDeletes.count(uuid) != 0) {
+				// Deleted while being written, there is nothing left to save.
+				move(failed.onSaved.begin(), failed.onSaved.end(), back_inserter(cancelled));
+				continue;
+			}
+			const auto [pending, inserted] = mPendingSaves.try_emplace(uuid, std::move(failed));
+			if (inserted) continue;
+			// Saved again while being written: the newer save is kept, and completes the callers of both.
+			pending->second.isNew = pending->second.isNew || failed.isNew;
+			pending->second.onSaved.insert(pending->second.onSaved.begin(),
+			                               make_move_iterator(failed.onSaved.begin()),
+			                               make_move_iterator(failed.onSaved.end()));
+		}
+		mPendingDeletes.insert(deletes.cbegin(), deletes.cend());
+	}
+	for (const auto& onSaved : cancelled) {
+		onSaved(false);
+	}
+}
+
+void ForkMessageContextSociRepository::writeBatch(session& sql,
+                                                  const map<string, PendingSave>& saves,
+                                                  const set<string>& deletes,
+                                                  bool rowAlias) {
+	transaction tr(sql);
+
+	vector<ForkRow> forks{};
+	vector<pair<string, string>> keys{};
+	vector<pair<string, BranchInfoDb>> branches{};
+	forks.reserve(saves.size());
+	for (const auto& [uuid, pending] : saves) {
+		const auto& dbFork = pending.dbFork;
+		forks.push_back({uuid, dbFork.currentPriority, dbFork.deliveredCount, dbFork.isFinished, dbFork.isMessage,
+		                 dbFork.expirationDate, dbFork.request, static_cast<int>(dbFork.msgPriority)});
+		for (const auto& key : dbFork.dbKeys) {
+			keys.emplace_back(uuid, key);
+		}
+		for (const auto& dbBranch : dbFork.dbBranches) {
+			branches.emplace_back(uuid, dbBranch);
+		}
+	}
+
+	executeMultiRow(
+	    sql,
+	    "insert into fork_message_context(uuid, current_priority, delivered_count, is_finished, is_message, "
+	    "expiration_date, request, msg_priority) values ",
+	    "(UuidToBin(:uuid), :current_priority, :delivered_count, :is_finished, :is_message, :expiration_date, "
+	    ":request, :msg_priority)",
+	    onDuplicateKeyUpdate({"current_priority", "delivered_count", "is_finished", "is_message", "expiration_date",
+	                          "request", "msg_priority"},
+	                         rowAlias),
+	    forks, [](statement& st, const ForkRow& fork, const string& suffix) {
+		    st.exchange(use(fork.uuid, "uuid" + suffix));
+		    st.exchange(use(fork.currentPriority, "current_priority" + suffix));
+		    st.exchange(use(fork.deliveredCount, "delivered_count" + suffix));
+		    st.exchange(use(fork.isFinished, "is_finished" + suffix));
+		    st.exchange(use(fork.isMessage, "is_message" + suffix));
+		    st.exchange(use(fork.expirationDate, "expiration_date" + suffix));
+		    st.exchange(use(fork.request, "request" + suffix));
+		    st.exchange(use(fork.msgPriority, "msg_priority" + suffix));
+		    return fork.request.size();
+	    });
+
+	// Keys never change, they are inserted with each save so that a save that failed is fully retried by the next.
+	executeMultiRow(sql, "insert ignore into fork_key(fork_uuid, key_value) values ",
+	                "(UuidToBin(:fork_uuid), :key_value)", "", keys,
+	                [](statement& st, const pair<string, string>& key, const string& suffix) {
+		                st.exchange(use(key.first, "fork_uuid" + suffix));
+		                st.exchange(use(key.second, "key_value" + suffix));
+		                return key.second.size();
+	                });
+
+	executeMultiRow(
+	    sql,
+	    "insert into branch_info(fork_uuid, contact_uid, request, last_response, priority, cleared_count) values ",
+	    "(UuidToBin(:fork_uuid), :contact_uid, :request, :last_response, :priority, :cleared_count)",
+	    onDuplicateKeyUpdate({"request", "last_response", "priority", "cleared_count"}, rowAlias),
+	    branches, [](statement& st, const pair<string, BranchInfoDb>& branch, const string& suffix) {
+		    st.exchange(use(branch.first, "fork_uuid" + suffix));
+		    st.exchange(use(branch.second.contactUid, "contact_uid" + suffix));
+		    st.exchange(use(branch.second.request, "request" + suffix));
+		    st.exchange(use(branch.second.lastResponse, "last_response" + suffix));
+		    st.exchange(use(branch.second.priority, "priority" + suffix));
+		    st.exchange(use(branch.second.clearedCount, "cleared_count" + suffix));
+		    return branch.second.request.size() + branch.second.lastResponse.size();
+	    });
+
+	const vector<string> deletedUuids{deletes.cbegin(), deletes.cend()};
+	executeMultiRow(sql, "delete from fork_message_context where uuid in (", "UuidToBin(:uuid)", ")", deletedUuids,
+	                [](statement& st, const string& uuid, const string& suffix) {
+		                st.exchange(use(uuid, "uuid" + suffix));
+		                return uuid.size();
+	                });
+
+	tr.commit();
+}
+
 #ifdef ENABLE_UNIT_TESTS
 void ForkMessageContextSociRepository::deleteAll() {
 	session sql(mConnectionPool);
@@ -18,6 +18,11 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
 
 #include <soci/connection-pool.h>
@@ -25,6 +30,9 @@
 #include <soci/session.h>
 #include <soci/sqlite3/soci-sqlite3.h>
 
+#include "flexisip/sofia-wrapper/su-root.hh"
+#include "flexisip/sofia-wrapper/timer.hh"
+
 #include "fork-message-context.hh"
 
 namespace flexisip {
@@ -62,12 +70,69 @@ public:
 	 */
 	std::vector<ForkMessageContextDb> findAllForkMessage();
 
+	/**
+	 * @return the uuid of the last fork_message_context in uuid order, which is creation time order, or an empty
+	 * string if there is none.
+	 */
+	std::string findLastForkMessageUuid();
+
+	/**
+	 * Load the minimal information (uuid, expiration date, priority and keys) of at most pageSize
+	 * fork_message_context, in uuid order, starting right after afterUuid (from the first one if empty) and ending at
+	 * lastUuid included.<br>
+	 * A single query is run per page, so the whole table can be browsed without holding it in memory. Bounding the
+	 * browsing with the last uuid found before it started excludes the messages saved in the meantime.
+	 */
+	std::vector<ForkMessageContextDb>
+	findForkMessagePage(const std::string& afterUuid, const std::string& lastUuid, unsigned int pageSize);
+
 	std::string saveForkMessageContext(const ForkMessageContextDb& dbFork);
 
 	void updateForkMessageContext(const ForkMessageContextDb& dbFork, const std::string& uuid);
 
 	void deleteByUuid(const std::string& uuid);
 
+	/**
+	 * Called once a queued save is written (true), or failed to be written (false), from a DB thread.
+	 */
+	using OnSaved = std::function<void(bool saved)>;
+
+	/**
+	 * Enable write-behind when delay is not zero: saves and deletes are queued, then written together after delay
+	 * (or as soon as maxBatchSize operations are pending), in one transaction with multi-row statements.
+	 * A message deleted before its first save is written is never written at all. Operations that failed to be
+	 * written are queued again, and retried after delay (or after one second if the queue is disabled).<br>
+	 * A zero delay disables the queue: callers save and delete directly, each in its own transaction.<br>
+	 * Must be called from the main loop, which runs the timer of the queue.
+	 */
+	void setWriteBehind(const std::shared_ptr<sofiasip::SuRoot>& root,
+	                    std::chrono::milliseconds delay,
+	                    unsigned int maxBatchSize);
+	bool isWriteBehindEnabled() const;
+	/**
+	 * Disable write-behind and write the queued operations before returning, so that a clean stop does not lose
+	 * them. Operations that still fail to be written are dropped. Must be called from the main loop.
+	 */
+	void stopWriteBehind();
+
+	/**
+	 * Generate the uuid of a new fork message, so it can be queued before being written.
+	 * Uuids are time-based, like the ones generated by the database, to keep insertions in primary key order.
+	 */
+	static std::string generateUuid();
+
+	/**
+	 * Queue the save of a fork message. isNew is true if the message was never queued before, in which case a
+	 * following queueDelete() may cancel it. Saves of the same message that are not written yet are merged.
+	 */
+	void queueSave(const std::string& uuid, const ForkMessageContextDb& dbFork, bool isNew, OnSaved&& onSaved);
+	void queueDelete(const std::string& uuid);
+
+	/**
+	 * Write all the queued operations now. Blocking I/O with DB, should be called in a thread.
+	 */
+	void flushWriteBehindQueue();
+
 #ifdef ENABLE_UNIT_TESTS
 	void deleteAll();
 #endif
@@ -77,6 +142,20 @@ private:
 	                                 const std::string& connectionString,
 	                                 unsigned int nbThreadsMax);
 
+	struct PendingSave {
+		ForkMessageContextDb dbFork;
+		bool isNew{false};
+		std::vector<OnSaved> onSaved{};
+	};
+
+	void scheduleFlush(bool now);
+	void runFlush();
+	void requeue(std::map<std::string, PendingSave>& saves, const std::set<std::string>& deletes);
+	static void writeBatch(soci::session& sql,
+	                       const std::map<std::string, PendingSave>& saves,
+	                       const std::set<std::string>& deletes,
+	                       bool rowAlias);
+
 	static void findAndPushBackKeys(const std::string& uuid, ForkMessageContextDb& dbFork, soci::session& sql);
 	static void findAndPushBackBranches(const std::string& uuid, ForkMessageContextDb& dbFork, soci::session& sql);
 
@@ -84,6 +163,19 @@ private:
 	std::vector<std::string> mUuidsToDelete{};
 	std::mutex mMutex{};
 
+	// Write-behind queue, see setWriteBehind().
+	std::chrono::milliseconds mWriteBehindDelay{0};
+	unsigned int mWriteBehindMaxBatchSize{1};
+	std::map<std::string, PendingSave> mPendingSaves{}; // protected by mQueueMutex
+	std::set<std::string> mPendingDeletes{};            // protected by mQueueMutex
+	std::shared_ptr<sofiasip::SuRoot> mRoot{};          // protected by mQueueMutex
+	std::unique_ptr<sofiasip::Timer> mFlushTimer{};     // main loop only
+	mutable std::mutex mQueueMutex{};
+	// The server supports row aliases in 'on duplicate key update' clauses (MySQL 8.0.19 and later).
+	bool mRowAlias{false};
+	// Flushes are serialized so that a message is never deleted before it is inserted.
+	std::mutex mFlushMutex{};
+
 	static std::string sBackendString;
 	static std::string sConnectionString;
 	static unsigned int sNbThreadsMax;
@@ -32,6 +32,11 @@ public:
 			addArg(arg);
 		}
 	}
+	void addArgs(const std::vector<std::string>& args) {
+		for (const auto& arg : args) {
+			addArg(arg);
+		}
+	}
 
 	const char* const* getCArgs() const {
 		return &mCArgs[0];
@@ -4,6 +4,7 @@
 
 #include "redis-async-script.hh"
 
+#include <string>
 #include <variant>
 
 #include "flexisip/logmanager.hh"
@@ -15,9 +16,11 @@
 namespace flexisip::redis::async {
 
 void Script::call(const Session::Ready& session,
-                  std::initializer_list<std::string>&& scriptArgs,
+                  const std::vector<std::string>& scriptKeys,
+                  const std::vector<std::string>& scriptArgs,
                   Session::CommandCallback&& callback) const {
-	auto args = std::make_unique<ArgsPacker>("EVALSHA", mSHA1, "1", "fs:*");
+	auto args = std::make_unique<ArgsPacker>("EVALSHA", mSHA1, std::to_string(scriptKeys.size()));
+	args->addArgs(scriptKeys);
 	args->addArgs(scriptArgs);
 
 	auto& argsRef = *args;
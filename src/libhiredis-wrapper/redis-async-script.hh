@@ -4,7 +4,8 @@
 
 #pragma once
 
-#include <initializer_list>
+#include <string>
+#include <vector>
 
 #include "redis-async-session.hh"
 
@@ -24,7 +25,8 @@ public:
 
 	// SAFETY: The Script object used to call this function must live at least as long as the session used
 	void call(const async::Session::Ready&,
-	          std::initializer_list<std::string>&& scriptArgs,
+	          const std::vector<std::string>& scriptKeys,
+	          const std::vector<std::string>& scriptArgs,
 	          async::Session::CommandCallback&&) const;
 
 private:
@@ -36,6 +36,9 @@ RedisParameters RedisParameters::fromRegistrarConf(GenericStruct const* const re
 		        if (timeout.count() <= 0) throw std::runtime_error{param->getCompleteName() + " must be positive"};
 		        return timeout;
 	        }(),
+	    .readFromReplicas = registarConf->get<ConfigBoolean>("redis-read-from-replicas")->read(),
+	    .maxReplicaLag = registarConf->get<ConfigInt>("redis-replica-max-lag")->read(),
+	    .serverSideBind = registarConf->get<ConfigBoolean>("redis-server-side-bind")->read(),
 	};
 }
 
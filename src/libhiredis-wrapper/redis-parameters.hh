@@ -21,6 +21,12 @@ struct RedisParameters {
 	std::chrono::seconds mSlaveCheckTimeout{0};
 	bool useSlavesAsBackup = true;
 	std::chrono::seconds mSubSessionKeepAliveTimeout{0};
+	// Send read-only commands to up-to-date replicas rather than to the master.
+	bool readFromReplicas = false;
+	// Maximum replication lag of a replica serving reads, in bytes of the replication stream.
+	long long maxReplicaLag = 0;
+	// Bind contacts with a server-side script, in a single round trip, when possible.
+	bool serverSideBind = false;
 
 	static RedisParameters fromRegistrarConf(GenericStruct const*);
 };
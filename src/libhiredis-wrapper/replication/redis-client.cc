@@ -2,6 +2,7 @@
  *  SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 
@@ -62,6 +63,21 @@ const Session::Ready* RedisClient::tryGetCmdSession() {
 
 	return nullptr;
 }
+const Session::Ready* RedisClient::tryGetReadSession(bool* fromReplica) {
+	if (fromReplica) *fromReplica = false;
+	if (mParams.readFromReplicas) {
+		for (size_t i = 0; i < mReplicas.size(); ++i) {
+			const auto& replica = mReplicas[mNextReplica++ % mReplicas.size()];
+			if (!replica.upToDate || !replica.authenticated) continue;
+			const auto* ready = replica.session->tryGetState<Session::Ready>();
+			if (!ready || !ready->connected()) continue;
+			if (fromReplica) *fromReplica = true;
+			return ready;
+		}
+	}
+	return tryGetCmdSession();
+}
+
 const SubscriptionSession::Ready* RedisClient::getSubSessionIfReady() const {
 	return isReady() ? &std::get<SubscriptionSession::Ready>(mSubSession.getState()) : nullptr;
 }
@@ -200,7 +216,7 @@ void RedisClient::handleReplicationInfoReply(const redis::reply::String& reply)
 			if (auto listener = mSessionListener.lock()) {
 				listener->onConnect(REDIS_OK); // TODO should this be called only on first connection ?
 			}
-			if (mParams.useSlavesAsBackup) {
+			if (mParams.useSlavesAsBackup || mParams.readFromReplicas) {
 				updateSlavesList(replyMap);
 			}
 		} else if (role == "slave") {
@@ -210,6 +226,8 @@ void RedisClient::handleReplicationInfoReply(const redis::reply::String& reply)
 			string masterStatus = replyMap["master_link_status"];
 
 			LOGW("%sOur redis instance is a slave of %s:%d", logPrefix().c_str(), masterAddress.c_str(), masterPort);
+			// Replicas are only known, and their lag only measured, from the master.
+			mReplicas.clear();
 			if (masterStatus == "up") {
 				SLOGW << logPrefix() << "Master is up, will attempt to connect to the master at " << masterAddress
 				      << ":" << masterPort;
@@ -264,6 +282,12 @@ void RedisClient::updateSlavesList(const map<std::string, std::string>& redisRep
 	} catch (const out_of_range&) {
 	}
 
+	if (mParams.readFromReplicas) {
+		const auto masterOffset = redisReply.find("master_repl_offset");
+		updateReplicas(newSlaves, masterOffset != redisReply.end() ? atoll(masterOffset->second.c_str()) : -1);
+	}
+	if (!mParams.useSlavesAsBackup) return;
+
 	for (const auto& oldSlave : mSlaves) {
 		if (find(newSlaves.begin(), newSlaves.end(), oldSlave) == newSlaves.end()) {
 			LOGD("%sReplication: Removing host %d %s:%d previous state:%s", logPrefix().c_str(), oldSlave.id,
@@ -276,6 +300,61 @@ void RedisClient::updateSlavesList(const map<std::string, std::string>& redisRep
 	mCurSlave = mSlaves.cend();
 }
 
+void RedisClient::updateReplicas(const std::vector<RedisHost>& slaves, long long masterOffset) {
+	decltype(mReplicas) replicas{};
+	for (const auto& host : slaves) {
+		auto existing = find_if(mReplicas.begin(), mReplicas.end(), [&host](const auto& replica) {
+			return replica.host.address == host.address && replica.host.port == host.port;
+		});
+		auto replica =
+		    existing != mReplicas.end() ? std::move(*existing) : Replica{host, make_unique<Session>(), false, false};
+		replica.host = host;
+		const auto lag = masterOffset - host.offset;
+		const auto upToDate = host.state == "online" && 0 <= host.offset && 0 <= lag && lag <= mParams.maxReplicaLag;
+		if (upToDate != replica.upToDate) {
+			LOGI("%sReplication: replica %s:%d %s reads (lag: %lld bytes)", logPrefix().c_str(), host.address.c_str(),
+			     host.port, upToDate ? "now serves" : "no longer serves", lag);
+		}
+		replica.upToDate = upToDate;
+
+		if (upToDate && replica.session->tryGetState<Session::Disconnected>()) connectReplica(replica);
+		replicas.push_back(std::move(replica));
+	}
+	// Sessions to replicas that are gone are destroyed here, aborting their pending commands.
+	mReplicas = std::move(replicas);
+}
+
+void RedisClient::connectReplica(Replica& replica) {
+	replica.authenticated = false;
+	// The replica is reached the way the master is, with the same credentials.
+	const auto& state = replica.session->connect(mRoot.getCPtr(), replica.host.address, replica.host.port);
+	const auto* ready = std::get_if<Session::Ready>(&state);
+	if (!ready) return;
+	Match(mParams.auth)
+	    .against([&replica](redis::auth::None) { replica.authenticated = true; },
+	             [this, ready, session = replica.session.get()](auto credentials) {
+		             ready->auth(credentials, [this, session](const Session&, Reply reply) {
+			             // The replica may have been dropped since the command was sent.
+			             auto* replica = findReplica(session);
+			             if (!replica || std::holds_alternative<reply::Disconnected>(reply)) return;
+			             if (auto* err = std::get_if<reply::Error>(&reply)) {
+				             SLOGE << logPrefix() << session->getLogPrefix()
+				                   << "Couldn't authenticate with Redis replica, not reading from it: " << *err;
+				             // Reconnected, and authenticated again, at the next replication check.
+				             session->forceDisconnect();
+				             return;
+			             }
+			             replica->authenticated = true;
+		             });
+	             });
+}
+
+RedisClient::Replica* RedisClient::findReplica(const Session* session) {
+	const auto replica = find_if(mReplicas.begin(), mReplicas.end(),
+	                             [session](const auto& replica) { return replica.session.get() == session; });
+	return replica != mReplicas.end() ? &*replica : nullptr;
+}
+
 void RedisClient::onHandleInfoTimer() {
 	if (auto* session = std::get_if<Session::Ready>(&mCmdSession.getState())) {
 		SLOGD << logPrefix() << "Launching periodic INFO query on REDIS";
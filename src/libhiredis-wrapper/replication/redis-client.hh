@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <memory>
 #include <optional>
+#include <vector>
 
 #include "flexisip/configmanager.hh"
 #include "flexisip/sofia-wrapper/su-root.hh"
@@ -27,12 +29,29 @@ public:
 	bool isConnected() const;
 
 	const Session::Ready* tryGetCmdSession();
+	/**
+	 * Session to send read-only commands to. When reading from replicas is enabled, this is the session to a replica
+	 * that was online and up-to-date (see RedisParameters::maxReplicaLag) at the last replication check, and that
+	 * accepted the credentials of the master, picked in a round-robin fashion. Otherwise, or if no replica qualifies,
+	 * this is the command session.
+	 * @param fromReplica if not null, set to whether the session is the one of a replica. Replies of replicas may be
+	 * older than the last writes, they must not be kept after the request that needed them.
+	 */
+	const Session::Ready* tryGetReadSession(bool* fromReplica = nullptr);
 	const SubscriptionSession::Ready* tryGetSubSession();
 	const SubscriptionSession::Ready* getSubSessionIfReady() const;
 
 	static void forceDisconnectForTest(RedisClient& thiz);
 
 private:
+	struct Replica {
+		RedisHost host;
+		std::unique_ptr<Session> session;
+		bool upToDate = false;
+		// The replica accepted the credentials of the master, or none are needed.
+		bool authenticated = false;
+	};
+
 	bool isReady() const;
 	void forceDisconnect();
 
@@ -46,6 +65,9 @@ private:
 	std::optional<std::tuple<const Session::Ready&, const SubscriptionSession::Ready&>> tryReconnect();
 	void getReplicationInfo(const redis::async::Session::Ready& stringReply);
 	void updateSlavesList(const std::map<std::string, std::string>& redisReply);
+	void updateReplicas(const std::vector<RedisHost>& slaves, long long masterOffset);
+	void connectReplica(Replica& replica);
+	Replica* findReplica(const Session* session);
 	/**
 	 * This callback is called when the Redis instance answered our "INFO replication" message.
 	 * We parse the response to determine if we are connected to the master Redis instance or
@@ -89,6 +111,9 @@ private:
 	SubSessionState mSubSessionState{SubSessionState::DISCONNECTED};
 	sofiasip::Timer mSubSessionKeepAliveTimer;
 	std::vector<RedisHost> mSlaves{};
+	// Replicas of the master, used for reads when RedisParameters::readFromReplicas is enabled.
+	std::vector<Replica> mReplicas{};
+	size_t mNextReplica = 0;
 	decltype(mSlaves)::const_iterator mCurSlave = mSlaves.cend();
 	std::optional<sofiasip::Timer> mReplicationTimer{std::nullopt};
 	std::optional<sofiasip::Timer> mReconnectTimer{std::nullopt};
@@ -28,7 +28,9 @@ RedisHost RedisHost::parseSlave(const string& slaveLine, int id) {
 		auto m = StringUtils::parseKeyValue(slaveLine, ',', '=');
 
 		if (m.find("ip") != m.end() && m.find("port") != m.end() && m.find("state") != m.end()) {
-			return RedisHost(id, m.at("ip"), atoi(m.at("port").c_str()), m.at("state"));
+			RedisHost host(id, m.at("ip"), atoi(m.at("port").c_str()), m.at("state"));
+			if (m.find("offset") != m.end()) host.offset = atoll(m.at("offset").c_str());
+			return host;
 		} else {
 			SLOGW << "Missing fields in the slaveline " << slaveLine;
 		}
@@ -36,6 +36,8 @@ struct RedisHost {
 	std::string address;
 	unsigned short port;
 	std::string state;
+	// Replication offset acknowledged by the slave, -1 if unknown (Redis < 2.8). Not part of the identity of the host.
+	long long offset = -1;
 };
 
 } // namespace flexisip::redis::async
@@ -962,7 +962,7 @@ int _main(int argc, const char* argv[], std::optional<pipe::WriteOnly>&& startup
 	 * We create an Agent in all cases, because it will declare config items that are necessary for presence server
 	 * to run.
 	 */
-	auto authDb = std::make_shared<AuthDb>(cfg);
+	auto authDb = std::make_shared<AuthDb>(cfg, root);
 	auto registrarDb = std::make_shared<RegistrarDb>(root, cfg);
 	a = make_shared<Agent>(root, cfg, authDb, registrarDb);
 	setOpenSSLThreadSafe();
@@ -17,9 +17,18 @@
 */
 
 #include <algorithm>
+#include <iterator>
 #include <list>
+#include <vector>
+
+#include <fcntl.h>
 #include <poll.h>
 #include <sys/resource.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#endif
 
 #include "flexisip-config.h"
 
@@ -62,7 +71,8 @@ unsigned int PollFd::getREvents(int index) const {
 }
 
 RelayChannel::RelayChannel(RelaySession* relaySession, const RelayTransport& rt, bool preventLoops)
-    : mRelayTransport(rt), mRemoteIp(std::string("undefined")), mDir(SendRecv), mPacketsReceived{}, mPacketsSent{} {
+    : mServer(relaySession->getRelayServer()), mRelayTransport(rt), mRemoteIp(std::string("undefined")),
+      mDir(SendRecv), mPacketsReceived{}, mPacketsSent{} {
 	mPfdIndex = -1;
 	initializeRtpSession(relaySession);
 	mSockAddrSize[0] = mSockAddrSize[1] = 0;
@@ -82,6 +92,13 @@ void RelayChannel::initializeRtpSession(RelaySession* relaySession) {
 		bindIp = mRelayTransport.mPreferredFamily == AF_INET6 ? mRelayTransport.mIpv6BindAddress
 		                                                      : mRelayTransport.mIpv4BindAddress;
 	}
+	if (mServer->getDemuxTable()) {
+		mSession = nullptr;
+		mSharedSockets = true;
+		mRelayTransport.mRtpPort = mServer->getSharedSockets(bindIp, mSockets);
+		mRelayTransport.mRtcpPort = mRelayTransport.mRtpPort + 1;
+		return;
+	}
 	mSession = relaySession->getRelayServer()->createRtpSession(bindIp.c_str());
 	mRelayTransport.mRtpPort = rtp_session_get_local_port(mSession);
 	mRelayTransport.mRtcpPort = mRelayTransport.mRtpPort + 1;
@@ -94,7 +111,7 @@ bool RelayChannel::checkSocketsValid() {
 }
 
 RelayChannel::~RelayChannel() {
-	rtp_session_destroy(mSession);
+	if (mSession) rtp_session_destroy(mSession);
 }
 
 const char* RelayChannel::dirToString(Dir dir) {
@@ -167,6 +184,16 @@ void RelayChannel::setRemoteAddr(const string& ip, int rtp_port, int rtcp_port,
 		mSockAddrSize[1] = 0;
 		mIsOpen = false;
 	}
+	updateDemuxTable();
+}
+
+void RelayChannel::updateDemuxTable() {
+	auto* demuxTable = mServer->getDemuxTable();
+	if (!demuxTable) return;
+	for (int i = 0; i < 2; ++i) {
+		demuxTable->setRemoteAddress(this, i, i == 0 ? mRelayTransport.mRtpPort : mRelayTransport.mRtcpPort,
+		                             (struct sockaddr*)&mSockAddr[i], mSockAddrSize[i]);
+	}
 }
 
 void RelayChannel::setDirection(Dir value) {
@@ -179,6 +206,7 @@ RelayChannel::Dir RelayChannel::getDirection() const {
 void RelayChannel::fillPollFd(PollFd* pfd) {
 	mPfdIndex = -1;
 	if (mSockets[0] == -1) return; // no socket to monitor
+	if (mSharedSockets) return;    // monitored by the MediaRelayServer
 	for (int i = 0; i < 2; ++i) {
 		int index = pfd->addFd(mSockets[i], POLLIN);
 		if (mPfdIndex == -1) mPfdIndex = index;
@@ -192,77 +220,132 @@ bool RelayChannel::checkPollFd(const PollFd* pfd, int i) {
 	return false;
 }
 
-int RelayChannel::recv(int i, uint8_t* buf, size_t buflen, time_t curTime) {
-	struct sockaddr_storage ss;
-	socklen_t addrsize = sizeof(ss);
-
-	int err = recvfrom(mSockets[i], buf, buflen, 0, (struct sockaddr*)&ss, &addrsize);
-	if (err > 0) {
-		mPacketsReceived[i]++;
-		mRecvErrorCount[i] = 0;
-		if (addrsize != mSockAddrSize[i] || memcmp(&ss, &mSockAddr[i], addrsize) != 0) {
-			if (curTime - mSockAddrLastUseTime[i] > sDestinationSwitchTimeout) {
-				char ipPort[128] = {0};
-				string localIp = mRelayTransport.mPreferredFamily == AF_INET6
-				                     ? (string("[") + mRelayTransport.mIpv6Address + string("]"))
-				                     : mRelayTransport.mIpv4Address;
-				bctbx_sockaddr_to_printable_ip_address((struct sockaddr*)&ss, addrsize, ipPort, sizeof(ipPort));
-				LOGD("RelayChannel [%p] destination address updated for [%s]: local=[%s:%i]  remote=[%s]", this,
-				     i == 0 ? "RTP" : "RTCP", localIp.c_str(),
-				     i == 0 ? mRelayTransport.mRtpPort : mRelayTransport.mRtcpPort, ipPort);
-				mSockAddrSize[i] = addrsize;
-				memcpy(&mSockAddr[i], &ss, addrsize);
-				mDestAddrChanged = true;
-				mSockAddrLastUseTime[i] = curTime;
-			} else {
-				/* We receive from new remote address. Wait that previous remote address is not used for
-				 * sDestinationSwitchTimeout seconds before deciding to switch to the new one.
-				 */
+bool RelayChannel::onPacketReceived(
+    int i, uint8_t* buf, size_t len, const sockaddr_storage& ss, socklen_t addrsize, time_t curTime) {
+	mPacketsReceived[i]++;
+	mRecvErrorCount[i] = 0;
+	if (addrsize != mSockAddrSize[i] || memcmp(&ss, &mSockAddr[i], addrsize) != 0) {
+		if (curTime - mSockAddrLastUseTime[i] > sDestinationSwitchTimeout) {
+			char ipPort[128] = {0};
+			string localIp = mRelayTransport.mPreferredFamily == AF_INET6
+			                     ? (string("[") + mRelayTransport.mIpv6Address + string("]"))
+			                     : mRelayTransport.mIpv4Address;
+			bctbx_sockaddr_to_printable_ip_address((struct sockaddr*)&ss, addrsize, ipPort, sizeof(ipPort));
+			const int localPort = i == 0 ? mRelayTransport.mRtpPort : mRelayTransport.mRtcpPort;
+			LOGD("RelayChannel [%p] destination address updated for [%s]: local=[%s:%i]  remote=[%s]", this,
+			     i == 0 ? "RTP" : "RTCP", localIp.c_str(), localPort, ipPort);
+			mSockAddrSize[i] = addrsize;
+			memcpy(&mSockAddr[i], &ss, addrsize);
+			mDestAddrChanged = true;
+			mSockAddrLastUseTime[i] = curTime;
+			if (auto* demuxTable = mServer->getDemuxTable()) {
+				demuxTable->setRemoteAddress(this, i, localPort, (struct sockaddr*)&mSockAddr[i], mSockAddrSize[i]);
 			}
 		} else {
-			/* The remote address from which we are receiving packets hasn't changed, just update last use time. */
-			mSockAddrLastUseTime[i] = curTime;
+			/* We receive from new remote address. Wait that previous remote address is not used for
+			 * sDestinationSwitchTimeout seconds before deciding to switch to the new one.
+			 */
 		}
+	} else {
+		/* The remote address from which we are receiving packets hasn't changed, just update last use time. */
+		mSockAddrLastUseTime[i] = curTime;
+	}
 
-		if (!mIsOpen || mDir == SendOnly || mDir == Inactive) {
-			/*LOGD("ignored packet");*/
-			return 0;
-		}
-		if (mFilter &&
-		    mFilter->onIncomingTransfer(buf, buflen, (struct sockaddr*)&mSockAddr[i], mSockAddrSize[i]) == false) {
-			return 0;
-		}
-	} else if (err == -1) {
+	if (!mIsOpen || mDir == SendOnly || mDir == Inactive) {
+		/*LOGD("ignored packet");*/
+		return false;
+	}
+	if (mFilter && mFilter->onIncomingTransfer(buf, len, (struct sockaddr*)&mSockAddr[i], mSockAddrSize[i]) == false) {
+		return false;
+	}
+	return true;
+}
+
+int RelayChannel::recv(int i, RelayPacketBatch& batch, time_t curTime) {
+	if (batch.read(mSockets[i]) == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
 		LOGW("Error receiving on port %i from %s:%i: %s", mRelayTransport.mRtpPort, mRemoteIp.c_str(), mRemotePort[i],
 		     strerror(errno));
 		if (errno == ECONNREFUSED) {
 			mRecvErrorCount[i]++;
 		}
+		return -1;
 	}
-	return err;
+	if (batch.size() == 0) return 0;
+	mServer->onPacketsReceived(batch.size());
+	return processReceived(i, batch, curTime);
 }
 
-int RelayChannel::send(int i, uint8_t* buf, size_t buflen) {
-	int err = 0;
+int RelayChannel::processReceived(int i, RelayPacketBatch& batch, time_t curTime) {
+	int toForward = 0;
+	for (size_t k = 0; k < batch.size(); ++k) {
+		if (batch.mLengths[k] > 0 && onPacketReceived(i, batch.data(k), batch.mLengths[k], batch.mAddrs[k],
+		                                              batch.mAddrSizes[k], curTime)) {
+			toForward++;
+		} else {
+			batch.mLengths[k] = 0;
+		}
+	}
+	return toForward;
+}
+
+void RelayChannel::send(int i, RelayPacketBatch& batch) {
 	/*if destination address is working mSockAddrSize>0*/
-	if (mRemotePort[i] > 0 && mSockAddrSize[i] > 0 && mDir != Inactive && mRecvErrorCount[i] < sMaxRecvErrors &&
-	    mIsOpen) {
-		if (!mFilter || mFilter->onOutgoingTransfer(buf, buflen, (struct sockaddr*)&mSockAddr[i], mSockAddrSize[i])) {
-			int localPort = (i == 0) ? mRelayTransport.mRtpPort : mRelayTransport.mRtcpPort;
-			err = sendto(mSockets[i], buf, buflen, 0, (struct sockaddr*)&mSockAddr[i], mSockAddrSize[i]);
-			mPacketsSent[i]++;
-			if (err == -1) {
-				LOGW("Error sending %i bytes (localport=%i dest=%s:%i) : %s", (int)buflen, localPort, mRemoteIp.c_str(),
-				     mRemotePort[i], strerror(errno));
-			} else if (err != (int)buflen) {
-				LOGW("Only %i bytes sent over %i bytes (localport=%i dest=%s:%i)", err, (int)buflen, localPort,
-				     mRemoteIp.c_str(), mRemotePort[i]);
+	if (mRemotePort[i] <= 0 || mSockAddrSize[i] == 0 || mDir == Inactive || mRecvErrorCount[i] >= sMaxRecvErrors ||
+	    !mIsOpen) {
+		/*LOGW("Not sending media, destination not valid or inactive stream."); */
+		return;
+	}
+	int localPort = (i == 0) ? mRelayTransport.mRtpPort : mRelayTransport.mRtcpPort;
+	auto* destAddr = (struct sockaddr*)&mSockAddr[i];
+	size_t count = 0;
+#ifdef __linux__
+	for (size_t k = 0; k < batch.mCount; ++k) {
+		size_t len = batch.mLengths[k];
+		if (len == 0) continue;
+		if (mFilter && !mFilter->onOutgoingTransfer(batch.data(k), len, destAddr, mSockAddrSize[i])) continue;
+		batch.mSendIovs[count].iov_base = batch.data(k);
+		batch.mSendIovs[count].iov_len = len;
+		auto& hdr = batch.mSendHeaders[count].msg_hdr;
+		hdr.msg_name = destAddr;
+		hdr.msg_namelen = mSockAddrSize[i];
+		count++;
+	}
+	if (count == 0) return;
+	int err = sendmmsg(mSockets[i], batch.mSendHeaders.data(), count, 0);
+	mPacketsSent[i] += count;
+	mServer->onPacketsSent(count);
+	if (err == -1) {
+		LOGW("Error sending %zu packets (localport=%i dest=%s:%i) : %s", count, localPort, mRemoteIp.c_str(),
+		     mRemotePort[i], strerror(errno));
+	} else if (err != (int)count) {
+		LOGW("Only %i packets sent over %zu (localport=%i dest=%s:%i)", err, count, localPort, mRemoteIp.c_str(),
+		     mRemotePort[i]);
+	} else {
+		for (size_t k = 0; k < count; ++k) {
+			if (batch.mSendHeaders[k].msg_len != batch.mSendIovs[k].iov_len) {
+				LOGW("Only %u bytes sent over %zu bytes (localport=%i dest=%s:%i)", batch.mSendHeaders[k].msg_len,
+				     batch.mSendIovs[k].iov_len, localPort, mRemoteIp.c_str(), mRemotePort[i]);
 			}
 		}
-	} else {
-		/*LOGW("Not sending media, destination not valid or inactive stream."); */
 	}
-	return err;
+#else
+	for (size_t k = 0; k < batch.mCount; ++k) {
+		size_t len = batch.mLengths[k];
+		if (len == 0) continue;
+		if (mFilter && !mFilter->onOutgoingTransfer(batch.data(k), len, destAddr, mSockAddrSize[i])) continue;
+		int err = sendto(mSockets[i], batch.data(k), len, 0, destAddr, mSockAddrSize[i]);
+		mPacketsSent[i]++;
+		mServer->onPacketsSent(1);
+		if (err == -1) {
+			LOGW("Error sending %i bytes (localport=%i dest=%s:%i) : %s", (int)len, localPort, mRemoteIp.c_str(),
+			     mRemotePort[i], strerror(errno));
+		} else if (err != (int)len) {
+			LOGW("Only %i bytes sent over %i bytes (localport=%i dest=%s:%i)", err, (int)len, localPort,
+			     mRemoteIp.c_str(), mRemotePort[i]);
+		}
+	}
+#endif
 }
 
 void RelayChannel::setFilter(shared_ptr<MediaFilter> filter) {
@@ -293,26 +376,28 @@ shared_ptr<RelayChannel> RelaySession::getChannel(const string& partyId, const s
 
 std::shared_ptr<RelayChannel>
 RelaySession::createBranch(const std::string& trId, const RelayTransport& rt, bool hasMultipleTargets) {
-	shared_ptr<RelayChannel> ret;
-	mMutex.lock();
-	ret = make_shared<RelayChannel>(this, rt, mServer->loopPreventionEnabled());
+	/* Create the channel without holding the mutex, as it may need the MediaRelayServer's one to get its sockets. */
+	auto ret = make_shared<RelayChannel>(this, rt, mServer->loopPreventionEnabled());
 	ret->setMultipleTargets(hasMultipleTargets);
+	mMutex.lock();
 	mBacks.insert(make_pair(trId, ret));
 	mMutex.unlock();
+	mServer->registerChannel(shared_from_this(), ret);
 	LOGD("RelaySession [%p]: branch corresponding to transaction [%s] added.", this, trId.c_str());
 	return ret;
 }
 
 void RelaySession::removeBranch(const std::string& trId) {
-	bool removed = false;
+	shared_ptr<RelayChannel> removed;
 	mMutex.lock();
 	auto it = mBacks.find(trId);
 	if (it != mBacks.end()) {
-		removed = true;
+		removed = (*it).second;
 		mBacks.erase(it);
 	}
 	mMutex.unlock();
 	if (removed) {
+		if (removed != mBack) mServer->unregisterChannel(removed);
 		LOGD("RelaySession [%p]: branch corresponding to transaction [%s] removed.", this, trId.c_str());
 	}
 }
@@ -333,10 +418,17 @@ void RelaySession::setEstablished(const std::string& tr_id) {
 	shared_ptr<RelayChannel> winner = getChannel("", tr_id);
 	if (winner) {
 		LOGD("RelaySession [%p] is established.", this);
+		list<shared_ptr<RelayChannel>> losers;
 		mMutex.lock();
 		mBack = winner;
+		for (const auto& branch : mBacks) {
+			if (branch.second != winner) losers.push_back(branch.second);
+		}
 		mBacks.clear();
 		mMutex.unlock();
+		for (const auto& loser : losers) {
+			mServer->unregisterChannel(loser);
+		}
 	} else LOGE("RelaySession [%p] is with from an unknown branch [%s].", this, tr_id.c_str());
 }
 
@@ -370,6 +462,21 @@ void RelaySession::checkPollFd(const PollFd* pfd, time_t curtime) {
 	mMutex.unlock();
 }
 
+bool RelaySession::hasChannel(const shared_ptr<RelayChannel>& chan) const {
+	if (chan == mFront || chan == mBack) return true;
+	if (mBack) return false;
+	for (const auto& branch : mBacks) {
+		if (branch.second == chan) return true;
+	}
+	return false;
+}
+
+void RelaySession::onChannelReadable(time_t curtime, const shared_ptr<RelayChannel>& chan, int i) {
+	mMutex.lock();
+	if (mUsed && hasChannel(chan)) transfer(curtime, chan, i);
+	mMutex.unlock();
+}
+
 RelaySession::~RelaySession() {
 	LOGD("RelaySession %p destroyed", this);
 }
@@ -394,7 +501,12 @@ void RelaySession::unuse() {
 
 	/* Do not log while holding a mutex, so copy out statistics first, and then display them. */
 
+	list<shared_ptr<RelayChannel>> channels;
 	mMutex.lock();
+	if (!mUsed) {
+		mMutex.unlock();
+		return;
+	}
 	mUsed = false;
 	for (int componentID = 0; componentID < 2; ++componentID) {
 		if (mFront) {
@@ -410,11 +522,21 @@ void RelaySession::unuse() {
 			back[componentID].sent = mBack->getSentPackets(componentID);
 		}
 	}
+	if (mFront) channels.push_back(mFront);
+	if (mBack) channels.push_back(mBack);
+	for (const auto& branch : mBacks) {
+		channels.push_back(branch.second);
+	}
 	mFront.reset();
 	mBacks.clear();
 	mBack.reset();
 	mMutex.unlock();
 
+	for (const auto& chan : channels) {
+		mServer->unregisterChannel(chan);
+	}
+	mServer->onSessionTerminated();
+
 	if (front[0].port != 0) {
 		Statistics::log(front, "Caller side");
 	}
@@ -440,34 +562,274 @@ bool RelaySession::checkChannels() {
 }
 
 void RelaySession::transfer(time_t curtime, const shared_ptr<RelayChannel>& chan, int i) {
-	uint8_t buf[1500];
-	const int maxsize = sizeof(buf);
-	int recv_len;
+	RelayPacketBatch& batch = mServer->getPacketBatch();
 
 	mLastActivityTime = curtime;
-	recv_len = chan->recv(i, buf, maxsize, curtime);
-	if (recv_len > 0) {
-		if (chan == mFront) {
-			if (mBack) {
-				mBack->send(i, buf, recv_len);
-			} else {
-				for (auto it = mBacks.begin(); it != mBacks.end(); ++it) {
-					shared_ptr<RelayChannel> dest = (*it).second;
-					dest->send(i, buf, recv_len);
-				}
-			}
+	if (chan->recv(i, batch, curtime) > 0) forward(chan, i, batch);
+}
+
+void RelaySession::forward(const shared_ptr<RelayChannel>& chan, int i, RelayPacketBatch& batch) {
+	if (chan == mFront) {
+		if (mBack) {
+			mBack->send(i, batch);
 		} else {
-			mFront->send(i, buf, recv_len);
+			for (auto it = mBacks.begin(); it != mBacks.end(); ++it) {
+				shared_ptr<RelayChannel> dest = (*it).second;
+				dest->send(i, batch);
+			}
+		}
+	} else {
+		mFront->send(i, batch);
+	}
+}
+
+void RelaySession::onPacketsDemultiplexed(time_t curtime,
+                                          const shared_ptr<RelayChannel>& chan,
+                                          int i,
+                                          RelayPacketBatch& batch) {
+	mMutex.lock();
+	if (mUsed && hasChannel(chan)) {
+		mLastActivityTime = curtime;
+		if (chan->processReceived(i, batch, curtime) > 0) forward(chan, i, batch);
+	}
+	mMutex.unlock();
+}
+
+RelayPacketBatch::RelayPacketBatch(size_t capacity)
+    : mBuffers(max<size_t>(capacity, 1)), mLengths(mBuffers.size()), mAddrs(mBuffers.size()),
+      mAddrSizes(mBuffers.size()) {
+#ifdef __linux__
+	mRecvIovs.resize(mBuffers.size());
+	mRecvHeaders.resize(mBuffers.size());
+	mSendIovs.resize(mBuffers.size());
+	mSendHeaders.resize(mBuffers.size());
+	for (size_t k = 0; k < mBuffers.size(); ++k) {
+		mRecvIovs[k].iov_base = mBuffers[k].data();
+		mRecvIovs[k].iov_len = sMaxPacketSize;
+		mRecvHeaders[k].msg_hdr = {};
+		mRecvHeaders[k].msg_hdr.msg_name = &mAddrs[k];
+		mRecvHeaders[k].msg_hdr.msg_namelen = sizeof(mAddrs[k]);
+		mRecvHeaders[k].msg_hdr.msg_iov = &mRecvIovs[k];
+		mRecvHeaders[k].msg_hdr.msg_iovlen = 1;
+		mSendHeaders[k].msg_hdr = {};
+		mSendHeaders[k].msg_hdr.msg_iov = &mSendIovs[k];
+		mSendHeaders[k].msg_hdr.msg_iovlen = 1;
+	}
+#endif
+}
+
+int RelayPacketBatch::read(int fd) {
+	mCount = 0;
+#ifdef __linux__
+	for (size_t k = 0; k < capacity(); ++k) {
+		mRecvHeaders[k].msg_hdr.msg_namelen = sizeof(mAddrs[k]);
+		mRecvHeaders[k].msg_len = 0;
+	}
+	int err = recvmmsg(fd, mRecvHeaders.data(), capacity(), MSG_DONTWAIT, nullptr);
+	if (err > 0) {
+		mCount = err;
+		for (size_t k = 0; k < mCount; ++k) {
+			mLengths[k] = mRecvHeaders[k].msg_len;
+			mAddrSizes[k] = mRecvHeaders[k].msg_hdr.msg_namelen;
+		}
+	}
+#else
+	mAddrSizes[0] = sizeof(mAddrs[0]);
+	int err = recvfrom(fd, data(0), sMaxPacketSize, 0, (struct sockaddr*)&mAddrs[0], &mAddrSizes[0]);
+	if (err > 0) {
+		mLengths[0] = err;
+		mCount = 1;
+	}
+#endif
+	return err == -1 ? -1 : static_cast<int>(mCount);
+}
+
+size_t RelayDemuxTable::AddressKeyHash::operator()(const AddressKey& key) const {
+	size_t h = std::hash<int>()(key.localPort) ^ (std::hash<uint16_t>()(key.remotePort) << 1);
+	for (size_t i = 0; i < key.remoteIp.size(); i += sizeof(uint32_t)) {
+		uint32_t word;
+		memcpy(&word, &key.remoteIp[i], sizeof(word));
+		h = h * 31 + std::hash<uint32_t>()(word);
+	}
+	return h;
+}
+
+bool RelayDemuxTable::makeAddressKey(int localPort, const sockaddr* addr, socklen_t addrlen, AddressKey& key) {
+	key.localPort = localPort;
+	if (addr->sa_family == AF_INET && addrlen >= sizeof(struct sockaddr_in)) {
+		const auto* sin = reinterpret_cast<const struct sockaddr_in*>(addr);
+		key.remotePort = ntohs(sin->sin_port);
+		key.remoteIp.fill(0);
+		key.remoteIp[10] = key.remoteIp[11] = 0xff;
+		memcpy(&key.remoteIp[12], &sin->sin_addr, 4);
+		return true;
+	}
+	if (addr->sa_family == AF_INET6 && addrlen >= sizeof(struct sockaddr_in6)) {
+		const auto* sin6 = reinterpret_cast<const struct sockaddr_in6*>(addr);
+		key.remotePort = ntohs(sin6->sin6_port);
+		memcpy(key.remoteIp.data(), &sin6->sin6_addr, 16);
+		return true;
+	}
+	return false;
+}
+
+bool RelayDemuxTable::getSsrc(const uint8_t* data, size_t len, bool isRtcp, uint32_t& ssrc) {
+	/* RTP packets have the SSRC after the sequence number and timestamp, RTCP ones have the sender's SSRC right after
+	 * the common header (packet type and length). */
+	const size_t offset = isRtcp ? 4 : 8;
+	if (len < offset + 4 || (data[0] >> 6) != 2) return false;
+	ssrc = (uint32_t(data[offset]) << 24) | (uint32_t(data[offset + 1]) << 16) | (uint32_t(data[offset + 2]) << 8) |
+	       uint32_t(data[offset + 3]);
+	return true;
+}
+
+void RelayDemuxTable::addChannel(const shared_ptr<RelaySession>& session, const shared_ptr<RelayChannel>& chan) {
+	mMutex.lock();
+	auto& record = mChannels[chan.get()];
+	record.session = session;
+	record.channel = chan;
+	mMutex.unlock();
+}
+
+void RelayDemuxTable::removeChannel(const RelayChannel* chan) {
+	mMutex.lock();
+	auto it = mChannels.find(chan);
+	if (it != mChannels.end()) {
+		const auto& record = (*it).second;
+		for (int i = 0; i < 2; ++i) {
+			if (!record.hasAddress[i]) continue;
+			auto addrIt = mByAddress.find(record.addresses[i]);
+			if (addrIt != mByAddress.end() && (*addrIt).second == chan) mByAddress.erase(addrIt);
+			removeWaitingChannel(chan, record.addresses[i]);
+		}
+		for (auto ssrcKey : record.ssrcKeys) {
+			auto ssrcIt = mBySsrc.find(ssrcKey);
+			if (ssrcIt != mBySsrc.end() && (*ssrcIt).second == chan) mBySsrc.erase(ssrcIt);
+		}
+		mChannels.erase(it);
+	}
+	mMutex.unlock();
+}
+
+void RelayDemuxTable::setRemoteAddress(
+    const RelayChannel* chan, int i, int localPort, const sockaddr* addr, socklen_t addrlen) {
+	AddressKey key{};
+	const bool valid = addrlen > 0 && makeAddressKey(localPort, addr, addrlen, key);
+	mMutex.lock();
+	auto it = mChannels.find(chan);
+	if (it == mChannels.end()) {
+		mMutex.unlock();
+		return;
+	}
+	auto& record = (*it).second;
+	if (record.hasAddress[i]) {
+		auto addrIt = mByAddress.find(record.addresses[i]);
+		if (addrIt != mByAddress.end() && (*addrIt).second == chan) mByAddress.erase(addrIt);
+		removeWaitingChannel(chan, record.addresses[i]);
+		record.hasAddress[i] = false;
+	}
+	if (valid) {
+		auto inserted = mByAddress.insert(make_pair(key, chan));
+		if (!inserted.second && (*inserted.first).second != chan) {
+			/* Another channel receives from this address on the same port: the most recent one wins, the other one
+			 * will only be found by SSRC. */
+			LOGD("RelayDemuxTable: channel [%p] takes over the address of channel [%p]", chan,
+			     (*inserted.first).second);
+			(*inserted.first).second = chan;
 		}
+		record.addresses[i] = key;
+		record.hasAddress[i] = true;
+		if (!record.hasReceived[i]) mWaitingByAddress.emplace(makeWaitingKey(key), chan);
 	}
+	mMutex.unlock();
+}
+
+const RelayChannel* RelayDemuxTable::findWaitingChannel(const AddressKey& key) const {
+	/* A NAT usually keeps the public IP announced in the SDP and only changes the port. The source is only given to a
+	 * channel if there is no ambiguity. */
+	auto range = mWaitingByAddress.equal_range(makeWaitingKey(key));
+	if (range.first == range.second || std::next(range.first) != range.second) return nullptr;
+	return (*range.first).second;
 }
 
-MediaRelayServer::MediaRelayServer(MediaRelay* module) : mModule(module) {
+void RelayDemuxTable::removeWaitingChannel(const RelayChannel* chan, const AddressKey& address) {
+	auto range = mWaitingByAddress.equal_range(makeWaitingKey(address));
+	for (auto it = range.first; it != range.second; ++it) {
+		if ((*it).second == chan) {
+			mWaitingByAddress.erase(it);
+			return;
+		}
+	}
+}
+
+bool RelayDemuxTable::find(
+    int localPort, const sockaddr* addr, socklen_t addrlen, const uint8_t* data, size_t len, bool isRtcp,
+    Target& target) {
+	AddressKey key{};
+	uint32_t ssrc = 0;
+	const bool hasSsrc = getSsrc(data, len, isRtcp, ssrc);
+	const RelayChannel* chan = nullptr;
+	bool learnSsrc = false;
+
+	mMutex.lock();
+	const bool hasKey = makeAddressKey(localPort, addr, addrlen, key);
+	if (hasKey) {
+		auto addrIt = mByAddress.find(key);
+		if (addrIt != mByAddress.end()) {
+			chan = (*addrIt).second;
+			learnSsrc = true;
+		}
+	}
+	if (!chan && hasSsrc) {
+		auto ssrcIt = mBySsrc.find(makeSsrcKey(localPort, ssrc));
+		if (ssrcIt != mBySsrc.end()) chan = (*ssrcIt).second;
+	}
+	if (!chan && hasKey) {
+		chan = findWaitingChannel(key);
+		learnSsrc = chan != nullptr;
+	}
+	if (chan) {
+		auto it = mChannels.find(chan);
+		if (it != mChannels.end()) {
+			auto& record = (*it).second;
+			target.session = record.session.lock();
+			target.channel = record.channel.lock();
+			for (int i = 0; i < 2; ++i) {
+				if (record.hasReceived[i] || !record.hasAddress[i] || record.addresses[i].localPort != localPort)
+					continue;
+				record.hasReceived[i] = true;
+				removeWaitingChannel(chan, record.addresses[i]);
+			}
+			if (learnSsrc && hasSsrc) {
+				auto ssrcKey = makeSsrcKey(localPort, ssrc);
+				if (mBySsrc.insert(make_pair(ssrcKey, chan)).second) record.ssrcKeys.push_back(ssrcKey);
+			}
+		}
+	}
+	mMutex.unlock();
+	return target.session && target.channel;
+}
+
+MediaRelayServer::MediaRelayServer(MediaRelay* module, int cpuIndex)
+    : mPacketBatch(module->mBatchSize), mModule(module), mCpuIndex(cpuIndex) {
 	mRunning = false;
 	mSessionsCount = 0;
 	if (pipe(mCtlPipe) == -1) {
 		LOGF("Could not create MediaRelayServer control pipe.");
 	}
+#ifdef __linux__
+	if (mModule->mUseEpoll) {
+		mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+		struct epoll_event ev {};
+		ev.events = EPOLLIN;
+		ev.data.u64 = sCtlPipeEventId;
+		if (mEpollFd == -1 || epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mCtlPipe[0], &ev) == -1) {
+			LOGE("MediaRelayServer [%p]: could not set up epoll (%s), falling back to poll()", this, strerror(errno));
+			if (mEpollFd != -1) close(mEpollFd);
+			mEpollFd = -1;
+		}
+	}
+#endif
 }
 
 Agent* MediaRelayServer::getAgent() {
@@ -498,6 +860,17 @@ RtpSession* MediaRelayServer::createRtpSession(const std::string& bindIp) {
 void MediaRelayServer::start() {
 	mRunning = true;
 	pthread_create(&mThread, NULL, &MediaRelayServer::threadFunc, this);
+#ifdef __linux__
+	if (mCpuIndex >= 0) {
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(mCpuIndex, &cpuSet);
+		int err = pthread_setaffinity_np(mThread, sizeof(cpuSet), &cpuSet);
+		if (err != 0) {
+			LOGW("MediaRelayServer [%p]: cannot pin relay thread to cpu %i: %s", this, mCpuIndex, strerror(err));
+		}
+	}
+#endif
 }
 
 MediaRelayServer::~MediaRelayServer() {
@@ -508,6 +881,12 @@ MediaRelayServer::~MediaRelayServer() {
 	}
 	mSessions.clear();
 	mSessionsCount = 0;
+	mRegisteredChannels.clear();
+	for (const auto& pair : mSharedSocketPairs) {
+		close(pair.sockets[0]);
+		close(pair.sockets[1]);
+	}
+	if (mEpollFd != -1) close(mEpollFd);
 	close(mCtlPipe[0]);
 	close(mCtlPipe[1]);
 }
@@ -516,9 +895,12 @@ shared_ptr<RelaySession> MediaRelayServer::createSession(const std::string& fron
                                                          const RelayTransport& frontRelayTransport) {
 	shared_ptr<RelaySession> s = make_shared<RelaySession>(this, frontId, frontRelayTransport);
 	mMutex.lock();
-	mSessions.push_back(s);
+	/* With epoll, sessions are kept alive by their RelayedCall and their channels by the epoll registrations, so there
+	 * is no need to hold them in a list that would have to be walked. */
+	if (mEpollFd == -1) mSessions.push_back(s);
 	mSessionsCount++;
 	mMutex.unlock();
+	registerChannel(s, s->getChannel(frontId, ""));
 	if (!mRunning) start();
 
 	LOGD("There are now %zu relay sessions running on MediaRelayServer [%p]", mSessionsCount, this);
@@ -528,10 +910,237 @@ shared_ptr<RelaySession> MediaRelayServer::createSession(const std::string& fron
 }
 
 void MediaRelayServer::update() {
+	/* The epoll set is updated as soon as channels are registered, no need to wake up the server thread. */
+	if (mEpollFd != -1) return;
 	/*write to the control pipe to wakeup the server thread */
 	if (write(mCtlPipe[1], "e", 1) == -1) LOGE("MediaRelayServer: fail to write to control pipe.");
 }
 
+void MediaRelayServer::registerChannel(const shared_ptr<RelaySession>& session, const shared_ptr<RelayChannel>& chan) {
+	if (!chan || !chan->checkSocketsValid()) return;
+	if (auto* demuxTable = getDemuxTable()) {
+		demuxTable->addChannel(session, chan);
+		// The remote address may have been set before the channel is registered.
+		chan->updateDemuxTable();
+		return;
+	}
+#ifdef __linux__
+	if (mEpollFd == -1) return;
+	postEpollCommand(EpollCommand{EpollCommand::Type::Add, session, chan});
+#endif
+}
+
+void MediaRelayServer::unregisterChannel(const shared_ptr<RelayChannel>& chan) {
+	if (!chan) return;
+	if (auto* demuxTable = getDemuxTable()) {
+		demuxTable->removeChannel(chan.get());
+		return;
+	}
+#ifdef __linux__
+	if (mEpollFd == -1) return;
+	/* The channel is kept alive by the command until the relay thread has removed its sockets from the epoll set. */
+	postEpollCommand(EpollCommand{EpollCommand::Type::Remove, {}, chan});
+#endif
+}
+
+void MediaRelayServer::postEpollCommand(EpollCommand&& command) {
+	mEpollCommands.push(std::move(command));
+	/* A single wake-up is enough for the relay thread to apply all commands queued until it clears the flag. */
+	if (!mEpollCommandsPending.exchange(true, std::memory_order_acq_rel)) {
+		if (write(mCtlPipe[1], "e", 1) == -1) LOGE("MediaRelayServer: fail to write to control pipe.");
+	}
+}
+
+void MediaRelayServer::applyEpollCommands() {
+#ifdef __linux__
+	/* Clear the flag first, so that commands posted while draining the queue trigger another wake-up. */
+	mEpollCommandsPending.store(false, std::memory_order_release);
+	EpollCommand command{};
+	while (mEpollCommands.pop(command)) {
+		const auto& chan = command.mChannel;
+		if (command.mType == EpollCommand::Type::Add) {
+			uint64_t id = mNextEpollId++;
+			for (int i = 0; i < 2; ++i) {
+				struct epoll_event ev {};
+				ev.events = EPOLLIN;
+				ev.data.u64 = (id << 1) | i;
+				if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, chan->getSocket(i), &ev) == -1) {
+					LOGE("MediaRelayServer [%p]: cannot register socket %i to epoll: %s", this, chan->getSocket(i),
+					     strerror(errno));
+				}
+			}
+			chan->setEpollId(id);
+			mRegisteredChannels[id] = ChannelRegistration{std::move(command.mSession), chan};
+		} else {
+			auto it = mRegisteredChannels.find(chan->getEpollId());
+			if (it != mRegisteredChannels.end()) {
+				for (int i = 0; i < 2; ++i) {
+					epoll_ctl(mEpollFd, EPOLL_CTL_DEL, chan->getSocket(i), nullptr);
+				}
+				mRegisteredChannels.erase(it);
+			}
+			chan->setEpollId(0);
+		}
+		// Release the channel now rather than when the next command is popped.
+		command = EpollCommand{};
+	}
+#endif
+}
+
+static constexpr auto kSharedSocketsDualStackIp = "::";
+
+static int openSharedSocket(const string& bindIp, int port) {
+	struct addrinfo hints {};
+	struct addrinfo* res = nullptr;
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV | AI_PASSIVE;
+	int err = getaddrinfo(bindIp.c_str(), to_string(port).c_str(), &hints, &res);
+	if (err != 0) {
+		LOGE("MediaRelayServer: invalid bind address [%s]: %s", bindIp.c_str(), gai_strerror(err));
+		return -1;
+	}
+	int fd = socket(res->ai_family, SOCK_DGRAM, 0);
+	if (fd == -1) {
+		LOGE("MediaRelayServer: cannot create socket: %s", strerror(errno));
+		freeaddrinfo(res);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	int on = 1, off = 0;
+	/* All relay threads bind their own socket to the same ports, the kernel balances incoming packets between them. */
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1) {
+		LOGW("MediaRelayServer: cannot set SO_REUSEPORT: %s", strerror(errno));
+	}
+	/* Only the IPv6 wildcard socket is dual-stack, see getSharedSockets(). Others must not receive IPv4 packets, that
+	 * would otherwise be balanced between them and the IPv4 sockets bound to the same port. */
+	const int* v6Only = bindIp == kSharedSocketsDualStackIp ? &off : &on;
+	if (res->ai_family == AF_INET6 && setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, v6Only, sizeof(*v6Only)) == -1) {
+		LOGW("MediaRelayServer: cannot set IPV6_V6ONLY on socket: %s", strerror(errno));
+	}
+	if (::bind(fd, res->ai_addr, res->ai_addrlen) == -1) {
+		LOGE("MediaRelayServer: cannot bind socket to [%s]:%i: %s", bindIp.c_str(), port, strerror(errno));
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+	return fd;
+}
+
+bool MediaRelayServer::openSharedSocketPool(const string& bindIp, SharedSocketPool& pool) {
+	for (int port : mModule->mSharedPorts) {
+		SharedSocketPair pair{port, {openSharedSocket(bindIp, port), openSharedSocket(bindIp, port + 1)}};
+		if (pair.sockets[0] == -1 || pair.sockets[1] == -1) {
+			if (pair.sockets[0] != -1) close(pair.sockets[0]);
+			if (pair.sockets[1] != -1) close(pair.sockets[1]);
+			continue;
+		}
+		pool.pairs.push_back(mSharedSocketPairs.size());
+		mSharedSocketPairs.push_back(pair);
+#ifdef __linux__
+		if (mEpollFd != -1) {
+			for (int i = 0; i < 2; ++i) {
+				struct epoll_event ev {};
+				ev.events = EPOLLIN;
+				/* Everything needed to read the socket is in the event, the relay thread has no table to look up. */
+				ev.data.u64 = sSharedSocketEventFlag | (uint64_t(port) << 32) | (uint64_t(pair.sockets[i]) << 1) | i;
+				if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, pair.sockets[i], &ev) == -1) {
+					LOGE("MediaRelayServer [%p]: cannot register shared socket to epoll: %s", this, strerror(errno));
+				}
+			}
+		}
+#endif
+	}
+	if (pool.pairs.empty()) {
+		LOGE("MediaRelayServer [%p]: no shared relay socket could be opened on [%s]", this, bindIp.c_str());
+		return false;
+	}
+	LOGI("MediaRelayServer [%p]: %zu shared relay socket pairs opened on [%s]", this, pool.pairs.size(),
+	     bindIp.c_str());
+	return true;
+}
+
+MediaRelayServer::SharedSocketPool& MediaRelayServer::getSharedSocketPool(const string& bindIp) {
+	auto it = mSharedSocketPools.find(bindIp);
+	if (it == mSharedSocketPools.end()) {
+		it = mSharedSocketPools.emplace(bindIp, SharedSocketPool{}).first;
+		openSharedSocketPool(bindIp, (*it).second);
+	}
+	return (*it).second;
+}
+
+int MediaRelayServer::getSharedSockets(const string& bindIp, int sockets[2]) {
+	int port = -1;
+	sockets[0] = sockets[1] = -1;
+	mMutex.lock();
+	/* Both wildcard addresses are served by a single pool of dual-stack sockets: sockets of both families bound to the
+	 * same port would split the IPv4 packets of a call between them. The IPv4 sockets are only used if IPv6 is not
+	 * available. */
+	auto* pool = &getSharedSocketPool(bindIp == "0.0.0.0" ? kSharedSocketsDualStackIp : bindIp);
+	if (pool->pairs.empty() && bindIp == "0.0.0.0") pool = &getSharedSocketPool(bindIp);
+	if (!pool->pairs.empty()) {
+		const auto& pair = mSharedSocketPairs[pool->pairs[pool->next++ % pool->pairs.size()]];
+		sockets[0] = pair.sockets[0];
+		sockets[1] = pair.sockets[1];
+		port = pair.port;
+	}
+	mMutex.unlock();
+	/* Wake up the poll() loop so that it monitors the new sockets. */
+	if (mEpollFd == -1) update();
+	return port;
+}
+
+void MediaRelayServer::onSharedSocketReadable(int fd, int localPort, int i, time_t curtime) {
+	RelayPacketBatch& batch = mPacketBatch;
+	int err = batch.read(fd);
+	if (err == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+		LOGW("MediaRelayServer [%p]: error receiving on shared port %i: %s", this, localPort, strerror(errno));
+	}
+	if (err <= 0) return;
+	onPacketsReceived(batch.size());
+
+	/* Find the destination of every packet, then hand over to each session the packets destined to it, keeping their
+	 * order. */
+	const auto count = batch.size();
+	auto& lengths = mDemuxLengths;
+	auto& targets = mDemuxTargets;
+	lengths.resize(count);
+	targets.resize(count);
+	auto* demuxTable = getDemuxTable();
+	for (size_t k = 0; k < count; ++k) {
+		lengths[k] = batch.length(k);
+		targets[k] = {};
+		if (!demuxTable->find(localPort, (const struct sockaddr*)&batch.address(k), batch.addressSize(k),
+		                      batch.data(k), lengths[k], i == 1, targets[k])) {
+			LOGD("MediaRelayServer [%p]: dropping packet received on shared port %i from unknown source", this,
+			     localPort);
+		}
+	}
+	for (size_t k = 0; k < count; ++k) {
+		if (!targets[k].channel) continue;
+		const auto target = targets[k];
+		for (size_t l = 0; l < count; ++l) {
+			if (l >= k && targets[l].channel == target.channel) {
+				batch.setLength(l, lengths[l]);
+				targets[l] = {};
+			} else {
+				batch.setLength(l, 0);
+			}
+		}
+		target.session->onPacketsDemultiplexed(curtime, target.channel, i, batch);
+	}
+}
+
+void MediaRelayServer::onSessionTerminated() {
+	/* With poll, sessions are removed from the list, and counted, by the server thread. */
+	if (mEpollFd == -1) return;
+	mMutex.lock();
+	mSessionsCount--;
+	mMutex.unlock();
+	LOGD("There are now %zu relay sessions running on MediaRelayServer [%p]", mSessionsCount, this);
+}
+
 static void set_high_prio() {
 	struct sched_param param;
 	int policy = SCHED_RR;
@@ -563,11 +1172,85 @@ static void set_high_prio() {
 }
 
 void MediaRelayServer::run() {
+	set_high_prio();
+	if (mEpollFd != -1) runEpoll();
+	else runPoll();
+}
+
+void MediaRelayServer::readCtlPipe() {
+	char tmp;
+	if (read(mCtlPipe[0], &tmp, 1) == -1) {
+		LOGE("Fail to read from control pipe.");
+	}
+}
+
+void MediaRelayServer::runEpoll() {
+#ifdef __linux__
+	struct epoll_event events[sMaxEpollEvents];
+	struct ReadyChannel {
+		shared_ptr<RelaySession> session;
+		shared_ptr<RelayChannel> channel;
+		int component;
+	};
+	struct ReadySharedSocket {
+		int fd;
+		int port;
+		int component;
+	};
+	vector<ReadyChannel> readyChannels;
+	vector<ReadySharedSocket> readySharedSockets;
+	readyChannels.reserve(sMaxEpollEvents);
+	readySharedSockets.reserve(sMaxEpollEvents);
+
+	while (mRunning) {
+		int nevents = epoll_wait(mEpollFd, events, sMaxEpollEvents, 1000);
+		if (nevents <= 0) {
+			if (nevents == -1 && errno != EINTR) LOGE("MediaRelayServer: epoll_wait() failed: %s", strerror(errno));
+			continue;
+		}
+		/* Apply pending registrations before resolving the events, so that none of them refers to a channel that was
+		 * unregistered in the meantime. Neither step needs the server mutex. */
+		for (int i = 0; i < nevents; ++i) {
+			if (events[i].data.u64 == sCtlPipeEventId) readCtlPipe();
+		}
+		applyEpollCommands();
+		for (int i = 0; i < nevents; ++i) {
+			uint64_t eventId = events[i].data.u64;
+			if (eventId == sCtlPipeEventId) continue;
+			if (eventId & sSharedSocketEventFlag) {
+				const int component = eventId & 1;
+				const int fd = static_cast<int>((eventId >> 1) & 0x7fffffff);
+				const int port = static_cast<int>((eventId >> 32) & 0xffff);
+				readySharedSockets.push_back({fd, port + component, component});
+				continue;
+			}
+			auto it = mRegisteredChannels.find(eventId >> 1);
+			if (it == mRegisteredChannels.end()) continue; // channel unregistered in the meantime
+			auto session = (*it).second.mSession.lock();
+			if (!session) continue;
+			readyChannels.push_back({std::move(session), (*it).second.mChannel, static_cast<int>(eventId & 1)});
+		}
+
+		time_t curtime = getCurrentTime();
+		for (const auto& ready : readyChannels) {
+			ready.session->onChannelReadable(curtime, ready.channel, ready.component);
+		}
+		readyChannels.clear();
+		for (const auto& ready : readySharedSockets) {
+			onSharedSocketReadable(ready.fd, ready.port, ready.component, curtime);
+		}
+		readySharedSockets.clear();
+	}
+#endif
+}
+
+void MediaRelayServer::runPoll() {
 	PollFd pfd(512);
 	int ctl_index;
 	int err;
+	vector<SharedSocketPair> sharedSocketPairs;
+	int sharedSocketsIndex;
 
-	set_high_prio();
 	while (mRunning) {
 		pfd.reset();
 		// fill the pollfd table
@@ -575,20 +1258,31 @@ void MediaRelayServer::run() {
 		for (auto it = mSessions.begin(); it != mSessions.end(); ++it) {
 			if ((*it)->isUsed()) (*it)->fillPollFd(&pfd);
 		}
+		sharedSocketPairs = mSharedSocketPairs;
 		mMutex.unlock();
 
+		sharedSocketsIndex = pfd.getCurIndex();
+		for (const auto& pair : sharedSocketPairs) {
+			pfd.addFd(pair.sockets[0], POLLIN);
+			pfd.addFd(pair.sockets[1], POLLIN);
+		}
 		ctl_index = pfd.addFd(mCtlPipe[0], POLLIN);
 
 		err = poll(pfd.getPfd(), pfd.getCurIndex(), 1000);
 		if (err > 0) {
 			// examine pollfd results
 			if (pfd.getREvents(ctl_index) & POLLIN) {
-				char tmp;
-				if (read(mCtlPipe[0], &tmp, 1) == -1) {
-					LOGE("Fail to read from control pipe.");
-				}
+				readCtlPipe();
 			}
 			time_t curtime = getCurrentTime();
+			for (size_t pairIndex = 0; pairIndex < sharedSocketPairs.size(); ++pairIndex) {
+				for (int i = 0; i < 2; ++i) {
+					if (pfd.getREvents(sharedSocketsIndex + 2 * pairIndex + i) & POLLIN) {
+						const auto& pair = sharedSocketPairs[pairIndex];
+						onSharedSocketReadable(pair.sockets[i], pair.port + i, i, curtime);
+					}
+				}
+			}
 			mMutex.lock();
 			for (auto it = mSessions.begin(); it != mSessions.end();) {
 				if (!(*it)->isUsed()) {
@@ -18,6 +18,14 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+
 #include <ortp/rtpsession.h>
 
 #include "flexisip/module.hh"
@@ -25,11 +33,13 @@
 #include "agent.hh"
 #include "callstore.hh"
 #include "sdp-modifier.hh"
+#include "utils/thread/mpsc-queue.hh"
 
 namespace flexisip {
 
 class RelayedCall;
 class MediaRelayServer;
+class RelayDemuxTable;
 
 class MediaRelay : public Module {
 	friend std::shared_ptr<Module> ModuleInfo<MediaRelay>::create(Agent*);
@@ -47,8 +57,11 @@ public:
 private:
 	MediaRelay(Agent* ag, const ModuleInfoBase* moduleInfo);
 
+	void updateRelayStats();
 	bool isInviteOrUpdate(sip_method_t method) const;
 	void createServers();
+	/* Picks the relay server of a new call, either in a round-robin fashion or by hashing its Call-ID. */
+	const std::shared_ptr<MediaRelayServer>& selectServer(const sip_t* sip);
 	bool processNewInvite(const std::shared_ptr<RelayedCall>& c,
 	                      const std::shared_ptr<OutgoingTransaction>& transaction,
 	                      const std::shared_ptr<RequestSipEvent>& ev);
@@ -77,6 +90,17 @@ private:
 	bool mPreventLoop;
 	bool mForceRelayForNonIceTargets;
 	bool mUsePublicIpForSdpMasquerading = false;
+	bool mUseEpoll = false;
+	/* Relay threads are pinned to a core each, and calls are dispatched to them by hashing their Call-ID. */
+	bool mShardedRelay = false;
+	int mBatchSize = 1;
+	StatCounter64* mCountRecvSyscalls = nullptr;
+	StatCounter64* mCountRecvPackets = nullptr;
+	StatCounter64* mCountSendSyscalls = nullptr;
+	StatCounter64* mCountSendPackets = nullptr;
+	/* Ports of the sockets shared by all relayed calls, empty if each channel opens its own sockets. */
+	std::vector<int> mSharedPorts;
+	std::shared_ptr<RelayDemuxTable> mDemuxTable;
 	static ModuleInfo<MediaRelay> sInfo;
 };
 
@@ -103,11 +127,143 @@ private:
 	int mCurSize;
 };
 
+/**
+ * Packets read from a relay socket with a single system call (recvmmsg()), and the structures needed to send them
+ * with a single system call (sendmmsg()) as well.
+ * Each relay thread owns one batch, which is reused for every transfer.
+ */
+class RelayPacketBatch {
+public:
+	static constexpr size_t sMaxPacketSize = 1500;
+
+	explicit RelayPacketBatch(size_t capacity);
+
+	/**
+	 * Read as many packets as the batch can hold from the given socket, without blocking.
+	 * @return the number of packets read, or -1 on error (errno is then set).
+	 */
+	int read(int fd);
+
+	size_t capacity() const {
+		return mBuffers.size();
+	}
+	/* Number of packets read from the socket by the last call to RelayChannel::recv(). */
+	size_t size() const {
+		return mCount;
+	}
+	uint8_t* data(size_t index) {
+		return mBuffers[index].data();
+	}
+	/* Size of the packet at the given index, 0 if the packet must not be forwarded. */
+	size_t length(size_t index) const {
+		return mLengths[index];
+	}
+	void setLength(size_t index, size_t length) {
+		mLengths[index] = length;
+	}
+	const struct sockaddr_storage& address(size_t index) const {
+		return mAddrs[index];
+	}
+	socklen_t addressSize(size_t index) const {
+		return mAddrSizes[index];
+	}
+
+private:
+	friend class RelayChannel;
+
+	std::vector<std::array<uint8_t, sMaxPacketSize>> mBuffers;
+	std::vector<size_t> mLengths;
+	std::vector<struct sockaddr_storage> mAddrs;
+	std::vector<socklen_t> mAddrSizes;
+#ifdef __linux__
+	std::vector<struct iovec> mRecvIovs;
+	std::vector<struct mmsghdr> mRecvHeaders;
+	std::vector<struct iovec> mSendIovs;
+	std::vector<struct mmsghdr> mSendHeaders;
+#endif
+	size_t mCount = 0;
+};
+
+/**
+ * When relay sockets are shared by all relayed calls, this table finds the channel a packet is destined to.
+ * Channels are looked up by the remote 5-tuple (the local port identifying the shared socket, as the protocol is
+ * always UDP), and then by SSRC for sources that were not announced in the SDP, e.g. a NAT that changed the
+ * source port. A source whose SSRC is not known yet is given to the channel of the local port that has not received
+ * anything so far and expects this remote IP (from the SDP), so that the channel can latch onto it. Sources from
+ * other IPs are never latched, so that they can't take over a relay leg.
+ * The table is common to all MediaRelayServers because the kernel balances packets between their sockets (bound to
+ * the same ports with SO_REUSEPORT) regardless of the server that owns the session.
+ */
+class RelayDemuxTable {
+public:
+	struct Target {
+		std::shared_ptr<RelaySession> session;
+		std::shared_ptr<RelayChannel> channel;
+	};
+
+	void addChannel(const std::shared_ptr<RelaySession>& session, const std::shared_ptr<RelayChannel>& chan);
+	void removeChannel(const RelayChannel* chan);
+	/* Set the remote address of the RTP (i=0) or RTCP (i=1) component of a channel, addrlen=0 to unset it. */
+	void setRemoteAddress(const RelayChannel* chan, int i, int localPort, const sockaddr* addr, socklen_t addrlen);
+	/**
+	 * Find the channel a packet received on localPort is destined to. On success, the SSRC of the packet is learnt, so
+	 * that the channel can still be found if the source address changes.
+	 */
+	bool find(int localPort, const sockaddr* addr, socklen_t addrlen, const uint8_t* data, size_t len, bool isRtcp,
+	          Target& target);
+
+private:
+	struct AddressKey {
+		int localPort = 0;
+		uint16_t remotePort = 0;
+		std::array<uint8_t, 16> remoteIp{}; // IPv4 addresses are stored as IPv4-mapped IPv6 addresses.
+		bool operator==(const AddressKey& other) const {
+			return localPort == other.localPort && remotePort == other.remotePort && remoteIp == other.remoteIp;
+		}
+	};
+	struct AddressKeyHash {
+		size_t operator()(const AddressKey& key) const;
+	};
+	struct ChannelRecord {
+		std::weak_ptr<RelaySession> session;
+		std::weak_ptr<RelayChannel> channel;
+		std::array<AddressKey, 2> addresses{};
+		std::array<bool, 2> hasAddress{};
+		std::array<bool, 2> hasReceived{};
+		std::vector<uint64_t> ssrcKeys;
+	};
+
+	static bool makeAddressKey(int localPort, const sockaddr* addr, socklen_t addrlen, AddressKey& key);
+	static bool getSsrc(const uint8_t* data, size_t len, bool isRtcp, uint32_t& ssrc);
+	static uint64_t makeSsrcKey(int localPort, uint32_t ssrc) {
+		return (uint64_t(localPort) << 32) | ssrc;
+	}
+	/* Key of the channels waiting for a source on a local port, from a remote IP whatever its port. */
+	static AddressKey makeWaitingKey(AddressKey key) {
+		key.remotePort = 0;
+		return key;
+	}
+	const RelayChannel* findWaitingChannel(const AddressKey& key) const;
+	/* Must be called with mMutex held. */
+	void removeWaitingChannel(const RelayChannel* chan, const AddressKey& address);
+
+	Mutex mMutex;
+	std::unordered_map<const RelayChannel*, ChannelRecord> mChannels;
+	std::unordered_map<AddressKey, const RelayChannel*, AddressKeyHash> mByAddress;
+	std::unordered_map<uint64_t, const RelayChannel*> mBySsrc;
+	/* Channels that have an address on a local port but have not received anything on it yet, by waiting key. */
+	std::unordered_multimap<AddressKey, const RelayChannel*, AddressKeyHash> mWaitingByAddress;
+};
+
 class MediaRelayServer {
 	friend class RelayedCall;
 
 public:
-	MediaRelayServer(MediaRelay* module);
+	/**
+	 * @param cpuIndex index of the core the relay thread is pinned to when the module runs in sharded mode, or -1 to
+	 * let the scheduler pick it.
+	 */
+	MediaRelayServer(MediaRelay* module, int cpuIndex = -1);
 	~MediaRelayServer();
 	std::shared_ptr<RelaySession> createSession(const std::string& frontId, const RelayTransport& frontRelayTransport);
 	void update();
@@ -117,17 +273,114 @@ public:
 	bool loopPreventionEnabled() const {
 		return mModule->mPreventLoop;
 	}
+	/**
+	 * With the epoll backend, sockets of a channel are registered once, when the channel is created, and unregistered
+	 * when it is no longer used by its session. With shared sockets, the channel is added to (resp. removed from) the
+	 * demultiplexing table instead. Both methods are otherwise no-op with the poll backend.
+	 * With epoll, the registration is handed over to the relay thread through a lock-free queue, so that the relay
+	 * thread never has to take the server mutex while relaying packets.
+	 */
+	void registerChannel(const std::shared_ptr<RelaySession>& session, const std::shared_ptr<RelayChannel>& chan);
+	void unregisterChannel(const std::shared_ptr<RelayChannel>& chan);
+	void onSessionTerminated();
+	/* Must only be used from the relay thread. */
+	RelayPacketBatch& getPacketBatch() {
+		return mPacketBatch;
+	}
+	void onPacketsReceived(size_t count) {
+		mRecvSyscalls.fetch_add(1, std::memory_order_relaxed);
+		mRecvPackets.fetch_add(count, std::memory_order_relaxed);
+	}
+	void onPacketsSent(size_t count) {
+		mSendSyscalls.fetch_add(1, std::memory_order_relaxed);
+		mSendPackets.fetch_add(count, std::memory_order_relaxed);
+	}
+	uint64_t getRecvSyscalls() const {
+		return mRecvSyscalls.load(std::memory_order_relaxed);
+	}
+	uint64_t getRecvPackets() const {
+		return mRecvPackets.load(std::memory_order_relaxed);
+	}
+	uint64_t getSendSyscalls() const {
+		return mSendSyscalls.load(std::memory_order_relaxed);
+	}
+	uint64_t getSendPackets() const {
+		return mSendPackets.load(std::memory_order_relaxed);
+	}
+	/* Null if relay channels open their own sockets. */
+	RelayDemuxTable* getDemuxTable() const {
+		return mModule->mDemuxTable.get();
+	}
+	/**
+	 * Get the RTP and RTCP sockets, shared by all relayed calls, to use for a new channel bound to the given IP.
+	 * Sockets are opened on first use and then picked in a round-robin fashion among the configured ports.
+	 * @return the RTP port, or -1 if the sockets could not be opened.
+	 */
+	int getSharedSockets(const std::string& bindIp, int sockets[2]);
 
 private:
+	struct ChannelRegistration {
+		std::weak_ptr<RelaySession> mSession;
+		std::shared_ptr<RelayChannel> mChannel;
+	};
+	struct EpollCommand {
+		enum class Type { Add, Remove };
+		Type mType = Type::Add;
+		std::weak_ptr<RelaySession> mSession;
+		std::shared_ptr<RelayChannel> mChannel;
+	};
+
+	struct SharedSocketPair {
+		int port;
+		int sockets[2];
+	};
+	struct SharedSocketPool {
+		std::vector<size_t> pairs; // Indexes in mSharedSocketPairs.
+		size_t next = 0;
+	};
+
+	static constexpr int sMaxEpollEvents = 256;
+	static constexpr uint64_t sCtlPipeEventId = 0;
+	/* Epoll ids of shared sockets have this bit set, and are made of the RTP port, the socket and the component. */
+	static constexpr uint64_t sSharedSocketEventFlag = uint64_t(1) << 63;
+
 	void start();
 	void run();
+	void runPoll();
+	void runEpoll();
+	void readCtlPipe();
+	void postEpollCommand(EpollCommand&& command);
+	void applyEpollCommands();
+	bool openSharedSocketPool(const std::string& bindIp, SharedSocketPool& pool);
+	/* Must be called with mMutex held. */
+	SharedSocketPool& getSharedSocketPool(const std::string& bindIp);
+	void onSharedSocketReadable(int fd, int localPort, int i, time_t curtime);
 	static void* threadFunc(void* arg);
 	Mutex mMutex;
 	std::list<std::shared_ptr<RelaySession>> mSessions;
 	size_t mSessionsCount; /* since std::list::size() is O(n), we use our own counter*/
+	/* Channels registered to the epoll instance, indexed by their epoll id (see RelayChannel::getEpollId()). Only
+	 * accessed by the relay thread, which receives registrations through mEpollCommands. */
+	std::unordered_map<uint64_t, ChannelRegistration> mRegisteredChannels;
+	uint64_t mNextEpollId = 1;
+	MpscQueue<EpollCommand> mEpollCommands;
+	/* Set when the relay thread has been woken up to apply epoll commands and has not done it yet. */
+	std::atomic<bool> mEpollCommandsPending{false};
+	std::map<std::string, SharedSocketPool> mSharedSocketPools; // Indexed by bind IP.
+	std::vector<SharedSocketPair> mSharedSocketPairs;
+	RelayPacketBatch mPacketBatch;
+	/* Used by the relay thread to demultiplex packets received on shared sockets. */
+	std::vector<size_t> mDemuxLengths;
+	std::vector<RelayDemuxTable::Target> mDemuxTargets;
+	std::atomic<uint64_t> mRecvSyscalls{0};
+	std::atomic<uint64_t> mRecvPackets{0};
+	std::atomic<uint64_t> mSendSyscalls{0};
+	std::atomic<uint64_t> mSendPackets{0};
 	MediaRelay* mModule;
 	pthread_t mThread;
 	int mCtlPipe[2];
+	int mEpollFd = -1;
+	int mCpuIndex = -1;
 	bool mRunning;
 	friend class RelayChannel;
 };
@@ -150,6 +403,17 @@ public:
 
 	void fillPollFd(PollFd* pfd);
 	void checkPollFd(const PollFd* pfd, time_t curtime);
+	/**
+	 * Called by the epoll backend when a socket of the given channel is readable.
+	 * Does nothing if the channel no longer belongs to this session.
+	 */
+	void onChannelReadable(time_t curtime, const std::shared_ptr<RelayChannel>& chan, int i);
+	/**
+	 * Called with shared sockets, when packets of the batch have been found to be destined to the given channel.
+	 * Packets destined to other channels have a zero length.
+	 */
+	void onPacketsDemultiplexed(time_t curtime, const std::shared_ptr<RelayChannel>& chan, int i,
+	                            RelayPacketBatch& batch);
 	void unuse();
 	int getActiveBranchesCount();
 
@@ -182,6 +446,8 @@ public:
 
 private:
 	void transfer(time_t current, const std::shared_ptr<RelayChannel>& org, int i);
+	void forward(const std::shared_ptr<RelayChannel>& org, int i, RelayPacketBatch& batch);
+	bool hasChannel(const std::shared_ptr<RelayChannel>& chan) const;
 	mutable Mutex mMutex;
 	MediaRelayServer* mServer;
 	time_t mLastActivityTime;
@@ -222,10 +488,36 @@ public:
 	int getRemoteRtcpPort() const {
 		return mRemotePort[1];
 	}
-	int recv(int i, uint8_t* buf, size_t size, time_t curTime);
-	int send(int i, uint8_t* buf, size_t size);
+	/**
+	 * Read as many packets as the batch can hold from the RTP (i=0) or RTCP (i=1) socket.
+	 * @return the number of packets to forward, or -1 on error.
+	 */
+	int recv(int i, RelayPacketBatch& batch, time_t curTime);
+	/**
+	 * Apply address learning and the incoming filter to the packets of the batch, which were read from the channel's
+	 * socket (or demultiplexed to it). Packets that must not be forwarded get a zero length.
+	 * @return the number of packets to forward.
+	 */
+	int processReceived(int i, RelayPacketBatch& batch, time_t curTime);
+	/* With shared sockets, publish the remote addresses of the channel to the demultiplexing table. */
+	void updateDemuxTable();
+	/**
+	 * Send the packets of the batch that must be forwarded to the remote address of this channel.
+	 */
+	void send(int i, RelayPacketBatch& batch);
 	void fillPollFd(PollFd* pfd);
 	bool checkPollFd(const PollFd* pfd, int i);
+	int getSocket(int i) const {
+		return mSockets[i];
+	}
+	/* Identifier of the channel in the epoll instance of its MediaRelayServer, 0 if not registered.
+	 * Only accessed by the relay thread. */
+	uint64_t getEpollId() const {
+		return mEpollId;
+	}
+	void setEpollId(uint64_t id) {
+		mEpollId = id;
+	}
 	void setFilter(std::shared_ptr<MediaFilter> filter);
 	uint64_t getReceivedPackets(int componentIndex) const {
 		return mPacketsReceived[componentIndex];
@@ -248,16 +540,21 @@ private:
 	static const int sMaxRecvErrors = 50;
 	static const int sDestinationSwitchTimeout = 5; // seconds
 	void initializeRtpSession(RelaySession* relaySession);
+	bool onPacketReceived(
+	    int i, uint8_t* buf, size_t len, const sockaddr_storage& ss, socklen_t addrsize, time_t curTime);
+	MediaRelayServer* mServer;
 	RelayTransport mRelayTransport; // The local addresses and ports used for relaying.
 	std::string mRemoteIp;
 	int mRemotePort[2];
 	RtpSession* mSession;
 	int mSockets[2];
+	bool mSharedSockets = false; /* Sockets are owned by the MediaRelayServer and shared with other channels. */
 	struct sockaddr_storage mSockAddr[2]; /*the destination address in use*/
 	socklen_t mSockAddrSize[2];
 	time_t mSockAddrLastUseTime[2] = {0};
 	std::shared_ptr<MediaFilter> mFilter;
 	int mPfdIndex;
+	uint64_t mEpollId = 0;
 	int mRecvErrorCount[2];
 	Dir mDir;
 	uint64_t mPacketsReceived[2];
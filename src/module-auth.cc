@@ -24,6 +24,9 @@
 #include "agent.hh"
 #include "auth/db/authdb.hh"
 #include "auth/flexisip-auth-module.hh"
+#if ENABLE_REDIS
+#include "auth/redis-nonce-store.hh"
+#endif
 #include "transaction/outgoing-transaction.hh"
 
 using namespace std;
@@ -73,6 +76,23 @@ void Authentication::declareConfig(GenericStruct& moduleConfig) {
 	     "false"},
 	    {String, "db-implementation", "Database backend implementation for digest authentication [soci,file].", "file"},
 	    {DurationS, "cache-expire", "Duration of the validity of the credentials added to the cache.", "1800"},
+	    {Boolean, "redis-nonce-store",
+	     "Share the nonces of digest challenges and their nonce counts with the other proxies connected to the Redis "
+	     "server configured in module::Registrar, so that a client may authenticate on any of them with a nonce "
+	     "issued by another one. Nonces expire in Redis after 'nonce-expires'. All the proxies must use the same "
+	     "'nonce-expires'.\n"
+	     "Requires Flexisip to be built with Redis support.",
+	     "false"},
+	    {Integer, "cache-max-size",
+	     "Maximum number of credentials kept in the cache. The least recently used ones are evicted beyond this "
+	     "limit. 0 means unlimited. The cache is split in 16 parts holding at least one credential each, so values "
+	     "below 16 actually keep up to 16 credentials. Not used by the 'file' backend.",
+	     "0"},
+	    {DurationS, "cache-refresh-ahead",
+	     "Credentials used less than this duration before their expiration are fetched again from the backend, while "
+	     "the cached ones are still used, so that active users do not hit the backend when their entry expires. 0 "
+	     "disables this behavior. Not used by the 'file' backend.",
+	     "0"},
 
 	    // deprecated parameters
 	    {StringList, "trusted-client-certificates",
@@ -109,6 +129,12 @@ void Authentication::declareConfig(GenericStruct& moduleConfig) {
 	moduleConfig.createStat("count-sync-retrieve", "Number of synchronous retrieves.");
 	moduleConfig.createStat("count-password-found", "Number of passwords found.");
 	moduleConfig.createStat("count-password-not-found", "Number of passwords not found.");
+	moduleConfig.createStat("count-password-cache-hits", "Number of passwords found in the cache.");
+	moduleConfig.createStat("count-password-cache-misses", "Number of passwords missing or expired in the cache.");
+	moduleConfig.createStat("count-password-cache-refreshes",
+	                        "Number of cached passwords fetched again from the backend before their expiration.");
+	moduleConfig.createStat("count-password-cache-evictions",
+	                        "Number of passwords evicted from the cache because of its size limit.");
 }
 
 void Authentication::onLoad(const GenericStruct* mc) {
@@ -275,6 +301,18 @@ FlexisipAuthModuleBase* Authentication::createAuthModule(const std::string& doma
 	    new FlexisipAuthModule(mAuthDb.db(), getAgent()->getRoot()->getCPtr(), domain, nonceExpire, qopAuth);
 	authModule->setOnPasswordFetchResultCb(
 	    [this](bool passFound) { passFound ? mCountPassFound++ : mCountPassNotFound++; });
+	if (mModuleConfig->get<ConfigBoolean>("redis-nonce-store")->read()) {
+#if ENABLE_REDIS
+		if (!mRedisNonceStore) {
+			const auto* registrarConf =
+			    getAgent()->getConfigManager().getRoot()->get<GenericStruct>("module::Registrar");
+			mRedisNonceStore = make_shared<RedisNonceStore>(*getAgent()->getRoot(), registrarConf);
+		}
+		authModule->setNonceStore(mRedisNonceStore);
+#else
+		SLOGE << "'redis-nonce-store' is enabled but Flexisip was built without Redis support, using a local store";
+#endif
+	}
 	SLOGI << "Found auth domain: " << domain;
 	return authModule;
 }
@@ -16,6 +16,8 @@
     along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <vector>
+
 #include "flexisip/logmanager.hh"
 #include "flexisip/module.hh"
 #include "flexisip/utils/sip-uri.hh"
@@ -53,6 +55,8 @@ private:
 
 	static ModuleInfo<B2bua> sInfo;
 	unique_ptr<SipUri> mDestRoute;
+	// One route per core of the B2BUA server, when it runs several ones.
+	vector<SipUri> mShardRoutes;
 	su_home_t mHome;
 	string mB2buaUserAgent;
 };
@@ -106,6 +110,17 @@ void B2bua::onLoad(const GenericStruct* moduleConfig) {
 	SLOGI << "module::" << getModuleName() << ": b2bua server is [" << mDestRoute->str() << "]";
 
 	const auto* b2buaServerConfig = getAgent()->getConfigManager().getRoot()->get<GenericStruct>("b2bua-server");
+	// Core N of the B2BUA server listens on its configured port + N.
+	mShardRoutes.clear();
+	const auto nbCores = b2buaServerConfig->get<ConfigInt>("nb-cores")->read();
+	if (1 < nbCores) {
+		const auto port = stoi(mDestRoute->getPort(true));
+		for (auto shardIndex = 0; shardIndex < nbCores; ++shardIndex) {
+			mShardRoutes.push_back(mDestRoute->replacePort(to_string(port + shardIndex)));
+		}
+		SLOGI << "module::" << getModuleName() << ": calls are dispatched by Call-ID between " << nbCores
+		      << " cores, from port " << port;
+	}
 	const auto userAgent = b2bua::parseUserAgentFromConfig(b2buaServerConfig->get<ConfigString>("user-agent")->read());
 	mB2buaUserAgent = userAgent.first + (userAgent.second.empty() ? "" : ("/" + userAgent.second));
 	SLOGI << "module::" << getModuleName() << ": ignore INVITE and CANCEL requests with \"User-Agent\" header set to "
@@ -122,9 +137,14 @@ void B2bua::onRequest(shared_ptr<RequestSipEvent>& ev) {
 		const auto requestIsFromB2BUA = sip->sip_user_agent and sip->sip_user_agent->g_string == mB2buaUserAgent;
 
 		if (!requestIsFromB2BUA) {
+			// A CANCEL has the Call-ID of its INVITE, so it reaches the same core.
+			const auto& destRoute =
+			    mShardRoutes.empty() || !sip->sip_call_id
+			        ? *mDestRoute
+			        : mShardRoutes[b2bua::shardOf(sip->sip_call_id->i_id, static_cast<unsigned>(mShardRoutes.size()))];
 			ModuleToolbox::cleanAndPrependRoute(this->getAgent(), ev->getMsgSip()->getMsg(), ev->getSip(),
-			                                    sip_route_create(&mHome, mDestRoute->get(), nullptr));
-			SLOGD << "Clean and prepend done to route " << mDestRoute->str();
+			                                    sip_route_create(&mHome, destRoute.get(), nullptr));
+			SLOGD << "Clean and prepend done to route " << destRoute.str();
 		} else { // Do not intercept the call
 			SLOGD << "Ignore INVITE with \"User-Agent\" header set to " << mB2buaUserAgent;
 		}
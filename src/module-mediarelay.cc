@@ -19,6 +19,8 @@
 #include "mediarelay.hh"
 
 #include <algorithm>
+#include <functional>
+#include <string_view>
 #include <vector>
 
 #include "flexisip/fork-context/fork-context.hh"
@@ -105,6 +107,29 @@ ModuleInfo<MediaRelay> MediaRelay::sInfo(
 	         "will deduce a suitable IP address by basing on data from SIP messages, which could fail in tricky "
 	         "situations e.g. when Flexisip is behind a TCP proxy.",
 	         "false"},
+	        {String, "polling-backend",
+	         "Mechanism used by relay threads to wait for incoming RTP/RTCP packets. Possible values are:\n"
+	         " - 'epoll': relay sockets are registered once when the relay channel is created, so that each wake-up "
+	         "only costs as much as the sockets that are actually ready. Only available on Linux.\n"
+	         " - 'poll': the whole list of relay sockets is rebuilt and examined at each wake-up. Kept as a fallback.",
+	         "epoll"},
+	        {Integer, "max-packets-per-syscall",
+	         "Maximum number of RTP/RTCP packets read from a relay socket, and then sent to each destination, with a "
+	         "single system call (recvmmsg()/sendmmsg()). A value of 1 processes packets one by one.",
+	         "32"},
+	        {Integer, "shared-sockets",
+	         "Number of RTP/RTCP port pairs, starting at 'sdp-port-range-min', shared by all relayed calls. Packets "
+	         "are then demultiplexed to the right call using their source address and SSRC. This removes the limit on "
+	         "concurrent relayed calls set by the port range, and saves two file descriptors per relayed stream. "
+	         "Every relay thread binds its own sockets to these ports with SO_REUSEPORT.\n"
+	         "A value of 0 disables the feature: each relayed stream then uses its own ports out of the port range.",
+	         "0"},
+	        {Boolean, "sharded-relay",
+	         "Pin each relay thread to its own CPU core, and always relay a given call on the same thread, chosen by "
+	         "hashing its Call-ID. This keeps the state of a call in the caches of a single core. Only effective on "
+	         "Linux. With 'shared-sockets', the kernel still balances incoming packets between threads, so affinity "
+	         "is not guaranteed for them.",
+	         "false"},
 #ifdef MEDIARELAY_SPECIFIC_FEATURES_ENABLED
 	        /*very specific features, useless for most people*/
 	        {Integer, "h264-filtering-bandwidth",
@@ -120,12 +145,24 @@ ModuleInfo<MediaRelay> MediaRelay::sInfo(
 	        config_item_end};
 	    moduleConfig.addChildrenValues(items);
 	    moduleConfig.createStatPair("count-calls", "Number of relayed calls.");
+	    moduleConfig.createStat("count-recv-syscalls",
+	                            "Number of system calls made to read relayed packets. Dividing 'count-recv-packets' by "
+	                            "this value gives the average number of packets read per system call.");
+	    moduleConfig.createStat("count-recv-packets", "Number of packets read by the media relay.");
+	    moduleConfig.createStat("count-send-syscalls",
+	                            "Number of system calls made to send relayed packets. Dividing 'count-send-packets' by "
+	                            "this value gives the average number of packets sent per system call.");
+	    moduleConfig.createStat("count-send-packets", "Number of packets sent by the media relay.");
     });
 
 MediaRelay::MediaRelay(Agent* ag, const ModuleInfoBase* moduleInfo) : Module(ag, moduleInfo), mCalls(NULL) {
 	auto p = mModuleConfig->getStatPair("count-calls");
 	mCountCalls = p.first;
 	mCountCallsFinished = p.second;
+	mCountRecvSyscalls = mModuleConfig->getStat("count-recv-syscalls");
+	mCountRecvPackets = mModuleConfig->getStat("count-recv-packets");
+	mCountSendSyscalls = mModuleConfig->getStat("count-send-syscalls");
+	mCountSendPackets = mModuleConfig->getStat("count-send-packets");
 }
 
 MediaRelay::~MediaRelay() {
@@ -137,11 +174,20 @@ void MediaRelay::createServers() {
 	int cpuCount = ModuleToolbox::getCpuCount();
 	int i;
 	for (i = 0; i < cpuCount; ++i) {
-		mServers.push_back(make_shared<MediaRelayServer>(this));
+		mServers.push_back(make_shared<MediaRelayServer>(this, mShardedRelay ? i : -1));
 	}
 	mCurServer = 0;
 }
 
+const shared_ptr<MediaRelayServer>& MediaRelay::selectServer(const sip_t* sip) {
+	if (mShardedRelay && sip->sip_call_id && sip->sip_call_id->i_id) {
+		return mServers[hash<string_view>{}(sip->sip_call_id->i_id) % mServers.size()];
+	}
+	const auto& server = mServers[mCurServer];
+	mCurServer = (mCurServer + 1) % mServers.size();
+	return server;
+}
+
 void MediaRelay::onLoad(const GenericStruct* modconf) {
 	mCalls = new CallStore();
 	mCalls->setCallStatCounters(mCountCalls, mCountCallsFinished);
@@ -171,6 +217,36 @@ void MediaRelay::onLoad(const GenericStruct* modconf) {
 	mInactivityPeriod = chrono::duration_cast<chrono::seconds>(
 	                        modconf->get<ConfigDuration<chrono::seconds>>("inactivity-period")->read())
 	                        .count();
+	mBatchSize = max(modconf->get<ConfigInt>("max-packets-per-syscall")->read(), 1);
+	mSharedPorts.clear();
+	mDemuxTable.reset();
+	const auto sharedSockets = modconf->get<ConfigInt>("shared-sockets")->read();
+	if (sharedSockets > 0) {
+		// RTP ports are even, the RTCP port being the next one.
+		for (int port = (mMinPort + 1) & ~1; port + 1 <= mMaxPort && (int)mSharedPorts.size() < sharedSockets;
+		     port += 2) {
+			mSharedPorts.push_back(port);
+		}
+		if ((int)mSharedPorts.size() < sharedSockets) {
+			LOGW("MediaRelay: only %zu shared port pairs fit in the port range", mSharedPorts.size());
+		}
+		mDemuxTable = make_shared<RelayDemuxTable>();
+	}
+	mShardedRelay = modconf->get<ConfigBoolean>("sharded-relay")->read();
+	const auto pollingBackend = modconf->get<ConfigString>("polling-backend");
+	const auto pollingBackendValue = pollingBackend->read();
+	if (pollingBackendValue == "epoll") {
+#ifdef __linux__
+		mUseEpoll = true;
+#else
+		LOGW("%s: 'epoll' is not available on this platform, using 'poll'", pollingBackend->getCompleteName().c_str());
+		mUseEpoll = false;
+#endif
+	} else if (pollingBackendValue == "poll") {
+		mUseEpoll = false;
+	} else {
+		LOGF("Invalid value for %s: '%s'", pollingBackend->getCompleteName().c_str(), pollingBackendValue.c_str());
+	}
 	createServers();
 }
 
@@ -308,9 +384,8 @@ void MediaRelay::onRequest(shared_ptr<RequestSipEvent>& ev) {
 				return;
 			}
 
-			c = make_shared<RelayedCall>(mServers[mCurServer], sip);
+			c = make_shared<RelayedCall>(selectServer(sip), sip);
 			c->forcePublicAddress(mUsePublicIpForSdpMasquerading);
-			mCurServer = (mCurServer + 1) % mServers.size();
 			newContext = true;
 			it->setProperty(getModuleName(), weak_ptr<RelayedCall>{c});
 			configureContext(c);
@@ -471,7 +546,23 @@ void MediaRelay::onResponse(shared_ptr<ResponseSipEvent>& ev) {
 	}
 }
 
+void MediaRelay::updateRelayStats() {
+	/* Relay threads count with atomics, the statistics are only updated from the main thread. */
+	uint64_t recvSyscalls = 0, recvPackets = 0, sendSyscalls = 0, sendPackets = 0;
+	for (const auto& server : mServers) {
+		recvSyscalls += server->getRecvSyscalls();
+		recvPackets += server->getRecvPackets();
+		sendSyscalls += server->getSendSyscalls();
+		sendPackets += server->getSendPackets();
+	}
+	mCountRecvSyscalls->set(recvSyscalls);
+	mCountRecvPackets->set(recvPackets);
+	mCountSendSyscalls->set(sendSyscalls);
+	mCountSendPackets->set(sendPackets);
+}
+
 void MediaRelay::onIdle() {
+	updateRelayStats();
 	mCalls->dump();
 	mCalls->removeAndDeleteInactives(mInactivityPeriod);
 	if (mCalls->size() > 0) LOGD("There are %i calls active in the MediaRelay call list.", mCalls->size());
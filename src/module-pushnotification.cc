@@ -113,6 +113,13 @@ ModuleInfo<PushNotification> PushNotification::sInfo(
 	         "0"},
 	        {Integer, "max-queue-size", "Maximum number of notifications queued for each push notification service",
 	         "100"},
+	        {Integer, "max-http2-connections",
+	         "Maximum number of HTTP/2 connections opened by each Apple or Firebase (v1 API) push notification client "
+	         "to its remote server. Requests are sent over the least loaded connection, and an additional connection "
+	         "is opened only when all the existing ones are nearly saturated, i.e. when less than 10% of the maximum "
+	         "number of concurrent streams allowed by the server are free on each of them. The limit of the server is "
+	         "assumed to be 100 until it is known, or when the server doesn't set any.",
+	         "1"},
 	        {Integer, "retransmission-count",
 	         "Number of push notification request retransmissions sent to a client for a "
 	         "same event (call or message). Retransmissions cease when a response is received from the client. Setting "
@@ -228,6 +235,12 @@ ModuleInfo<PushNotification> PushNotification::sInfo(
 	        {String, "external-push-method", "Method for reaching external-push-uri, typically GET or POST", "GET"},
 	        {String, "external-push-protocol",
 	         "Protocol used for reaching external-push-uri, http2 or http (deprecated)", "http2"},
+	        {Integer, "external-push-max-concurrent-requests",
+	         "Only used when external-push-protocol is 'http'. Maximum number of requests sent at the same time to "
+	         "external-push-uri. A non-zero value makes the requests sent from the main loop, each over its own "
+	         "keep-alive connection. With the default value '0', requests are sent one by one from a dedicated thread, "
+	         "each one waiting for the response to the previous one.",
+	         "0"},
 	        {DurationMIN, "register-wakeup-interval",
 	         "Send service push notification periodically to all devices that are about to expire and should wake up "
 	         "to "
@@ -284,6 +297,25 @@ ModuleInfo<PushNotification> PushNotification::sInfo(
 	        ->setDeprecated({"2023-07-15", "2.3.0", "Windows push are not handled anymore. This config does nothing."});
 	    moduleConfig.createStat("count-pn-failed", "Number of push notifications failed to be sent");
 	    moduleConfig.createStat("count-pn-sent", "Number of push notifications successfully sent");
+	    moduleConfig.createStat("count-pn-queue-size",
+	                            "Number of push notifications waiting in the queue of the external-push-uri client.");
+	    moduleConfig.createStat("count-pn-queue-time",
+	                            "Cumulated time (in milliseconds) spent by the push notifications in the queue of the "
+	                            "external-push-uri client. Divide by count-pn-dequeued to get the average.");
+	    moduleConfig.createStat("count-pn-dequeued",
+	                            "Number of push notifications taken out of the queue of the external-push-uri client.");
+	    moduleConfig.createStat("count-pn-http2-connections",
+	                            "Number of HTTP/2 connections established by the Apple and Firebase v1 clients. "
+	                            "Updated every 10 seconds.");
+	    moduleConfig.createStat("count-pn-http2-active-streams",
+	                            "Number of push notifications sent over the HTTP/2 connections of the Apple and "
+	                            "Firebase v1 clients and waiting for their response. Updated every 10 seconds.");
+	    moduleConfig.createStat("count-pn-http2-pending-requests",
+	                            "Number of push notifications waiting for an HTTP/2 connection of the Apple and "
+	                            "Firebase v1 clients to be established. Updated every 10 seconds.");
+	    moduleConfig.createStat("count-pn-http2-max-latency",
+	                            "Highest average response time (in microseconds) of the HTTP/2 connections of the "
+	                            "Apple and Firebase v1 clients. Updated every 10 seconds.");
     });
 
 PushNotification::PushNotification(Agent* ag, const ModuleInfoBase* moduleInfo) : Module(ag, moduleInfo) {
@@ -334,6 +366,11 @@ void PushNotification::onLoad(const GenericStruct* mc) {
 	mCallRemotePushInterval = chrono::duration_cast<chrono::seconds>(callRemotePushInterval);
 
 	mPNS = make_unique<pushnotification::Service>(getAgent()->getRoot(), maxQueueSize);
+	const auto* maxHttp2ConnectionsCfg = mc->get<ConfigInt>("max-http2-connections");
+	if (maxHttp2ConnectionsCfg->read() < 1) {
+		LOGF("%s must be strictly positive", maxHttp2ConnectionsCfg->getCompleteName().c_str());
+	}
+	mPNS->setMaxConnectionsPerClient(maxHttp2ConnectionsCfg->read());
 
 	// Load the 'add-to-tag-filter' parameter
 	const auto* addToTagFilterCfg = mc->get<ConfigString>("add-to-tag-filter");
@@ -347,6 +384,11 @@ void PushNotification::onLoad(const GenericStruct* mc) {
 	}
 
 	if (!externalUri.empty()) {
+		const auto* maxConcurrentRequestsCfg = mc->get<ConfigInt>("external-push-max-concurrent-requests");
+		const auto maxConcurrentRequests = maxConcurrentRequestsCfg->read();
+		if (maxConcurrentRequests < 0) {
+			LOGF("%s must be positive", maxConcurrentRequestsCfg->getCompleteName().c_str());
+		}
 		auto const* externalPushMethodCfg = mc->get<ConfigString>("external-push-method");
 		auto const* externalPushProtocolCfg = mc->get<ConfigString>("external-push-protocol");
 		try {
@@ -354,7 +396,8 @@ void PushNotification::onLoad(const GenericStruct* mc) {
 			auto externalPushMethod = stringToGenericPushMethod(externalPushMethodCfg->read());
 			auto externalPushProtocol = stringToGenericPushProtocol(externalPushProtocolCfg->read());
 			if (!externalPushUri.empty()) {
-				mPNS->setupGenericClient(externalPushUri, externalPushMethod, externalPushProtocol);
+				mPNS->setupGenericClient(externalPushUri, externalPushMethod, externalPushProtocol,
+				                         maxConcurrentRequests);
 			}
 		} catch (const sofiasip::InvalidUrlError& e) {
 			LOGF("Invalid value for '%s' parameter: %s", externalUriCfg->getCompleteName().c_str(), e.what());
@@ -365,6 +408,13 @@ void PushNotification::onLoad(const GenericStruct* mc) {
 	}
 
 	mPNS->setStatCounters(mCountFailed, mCountSent);
+	mPNS->setQueueStatCounters(mModuleConfig->getStat("count-pn-queue-size"),
+	                           mModuleConfig->getStat("count-pn-queue-time"),
+	                           mModuleConfig->getStat("count-pn-dequeued"));
+	mPNS->setHttp2StatCounters(mModuleConfig->getStat("count-pn-http2-connections"),
+	                           mModuleConfig->getStat("count-pn-http2-active-streams"),
+	                           mModuleConfig->getStat("count-pn-http2-pending-requests"),
+	                           mModuleConfig->getStat("count-pn-http2-max-latency"));
 	if (appleEnabled) mPNS->setupiOSClient(certdir, "");
 	if (firebaseEnabled) mPNS->setupFirebaseClients(mc);
 
@@ -458,6 +458,51 @@ void ModuleRegistrar::declareConfig(GenericStruct& moduleConfig) {
 	        "hostname info are on private network for example.",
 	        "true",
 	    },
+	    {
+	        Boolean,
+	        "redis-read-from-replicas",
+	        "Send the lookups of the registrar (fetching the contacts of an address of record, e.g. to route a call or "
+	        "a message) to a Redis replica rather than to the master. Writes always go to the master. A replica is "
+	        "used only if it was online and its replication lag was below 'redis-replica-max-lag' at the last check "
+	        "(see 'redis-slave-check-period'), otherwise lookups fall back to the master. Lookups may thus miss the "
+	        "most recent registrations. Replicas are authenticated with the credentials of the master, and the "
+	        "contacts they return are never kept in the Record cache (see 'redis-record-cache-size').",
+	        "false",
+	    },
+	    {
+	        Integer,
+	        "redis-replica-max-lag",
+	        "Maximum replication lag, in bytes of the replication stream ('master_repl_offset' of the master minus the "
+	        "'offset' of the replica), for a replica to serve lookups when 'redis-read-from-replicas' is enabled.",
+	        "65536",
+	    },
+	    {
+	        Boolean,
+	        "redis-server-side-bind",
+	        "Apply registrations with a script executed by Redis, in a single round trip, instead of fetching the "
+	        "address of record then sending the changes. This is used when all the contacts of the REGISTER request "
+	        "are identified by a unique id (+sip.instance), registrations of other contacts are applied as usual.\n"
+	        "The script needs metadata about the contacts, stored next to each address of record, that is only written "
+	        "when this setting is enabled: it must be the same on all the instances sharing the Redis database.",
+	        "false",
+	    },
+	    {
+	        Integer,
+	        "redis-record-cache-size",
+	        "Maximum number of addresses of record whose contacts are kept in memory after being fetched from Redis, "
+	        "so that subsequent lookups are answered without querying Redis. An entry is dropped when the address of "
+	        "record is modified by this server, or by another one if the Redis server is configured to send keyspace "
+	        "notifications for hashes and generic commands (e.g. 'notify-keyspace-events Eghx'). Otherwise, lookups "
+	        "may return outdated contacts for up to 'redis-record-cache-ttl'.\n"
+	        "0 disables the cache.",
+	        "0",
+	    },
+	    {
+	        DurationMS,
+	        "redis-record-cache-ttl",
+	        "Maximum time an address of record is kept in the cache configured by 'redis-record-cache-size'.",
+	        "1000",
+	    },
 	    {
 	        DurationS,
 	        "redis-subscription-keep-alive-check-period",
@@ -526,6 +571,10 @@ void ModuleRegistrar::declareConfig(GenericStruct& moduleConfig) {
 	moduleConfig.createStatPair("count-bind", "Number of registers.");
 	moduleConfig.createStat("count-local-registered-users",
 	                        "Number of users currently registered through this server.");
+	moduleConfig.createStat("count-record-cache-hits", "Number of Redis lookups answered by the Record cache.");
+	moduleConfig.createStat("count-record-cache-misses", "Number of Redis lookups not found in the Record cache.");
+	moduleConfig.createStat("count-record-cache-evictions",
+	                        "Number of entries dropped from the Record cache because it was full or too old.");
 }
 
 void ModuleRegistrar::onLoad(const GenericStruct* mc) {
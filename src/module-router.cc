@@ -19,6 +19,7 @@
 #include "flexisip/module-router.hh"
 
 #include <memory>
+#include <set>
 
 #include "sofia-sip/sip.h"
 #include <sofia-sip/sip_status.h>
@@ -40,6 +41,7 @@
 #if ENABLE_SOCI
 #include "fork-context/fork-message-context-db-proxy.hh"
 #include "fork-context/fork-message-context-soci-repository.hh"
+#include "utils/thread/auto-thread-pool.hh"
 #endif
 
 using namespace std;
@@ -104,6 +106,24 @@ void ModuleRouter::declareConfig(GenericStruct& moduleConfig) {
 	     "db='mydb' user='myuser' password='mypass' host='myhost.com'"},
 	    {Integer, "message-database-pool-size",
 	     "Size of the pool of connections that Soci will use for accessing the message database.", "100"},
+	    {Integer, "message-database-restore-page-size",
+	     "At startup, the messages waiting for delivery in the message database are restored in the background by "
+	     "pages of this number of messages. Only their recipients are loaded, the messages themselves are read from "
+	     "the database when one of their recipients registers.\n"
+	     "A recipient that registers before the page of its messages is restored receives them at its next "
+	     "registration only.",
+	     "1000"},
+	    {DurationMS, "message-database-write-behind-delay",
+	     "If not zero, the messages to save in, or delete from, the message database are queued during this delay and "
+	     "then written together, in a single transaction. A message delivered before the end of the delay is never "
+	     "written at all. A message is only released from memory once written, but the messages still queued are lost "
+	     "if the proxy crashes: the larger the delay, the more messages may be lost.\n"
+	     "If zero, every message is written to the database as soon as possible, in its own transaction.",
+	     "0"},
+	    {Integer, "message-database-write-behind-max-batch-size",
+	     "Maximum number of queued writes. The queue is written as soon as it reaches this size. Only used if "
+	     "'message-database-write-behind-delay' is not zero.",
+	     "1000"},
 	    {String, "fallback-route",
 	     "Default route to apply when the recipient is unreachable or when when all attempted destination have "
 	     "failed."
@@ -263,8 +283,22 @@ void ModuleRouter::onLoad(const GenericStruct* mc) {
 		    mc->get<ConfigString>("message-database-backend")->read(),
 		    mc->get<ConfigString>("message-database-connection-string")->read(),
 		    mc->get<ConfigInt>("message-database-pool-size")->read());
-
-		restoreForksFromDatabase();
+		mRestorePageSize = max(mc->get<ConfigInt>("message-database-restore-page-size")->read(), 1);
+		// Same thread pool as the one used by the fork proxies to access the database.
+		mDbThreadNumber = mc->get<ConfigInt>("message-database-pool-size")->read() * 2;
+
+		SLOGI << "Fork message to DB is enabled, retrieving previous messages in DB ...";
+		// Connect to the database now, restoration is then done page by page in the background.
+		const auto& repository = ForkMessageContextSociRepository::getInstance();
+		repository->setWriteBehind(
+		    getAgent()->getRoot(),
+		    mc->get<ConfigDuration<chrono::milliseconds>>("message-database-write-behind-delay")->read(),
+		    max(mc->get<ConfigInt>("message-database-write-behind-max-batch-size")->read(), 1));
+		// Uuids are ordered by creation time. The messages saved from now on, while restoring, come after this one
+		// and must not be restored: they are already handled by this proxy.
+		mRestoreLastUuid = repository->findLastForkMessageUuid();
+		if (mRestoreLastUuid.empty()) SLOGI << " ... no fork message to restore from DB.";
+		else restoreForksFromDatabase();
 	}
 #endif
 
@@ -273,20 +307,101 @@ void ModuleRouter::onLoad(const GenericStruct* mc) {
 	}
 }
 
+void ModuleRouter::onUnload() {
 #if ENABLE_SOCI
-void ModuleRouter::restoreForksFromDatabase() {
-	SLOGI << "Fork message to DB is enabled, retrieving previous messages in DB ...";
-	auto allDbMessages = ForkMessageContextSociRepository::getInstance()->findAllForkMessage();
-	SLOGD << " ... " << allDbMessages.size() << " messages found in DB ...";
-	for (auto& dbMessage : allDbMessages) {
+	// Write the fork messages still queued, they would be lost otherwise.
+	if (mMessageForkCfg && mMessageForkCfg->mSaveForkMessageEnabled) {
+		ForkMessageContextSociRepository::getInstance()->stopWriteBehind();
+	}
+#endif
+}
+
+#if ENABLE_SOCI
+void ModuleRouter::restoreForksFromDatabase(const std::string& afterUuid) {
+	AutoThreadPool::getDbThreadPool(mDbThreadNumber)
+	    ->run([weakRouter = weak_from_this(), afterUuid, lastUuid = mRestoreLastUuid, pageSize = mRestorePageSize]() {
+		    vector<ForkMessageContextDb> page{};
+		    try {
+			    page = ForkMessageContextSociRepository::getInstance()->findForkMessagePage(afterUuid, lastUuid,
+			                                                                                pageSize);
+		    } catch (const exception& e) {
+			    SLOGE << "ModuleRouter - Failed to restore fork messages from DB, stopping at UUID[" << afterUuid
+			          << "]: " << e.what();
+			    return;
+		    }
+		    if (auto router = weakRouter.lock()) {
+			    router->getAgent()->getRoot()->addToMainLoop([weakRouter, page = std::move(page)]() mutable {
+				    if (auto sharedRouter = weakRouter.lock()) sharedRouter->onForkPageRestored(page);
+			    });
+		    }
+	    });
+}
+
+namespace {
+
+// Delivers the restored messages to the contacts of their recipients that registered before the messages were restored.
+class RestoredForksContactsFetcher : public ListContactUpdateListener {
+public:
+	RestoredForksContactsFetcher(const weak_ptr<ModuleRouter>& router,
+	                             const weak_ptr<OnContactRegisteredListener>& listener)
+	    : mRouter{router}, mListener{listener} {
+	}
+
+	void onContactsUpdated() override {
+		const auto router = mRouter.lock();
+		const auto listener = mListener.lock();
+		if (!router || !listener) return;
+		for (const auto& record : records) {
+			for (const auto& contact : record->getExtendedContacts()) {
+				router->onContactRegistered(listener, contact->mKey.str(), record);
+			}
+		}
+	}
+
+private:
+	weak_ptr<ModuleRouter> mRouter;
+	weak_ptr<OnContactRegisteredListener> mListener;
+};
+
+} // namespace
+
+void ModuleRouter::onForkPageRestored(vector<ForkMessageContextDb>& page) {
+	// The restored messages are delivered on the next registration of one of their recipients, and right away to the
+	// contacts that are already registered.
+	// Keys shared by several messages of the page are subscribed and fetched only once.
+	set<string> keys{};
+	for (auto& dbMessage : page) {
 		mStats.mCountForks->incrStart();
 		auto restoredForkMessage = ForkMessageContextDbProxy::make(shared_from_this(), dbMessage);
 		for (const auto& key : dbMessage.dbKeys) {
 			mForks.emplace(key, restoredForkMessage);
-			mAgent->getRegistrarDb().subscribe(Record::Key(key), std::weak_ptr<OnContactRegisteredListener>(mOnContactRegisteredListener));
+			keys.insert(key);
+		}
+	}
+	vector<SipUri> recipients{};
+	for (const auto& key : keys) {
+		mAgent->getRegistrarDb().subscribe(Record::Key(key),
+		                                   std::weak_ptr<OnContactRegisteredListener>(mOnContactRegisteredListener));
+		try {
+			// Keys are AORs without scheme, or the URIs of alias contacts.
+			recipients.emplace_back(key.rfind("sip:", 0) == 0 || key.rfind("sips:", 0) == 0 ? key : "sip:" + key);
+		} catch (const exception& e) {
+			SLOGW << "ModuleRouter - Can't fetch the contacts of restored fork message key[" << key
+			      << "]: " << e.what();
 		}
 	}
-	SLOGI << " ... " << mForks.size() << " fork message restored from DB.";
+	if (!recipients.empty()) {
+		mAgent->getRegistrarDb().fetchList(
+		    recipients, make_shared<RestoredForksContactsFetcher>(weak_from_this(), mOnContactRegisteredListener));
+	}
+	mRestoredForkCount += page.size();
+
+	if (page.size() < mRestorePageSize) {
+		SLOGI << " ... " << mRestoredForkCount << " fork message restored from DB.";
+		return;
+	}
+	SLOGD << " ... " << mRestoredForkCount << " fork message restored from DB so far ...";
+	restoreForksFromDatabase(page.back().uuid);
 }
 #endif
 
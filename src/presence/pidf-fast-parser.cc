@@ -0,0 +1,703 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pidf-fast-parser.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flexisip/logmanager.hh"
+
+#include "xml/data-model.hh"
+#include "xml/pidf-oma-pres.hh"
+#include "xml/rpid.hh"
+
+using namespace std;
+using namespace std::string_view_literals;
+
+namespace flexisip {
+namespace {
+
+constexpr auto kPidfNs = "urn:ietf:params:xml:ns:pidf"sv;
+constexpr auto kDataModelNs = "urn:ietf:params:xml:ns:pidf:data-model"sv;
+constexpr auto kRpidNs = "urn:ietf:params:xml:ns:pidf:rpid"sv;
+constexpr auto kOmaPresNs = "urn:oma:xml:prs:pidf:oma-pres"sv;
+constexpr auto kXmlNs = "http://www.w3.org/XML/1998/namespace"sv;
+// Any namespace which is not one of the above
+constexpr auto kOtherNs = "#other"sv;
+
+/**
+ * Thrown when the document can't be handled by the fast path.
+ */
+struct Unsupported {
+	string_view reason;
+};
+
+bool isBlank(string_view text) {
+	return text.find_first_not_of(" \t\r\n") == string_view::npos;
+}
+
+string_view trim(string_view text) {
+	const auto start = text.find_first_not_of(" \t\r\n");
+	if (start == string_view::npos) return {};
+	return text.substr(start, text.find_last_not_of(" \t\r\n") - start + 1);
+}
+
+void appendUtf8(string& out, uint32_t codePoint) {
+	if (codePoint == 0 || 0x10FFFF < codePoint || (0xD800 <= codePoint && codePoint <= 0xDFFF)) {
+		throw Unsupported{"invalid character reference"};
+	}
+	if (codePoint < 0x80) {
+		out += char(codePoint);
+	} else if (codePoint < 0x800) {
+		out += char(0xC0 | (codePoint >> 6));
+		out += char(0x80 | (codePoint & 0x3F));
+	} else if (codePoint < 0x10000) {
+		out += char(0xE0 | (codePoint >> 12));
+		out += char(0x80 | ((codePoint >> 6) & 0x3F));
+		out += char(0x80 | (codePoint & 0x3F));
+	} else {
+		out += char(0xF0 | (codePoint >> 18));
+		out += char(0x80 | ((codePoint >> 12) & 0x3F));
+		out += char(0x80 | ((codePoint >> 6) & 0x3F));
+		out += char(0x80 | (codePoint & 0x3F));
+	}
+}
+
+/**
+ * Append the text to 'out', replacing the predefined entities and the character references.
+ */
+void appendDecoded(string& out, string_view text) {
+	for (auto ampersand = text.find('&'); ampersand != string_view::npos; ampersand = text.find('&')) {
+		out.append(text.substr(0, ampersand));
+		const auto semicolon = text.find(';', ampersand);
+		if (semicolon == string_view::npos) throw Unsupported{"unterminated entity"};
+		const auto entity = text.substr(ampersand + 1, semicolon - ampersand - 1);
+		if (entity == "lt") out += '<';
+		else if (entity == "gt") out += '>';
+		else if (entity == "amp") out += '&';
+		else if (entity == "quot") out += '"';
+		else if (entity == "apos") out += '\'';
+		else if (1 < entity.size() && entity[0] == '#') {
+			const auto hexadecimal = entity[1] == 'x';
+			const auto digits = entity.substr(hexadecimal ? 2 : 1);
+			uint32_t codePoint = 0;
+			const auto end = digits.data() + digits.size();
+			if (digits.empty() || from_chars(digits.data(), end, codePoint, hexadecimal ? 16 : 10).ptr != end) {
+				throw Unsupported{"invalid character reference"};
+			}
+			appendUtf8(out, codePoint);
+		} else throw Unsupported{"unknown entity"};
+		text.remove_prefix(semicolon + 1);
+	}
+	out.append(text);
+}
+
+/**
+ * Minimal pull parser for XML documents, with namespace support.
+ * Each call to next() moves to the next start tag, end tag or text of the document. Empty-element tags are reported
+ * as a start tag immediately followed by an end tag. Comments and processing instructions are skipped.
+ */
+class XmlPullReader {
+public:
+	enum class Token { StartElement, EndElement, Text, EndOfDocument };
+
+	struct Attribute {
+		string_view ns;
+		string_view localName;
+		string value;
+	};
+
+	explicit XmlPullReader(string_view document) : mDocument{document} {
+	}
+
+	Token next() {
+		if (mPendingEnd) {
+			mPendingEnd = false;
+			return endElement();
+		}
+		mText.clear();
+		while (true) {
+			if (mPosition == mDocument.size()) {
+				if (!isBlank(mText)) throw Unsupported{"text after the root element"};
+				if (!mOpenElements.empty()) throw Unsupported{"unterminated element"};
+				return Token::EndOfDocument;
+			}
+			if (mDocument[mPosition] != '<') {
+				const auto end = min(mDocument.find('<', mPosition), mDocument.size());
+				const auto rawText = mDocument.substr(mPosition, end - mPosition);
+				// Line ends would have to be normalized.
+				if (rawText.find('\r') != string_view::npos) throw Unsupported{"carriage return in text"};
+				appendDecoded(mText, rawText);
+				mPosition = end;
+				continue;
+			}
+			if (startsWith("<!--")) {
+				skipPast("-->");
+				continue;
+			}
+			if (startsWith("<?")) {
+				const auto start = mPosition;
+				skipPast("?>");
+				checkEncoding(mDocument.substr(start, mPosition - start));
+				continue;
+			}
+			if (startsWith("<!")) throw Unsupported{"CDATA section or DTD"};
+			if (!mText.empty()) {
+				// Text is reported before the tag that follows it.
+				if (mOpenElements.empty() && !isBlank(mText)) throw Unsupported{"text outside of the root element"};
+				if (!mOpenElements.empty()) return Token::Text;
+				mText.clear();
+			}
+			if (startsWith("</")) {
+				readEndTag();
+				return endElement();
+			}
+			readStartTag();
+			return Token::StartElement;
+		}
+	}
+
+	// Namespace and local name of the current element.
+	string_view ns() const {
+		return mNs;
+	}
+	string_view localName() const {
+		return mLocalName;
+	}
+	bool is(string_view ns, string_view localName) const {
+		return mNs == ns && mLocalName == localName;
+	}
+	// Attributes of the current start tag.
+	const vector<Attribute>& attributes() const {
+		return mAttributes;
+	}
+	const string& text() const {
+		return mText;
+	}
+
+private:
+	struct OpenElement {
+		string_view qualifiedName;
+		size_t namespaceCount;
+	};
+
+	bool startsWith(string_view prefix) const {
+		return mDocument.compare(mPosition, prefix.size(), prefix) == 0;
+	}
+
+	void skipPast(string_view terminator) {
+		const auto end = mDocument.find(terminator, mPosition);
+		if (end == string_view::npos) throw Unsupported{"unterminated markup"};
+		mPosition = end + terminator.size();
+	}
+
+	// Only UTF-8 documents are supported.
+	static void checkEncoding(string_view processingInstruction) {
+		const auto encodingStart = processingInstruction.find("encoding");
+		if (processingInstruction.substr(0, 6) != "<?xml " || encodingStart == string_view::npos) return;
+		auto encoding = string{processingInstruction.substr(encodingStart)};
+		transform(encoding.begin(), encoding.end(), encoding.begin(), [](unsigned char c) { return tolower(c); });
+		if (encoding.find("\"utf-8\"") == string::npos && encoding.find("'utf-8'") == string::npos) {
+			throw Unsupported{"unsupported encoding"};
+		}
+	}
+
+	void skipSpaces() {
+		while (mPosition < mDocument.size() && isBlank(mDocument.substr(mPosition, 1))) {
+			mPosition++;
+		}
+	}
+
+	string_view readName() {
+		const auto start = mPosition;
+		while (mPosition < mDocument.size()) {
+			const auto c = mDocument[mPosition];
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '=' || c == '>' || c == '/' || c == '<') break;
+			mPosition++;
+		}
+		if (mPosition == start) throw Unsupported{"missing name"};
+		return mDocument.substr(start, mPosition - start);
+	}
+
+	// Known namespaces are mapped to the constants above, so that no copy of the URIs has to be kept.
+	static string_view canonicalNamespace(string_view uri) {
+		for (const auto known : {kPidfNs, kDataModelNs, kRpidNs, kOmaPresNs, kXmlNs}) {
+			if (uri == known) return known;
+		}
+		return uri.empty() ? ""sv : kOtherNs;
+	}
+
+	string_view resolve(string_view prefix) const {
+		if (prefix == "xml") return kXmlNs;
+		for (auto it = mNamespaces.rbegin(); it != mNamespaces.rend(); ++it) {
+			if (it->first == prefix) return it->second;
+		}
+		if (prefix.empty()) return {};
+		throw Unsupported{"unknown namespace prefix"};
+	}
+
+	static pair<string_view, string_view> splitQualifiedName(string_view name) {
+		const auto colon = name.find(':');
+		if (colon == string_view::npos) return {{}, name};
+		return {name.substr(0, colon), name.substr(colon + 1)};
+	}
+
+	void readStartTag() {
+		if (mOpenElements.empty() && mRootRead) throw Unsupported{"several root elements"};
+		mRootRead = true;
+		mPosition++; // '<'
+		const auto qualifiedName = readName();
+		const auto namespaceCount = mNamespaces.size();
+
+		// Prefixes may be declared after they are used in the same tag, so the attributes are resolved at the end.
+		vector<pair<string_view, string>> rawAttributes{};
+		while (true) {
+			skipSpaces();
+			if (mPosition == mDocument.size()) throw Unsupported{"unterminated start tag"};
+			if (startsWith("/>")) {
+				mPosition += 2;
+				mPendingEnd = true;
+				break;
+			}
+			if (startsWith(">")) {
+				mPosition++;
+				break;
+			}
+			const auto name = readName();
+			skipSpaces();
+			if (!startsWith("=")) throw Unsupported{"attribute without value"};
+			mPosition++;
+			skipSpaces();
+			if (mPosition == mDocument.size()) throw Unsupported{"unterminated start tag"};
+			const auto quote = mDocument[mPosition];
+			if (quote != '"' && quote != '\'') throw Unsupported{"unquoted attribute value"};
+			const auto end = mDocument.find(quote, mPosition + 1);
+			if (end == string_view::npos) throw Unsupported{"unterminated attribute value"};
+			const auto rawValue = mDocument.substr(mPosition + 1, end - mPosition - 1);
+			if (rawValue.find('<') != string_view::npos) throw Unsupported{"'<' in attribute value"};
+			mPosition = end + 1;
+
+			string value{};
+			appendDecoded(value, rawValue);
+			if (name == "xmlns") {
+				mNamespaces.emplace_back(""sv, canonicalNamespace(value));
+			} else if (name.substr(0, 6) == "xmlns:") {
+				mNamespaces.emplace_back(name.substr(6), canonicalNamespace(value));
+			} else {
+				rawAttributes.emplace_back(name, std::move(value));
+			}
+		}
+
+		const auto [prefix, localName] = splitQualifiedName(qualifiedName);
+		mNs = resolve(prefix);
+		mLocalName = localName;
+		mAttributes.clear();
+		for (auto& [name, value] : rawAttributes) {
+			const auto [attributePrefix, attributeLocalName] = splitQualifiedName(name);
+			// Unprefixed attributes have no namespace.
+			mAttributes.push_back({attributePrefix.empty() ? ""sv : resolve(attributePrefix), attributeLocalName,
+			                       std::move(value)});
+		}
+		mOpenElements.push_back({qualifiedName, namespaceCount});
+	}
+
+	void readEndTag() {
+		mPosition += 2; // '</'
+		const auto qualifiedName = readName();
+		skipSpaces();
+		if (!startsWith(">")) throw Unsupported{"invalid end tag"};
+		mPosition++;
+		if (mOpenElements.empty() || mOpenElements.back().qualifiedName != qualifiedName) {
+			throw Unsupported{"mismatched end tag"};
+		}
+	}
+
+	Token endElement() {
+		const auto [prefix, localName] = splitQualifiedName(mOpenElements.back().qualifiedName);
+		mNs = resolve(prefix);
+		mLocalName = localName;
+		mAttributes.clear();
+		mNamespaces.resize(mOpenElements.back().namespaceCount);
+		mOpenElements.pop_back();
+		return Token::EndElement;
+	}
+
+	string_view mDocument;
+	size_t mPosition{0};
+	bool mPendingEnd{false};
+	bool mRootRead{false};
+	vector<OpenElement> mOpenElements{};
+	// In-scope namespace declarations (prefix, canonical namespace), innermost last
+	vector<pair<string_view, string_view>> mNamespaces{};
+	string_view mNs{};
+	string_view mLocalName{};
+	vector<Attribute> mAttributes{};
+	string mText{};
+};
+
+
+using Token = XmlPullReader::Token;
+
+/**
+ * Value of a whitespace-collapsed type (xs:ID, xs:anyURI, xs:token...).
+ */
+string collapsed(string_view text) {
+	const auto value = trim(text);
+	if (value.find_first_of(" \t\r\n") != string_view::npos) throw Unsupported{"whitespace in collapsed value"};
+	return string{value};
+}
+
+/**
+ * Fail if the current start tag has other attributes than the allowed ones, given as (namespace, local name).
+ */
+void checkAttributes(const XmlPullReader& reader, initializer_list<pair<string_view, string_view>> allowed) {
+	for (const auto& attribute : reader.attributes()) {
+		if (find(allowed.begin(), allowed.end(), make_pair(attribute.ns, attribute.localName)) == allowed.end()) {
+			throw Unsupported{"unsupported attribute"};
+		}
+	}
+}
+
+optional<string> getAttribute(const XmlPullReader& reader, string_view ns, string_view localName) {
+	for (const auto& attribute : reader.attributes()) {
+		if (attribute.ns == ns && attribute.localName == localName) return attribute.value;
+	}
+	return nullopt;
+}
+
+/**
+ * Read the text content of the current element, up to its end tag.
+ */
+string readText(XmlPullReader& reader) {
+	string text{};
+	while (true) {
+		switch (reader.next()) {
+			case Token::Text:
+				text += reader.text();
+				break;
+			case Token::EndElement:
+				return text;
+			case Token::StartElement:
+			case Token::EndOfDocument:
+				throw Unsupported{"element in text-only content"};
+		}
+	}
+}
+
+/**
+ * Call onChild() for each child element of the current element. onChild() must read the child up to its end tag.
+ */
+template <typename OnChild>
+void readChildren(XmlPullReader& reader, OnChild&& onChild) {
+	while (true) {
+		switch (reader.next()) {
+			case Token::StartElement:
+				onChild();
+				break;
+			case Token::EndElement:
+				return;
+			case Token::Text:
+				if (!isBlank(reader.text())) throw Unsupported{"mixed content"};
+				break;
+			case Token::EndOfDocument:
+				throw Unsupported{"unterminated element"};
+		}
+	}
+}
+
+void readEmpty(XmlPullReader& reader) {
+	checkAttributes(reader, {});
+	if (!isBlank(readText(reader))) throw Unsupported{"content in empty element"};
+}
+
+/**
+ * Enforce the order of the child elements given by the schema: each child is given the rank of its element in the
+ * sequence.
+ */
+class SequenceOrder {
+public:
+	void check(int rank, bool repeatable) {
+		if (rank < mLastRank || (rank == mLastRank && !repeatable)) throw Unsupported{"unexpected element order"};
+		mLastRank = rank;
+	}
+
+private:
+	int mLastRank{-1};
+};
+
+/**
+ * Parse a xs:dateTime value: YYYY-MM-DDThh:mm:ss[.s+][Z|(+|-)hh:mm]
+ */
+Xsd::XmlSchema::DateTime parseDateTime(string_view text) {
+	const auto value = collapsed(text);
+	size_t position = 0;
+	const auto readNumber = [&value, &position](size_t length, int min, int max) {
+		auto number = 0;
+		const auto end = value.data() + position + length;
+		if (value.size() < position + length || from_chars(value.data() + position, end, number).ptr != end ||
+		    number < min || max < number) {
+			throw Unsupported{"invalid dateTime"};
+		}
+		position += length;
+		return number;
+	};
+	const auto expect = [&value, &position](char separator) {
+		if (value.size() <= position || value[position] != separator) throw Unsupported{"invalid dateTime"};
+		position++;
+	};
+
+	const auto year = readNumber(4, 1, 9999);
+	expect('-');
+	const auto month = static_cast<unsigned short>(readNumber(2, 1, 12));
+	expect('-');
+	const auto day = static_cast<unsigned short>(readNumber(2, 1, 31));
+	expect('T');
+	const auto hours = static_cast<unsigned short>(readNumber(2, 0, 23));
+	expect(':');
+	const auto minutes = static_cast<unsigned short>(readNumber(2, 0, 59));
+	expect(':');
+	const auto secondsStart = position;
+	readNumber(2, 0, 59);
+	if (position < value.size() && value[position] == '.') {
+		const auto fractionStart = ++position;
+		while (position < value.size() && isdigit(static_cast<unsigned char>(value[position]))) {
+			position++;
+		}
+		if (position == fractionStart) throw Unsupported{"invalid dateTime"};
+	}
+	const auto seconds = stod(value.substr(secondsStart, position - secondsStart));
+
+	if (position == value.size()) return Xsd::XmlSchema::DateTime{year, month, day, hours, minutes, seconds};
+	if (value[position] == 'Z' && position + 1 == value.size()) {
+		return Xsd::XmlSchema::DateTime{year, month, day, hours, minutes, seconds, 0, 0};
+	}
+	if (value[position] != '+' && value[position] != '-') throw Unsupported{"invalid dateTime"};
+	const short sign = value[position++] == '-' ? -1 : 1;
+	const auto zoneHours = static_cast<short>(sign * readNumber(2, 0, 14));
+	expect(':');
+	const auto zoneMinutes = static_cast<short>(sign * readNumber(2, 0, 59));
+	if (position != value.size()) throw Unsupported{"invalid dateTime"};
+	return Xsd::XmlSchema::DateTime{year, month, day, hours, minutes, seconds, zoneHours, zoneMinutes};
+}
+
+template <typename NoteType>
+NoteType readNote(XmlPullReader& reader) {
+	checkAttributes(reader, {{kXmlNs, "lang"}});
+	const auto lang = getAttribute(reader, kXmlNs, "lang");
+	NoteType note{readText(reader)};
+	if (lang) note.setLang(Xsd::Namespace::Lang{*lang});
+	return note;
+}
+
+Xsd::Pidf::Status readStatus(XmlPullReader& reader) {
+	checkAttributes(reader, {});
+	Xsd::Pidf::Status status{};
+	SequenceOrder order{};
+	readChildren(reader, [&reader, &status, &order] {
+		if (!reader.is(kPidfNs, "basic")) throw Unsupported{"unsupported status element"};
+		order.check(0, false);
+		checkAttributes(reader, {});
+		const auto basic = readText(reader);
+		if (basic != "open" && basic != "closed") throw Unsupported{"invalid basic status"};
+		status.setBasic(Xsd::Pidf::Basic{basic});
+	});
+	return status;
+}
+
+oma_pres::ServiceDescription readServiceDescription(XmlPullReader& reader) {
+	checkAttributes(reader, {});
+	optional<string> serviceId{}, version{}, description{};
+	SequenceOrder order{};
+	readChildren(reader, [&] {
+		checkAttributes(reader, {});
+		if (reader.is(kOmaPresNs, "service-id")) {
+			order.check(0, false);
+			serviceId = collapsed(readText(reader));
+		} else if (reader.is(kOmaPresNs, "version")) {
+			order.check(1, false);
+			version = collapsed(readText(reader));
+		} else if (reader.is(kOmaPresNs, "description")) {
+			order.check(2, false);
+			description = collapsed(readText(reader));
+		} else throw Unsupported{"unsupported service-description element"};
+	});
+	if (!serviceId || !version) throw Unsupported{"incomplete service-description"};
+	oma_pres::ServiceDescription serviceDescription{*serviceId, *version};
+	if (description) serviceDescription.setDescription(*description);
+	return serviceDescription;
+}
+
+unique_ptr<Xsd::Pidf::Tuple> readTuple(XmlPullReader& reader) {
+	checkAttributes(reader, {{""sv, "id"}});
+	const auto id = getAttribute(reader, ""sv, "id");
+	if (!id) throw Unsupported{"tuple without id"};
+
+	// The status is mandatory and comes first.
+	auto token = reader.next();
+	if (token == Token::Text && isBlank(reader.text())) token = reader.next();
+	if (token != Token::StartElement || !reader.is(kPidfNs, "status")) throw Unsupported{"tuple without status"};
+	auto tuple = make_unique<Xsd::Pidf::Tuple>(readStatus(reader), collapsed(*id));
+
+	SequenceOrder order{};
+	readChildren(reader, [&reader, &tuple, &order] {
+		if (reader.is(kPidfNs, "contact")) {
+			order.check(0, false);
+			checkAttributes(reader, {});
+			tuple->setContact(Xsd::Pidf::Contact{collapsed(readText(reader))});
+		} else if (reader.is(kPidfNs, "note")) {
+			order.check(1, true);
+			tuple->getNote().push_back(readNote<Xsd::Pidf::Note>(reader));
+		} else if (reader.is(kPidfNs, "timestamp")) {
+			order.check(2, false);
+			checkAttributes(reader, {});
+			tuple->setTimestamp(parseDateTime(readText(reader)));
+		} else if (reader.is(kOmaPresNs, "service-description")) {
+			order.check(3, true);
+			tuple->getServiceDescription().push_back(readServiceDescription(reader));
+		} else throw Unsupported{"unsupported tuple element"};
+	});
+	return tuple;
+}
+
+using ActivityAdder = void (*)(Xsd::Rpid::Activities&);
+
+#define ACTIVITY(name, getter)                                                                                         \
+	{ name, [](Xsd::Rpid::Activities& activities) { activities.getter().push_back(Xsd::Rpid::Empty{}); } }
+
+const unordered_map<string_view, ActivityAdder> sActivities{
+    ACTIVITY("appointment", getAppointment),
+    ACTIVITY("away", getAway),
+    ACTIVITY("breakfast", getBreakfast),
+    ACTIVITY("busy", getBusy),
+    ACTIVITY("dinner", getDinner),
+    ACTIVITY("holiday", getHoliday),
+    ACTIVITY("in-transit", getInTransit),
+    ACTIVITY("looking-for-work", getLookingForWork),
+    ACTIVITY("meal", getMeal),
+    ACTIVITY("meeting", getMeeting),
+    ACTIVITY("on-the-phone", getOnThePhone),
+    ACTIVITY("performance", getPerformance),
+    ACTIVITY("permanent-absence", getPermanentAbsence),
+    ACTIVITY("playing", getPlaying),
+    ACTIVITY("presentation", getPresentation),
+    ACTIVITY("shopping", getShopping),
+    ACTIVITY("sleeping", getSleeping),
+    ACTIVITY("spectator", getSpectator),
+    ACTIVITY("steering", getSteering),
+    ACTIVITY("travel", getTravel),
+    ACTIVITY("tv", getTv),
+    ACTIVITY("vacation", getVacation),
+    ACTIVITY("working", getWorking),
+    ACTIVITY("worship", getWorship),
+};
+
+#undef ACTIVITY
+
+Xsd::Rpid::Activities readActivities(XmlPullReader& reader) {
+	checkAttributes(reader, {});
+	Xsd::Rpid::Activities activities{};
+	auto hasActivity = false;
+	readChildren(reader, [&reader, &activities, &hasActivity] {
+		if (reader.ns() != kRpidNs) throw Unsupported{"unsupported activities element"};
+		if (reader.localName() == "unknown") {
+			if (hasActivity) throw Unsupported{"unexpected element order"};
+			readEmpty(reader);
+			activities.setUnknown(Xsd::Rpid::Empty{});
+			hasActivity = true;
+			return;
+		}
+		const auto activity = sActivities.find(reader.localName());
+		if (activity == sActivities.end() || activities.getUnknown()) throw Unsupported{"unsupported activity"};
+		readEmpty(reader);
+		activity->second(activities);
+		hasActivity = true;
+	});
+	return activities;
+}
+
+Xsd::DataModel::Person readPerson(XmlPullReader& reader) {
+	checkAttributes(reader, {{""sv, "id"}});
+	const auto id = getAttribute(reader, ""sv, "id");
+	if (!id) throw Unsupported{"person without id"};
+	Xsd::DataModel::Person person{collapsed(*id)};
+
+	SequenceOrder order{};
+	readChildren(reader, [&reader, &person, &order] {
+		if (reader.is(kDataModelNs, "note")) {
+			order.check(0, true);
+			person.getNote().push_back(readNote<Xsd::DataModel::Note_t>(reader));
+		} else if (reader.is(kRpidNs, "activities")) {
+			order.check(1, true);
+			person.getActivities().push_back(readActivities(reader));
+		} else if (reader.is(kDataModelNs, "timestamp")) {
+			order.check(2, false);
+			checkAttributes(reader, {});
+			person.setTimestamp(Xsd::DataModel::Timestamp_t{parseDateTime(readText(reader))});
+		} else throw Unsupported{"unsupported person element"};
+	});
+	return person;
+}
+
+unique_ptr<Xsd::Pidf::Presence> readPresence(XmlPullReader& reader) {
+	if (reader.next() != Token::StartElement || !reader.is(kPidfNs, "presence")) {
+		throw Unsupported{"root element is not a presence"};
+	}
+	checkAttributes(reader, {{""sv, "entity"}});
+	const auto entity = getAttribute(reader, ""sv, "entity");
+	if (!entity) throw Unsupported{"presence without entity"};
+	auto presence = make_unique<Xsd::Pidf::Presence>(collapsed(*entity));
+
+	SequenceOrder order{};
+	readChildren(reader, [&reader, &presence, &order] {
+		if (reader.is(kPidfNs, "tuple")) {
+			order.check(0, true);
+			presence->getTuple().push_back(readTuple(reader));
+		} else if (reader.is(kPidfNs, "note")) {
+			order.check(1, true);
+			presence->getNote().push_back(readNote<Xsd::Pidf::Note>(reader));
+		} else if (reader.is(kDataModelNs, "person")) {
+			order.check(2, false);
+			presence->setPerson(readPerson(reader));
+		} else throw Unsupported{"unsupported presence element"};
+	});
+	if (reader.next() != Token::EndOfDocument) throw Unsupported{"content after the root element"};
+	return presence;
+}
+
+} // namespace
+
+unique_ptr<Xsd::Pidf::Presence> PidfFastParser::parse(string_view document) noexcept {
+	try {
+		XmlPullReader reader{document};
+		return readPresence(reader);
+	} catch (const Unsupported& e) {
+		SLOGD << "PidfFastParser - cannot handle document: " << e.reason;
+	} catch (const exception& e) {
+		SLOGD << "PidfFastParser - cannot handle document: " << e.what();
+	}
+	return nullptr;
+}
+
+} // namespace flexisip
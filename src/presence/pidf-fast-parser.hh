@@ -0,0 +1,48 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+#include "xml/pidf+xml.hh"
+
+namespace flexisip {
+
+/**
+ * Fast path for the parsing of the PIDF documents received in PUBLISH requests.
+ * The document is read in a single pass, without building any DOM, and the Xsd::Pidf objects are filled directly.
+ *
+ * Only the subset commonly published by user agents is understood:
+ *  - presence: tuple*, note*, dm:person?
+ *  - tuple: status (with basic only), contact (without priority), note*, timestamp, oma-pres:service-description*
+ *  - dm:person: note*, rpid:activities* (plain activities and unknown only), timestamp
+ * Anything else (other elements or attributes, CDATA sections, DTD...) makes the parsing fail, so that the complete
+ * parser can be used instead.
+ */
+class PidfFastParser {
+public:
+	/**
+	 * @return the parsed document, or nullptr if it isn't well-formed or uses something outside of the supported
+	 * subset.
+	 */
+	static std::unique_ptr<Xsd::Pidf::Presence> parse(std::string_view document) noexcept;
+};
+
+} // namespace flexisip
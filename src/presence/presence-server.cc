@@ -30,6 +30,7 @@
 
 #include "bellesip-signaling-exception.hh"
 #include "observers/presence-longterm.hh"
+#include "pidf-fast-parser.hh"
 #include "presence/presentity/presentity-manager.hh"
 #include "presence/presentity/presentity-presence-information.hh"
 #include "presence/subscription/subscription.hh"
@@ -520,15 +521,21 @@ void PresenceServer::processPublishRequestEvent(const belle_sip_request_event_t*
 	// At that point, we are safe
 
 	if (belle_sip_message_get_body_size(BELLE_SIP_MESSAGE(request)) > 0) {
-		unique_ptr<Xsd::Pidf::Presence> presenceBody = nullptr;
-		try {
-			istringstream data(belle_sip_message_get_body(BELLE_SIP_MESSAGE(request)));
-			presenceBody = Xsd::Pidf::parsePresence(data, Xsd::XmlSchema::Flags::dont_validate);
-		} catch (const Xsd::XmlSchema::Exception& e) {
-			ostringstream os;
-			os << "Cannot parse body caused by [" << e << "]";
-			// todo check error code
-			throw BELLESIP_SIGNALING_EXCEPTION_1(400, belle_sip_header_create("Warning", os.str().c_str())) << os.str();
+		const auto* body = belle_sip_message_get_body(BELLE_SIP_MESSAGE(request));
+		const auto bodySize = static_cast<size_t>(belle_sip_message_get_body_size(BELLE_SIP_MESSAGE(request)));
+		// Fast path for the common documents, the complete parser is only used for the others.
+		auto presenceBody = PidfFastParser::parse({body, bodySize});
+		if (!presenceBody) {
+			try {
+				istringstream data(body);
+				presenceBody = Xsd::Pidf::parsePresence(data, Xsd::XmlSchema::Flags::dont_validate);
+			} catch (const Xsd::XmlSchema::Exception& e) {
+				ostringstream os;
+				os << "Cannot parse body caused by [" << e << "]";
+				// todo check error code
+				throw BELLESIP_SIGNALING_EXCEPTION_1(400, belle_sip_header_create("Warning", os.str().c_str()))
+				    << os.str();
+			}
 		}
 
 		// check entity
@@ -56,6 +56,7 @@ void PresenceInformationElementMap::removeByEtag(const std::string& eTag, bool n
 	if (it != mInformationElements.end()) {
 		mInformationElements.erase(it);
 		setupLastActivity();
+		mVersion++;
 		if (notifyOther) {
 			notifyListeners();
 		}
@@ -69,6 +70,7 @@ void PresenceInformationElementMap::setupLastActivity() {
 	    [weakThis = weak_from_this()](unsigned int) {
 		    if (auto sharedThis = weakThis.lock()) {
 			    sharedThis->mLastActivity = nullopt;
+			    sharedThis->mVersion++;
 		    }
 		    return BELLE_SIP_STOP;
 	    },
@@ -78,6 +80,7 @@ void PresenceInformationElementMap::setupLastActivity() {
 void PresenceInformationElementMap::emplace(const std::string& eTag,
                                             std::unique_ptr<PresenceInformationElement>&& element) {
 	if (mInformationElements.try_emplace(eTag, std::move(element)).second) {
+		mVersion++;
 		notifyListeners();
 		if (mInformationElements.size() > 10) {
 			SLOGI << "PresenceInformationElementMap[" << this << "] - large map of " << mInformationElements.size()
@@ -95,6 +98,8 @@ void PresenceInformationElementMap::mergeInto(const std::shared_ptr<PresenceInfo
 	otherMap->mInformationElements.merge(mInformationElements);
 	otherMap->mListeners.insert(end(otherMap->mListeners), begin(mListeners), end(mListeners));
 	otherMap->mParents.insert(end(otherMap->mParents), begin(mParents), end(mParents));
+	otherMap->mVersion++;
+	mVersion++;
 
 	if (notifyOther) {
 		otherMap->notifyListeners();
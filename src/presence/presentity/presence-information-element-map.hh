@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -58,6 +59,7 @@ public:
 			elementToRefresh->setExpiresTimer(std::move(timer));
 			emplace(newEtag, std::move(elementToRefresh));
 			setupLastActivity();
+			mVersion++;
 		} else {
 			throw FLEXISIP_EXCEPTION << "Unknown eTag [" << oldEtag << "] in map.";
 		}
@@ -91,6 +93,14 @@ public:
 		return mLastActivity;
 	};
 
+	/**
+	 * Incremented every time the elements of the map, or the time of last activity, change. Used to know whether
+	 * something built from the map is still up to date.
+	 */
+	uint64_t getVersion() const {
+		return mVersion;
+	}
+
 private:
 	explicit PresenceInformationElementMap(belle_sip_main_loop_t* belleSipMainloop,
 	                                       const std::weak_ptr<PresentityPresenceInformation>& initialParent,
@@ -104,6 +114,7 @@ private:
 	std::vector<std::weak_ptr<ElementMapListener>> mListeners{};
 	std::optional<std::chrono::system_clock::time_point> mLastActivity = std::nullopt;
 	BelleSipSourcePtr mLastActivityTimer = nullptr;
+	uint64_t mVersion{0};
 
 	mutable std::list<std::weak_ptr<PresentityPresenceInformation>> mParents;
 	const std::weak_ptr<StatPair> mCountPresenceElementMap;
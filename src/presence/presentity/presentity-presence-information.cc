@@ -205,11 +205,13 @@ string PresentityPresenceInformation::refreshTuplesForEtag(const string& eTag, i
 
 void PresentityPresenceInformation::setDefaultElement() {
 	mDefaultInformationElement = make_shared<PresenceInformationElement>(getEntity(), mCountPresenceElement);
+	invalidatePidfCache();
 	notifyAll();
 }
 
 void PresentityPresenceInformation::setDefaultElement(const belle_sip_uri_t* newEntity) {
 	mDefaultInformationElement = make_shared<PresenceInformationElement>(getEntity(), mCountPresenceElement);
+	invalidatePidfCache();
 
 	if (char* newEntityAsString = belle_sip_uri_to_string(newEntity)) {
 		for (auto& tup : mDefaultInformationElement->getTuples()) {
@@ -317,8 +319,10 @@ void PresentityPresenceInformation::removeListener(const shared_ptr<PresentityPr
 void PresentityPresenceInformation::addCapability(const std::string& capability) {
 	if (mCapabilities.empty()) {
 		mCapabilities = capability;
+		invalidatePidfCache();
 	} else if (mCapabilities.find(capability) == string::npos) {
 		mCapabilities += ", " + capability;
+		invalidatePidfCache();
 		notifyAll();
 	}
 }
@@ -331,7 +335,21 @@ bool PresentityPresenceInformation::isKnown() const {
 	return !mInformationElements->isEmpty() || hasDefaultElement();
 }
 
-string PresentityPresenceInformation::getPidf(bool extended) {
+const string& PresentityPresenceInformation::getPidf(bool extended) {
+	auto& cached = mCachedPidfs[extended ? 1 : 0];
+	if (cached && cached->map == mInformationElements.get() &&
+	    cached->mapVersion == mInformationElements->getVersion()) {
+		return cached->body;
+	}
+
+	// Serialize before resetting the cache entry, so that the previous body is kept if an exception is thrown.
+	auto body = serializePidf(extended);
+	mPidfSerializationCount++;
+	cached = CachedPidf{mInformationElements.get(), mInformationElements->getVersion(), std::move(body)};
+	return cached->body;
+}
+
+string PresentityPresenceInformation::serializePidf(bool extended) {
 	stringstream out;
 	try {
 		char* entity = belle_sip_uri_to_string(getEntity());
@@ -498,6 +516,7 @@ void PresentityPresenceInformation::forEachSubscriber(
 void PresentityPresenceInformation::linkTo(const std::shared_ptr<PresentityPresenceInformation>& other) {
 	mInformationElements->mergeInto(other->mInformationElements, false);
 	mInformationElements = other->mInformationElements;
+	invalidatePidfCache();
 
 	forEachSubscriber([this](const auto& listener) {
 		mPresentityManager.enableExtendedNotifyIfPossible(listener, shared_from_this());
@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include <array>
 #include <list>
+#include <optional>
 
 #include <belle-sip/belle-sip.h>
 #include <memory>
@@ -115,8 +117,10 @@ public:
 
 	/*
 	 * return the presence information for this entity in a pidf serilized format
+	 * The document is only serialized again when the presence information has changed since the previous call, so that
+	 * all the listeners of a presentity share the same body. The returned reference is valid until the next change.
 	 */
-	std::string getPidf(bool extended);
+	const std::string& getPidf(bool extended);
 
 	/*
 	 * return true if a presence info is already known from a publish
@@ -149,6 +153,13 @@ public:
 		notifyAll();
 	}
 
+	/*
+	 * return the number of times the pidf was actually serialized, for statistics and tests
+	 */
+	uint64_t getPidfSerializationCount() const {
+		return mPidfSerializationCount;
+	}
+
 	void linkTo(const std::shared_ptr<PresentityPresenceInformation>& other);
 
 	/*
@@ -174,6 +185,14 @@ private:
 	 */
 	void notifyAll();
 
+	std::string serializePidf(bool extended);
+	/*
+	 * Must be called every time something used by serializePidf(), other than the element map, is modified.
+	 */
+	void invalidatePidfCache() {
+		mCachedPidfs = {};
+	}
+
 	std::shared_ptr<PresentityPresenceInformationListener> findSubscriber(
 	    const std::function<bool(const std::shared_ptr<PresentityPresenceInformationListener>&)>& predicate) const;
 	void forEachSubscriber(
@@ -196,6 +215,15 @@ private:
 	std::string mName;
 	std::string mCapabilities;
 	std::unordered_map<std::string, std::string> mAddedCapabilities;
+
+	// Serialized pidf, and version of the element map it was built from.
+	struct CachedPidf {
+		const PresenceInformationElementMap* map;
+		uint64_t mapVersion;
+		std::string body;
+	};
+	std::array<std::optional<CachedPidf>, 2> mCachedPidfs{}; // indexed by the 'extended' flag
+	uint64_t mPidfSerializationCount{0};
 };
 
 std::ostream& operator<<(std::ostream& __os, const PresentityPresenceInformation&);
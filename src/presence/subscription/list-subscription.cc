@@ -70,7 +70,7 @@ void ListSubscription::addInstanceToResource(Xsd::Rlmi::Resource& resource,
 	ostringstream cid;
 	cid << cid_rand_part << "@" << belle_sip_uri_get_host(mName.get());
 	instance.setCid(cid.str());
-	string pidf = presentityInformation.getPidf(extended);
+	const auto& pidf = presentityInformation.getPidf(extended);
 	belle_sip_memory_body_handler_t* bodyPart =
 	    belle_sip_memory_body_handler_new_copy_from_buffer((void*)pidf.c_str(), pidf.length(), nullptr, nullptr);
 	belle_sip_body_handler_add_header(BELLE_SIP_BODY_HANDLER(bodyPart),
@@ -171,9 +171,10 @@ void ListSubscription::notify(bool isFullState) {
 		map[""].name = "urn:ietf:params:xml:ns:rlmi";
 		stringstream out;
 		Xsd::Rlmi::serializeList(out, resourceList, map);
+		const auto rlmi = out.str();
 
 		belle_sip_memory_body_handler_t* firstBodyPart = belle_sip_memory_body_handler_new_copy_from_buffer(
-		    (void*)out.str().c_str(), out.str().length(), nullptr, nullptr);
+		    (void*)rlmi.c_str(), rlmi.length(), nullptr, nullptr);
 		belle_sip_body_handler_add_header(BELLE_SIP_BODY_HANDLER(firstBodyPart),
 		                                  belle_sip_header_create("Content-Transfer-Encoding", "binary"));
 		ostringstream content_id;
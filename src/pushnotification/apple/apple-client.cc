@@ -35,7 +35,8 @@ AppleClient::AppleClient(sofiasip::SuRoot& root,
                          const std::string& trustStorePath,
                          const std::string& certPath,
                          const std::string& certName,
-                         const Service* service)
+                         const Service* service,
+                         unsigned maxConnections)
     : Client{service} {
 	ostringstream os{};
 	os << "AppleClient[" << this << "]";
@@ -43,7 +44,12 @@ AppleClient::AppleClient(sofiasip::SuRoot& root,
 	SLOGD << mLogPrefix << ": constructing AppleClient";
 
 	const auto apn_server = (certName.find(".dev") != string::npos) ? APN_DEV_ADDRESS : APN_PROD_ADDRESS;
-	mHttp2Client = Http2Client::make(root, apn_server, APN_PORT, trustStorePath, certPath);
+	mHttp2ClientPool = make_unique<Http2ClientPool>(
+	    root,
+	    [&root, apn_server, port = APN_PORT, trustStorePath, certPath] {
+		    return Http2Client::make(root, apn_server, port, trustStorePath, certPath);
+	    },
+	    maxConnections);
 }
 
 std::shared_ptr<Request> AppleClient::makeRequest(PushType pType,
@@ -55,11 +61,10 @@ std::shared_ptr<Request> AppleClient::makeRequest(PushType pType,
 void AppleClient::sendPush(const std::shared_ptr<Request>& req) {
 	auto appleReq = dynamic_pointer_cast<AppleRequest>(req);
 
-	auto host = mHttp2Client->getHost();
-	appleReq->getHeaders().add("host", host);
+	appleReq->getHeaders().add("host", mHttp2ClientPool->getHost());
 
 	appleReq->setState(Request::State::InProgress);
-	mHttp2Client->send(
+	mHttp2ClientPool->send(
 	    appleReq, [this](const auto& req, const auto& resp) { this->onResponse(req, resp); },
 	    [this](const auto& req) { this->onError(req); });
 }
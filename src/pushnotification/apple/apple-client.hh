@@ -23,7 +23,7 @@
 #include "pushnotification/client.hh"
 #include "utils/transport/http/http-message.hh"
 #include "utils/transport/http/http-response.hh"
-#include "utils/transport/http/http2client.hh"
+#include "utils/transport/http/http2client-pool.hh"
 
 namespace flexisip {
 namespace pushnotification {
@@ -37,7 +37,8 @@ public:
 	            const std::string& trustStorePath,
 	            const std::string& certPath,
 	            const std::string& certName,
-	            const Service* service = nullptr);
+	            const Service* service = nullptr,
+	            unsigned maxConnections = 1);
 
 	/**
 	 * Send the request to the apple PNR service. If the request succeed, if a response is received, the
@@ -52,15 +53,19 @@ public:
 	                                     const std::map<std::string, std::shared_ptr<Client>>& = {}) override;
 
 	bool isIdle() const noexcept override {
-		return mHttp2Client->isIdle();
+		return mHttp2ClientPool->isIdle();
 	}
 
 	void enableInsecureTestMode() {
-		mHttp2Client->enableInsecureTestMode();
+		mHttp2ClientPool->enableInsecureTestMode();
 	}
 
 	void setRequestTimeout(std::chrono::seconds requestTimeout) override {
-		mHttp2Client->setRequestTimeout(requestTimeout);
+		mHttp2ClientPool->setRequestTimeout(requestTimeout);
+	}
+
+	const Http2ClientPool& getHttp2ClientPool() const {
+		return *mHttp2ClientPool;
 	}
 
 	static std::string APN_DEV_ADDRESS;
@@ -70,7 +75,7 @@ private:
 	void onResponse(const std::shared_ptr<HttpMessage>& request, const std::shared_ptr<HttpResponse>& response);
 	void onError(const std::shared_ptr<HttpMessage>& request);
 
-	std::shared_ptr<Http2Client> mHttp2Client;
+	std::unique_ptr<Http2ClientPool> mHttp2ClientPool;
 	std::string mLogPrefix{};
 
 	static std::string APN_PROD_ADDRESS;
@@ -38,5 +38,27 @@ void Client::incrFailedCounter() {
 	}
 }
 
+void Client::setQueueSizeStat(size_t queueSize) {
+	if (mService) {
+		if (auto counter = mService->getQueueSizeCounter()) {
+			// The counter is the sum of the queue sizes of all the clients.
+			if (queueSize > mReportedQueueSize) counter->add(queueSize - mReportedQueueSize);
+			else counter->sub(mReportedQueueSize - queueSize);
+		}
+	}
+	mReportedQueueSize = queueSize;
+}
+
+void Client::addTimeInQueueStat(chrono::steady_clock::duration timeInQueue) {
+	if (mService) {
+		if (auto counter = mService->getQueueTimeCounter()) {
+			counter->add(chrono::duration_cast<chrono::milliseconds>(timeInQueue).count());
+		}
+		if (auto counter = mService->getDequeuedCounter()) {
+			counter->incr();
+		}
+	}
+}
+
 } // namespace pushnotification
 } // namespace flexisip
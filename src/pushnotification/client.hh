@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "request.hh"
 #include "service.hh"
 
@@ -42,9 +44,13 @@ public:
 protected:
 	void incrSentCounter();
 	void incrFailedCounter();
+	// Stats of the clients which queue requests before sending them. Calls for the same client must not be concurrent.
+	void setQueueSizeStat(size_t queueSize);
+	void addTimeInQueueStat(std::chrono::steady_clock::duration timeInQueue);
 
 private:
 	const Service* mService;
+	size_t mReportedQueueSize{0}; // Share of the queue size counter last reported by this client.
 
 	friend class Service;
 };
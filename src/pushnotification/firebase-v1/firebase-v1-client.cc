@@ -21,7 +21,7 @@
 #include "flexisip/logmanager.hh"
 #include "firebase-v1-authentication-manager.hh"
 #include "firebase-v1-request.hh"
-#include "utils/transport/http/http2client.hh"
+#include "utils/transport/http/http2client-pool.hh"
 
 using namespace std;
 
@@ -32,14 +32,22 @@ std::string FirebaseV1Client::FIREBASE_PORT{"443"};
 
 FirebaseV1Client::FirebaseV1Client(sofiasip::SuRoot& root,
                                    std::shared_ptr<FirebaseV1AuthenticationManager>&& authenticationManager,
-                                   const Service* service)
+                                   const Service* service,
+                                   unsigned maxConnections)
     : Client{service}, mProjectId(authenticationManager->getProjectId()) {
 	ostringstream os{};
 	os << "FirebaseV1Client[" << this << "]";
 	mLogPrefix = os.str();
 	SLOGD << mLogPrefix << ": constructing FirebaseV1Client";
 
-	mHttp2Client = Http2Client::make(root, FIREBASE_ADDRESS, FIREBASE_PORT, std::move(authenticationManager));
+	// All the connections share the same access token.
+	mHttp2ClientPool = make_unique<Http2ClientPool>(
+	    root,
+	    [&root, host = FIREBASE_ADDRESS, port = FIREBASE_PORT,
+	     authManager = shared_ptr<AuthenticationManager>{std::move(authenticationManager)}] {
+		    return Http2Client::make(root, host, port, shared_ptr<AuthenticationManager>{authManager});
+	    },
+	    maxConnections);
 }
 
 std::shared_ptr<Request> FirebaseV1Client::makeRequest(PushType pType,
@@ -52,7 +60,7 @@ void FirebaseV1Client::sendPush(const std::shared_ptr<Request>& req) {
 	auto firebaseReq = dynamic_pointer_cast<FirebaseV1Request>(req);
 
 	firebaseReq->setState(Request::State::InProgress);
-	mHttp2Client->send(
+	mHttp2ClientPool->send(
 	    firebaseReq, [this](const auto& req, const auto& resp) { this->onResponse(req, resp); },
 	    [this](const auto& req) { this->onError(req); });
 }
@@ -26,7 +26,7 @@
 #include "pushnotification/firebase-v1/firebase-v1-authentication-manager.hh"
 #include "utils/transport/http/http-message.hh"
 #include "utils/transport/http/http-response.hh"
-#include "utils/transport/http/http2client.hh"
+#include "utils/transport/http/http2client-pool.hh"
 
 namespace flexisip::pushnotification {
 
@@ -37,7 +37,8 @@ class FirebaseV1Client : public Client {
 public:
 	FirebaseV1Client(sofiasip::SuRoot& root,
 	                 std::shared_ptr<FirebaseV1AuthenticationManager>&& authenticationManager,
-	                 const Service* service = nullptr);
+	                 const Service* service = nullptr,
+	                 unsigned maxConnections = 1);
 
 	/**
 	 * Send the request to the Firebase PNR server. If the request succeeds and a response is received, the
@@ -52,19 +53,19 @@ public:
 	                                     const std::map<std::string, std::shared_ptr<Client>>& = {}) override;
 
 	[[nodiscard]] bool isIdle() const noexcept override {
-		return mHttp2Client->isIdle();
+		return mHttp2ClientPool->isIdle();
 	}
 
 	void enableInsecureTestMode() {
-		mHttp2Client->enableInsecureTestMode();
+		mHttp2ClientPool->enableInsecureTestMode();
 	}
 
 	void setRequestTimeout(std::chrono::seconds requestTimeout) override {
-		mHttp2Client->setRequestTimeout(requestTimeout);
+		mHttp2ClientPool->setRequestTimeout(requestTimeout);
 	}
 
-	[[nodiscard]] const std::shared_ptr<Http2Client>& getHttp2Client() const {
-		return mHttp2Client;
+	[[nodiscard]] const Http2ClientPool& getHttp2ClientPool() const {
+		return *mHttp2ClientPool;
 	}
 
 	static std::string FIREBASE_ADDRESS;
@@ -74,7 +75,7 @@ private:
 	void onResponse(const std::shared_ptr<HttpMessage>& request, const std::shared_ptr<HttpResponse>& response);
 	void onError(const std::shared_ptr<HttpMessage>& request);
 
-	std::shared_ptr<Http2Client> mHttp2Client;
+	std::unique_ptr<Http2ClientPool> mHttp2ClientPool;
 	std::string mLogPrefix{};
 	std::string mProjectId{};
 };
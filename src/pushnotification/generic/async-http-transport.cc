@@ -0,0 +1,314 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "async-http-transport.hh"
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <sstream>
+
+#include "flexisip/logmanager.hh"
+
+#include "utils/string-utils.hh"
+
+using namespace std;
+
+namespace flexisip::pushnotification {
+
+/**
+ * One keep-alive connection of the transport, carrying one request at a time.
+ */
+class AsyncHttpTransport::Connection : public enable_shared_from_this<Connection> {
+public:
+	Connection(AsyncHttpTransport& transport, unique_ptr<TlsConnection>&& tls)
+	    : mTransport{transport}, mTls{std::move(tls)}, mTimer{transport.mRoot, sIdleTimeout} {
+		ostringstream os{};
+		os << "AsyncHttpTransport::Connection[" << this << "]: ";
+		mLogPrefix = os.str();
+	}
+	~Connection() {
+		unregisterPollIn();
+	}
+
+	bool isConnected() const noexcept {
+		return mState == State::Connected;
+	}
+	bool isAvailable() const noexcept {
+		return mRequest == nullptr;
+	}
+
+	void send(const shared_ptr<LegacyRequest>& req) {
+		mRequest = req;
+		mRetried = false;
+		if (mState == State::Disconnected) connect();
+		else writeRequest();
+	}
+
+private:
+	enum class State { Disconnected, Connecting, Connected };
+
+	void connect() {
+		SLOGD << mLogPrefix << "connecting to " << mTls->getHost() << ":" << mTls->getPort();
+		mState = State::Connecting;
+		mTls->connectAsync(*mTransport.mRoot.getCPtr(), [weakThis = weak_from_this()] {
+			if (auto sharedThis = weakThis.lock()) sharedThis->onConnected();
+		});
+	}
+
+	void onConnected() {
+		if (!mTls->isConnected()) {
+			mState = State::Disconnected;
+			finish("Cannot create connection to server");
+			return;
+		}
+		mState = State::Connected;
+		su_wait_create(&mPollInWait, mTls->getFd(), SU_WAIT_IN);
+		su_root_register(mTransport.mRoot.getCPtr(), &mPollInWait, onPollInCb, this, su_pri_normal);
+		mPollInRegistered = true;
+		if (mRequest) writeRequest();
+		else waitForNextRequest();
+	}
+
+	void writeRequest() {
+		mResponse.clear();
+		const auto& buffer = mRequest->getData(mTransport.mUrl, mTransport.mMethod);
+		size_t written = 0;
+		while (written < buffer.size()) {
+			const auto count = mTls->write(buffer.data() + written, int(buffer.size() - written));
+			if (count <= 0) break;
+			written += count;
+		}
+		SLOGD << mLogPrefix << "PNR " << mRequest.get() << " sent " << written << "/" << buffer.size() << " data";
+		if (written < buffer.size()) {
+			onFailure("Cannot send to server", true);
+			return;
+		}
+		mTimer.set([this] { onFailure("No response from server", false); }, mTransport.mRequestTimeout);
+	}
+
+	void waitForNextRequest() {
+		mTimer.set(
+		    [this] {
+			    SLOGD << mLogPrefix << "connection is idle";
+			    disconnect();
+		    },
+		    sIdleTimeout);
+	}
+
+	static int onPollInCb(su_root_magic_t*, su_wait_t* w, su_wakeup_arg_t* arg) noexcept {
+		static_cast<Connection*>(arg)->onPollIn(w->revents);
+		return 0;
+	}
+
+	void onPollIn(int revents) {
+		char buffer[4096];
+		int count = 0;
+		if (revents & SU_WAIT_IN) {
+			while ((count = mTls->read(buffer, sizeof(buffer))) > 0) {
+				mResponse.append(buffer, count);
+			}
+		}
+		const auto closed = count < 0 || !mTls->isConnected() || (revents & (SU_WAIT_HUP | SU_WAIT_ERR)) != 0;
+
+		if (!mRequest) {
+			// Nothing is expected from the server. It is most likely closing the connection.
+			mResponse.clear();
+			if (closed) disconnect();
+			return;
+		}
+
+		auto keepAlive = true;
+		auto length = responseLength(mResponse, keepAlive);
+		if (length == 0 && mResponse.empty() && closed) {
+			// The server closed the connection before receiving the request (e.g. keep-alive timeout on its side).
+			onFailure("Connection closed by server", true);
+			return;
+		}
+		if (length == 0 || length == string_view::npos) {
+			if (!closed) return; // Wait for the end of the response.
+			if (length == 0) {
+				onFailure("Incomplete response from server", false);
+				return;
+			}
+			length = mResponse.size();
+		}
+
+		const auto response = mResponse.substr(0, length);
+		SLOGD << mLogPrefix << "PNR " << mRequest.get() << " read " << response.size() << " data:\n" << response;
+		const auto error = mRequest->isValidResponse(response);
+		if (!error.empty() || !keepAlive || closed) disconnect();
+		else waitForNextRequest();
+		finish(error.empty() ? "" : "Invalid server response: " + error);
+	}
+
+	void onFailure(const string& error, bool retry) {
+		SLOGD << mLogPrefix << "PNR " << mRequest.get() << ": " << error;
+		disconnect();
+		if (retry && !mRetried) {
+			// Most likely a stale keep-alive connection: send the request again over a new one.
+			mRetried = true;
+			connect();
+			return;
+		}
+		finish(error);
+	}
+
+	// Must be the last call of the methods which call it, because the transport may give a new request to this
+	// connection.
+	void finish(const string& error) {
+		if (!mRequest) return;
+		auto request = std::move(mRequest);
+		mTransport.onRequestDone(*request, error);
+	}
+
+	void disconnect() {
+		mTimer.reset();
+		unregisterPollIn();
+		mTls->disconnect();
+		mResponse.clear();
+		mState = State::Disconnected;
+	}
+
+	void unregisterPollIn() {
+		if (!mPollInRegistered) return;
+		su_root_unregister(mTransport.mRoot.getCPtr(), &mPollInWait, onPollInCb, this);
+		su_wait_destroy(&mPollInWait);
+		mPollInRegistered = false;
+	}
+
+	AsyncHttpTransport& mTransport;
+	unique_ptr<TlsConnection> mTls;
+	State mState{State::Disconnected};
+	su_wait_t mPollInWait{};
+	bool mPollInRegistered{false};
+	sofiasip::Timer mTimer;
+	shared_ptr<LegacyRequest> mRequest{};
+	bool mRetried{false};
+	string mResponse{};
+	string mLogPrefix{};
+};
+
+AsyncHttpTransport::AsyncHttpTransport(sofiasip::SuRoot& root,
+                                       ConnectionFactory&& connectionFactory,
+                                       Method method,
+                                       const sofiasip::Url& url,
+                                       unsigned maxConnections,
+                                       Transport::OnSuccessCb&& onSuccess,
+                                       Transport::OnErrorCb&& onError,
+                                       OnAvailableCb&& onAvailable)
+    : mRoot{root}, mMethod{method}, mUrl{url}, mOnSuccess{std::move(onSuccess)}, mOnError{std::move(onError)},
+      mOnAvailable{std::move(onAvailable)} {
+	mConnections.reserve(maxConnections);
+	for (auto i = 0u; i < max(maxConnections, 1u); ++i) {
+		mConnections.push_back(make_shared<Connection>(*this, connectionFactory()));
+	}
+}
+
+AsyncHttpTransport::~AsyncHttpTransport() = default;
+
+bool AsyncHttpTransport::send(const shared_ptr<LegacyRequest>& req) {
+	// Prefer a connection which is already established.
+	auto connection = find_if(mConnections.begin(), mConnections.end(), [](const auto& candidate) {
+		return candidate->isAvailable() && candidate->isConnected();
+	});
+	if (connection == mConnections.end()) {
+		connection = find_if(mConnections.begin(), mConnections.end(),
+		                     [](const auto& candidate) { return candidate->isAvailable(); });
+		if (connection == mConnections.end()) return false;
+	}
+	(*connection)->send(req);
+	return true;
+}
+
+bool AsyncHttpTransport::isIdle() const noexcept {
+	return all_of(mConnections.cbegin(), mConnections.cend(),
+	              [](const auto& connection) { return connection->isAvailable(); });
+}
+
+void AsyncHttpTransport::onRequestDone(LegacyRequest& req, const string& error) {
+	if (error.empty()) mOnSuccess(req);
+	else mOnError(req, error);
+	mOnAvailable();
+}
+
+size_t AsyncHttpTransport::responseLength(string_view data, bool& keepAlive) {
+	keepAlive = true;
+	const auto headersEnd = data.find("\r\n\r\n");
+	if (headersEnd == string_view::npos) return 0;
+	const auto bodyStart = headersEnd + 4;
+
+	auto statusCode = 0;
+	if (const auto space = data.find(' '); space < headersEnd) {
+		from_chars(data.data() + space + 1, data.data() + headersEnd, statusCode);
+	}
+
+	optional<size_t> contentLength{};
+	auto chunked = false;
+	for (auto lineStart = data.find("\r\n") + 2; lineStart < bodyStart;) {
+		const auto lineEnd = data.find("\r\n", lineStart);
+		const auto line = data.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 2;
+		const auto colon = line.find(':');
+		if (colon == string_view::npos) continue;
+		const auto name = StringUtils::toLower(string{line.substr(0, colon)});
+		auto value = StringUtils::toLower(string{line.substr(colon + 1)});
+		value.erase(0, value.find_first_not_of(' '));
+		if (name == "content-length") {
+			size_t length = 0;
+			from_chars(value.data(), value.data() + value.size(), length);
+			contentLength = length;
+		} else if (name == "transfer-encoding") {
+			chunked = value.find("chunked") != string::npos;
+		} else if (name == "connection") {
+			keepAlive = value.find("close") == string::npos;
+		}
+	}
+
+	// Responses without body
+	if ((100 <= statusCode && statusCode < 200) || statusCode == 204 || statusCode == 304) return bodyStart;
+
+	if (chunked) {
+		auto position = bodyStart;
+		while (true) {
+			const auto lineEnd = data.find("\r\n", position);
+			if (lineEnd == string_view::npos) return 0;
+			size_t chunkSize = 0;
+			from_chars(data.data() + position, data.data() + lineEnd, chunkSize, 16);
+			position = lineEnd + 2;
+			if (chunkSize == 0) {
+				// Skip the trailers, up to the empty line.
+				while (true) {
+					const auto trailerEnd = data.find("\r\n", position);
+					if (trailerEnd == string_view::npos) return 0;
+					if (trailerEnd == position) return position + 2;
+					position = trailerEnd + 2;
+				}
+			}
+			position += chunkSize + 2;
+			if (data.size() < position) return 0;
+		}
+	}
+
+	if (contentLength) return data.size() < bodyStart + *contentLength ? 0 : bodyStart + *contentLength;
+
+	keepAlive = false;
+	return string_view::npos;
+}
+
+} // namespace flexisip::pushnotification
@@ -0,0 +1,107 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sofia-sip/su_wait.h>
+
+#include "flexisip/sofia-wrapper/su-root.hh"
+#include "flexisip/sofia-wrapper/timer.hh"
+
+#include "pushnotification/generic/generic-enums.hh"
+#include "pushnotification/legacy/legacy-client.hh"
+#include "utils/transport/tls-connection.hh"
+
+namespace flexisip::pushnotification {
+
+/**
+ * Non-blocking HTTP/1.1 transport running on the main loop.
+ * Requests are sent over up to 'maxConnections' keep-alive connections, each one carrying a single request at a time.
+ * The caller is told through the OnAvailableCb when a connection is free again, so that it can send its next request.
+ */
+class AsyncHttpTransport {
+public:
+	using ConnectionFactory = std::function<std::unique_ptr<TlsConnection>()>;
+	using OnAvailableCb = std::function<void()>;
+
+	AsyncHttpTransport(sofiasip::SuRoot& root,
+	                   ConnectionFactory&& connectionFactory,
+	                   Method method,
+	                   const sofiasip::Url& url,
+	                   unsigned maxConnections,
+	                   Transport::OnSuccessCb&& onSuccess,
+	                   Transport::OnErrorCb&& onError,
+	                   OnAvailableCb&& onAvailable);
+	AsyncHttpTransport(const AsyncHttpTransport&) = delete;
+	AsyncHttpTransport(AsyncHttpTransport&&) = delete;
+	~AsyncHttpTransport();
+
+	/**
+	 * Send the request over a free connection. The request is never answered synchronously.
+	 * @return false if all the connections are busy.
+	 */
+	bool send(const std::shared_ptr<LegacyRequest>& req);
+
+	/**
+	 * @return true when no request is in progress.
+	 */
+	bool isIdle() const noexcept;
+
+	/**
+	 * Time to wait for a complete response. Valid only for future requests.
+	 */
+	void setRequestTimeout(std::chrono::seconds requestTimeout) noexcept {
+		mRequestTimeout = requestTimeout;
+	}
+
+	/**
+	 * Length of the complete HTTP/1.1 response at the beginning of data.
+	 * @param[out] keepAlive false when the server announced it would close the connection.
+	 * @return 0 if the response is not complete yet, std::string_view::npos if its end is only marked by the closing
+	 * of the connection.
+	 */
+	static size_t responseLength(std::string_view data, bool& keepAlive);
+
+private:
+	class Connection;
+
+	void onRequestDone(LegacyRequest& req, const std::string& error);
+
+	sofiasip::SuRoot& mRoot;
+	Method mMethod;
+	sofiasip::Url mUrl;
+	Transport::OnSuccessCb mOnSuccess;
+	Transport::OnErrorCb mOnError;
+	OnAvailableCb mOnAvailable;
+	std::vector<std::shared_ptr<Connection>> mConnections{};
+	std::chrono::seconds mRequestTimeout{30};
+
+	/**
+	 * Delay before an unused connection is closed.
+	 */
+	static constexpr std::chrono::seconds sIdleTimeout{60};
+};
+
+} // namespace flexisip::pushnotification
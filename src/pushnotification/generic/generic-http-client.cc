@@ -18,6 +18,8 @@
 
 #include "generic-http-client.hh"
 
+#include "flexisip/logmanager.hh"
+
 #include "generic-http-request.hh"
 #include "generic-utils.hh"
 #include "pushnotification/push-notification-exceptions.hh"
@@ -33,23 +35,80 @@ GenericHttpClient::GenericHttpClient(std::unique_ptr<Transport>&& transport,
     : LegacyClient(std::move(transport), name, maxQueueSize, service) {
 }
 
-std::unique_ptr<GenericHttpClient> GenericHttpClient::makeUnique(
-    const sofiasip::Url& url, Method method, const string& name, unsigned int maxQueueSize, const Service* service) {
+GenericHttpClient::GenericHttpClient(sofiasip::SuRoot& root,
+                                     AsyncHttpTransport::ConnectionFactory&& connectionFactory,
+                                     Method method,
+                                     const sofiasip::Url& url,
+                                     unsigned maxConcurrentRequests,
+                                     const std::string& name,
+                                     unsigned maxQueueSize,
+                                     const Service* service)
+    : LegacyClient(nullptr, name, maxQueueSize, service) {
+	mAsyncTransport = make_unique<AsyncHttpTransport>(
+	    root, std::move(connectionFactory), method, url, maxConcurrentRequests,
+	    [this](auto& req) { onSuccess(req); }, [this](auto& req, const auto& msg) { onError(req, msg); },
+	    [this] { sendQueuedRequests(); });
+}
+
+std::unique_ptr<GenericHttpClient> GenericHttpClient::makeUnique(const sofiasip::Url& url,
+                                                                 Method method,
+                                                                 const string& name,
+                                                                 unsigned int maxQueueSize,
+                                                                 const Service* service,
+                                                                 const std::shared_ptr<sofiasip::SuRoot>& root,
+                                                                 unsigned maxConcurrentRequests) {
 	if (method != Method::HttpGet && method != Method::HttpPost) {
 		throw UnauthorizedHttpMethod{method};
 	}
 
-	unique_ptr<TlsConnection> conn{};
-	if (url.getType() == url_https) {
-		conn = make_unique<TlsConnection>(url.getHost(), url.getPort(true));
-	} else {
-		conn = make_unique<TlsConnection>(url.getHost(), url.getPort(true), "", "");
-	}
+	auto makeConnection = [host = url.getHost(), port = url.getPort(true), secured = url.getType() == url_https] {
+		if (secured) return make_unique<TlsConnection>(host, port);
+		return make_unique<TlsConnection>(host, port, "", "");
+	};
 
-	return make_unique<GenericHttpClient>(make_unique<TlsTransport>(std::move(conn), method, url), name, maxQueueSize,
+	if (maxConcurrentRequests != 0 && root) {
+		return make_unique<GenericHttpClient>(*root, std::move(makeConnection), method, url, maxConcurrentRequests,
+		                                      name, maxQueueSize, service);
+	}
+	return make_unique<GenericHttpClient>(make_unique<TlsTransport>(makeConnection(), method, url), name, maxQueueSize,
 	                                      service);
 }
 
+void GenericHttpClient::sendPush(const std::shared_ptr<Request>& req) {
+	if (!mAsyncTransport) {
+		LegacyClient::sendPush(req);
+		return;
+	}
+
+	auto legacyReq = dynamic_pointer_cast<LegacyRequest>(req);
+	legacyReq->setState(Request::State::InProgress);
+	// Keep the order of the requests: a free connection is only used directly if nothing is waiting.
+	if (mRequestQueue.empty() && mAsyncTransport->send(legacyReq)) {
+		addTimeInQueueStat(chrono::steady_clock::duration::zero());
+		return;
+	}
+
+	if (mRequestQueue.size() >= mMaxQueueSize) {
+		SLOGW << "GenericHttpClient PushNotificationClient " << mName << " PNR " << legacyReq.get()
+		      << " queue full, push lost";
+		onError(*legacyReq, "Error queue full");
+		return;
+	}
+	mRequestQueue.push({legacyReq, chrono::steady_clock::now()});
+	setQueueSizeStat(mRequestQueue.size());
+	SLOGD << "GenericHttpClient PushNotificationClient " << mName << " PNR " << legacyReq.get()
+	      << " all connections are busy, queue_size=" << mRequestQueue.size();
+}
+
+void GenericHttpClient::sendQueuedRequests() {
+	// AsyncHttpTransport::send() never answers synchronously, so the queue can't be modified by a nested call.
+	while (!mRequestQueue.empty() && mAsyncTransport->send(mRequestQueue.front().request)) {
+		addTimeInQueueStat(chrono::steady_clock::now() - mRequestQueue.front().enqueuedAt);
+		mRequestQueue.pop();
+	}
+	setQueueSizeStat(mRequestQueue.size());
+}
+
 std::shared_ptr<Request>
 GenericHttpClient::makeRequest(PushType pType,
                                const std::shared_ptr<const PushInfo>& pInfo,
@@ -18,9 +18,12 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
-#include "generic-http-client.hh"
+#include "flexisip/sofia-wrapper/su-root.hh"
+
+#include "async-http-transport.hh"
 #include "pushnotification/legacy/legacy-client.hh"
 
 namespace flexisip {
@@ -28,24 +31,58 @@ namespace pushnotification {
 
 /**
  * PNR (Push Notification Request) client designed to send push notification toa custom push API.
+ * By default, requests are sent one by one from a dedicated thread (see LegacyClient). In non-blocking mode, they are
+ * sent from the main loop over several keep-alive connections (see AsyncHttpTransport).
  */
 class GenericHttpClient : public LegacyClient {
 
 public:
+	/**
+	 * @param maxConcurrentRequests if not zero, create a client in non-blocking mode that sends at most this number of
+	 * requests at the same time. 'root' must then be set.
+	 */
 	static std::unique_ptr<GenericHttpClient> makeUnique(const sofiasip::Url& url,
 	                                                     Method method,
 	                                                     const std::string& name,
 	                                                     unsigned maxQueueSize,
-	                                                     const Service* service);
+	                                                     const Service* service,
+	                                                     const std::shared_ptr<sofiasip::SuRoot>& root = nullptr,
+	                                                     unsigned maxConcurrentRequests = 0);
 
 	GenericHttpClient(std::unique_ptr<Transport>&& transport,
 	                  const std::string& name,
 	                  unsigned maxQueueSize,
 	                  const Service* service);
+	/**
+	 * Create a client in non-blocking mode.
+	 */
+	GenericHttpClient(sofiasip::SuRoot& root,
+	                  AsyncHttpTransport::ConnectionFactory&& connectionFactory,
+	                  Method method,
+	                  const sofiasip::Url& url,
+	                  unsigned maxConcurrentRequests,
+	                  const std::string& name,
+	                  unsigned maxQueueSize,
+	                  const Service* service);
 
+	void sendPush(const std::shared_ptr<Request>& req) override;
 	std::shared_ptr<Request> makeRequest(PushType,
 	                                     const std::shared_ptr<const PushInfo>&,
 	                                     const std::map<std::string, std::shared_ptr<Client>>&) override;
+
+	bool isIdle() const noexcept override {
+		if (!mAsyncTransport) return LegacyClient::isIdle();
+		return mRequestQueue.empty() && mAsyncTransport->isIdle();
+	}
+
+	void setRequestTimeout(std::chrono::seconds requestTimeout) override {
+		if (mAsyncTransport) mAsyncTransport->setRequestTimeout(requestTimeout);
+	}
+
+private:
+	void sendQueuedRequests();
+
+	std::unique_ptr<AsyncHttpTransport> mAsyncTransport{};
 };
 } // namespace pushnotification
 } // namespace flexisip
@@ -162,7 +162,8 @@ void LegacyClient::sendPush(const std::shared_ptr<Request>& req) {
 		legacyReq->setState(Request::State::Failed);
 	} else {
 		legacyReq->setState(Request::State::InProgress);
-		mRequestQueue.push(legacyReq);
+		mRequestQueue.push({legacyReq, chrono::steady_clock::now()});
+		setQueueSizeStat(mRequestQueue.size());
 		/*client is running, it will pop the queue as soon he is finished with current request*/
 		SLOGD << "LegacyClient PushNotificationClient " << mName << " PNR " << legacyReq.get()
 		      << " running, queue_size=" << size;
@@ -178,8 +179,10 @@ void LegacyClient::run() noexcept {
 		if (!mRequestQueue.empty()) {
 			size_t size = mRequestQueue.size();
 			SLOGD << "LegacyClient PushNotificationClient " << mName << " next, queue_size=" << size;
-			auto req = mRequestQueue.front();
+			auto req = std::move(mRequestQueue.front().request);
+			addTimeInQueueStat(chrono::steady_clock::now() - mRequestQueue.front().enqueuedAt);
 			mRequestQueue.pop();
+			setQueueSizeStat(mRequestQueue.size());
 			lock.unlock();
 
 			// send push to the server and wait for its answer
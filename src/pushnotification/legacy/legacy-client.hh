@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <ctime>
 #include <functional>
@@ -81,6 +82,11 @@ private:
 	time_t mLastUse{0};
 };
 
+struct QueuedRequest {
+	std::shared_ptr<LegacyRequest> request;
+	std::chrono::steady_clock::time_point enqueuedAt;
+};
+
 class LegacyClient : public Client {
 public:
 	LegacyClient(std::unique_ptr<Transport>&& transport,
@@ -102,7 +108,7 @@ protected:
 
 	std::string mName{};
 	std::unique_ptr<Transport> mTransport{};
-	std::queue<std::shared_ptr<LegacyRequest>> mRequestQueue{};
+	std::queue<QueuedRequest> mRequestQueue{};
 	unsigned mMaxQueueSize{0};
 
 private:
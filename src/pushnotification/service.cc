@@ -58,7 +58,8 @@ shared_ptr<Client> Service::createAppleClient(const path& caFile, const path& ce
 	auto certName = certFile.stem();
 	auto certPath = certDir / certFile;
 	try {
-		mClients[certName] = make_unique<AppleClient>(*mRoot, caFile, certPath, certName, this);
+		mClients[certName] =
+		    make_unique<AppleClient>(*mRoot, caFile, certPath, certName, this, mMaxConnectionsPerClient);
 		SLOGD << "Created iOS push notification client [" << certName << "]";
 		return mClients[certName];
 	} catch (const TlsConnection::CreationError& err) {
@@ -122,17 +123,59 @@ void Service::sendPush(const std::shared_ptr<Request>& pn) {
 	client->sendPush(pn);
 }
 
+void Service::setHttp2StatCounters(StatCounter64* connections,
+                                   StatCounter64* activeStreams,
+                                   StatCounter64* pendingRequests,
+                                   StatCounter64* maxLatency) {
+	mHttp2Connections = connections;
+	mHttp2ActiveStreams = activeStreams;
+	mHttp2PendingRequests = pendingRequests;
+	mHttp2MaxLatency = maxLatency;
+	mHttp2StatsTimer = make_unique<sofiasip::Timer>(mRoot, sHttp2StatsInterval);
+	mHttp2StatsTimer->setForEver([this] { updateHttp2Stats(); });
+}
+
+void Service::updateHttp2Stats() {
+	uint64_t connections{0}, activeStreams{0}, pendingRequests{0};
+	chrono::microseconds maxLatency{0};
+	for (const auto& [name, client] : mClients) {
+		const Http2ClientPool* pool{};
+		if (const auto* appleClient = dynamic_cast<const AppleClient*>(client.get())) {
+			pool = &appleClient->getHttp2ClientPool();
+		} else if (const auto* firebaseClient = dynamic_cast<const FirebaseV1Client*>(client.get())) {
+			pool = &firebaseClient->getHttp2ClientPool();
+		}
+		if (!pool) continue;
+
+		auto index = 0;
+		for (const auto& stats : pool->getStats()) {
+			SLOGD << "PushNotification client " << name << ", HTTP/2 connection #" << index++ << ": " << stats;
+			if (stats.state == Http2Client::State::Connected) ++connections;
+			activeStreams += stats.activeStreams;
+			pendingRequests += stats.pendingRequests;
+			maxLatency = max(maxLatency, stats.latency.averageLatency);
+		}
+	}
+	if (mHttp2Connections) mHttp2Connections->set(connections);
+	if (mHttp2ActiveStreams) mHttp2ActiveStreams->set(activeStreams);
+	if (mHttp2PendingRequests) mHttp2PendingRequests->set(pendingRequests);
+	if (mHttp2MaxLatency) mHttp2MaxLatency->set(maxLatency.count());
+}
+
 bool Service::isIdle() const noexcept {
 	return all_of(mClients.cbegin(), mClients.cend(), [](const auto& kv) { return kv.second->isIdle(); });
 }
 
-void Service::setupGenericClient(const sofiasip::Url& url, Method method, Protocol protocol) {
+void Service::setupGenericClient(const sofiasip::Url& url,
+                                 Method method,
+                                 Protocol protocol,
+                                 unsigned maxConcurrentRequests) {
 	if (method != Method::HttpGet && method != Method::HttpPost) {
 		throw UnauthorizedHttpMethod{method};
 	}
 	if (protocol == Protocol::Http) {
-		mClients[sGenericClientName] =
-		    GenericHttpClient::makeUnique(url, method, sGenericClientName, mMaxQueueSize, this);
+		mClients[sGenericClientName] = GenericHttpClient::makeUnique(url, method, sGenericClientName, mMaxQueueSize,
+		                                                             this, mRoot, maxConcurrentRequests);
 	} else {
 		mClients[sGenericClientName] = make_unique<GenericHttp2Client>(url, method, *mRoot, this);
 	}
@@ -206,7 +249,7 @@ void Service::addFirebaseV1Client(const std::string& appId,
 	                                  make_shared<FirebaseV1AuthenticationManager>(
 	                                      mRoot, FIREBASE_GET_ACCESS_TOKEN_SCRIPT_PATH, serviceAccountFilePath,
 	                                      defaultRefreshInterval, tokenExpirationAnticipationTime),
-	                                  this);
+	                                  this, mMaxConnectionsPerClient);
 	SLOGD << "Adding firebase push notification client [" << appId << "]";
 }
 
@@ -27,6 +27,7 @@
 #include <thread>
 
 #include "flexisip/configmanager.hh"
+#include "flexisip/sofia-wrapper/timer.hh"
 #include "flexisip/utils/sip-uri.hh"
 
 #include "client.hh"
@@ -53,6 +54,48 @@ public:
 		mCountFailed = countFailed;
 		mCountSent = countSent;
 	}
+	StatCounter64* getQueueSizeCounter() const noexcept {
+		return mQueueSize;
+	}
+	StatCounter64* getQueueTimeCounter() const noexcept {
+		return mQueueTime;
+	}
+	StatCounter64* getDequeuedCounter() const noexcept {
+		return mCountDequeued;
+	}
+	/**
+	 * @param queueSize number of requests currently waiting in the queue of the clients.
+	 * @param queueTime cumulated time spent by the requests in the queue, in milliseconds.
+	 * @param countDequeued number of requests taken out of the queue.
+	 */
+	void setQueueStatCounters(StatCounter64* queueSize,
+	                          StatCounter64* queueTime,
+	                          StatCounter64* countDequeued) noexcept {
+		mQueueSize = queueSize;
+		mQueueTime = queueTime;
+		mCountDequeued = countDequeued;
+	}
+
+	/**
+	 * Periodically sum the occupancy of the HTTP/2 connections of the Apple and Firebase v1 clients into these
+	 * counters, and log the stats of each connection.
+	 *
+	 * @param connections number of established connections.
+	 * @param activeStreams number of requests waiting for their response.
+	 * @param pendingRequests number of requests waiting for their connection to be established.
+	 * @param maxLatency highest average response latency of the connections, in microseconds.
+	 */
+	void setHttp2StatCounters(StatCounter64* connections,
+	                          StatCounter64* activeStreams,
+	                          StatCounter64* pendingRequests,
+	                          StatCounter64* maxLatency);
+
+	/**
+	 * Maximum number of HTTP/2 connections of each Apple and Firebase v1 client created after this call.
+	 */
+	void setMaxConnectionsPerClient(unsigned maxConnections) noexcept {
+		mMaxConnectionsPerClient = maxConnections;
+	}
 
 	const std::map<std::string, std::shared_ptr<Client>> getClients() {
 		return mClients;
@@ -60,7 +103,14 @@ public:
 
 	std::shared_ptr<Request> makeRequest(PushType pType, const std::shared_ptr<const PushInfo>& pInfo);
 	void sendPush(const std::shared_ptr<Request>& pn);
-	void setupGenericClient(const sofiasip::Url& url, Method method, Protocol protocol);
+	/**
+	 * @param maxConcurrentRequests if not zero and protocol is Protocol::Http, requests are sent from the main loop
+	 * over at most this number of keep-alive connections instead of one by one from a dedicated thread.
+	 */
+	void setupGenericClient(const sofiasip::Url& url,
+	                        Method method,
+	                        Protocol protocol,
+	                        unsigned maxConcurrentRequests = 0);
 	void setupiOSClient(const std::string& certDir, const std::string& caFile);
 	void setupFirebaseClients(const GenericStruct* pushConfig);
 	void addFirebaseClient(const std::string& appId, const std::string& apiKey = "");
@@ -84,16 +134,28 @@ private:
 	                                          const std::filesystem::path& certDir,
 	                                          const std::filesystem::path& certName);
 	std::shared_ptr<Client> createAppleClientFromPotentialNewCertificate(const std::string& certName);
+	void updateHttp2Stats();
 
 	// Private attributes
 	std::shared_ptr<sofiasip::SuRoot> mRoot;
 	unsigned mMaxQueueSize{0};
+	unsigned mMaxConnectionsPerClient{1};
 	std::map<std::string, std::shared_ptr<Client>> mClients{};
 	std::string mWindowsPhonePackageSID{};
 	std::string mWindowsPhoneApplicationSecret{};
 	std::map<std::filesystem::path, std::filesystem::path> mAppleCertDirs{};
 	StatCounter64* mCountFailed{nullptr};
 	StatCounter64* mCountSent{nullptr};
+	StatCounter64* mQueueSize{nullptr};
+	StatCounter64* mQueueTime{nullptr};
+	StatCounter64* mCountDequeued{nullptr};
+	StatCounter64* mHttp2Connections{nullptr};
+	StatCounter64* mHttp2ActiveStreams{nullptr};
+	StatCounter64* mHttp2PendingRequests{nullptr};
+	StatCounter64* mHttp2MaxLatency{nullptr};
+	std::unique_ptr<sofiasip::Timer> mHttp2StatsTimer{};
+
+	static constexpr std::chrono::seconds sHttp2StatsInterval{10};
 
 	static const std::string sFallbackClientKey;
 };
@@ -0,0 +1,105 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "record-cache.hh"
+
+using namespace std;
+
+namespace flexisip {
+
+RecordCache::RecordCache(size_t maxSize, chrono::milliseconds ttl, const Stats& stats)
+    : mMaxSize{maxSize}, mTtl{ttl}, mStats{stats} {
+}
+
+const vector<ExtendedContact>* RecordCache::find(const string& key) {
+	const auto indexIt = mIndex.find(key);
+	if (indexIt == mIndex.end()) {
+		incr(mStats.misses);
+		return nullptr;
+	}
+
+	const auto entryIt = indexIt->second;
+	if (entryIt->expiresAt <= chrono::steady_clock::now()) {
+		erase(entryIt);
+		incr(mStats.evictions);
+		incr(mStats.misses);
+		return nullptr;
+	}
+
+	mEntries.splice(mEntries.begin(), mEntries, entryIt);
+	incr(mStats.hits);
+	return &entryIt->contacts;
+}
+
+void RecordCache::insert(const string& key, vector<ExtendedContact>&& contacts, uint64_t generation) {
+	if (mMaxSize == 0 || generation < mForgottenGeneration) return;
+	if (const auto invalidationIt = mInvalidationIndex.find(key);
+	    invalidationIt != mInvalidationIndex.end() && generation < invalidationIt->second->generation)
+		return;
+
+	const auto expiresAt = chrono::steady_clock::now() + mTtl;
+	if (const auto indexIt = mIndex.find(key); indexIt != mIndex.end()) {
+		auto& entry = *indexIt->second;
+		entry.contacts = std::move(contacts);
+		entry.expiresAt = expiresAt;
+		mEntries.splice(mEntries.begin(), mEntries, indexIt->second);
+		return;
+	}
+
+	while (mMaxSize <= mEntries.size()) {
+		erase(prev(mEntries.end()));
+		incr(mStats.evictions);
+	}
+	mEntries.push_front({key, std::move(contacts), expiresAt});
+	mIndex.emplace(key, mEntries.begin());
+}
+
+void RecordCache::invalidate(const string& key) {
+	if (const auto indexIt = mIndex.find(key); indexIt != mIndex.end()) erase(indexIt->second);
+	if (mMaxSize == 0) return;
+
+	mGeneration++;
+	if (const auto invalidationIt = mInvalidationIndex.find(key); invalidationIt != mInvalidationIndex.end()) {
+		invalidationIt->second->generation = mGeneration;
+		mInvalidations.splice(mInvalidations.end(), mInvalidations, invalidationIt->second);
+		return;
+	}
+	while (mMaxSize <= mInvalidations.size()) {
+		mForgottenGeneration = mInvalidations.front().generation;
+		mInvalidationIndex.erase(mInvalidations.front().key);
+		mInvalidations.pop_front();
+	}
+	mInvalidations.push_back({mGeneration, key});
+	mInvalidationIndex.emplace(key, prev(mInvalidations.end()));
+}
+
+void RecordCache::clear() {
+	mGeneration++;
+	mForgottenGeneration = mGeneration;
+	mIndex.clear();
+	mEntries.clear();
+	mInvalidationIndex.clear();
+	mInvalidations.clear();
+}
+
+void RecordCache::erase(EntryList::iterator it) {
+	mIndex.erase(it->key);
+	mEntries.erase(it);
+}
+
+} // namespace flexisip
@@ -0,0 +1,112 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flexisip/configmanager.hh"
+
+#include "registrar/extended-contact.hh"
+
+namespace flexisip {
+
+/**
+ * In-process cache of the contacts of Records, indexed by the string of their Record::Key.
+ *
+ * Entries live at most `ttl` and the least recently used entries are evicted when the cache holds `maxSize` of them.
+ * The cache does not know anything about the database it stands in front of: it is up to the owner to invalidate an
+ * entry whenever it learns the Record has changed. To avoid re-inserting a value that was read before such a change,
+ * insertions are tagged with the generation observed when the read was issued and dropped if the same key was
+ * invalidated in between. The generations of the last `maxSize` invalidated keys are remembered, insertions older than
+ * a forgotten invalidation are dropped whatever their key.
+ *
+ * Not thread-safe, meant to be used from the main loop only.
+ */
+class RecordCache {
+public:
+	struct Stats {
+		StatCounter64* hits = nullptr;
+		StatCounter64* misses = nullptr;
+		StatCounter64* evictions = nullptr; // Entries dropped because of the size limit or their age.
+	};
+
+	RecordCache(size_t maxSize, std::chrono::milliseconds ttl, const Stats& stats);
+	RecordCache(size_t maxSize, std::chrono::milliseconds ttl) : RecordCache(maxSize, ttl, Stats{}) {
+	}
+
+	/**
+	 * @return the cached contacts of the Record, or nullptr if the entry is missing or too old. The pointer is only
+	 * valid until the next call to a non-const method.
+	 */
+	const std::vector<ExtendedContact>* find(const std::string& key);
+	/**
+	 * Current generation, to pass back to insert() when the value read from the database is received.
+	 */
+	std::uint64_t generation() const {
+		return mGeneration;
+	}
+	/**
+	 * Insert or replace the entry of the Record. Ignored if this entry was invalidated since `generation` was read.
+	 */
+	void insert(const std::string& key, std::vector<ExtendedContact>&& contacts, std::uint64_t generation);
+	void invalidate(const std::string& key);
+	void clear();
+
+	size_t size() const {
+		return mIndex.size();
+	}
+
+private:
+	struct Entry {
+		std::string key;
+		std::vector<ExtendedContact> contacts;
+		std::chrono::steady_clock::time_point expiresAt;
+	};
+	using EntryList = std::list<Entry>;
+	struct Invalidation {
+		std::uint64_t generation;
+		std::string key;
+	};
+	using InvalidationList = std::list<Invalidation>;
+
+	static void incr(StatCounter64* stat) {
+		if (stat) stat->incr();
+	}
+	void erase(EntryList::iterator it);
+
+	const size_t mMaxSize;
+	const std::chrono::milliseconds mTtl;
+	const Stats mStats;
+	// Most recently used first.
+	EntryList mEntries{};
+	std::unordered_map<std::string, EntryList::iterator> mIndex{};
+	std::uint64_t mGeneration = 0;
+	// Oldest first.
+	InvalidationList mInvalidations{};
+	std::unordered_map<std::string, InvalidationList::iterator> mInvalidationIndex{};
+	// Generation of the most recent invalidation that is no longer remembered, or of the last clear().
+	std::uint64_t mForgottenGeneration = 0;
+};
+
+} // namespace flexisip
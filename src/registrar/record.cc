@@ -311,9 +311,7 @@ ChangeSet Record::removeInvalidContacts() {
 	return changeSet;
 }
 
-ChangeSet Record::update(const sip_t* sip,
-                         const BindingParameters& parameters,
-                         const shared_ptr<ContactUpdateListener>& listener) {
+list<unique_ptr<ExtendedContact>> Record::makeContacts(const sip_t* sip, const BindingParameters& parameters) {
 	list<string> stlPath;
 	sofiasip::Home home;
 	string userAgent;
@@ -348,6 +346,13 @@ ChangeSet Record::update(const sip_t* sip,
 	}
 
 	eliminateAmbiguousContacts(extendedContacts);
+	return extendedContacts;
+}
+
+ChangeSet Record::update(const sip_t* sip,
+                         const BindingParameters& parameters,
+                         const shared_ptr<ContactUpdateListener>& listener) {
+	auto extendedContacts = makeContacts(sip, parameters);
 
 	// Update the Record.
 	ChangeSet changeSet = removeInvalidContacts();
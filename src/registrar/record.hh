@@ -161,6 +161,10 @@ public:
 	ChangeSet update(const sip_t* sip,
 	                 const BindingParameters& parameters,
 	                 const std::shared_ptr<ContactUpdateListener>& listener);
+	/**
+	 * Build the contacts to bind from a REGISTER request, as update() does, without applying them to the Record.
+	 */
+	std::list<std::unique_ptr<ExtendedContact>> makeContacts(const sip_t* sip, const BindingParameters& parameters);
 	// Deprecated: this one is used by serializer
 	void update(const ExtendedContactCommon& ecc,
 	            const char* sipuri,
@@ -177,6 +181,9 @@ public:
 	bool isEmpty() const {
 		return mContacts.empty();
 	}
+	bool isDomain() const {
+		return mIsDomain;
+	}
 	const Key& getKey() const {
 		return mKey;
 	}
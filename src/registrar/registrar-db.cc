@@ -70,8 +70,18 @@ RegistrarDb::RegistrarDb(const std::shared_ptr<sofiasip::SuRoot>& root, const st
 		auto params = redis::async::RedisParameters::fromRegistrarConf(registrar);
 
 		auto notifyState = [this](bool bWritable) { this->notifyStateListener(bWritable); };
+		unique_ptr<RecordCache> recordCache{};
+		if (const auto cacheSize = registrar->get<ConfigInt>("redis-record-cache-size")->read(); 0 < cacheSize) {
+			const auto ttl = registrar->get<ConfigDuration<chrono::milliseconds>>("redis-record-cache-ttl")->read();
+			recordCache = make_unique<RecordCache>(cacheSize, ttl,
+			                                       RecordCache::Stats{
+			                                           registrar->getStat("count-record-cache-hits"),
+			                                           registrar->getStat("count-record-cache-misses"),
+			                                           registrar->getStat("count-record-cache-evictions"),
+			                                       });
+		}
 		mBackend = make_unique<RegistrarDbRedisAsync>(*mRoot, mRecordConfig, mLocalRegExpire, params, notifyContact,
-		                                              notifyState);
+		                                              notifyState, std::move(recordCache));
 		static_cast<RegistrarDbRedisAsync*>(mBackend.get())->connect();
 	}
 #endif
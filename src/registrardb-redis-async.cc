@@ -24,6 +24,7 @@
 #include <cstdio>
 #include <ctime>
 #include <iterator>
+#include <list>
 #include <memory>
 #include <optional>
 #include <set>
@@ -64,7 +65,66 @@ namespace {
 const Script FETCH_EXPIRING_CONTACTS_SCRIPT{
 #include "fetch-expiring-contacts.lua.hh"
     , // ❯ sed -n '/R"lua(/,/)lua"/p' fetch-expiring-contacts.lua.hh | sed 's/R"lua(//' | head -n-1 | sha1sum
-    "8f26674ebf2a65c4eee45d2ae9b98c121cf6ff43"};
+    "a9a243a3ec4a6aee7a943d30cd54d98ef83927cd"};
+
+const Script BACKFILL_EXPIRING_CONTACTS_SCRIPT{
+#include "backfill-expiring-contacts.lua.hh"
+    , // ❯ sed -n '/R"lua(/,/)lua"/p' backfill-expiring-contacts.lua.hh | sed 's/R"lua(//' | head -n-1 | sha1sum
+    "49dcb16e59ff7a1291d406b971cdb501b25b0158"};
+
+const Script BIND_CONTACTS_SCRIPT{
+#include "bind-contacts.lua.hh"
+    , // ❯ sed -n '/R"lua(/,/)lua"/p' bind-contacts.lua.hh | sed 's/R"lua(//' | head -n-1 | sha1sum
+    "f43dbab8dc32234dfd1768885ba41bccbe8571e9"};
+
+// Sorted set of the contacts with push parameters, scored by their expiration time. Members are made of the Redis key
+// of the Record and the unique id of the contact, separated by a line feed.
+constexpr auto kExpiringContactsIndex = "fs-index:push-contacts-by-expiry";
+// Sorted set of the lifetimes ('expires' parameter) of the contacts of the index above, to bound the range to fetch.
+// Lifetimes are scored by the latest expiration time of the contacts that have them, so that they can be pruned.
+constexpr auto kContactLifetimesIndex = "fs-index:push-contact-lifetimes";
+// Set once the contacts of the Records written before the index existed have been added to it.
+constexpr auto kExpiringContactsIndexBackfilled = "fs-index:push-contacts-by-expiry:backfilled";
+constexpr auto kExpiringContactsPageSize = 500;
+
+bool hasPushParams(const ExtendedContact& contact) {
+	const auto* url = contact.mSipContact ? contact.mSipContact->m_url : nullptr;
+	return url && (url_has_param(url, "pn-provider") || url_has_param(url, "pn-type"));
+}
+
+string makeExpiringContactsIndexMember(const string& recordKey, const ExtendedContact& contact) {
+	return recordKey + '\n' + contact.mKey.str();
+}
+
+// Hash of the metadata of the contacts of a Record, by unique id, needed by BIND_CONTACTS_SCRIPT to apply the binding
+// rules without parsing contacts. It is kept up to date by both bind implementations when the server-side bind is
+// enabled, and not written at all otherwise.
+constexpr auto kBindMetadataPrefix = "fs-meta:";
+
+string makeBindMetadataKey(const Record::Key& key) {
+	return kBindMetadataPrefix + key.asString();
+}
+
+// See the description of the metadata in bind-contacts.lua.hh
+string serializeBindMetadata(const ExtendedContact& contact) {
+	const auto lifetime = contact.getSipExpires().count();
+	ostringstream metadata{};
+	metadata << contact.getRegisterTime() << ' ' << contact.getExpireTime() << ' ' << contact.getSipExpireTime() << ' '
+	         << lifetime << ' ' << (hasPushParams(contact) && 0 < lifetime ? 1 : 0);
+	const auto& pushParams = contact.mPushParamList;
+	for (const auto& pushParam : pushParams.getPushParams()) {
+		metadata << '\n' << pushParams.getProvider() << ' ' << pushParam.getPrId() << ' ' << pushParam.getParam();
+	}
+	return metadata.str();
+}
+
+// The rules of Record::insertOrUpdateBinding() implemented by BIND_CONTACTS_SCRIPT only cover contacts identified by a
+// unique id.
+bool canBindServerSide(const Record& record, const list<unique_ptr<ExtendedContact>>& contacts) {
+	if (record.getConfig().assumeUniqueDomains() && record.isDomain()) return false;
+	return all_of(contacts.cbegin(), contacts.cend(),
+	              [](const auto& contact) { return !contact->mKey.isPlaceholder(); });
+}
 
 } // namespace
 
@@ -78,10 +138,12 @@ RegistrarDbRedisAsync::RegistrarDbRedisAsync(
     LocalRegExpire& localRegExpire,
     const RedisParameters& params,
     std::function<void(const Record::Key&, std::optional<std::string_view>)> notifyContact,
-    std::function<void(bool)> notifyState)
+    std::function<void(bool)> notifyState,
+    std::unique_ptr<RecordCache>&& recordCache)
     : mRedisClient{root, params, SoftPtr<SessionListener>::fromObjectLivingLongEnough(*this)}, mRoot{root},
       mRecordConfig{recordConfig}, mLocalRegExpire{localRegExpire}, mNotifyContactListener{std::move(notifyContact)},
-      mNotifyStateListener{std::move(notifyState)} {
+      mNotifyStateListener{std::move(notifyState)}, mRecordCache{std::move(recordCache)},
+      mServerSideBind{params.serverSideBind} {
 }
 
 bool RegistrarDbRedisAsync::isConnected() const {
@@ -108,17 +170,31 @@ auto logErrorReply(const ArgsPacker& cmd) {
 
 void RegistrarDbRedisAsync::onConnect(int status) {
 	if (status == REDIS_OK) {
+		// Changes may have been missed while disconnected (or the server may be another one).
+		if (mRecordCache) mRecordCache->clear();
 		setWritable(true);
 		subscribeToKeyExpiration();
+		subscribeToKeyChanges();
+		backfillExpiringContactsIndex();
 	}
 }
 
 void RegistrarDbRedisAsync::onDisconnect(int status) {
+	if (mRecordCache) mRecordCache->clear();
 	if (status == REDIS_OK) {
 		setWritable(false);
 	}
 }
 
+void RegistrarDbRedisAsync::invalidateCachedRecord(std::string_view redisKey) {
+	if (!mRecordCache) return;
+
+	if (auto suffix = StringUtils::removePrefix(redisKey, "fs:")) {
+		redisKey = *suffix;
+	}
+	mRecordCache->invalidate(string{redisKey});
+}
+
 void RegistrarDbRedisAsync::handlePublish(std::string_view topic, Reply reply) {
 	if (std::holds_alternative<reply::Disconnected>(reply)) {
 		SLOGD << "RegistrarDbRedisAsync::handlePublish - Subscription to '" << topic << "' disconnected.";
@@ -133,6 +209,7 @@ void RegistrarDbRedisAsync::handlePublish(std::string_view topic, Reply reply) {
 		if (messageType == "message") {
 			const auto& message = std::get<reply::String>(messageOrSubsCount);
 			SLOGD << "Publish array received: [" << messageType << ", " << channel << ", " << message << "]";
+			invalidateCachedRecord(channel);
 			mNotifyContactListener(Record::Key(channel), message);
 			return;
 		}
@@ -173,6 +250,8 @@ void RegistrarDbRedisAsync::subscribeToKeyExpiration() {
 		try {
 			const auto& array = std::get<reply::Array>(reply);
 			string_view key = std::get<reply::String>(array[2]);
+			if (StringUtils::startsWith(key, kBindMetadataPrefix)) return;
+			invalidateCachedRecord(key);
 			if (auto suffix = StringUtils::removePrefix(key, "fs:")) {
 				key = *suffix;
 			}
@@ -182,6 +261,29 @@ void RegistrarDbRedisAsync::subscribeToKeyExpiration() {
 	});
 }
 
+void RegistrarDbRedisAsync::subscribeToKeyChanges() {
+	if (!mRecordCache) return;
+	auto* ready = mRedisClient.tryGetSubSession();
+	if (!ready) {
+		return;
+	}
+
+	// Only received if the server is configured to send them (see 'notify-keyspace-events'), otherwise the age limit of
+	// the cache entries is the only bound on their staleness.
+	for (const auto* event : {"__keyevent@0__:hset", "__keyevent@0__:hdel", "__keyevent@0__:del"}) {
+		auto subscription = ready->subscriptions()[event];
+		if (subscription.subscribed()) continue;
+
+		LOGD("Subscribing to %s for the Record cache", event);
+		subscription.subscribe([this](auto, Reply reply) {
+			const auto* array = std::get_if<reply::Array>(&reply);
+			if (!array || array->size() < 3) return;
+			const auto key = (*array)[2];
+			if (const auto* keyStr = std::get_if<reply::String>(&key)) invalidateCachedRecord(*keyStr);
+		});
+	}
+}
+
 void RegistrarDbRedisAsync::subscribe(const Record::Key& key) {
 	const auto topic = key.asString();
 	SLOGD << "Sending SUBSCRIBE command to Redis for topic '" << topic << "'";
@@ -260,14 +362,62 @@ void RegistrarDbRedisAsync::serializeAndSendToRedis(RedisRegisterContext& contex
 
 	LOGD("Binding %s [%i] contact sets, [%i] contacts removed.", key.c_str(), setCount, delCount);
 
+	updateExpiringContactsIndex(*cmdSession, context);
+
 	/* Set global expiration for the Record */
-	redis::ArgsPacker expireAtCmd{"EXPIREAT", key, to_string(context.mRecord->latestExpire())};
+	const auto latestExpire = to_string(context.mRecord->latestExpire());
+	redis::ArgsPacker expireAtCmd{"EXPIREAT", key, latestExpire};
 	cmdSession->timedCommand(expireAtCmd, logErrorReply(expireAtCmd));
 
+	/* Rewrite the metadata of all the contacts, which heals Records written without it. Only the server-side bind
+	 * reads it. */
+	if (mServerSideBind) {
+		const auto metadataKey = makeBindMetadataKey(context.mRecord->getKey());
+		redis::ArgsPacker metadataDelArgs("DEL", metadataKey);
+		cmdSession->timedCommand(metadataDelArgs, logErrorReply(metadataDelArgs));
+		if (!context.mRecord->isEmpty()) {
+			redis::ArgsPacker metadataArgs("HMSET", metadataKey);
+			for (const auto& ec : context.mRecord->getExtendedContacts()) {
+				metadataArgs.addPair(ec->mKey, serializeBindMetadata(*ec));
+			}
+			cmdSession->timedCommand(metadataArgs, logErrorReply(metadataArgs));
+			redis::ArgsPacker metadataExpireAtCmd{"EXPIREAT", metadataKey, latestExpire};
+			cmdSession->timedCommand(metadataExpireAtCmd, logErrorReply(metadataExpireAtCmd));
+		}
+	}
+
 	/* Execute the transaction */
 	cmdSession->timedCommand({"EXEC"}, std::move(forwardedCb));
 }
 
+void RegistrarDbRedisAsync::updateExpiringContactsIndex(const Session::Ready& cmdSession,
+                                                        const RedisRegisterContext& context) {
+	const auto recordKey = context.mRecord->getKey().toRedisKey();
+	redis::ArgsPacker zAddArgs("ZADD", kExpiringContactsIndex);
+	redis::ArgsPacker lifetimesArgs("ZADD", kContactLifetimesIndex);
+	redis::ArgsPacker zRemArgs("ZREM", kExpiringContactsIndex);
+	for (const auto& ec : context.mChangeSet.mUpsert) {
+		const auto lifetime = ec->getSipExpires().count();
+		if (hasPushParams(*ec) && 0 < lifetime) {
+			zAddArgs.addPair(to_string(ec->getSipExpireTime()), makeExpiringContactsIndexMember(recordKey, *ec));
+			lifetimesArgs.addPair(to_string(ec->getSipExpireTime()), to_string(lifetime));
+		} else {
+			// The contact may have lost its push parameters.
+			zRemArgs.addFieldName(makeExpiringContactsIndexMember(recordKey, *ec));
+		}
+	}
+	for (const auto& ec : context.mChangeSet.mDelete) {
+		zRemArgs.addFieldName(makeExpiringContactsIndexMember(recordKey, *ec));
+	}
+
+	// Commands are sent only if they have at least one member.
+	if (2 < zAddArgs.getArgCount()) {
+		cmdSession.timedCommand(zAddArgs, logErrorReply(zAddArgs));
+		cmdSession.timedCommand(lifetimesArgs, logErrorReply(lifetimesArgs));
+	}
+	if (2 < zRemArgs.getArgCount()) cmdSession.timedCommand(zRemArgs, logErrorReply(zRemArgs));
+}
+
 /* Methods called by the callbacks */
 
 void RegistrarDbRedisAsync::sBindRetry(void* ud) noexcept {
@@ -313,11 +463,6 @@ void RegistrarDbRedisAsync::handleBind(Reply reply, std::unique_ptr<RedisRegiste
 void RegistrarDbRedisAsync::doBind(const MsgSip& msg,
                                    const BindingParameters& parameters,
                                    const std::shared_ptr<ContactUpdateListener>& listener) {
-	// - Fetch the record from redis
-	// - update the Record from the message and binding parameters
-	// - push the new record to redis by commiting changes to apply (set or remove).
-	// - notify the onRecordFound().
-
 	const Session::Ready* cmdSession;
 	if (!(cmdSession = mRedisClient.tryGetCmdSession())) {
 		if (listener) listener->onError(SipStatus(SIP_500_INTERNAL_SERVER_ERROR));
@@ -328,8 +473,39 @@ void RegistrarDbRedisAsync::doBind(const MsgSip& msg,
 	mLocalRegExpire.update(context->mRecord);
 
 	const auto& key = context->mRecord->getKey();
-	cmdSession->timedCommand({"HGETALL", key.toRedisKey()}, [context = std::move(context), this](Session&,
-	                                                                                             Reply reply) mutable {
+	if (mRecordCache) mRecordCache->invalidate(key.asString());
+
+	if (mServerSideBind) {
+		list<unique_ptr<ExtendedContact>> contacts{};
+		try {
+			contacts = context->mRecord->makeContacts(context->mMsg.getSip(), context->mBindingParameters);
+		} catch (const InvalidRequestError& e) {
+			if (listener) listener->onInvalid(e.getSipStatus());
+			return;
+		} catch (const std::exception& e) {
+			SLOGE << "Unexpected exception when building contacts to bind: " << e.what();
+			if (listener) listener->onError(SipStatus(SIP_500_INTERNAL_SERVER_ERROR));
+			return;
+		}
+
+		if (canBindServerSide(*context->mRecord, contacts)) {
+			bindServerSide(*cmdSession, std::move(context), std::move(contacts));
+			return;
+		}
+	}
+
+	fetchAndBind(*cmdSession, std::move(context));
+}
+
+void RegistrarDbRedisAsync::fetchAndBind(const Session::Ready& cmdSession,
+                                         std::unique_ptr<RedisRegisterContext>&& context) {
+	// - Fetch the record from redis
+	// - update the Record from the message and binding parameters
+	// - push the new record to redis by commiting changes to apply (set or remove).
+	// - notify the onRecordFound().
+	const auto& key = context->mRecord->getKey();
+	cmdSession.timedCommand({"HGETALL", key.toRedisKey()}, [context = std::move(context), this](Session&,
+	                                                                                            Reply reply) mutable {
 		SLOGD << "Got current Record content for key [fs:" << context->mRecord->getKey() << "]";
 		auto* array = std::get_if<reply::Array>(&reply);
 		if (array == nullptr) {
@@ -371,15 +547,72 @@ void RegistrarDbRedisAsync::doBind(const MsgSip& msg,
 		SLOGD << "Sending updated content to REDIS for key [fs:" << context->mRecord->getKey() << "]: " << changeset;
 		auto& ctxRef = *context;
 		serializeAndSendToRedis(ctxRef, [this, context = std::move(context)](Session&, Reply reply) mutable {
+			// Fetches sent while the bind was in progress may have read the previous content.
+			if (mRecordCache) mRecordCache->invalidate(context->mRecord->getKey().asString());
 			handleBind(reply, std::move(context));
 		});
 	});
 }
 
+void RegistrarDbRedisAsync::bindServerSide(const Session::Ready& cmdSession,
+                                           std::unique_ptr<RedisRegisterContext>&& context,
+                                           std::list<std::unique_ptr<ExtendedContact>>&& contacts) {
+	const auto& key = context->mRecord->getKey();
+	vector<string> args{to_string(getCurrentTime()), to_string(mRecordConfig.getMaxContacts())};
+	args.reserve(args.size() + 3 * contacts.size());
+	for (const auto& contact : contacts) {
+		args.push_back(contact->mKey.str());
+		args.push_back(contact->serializeAsUrlEncodedParams());
+		args.push_back(serializeBindMetadata(*contact));
+	}
+
+	SLOGD << "Binding " << contacts.size() << " contact(s) to fs:" << key << " [" << context->token << "] server-side";
+	BIND_CONTACTS_SCRIPT.call(
+	    cmdSession, {key.toRedisKey(), makeBindMetadataKey(key), kExpiringContactsIndex, kContactLifetimesIndex}, args,
+	    [context = std::move(context), this](Session& session, Reply reply) mutable {
+		    handleServerSideBind(session, reply, std::move(context));
+	    });
+}
+
+void RegistrarDbRedisAsync::handleServerSideBind(Session& session,
+                                                 Reply reply,
+                                                 std::unique_ptr<RedisRegisterContext>&& context) {
+	const auto& record = context->mRecord;
+	const auto* array = std::get_if<reply::Array>(&reply);
+	if (array && array->size() == 3) {
+		const auto replaced = (*array)[1];
+		const auto content = (*array)[2];
+		const auto* replacedContacts = std::get_if<reply::Array>(&replaced);
+		const auto* recordContacts = std::get_if<reply::Array>(&content);
+		if (replacedContacts && recordContacts) {
+			const auto& messageExpiresName = record->getConfig().messageExpiresName();
+			for (auto&& contact : parseContacts(replacedContacts->pairwise(), messageExpiresName)) {
+				if (context->listener) context->listener->onContactUpdated(std::move(contact));
+			}
+			insertActiveContacts(*record, parseContacts(recordContacts->pairwise(), messageExpiresName));
+			if (mRecordCache) mRecordCache->invalidate(record->getKey().asString());
+			if (context->listener) context->listener->onRecordFound(record);
+			return;
+		}
+	}
+
+	// The Record has contacts written without metadata, or something went wrong: fall back to the regular bind.
+	if (!std::holds_alternative<reply::Array>(reply)) {
+		SLOGW << "Unexpected reply binding fs:" << record->getKey() << " [" << context->token
+		      << "] server-side, falling back to a regular bind: " << StreamableVariant(reply);
+	}
+	const auto* cmdSession = std::get_if<Session::Ready>(&session.getState());
+	if (!cmdSession) {
+		if (context->listener) context->listener->onError(SipStatus(SIP_500_INTERNAL_SERVER_ERROR));
+		return;
+	}
+	fetchAndBind(*cmdSession, std::move(context));
+}
+
 void RegistrarDbRedisAsync::handleClear(Reply reply, const RedisRegisterContext& context) {
 	const auto recordName = context.mRecord->getKey().toRedisKey() + " [" + std::to_string(context.token) + "]";
 	if (const auto* keysDeleted = std::get_if<reply::Integer>(&reply)) {
-		if (*keysDeleted == 1) {
+		if (0 < *keysDeleted) {
 			SLOGD << "Record " << recordName << " successfully cleared";
 			if (context.listener) context.listener->onRecordFound(context.mRecord);
 			return;
@@ -440,7 +673,11 @@ void RegistrarDbRedisAsync::doClear(const MsgSip& msg, const shared_ptr<ContactU
 		const auto& key = context->mRecord->getKey().asString();
 		SLOGD << "Clearing fs:" << key << " [" << context->token << "]";
 		mLocalRegExpire.remove(key);
-		cmdSession->timedCommand({"DEL", "fs:" + key}, [context = std::move(context), this](Session&, Reply reply) {
+		if (mRecordCache) mRecordCache->invalidate(key);
+		const auto metadataKey = makeBindMetadataKey(context->mRecord->getKey());
+		cmdSession->timedCommand({"DEL", "fs:" + key, metadataKey}, [context = std::move(context), this](Session&,
+		                                                                                                Reply reply) {
+			if (mRecordCache) mRecordCache->invalidate(context->mRecord->getKey().asString());
 			handleClear(reply, *context);
 		});
 	} catch (const sofiasip::InvalidUrlError& e) {
@@ -452,11 +689,9 @@ void RegistrarDbRedisAsync::doClear(const MsgSip& msg, const shared_ptr<ContactU
 	}
 }
 
-void RegistrarDbRedisAsync::handleFetch(redis::async::Reply reply, const RedisRegisterContext& context) {
-	const auto& record = context.mRecord;
-	const auto recordName = record->getKey().toRedisKey() + " [" + std::to_string(context.token) + "]";
-	const auto insertIfActive = [&record = *record](auto&& contact) {
-		if (contact->isExpired()) return;
+void RegistrarDbRedisAsync::insertActiveContacts(Record& record, vector<unique_ptr<ExtendedContact>>&& contacts) {
+	for (auto&& contact : contacts) {
+		if (contact->isExpired()) continue;
 
 		try {
 			record.insertOrUpdateBinding(std::move(contact), nullptr);
@@ -473,19 +708,31 @@ void RegistrarDbRedisAsync::handleFetch(redis::async::Reply reply, const RedisRe
 		} catch (const std::exception& e) {
 			SLOGE << "Unexpected exception: " << e.what();
 		}
-	};
+	}
+}
+
+void RegistrarDbRedisAsync::handleFetch(redis::async::Reply reply, const RedisRegisterContext& context) {
+	const auto& record = context.mRecord;
+	const auto recordName = record->getKey().toRedisKey() + " [" + std::to_string(context.token) + "]";
 
 	auto* listener = context.listener.get();
 	Match(reply).against(
 	    // doFetch
-	    [&recordName, &insertIfActive, listener, &record, &context](const reply::Array& array) {
+	    [this, &recordName, listener, &record, &context](const reply::Array& array) {
 		    // This is the most common scenario: we want all contacts inside the record
 		    const auto contacts = array.pairwise();
 		    SLOGD << "GOT " << recordName << " --> " << contacts.size() << " contacts";
-		    if (0 < contacts.size()) {
-			    for (auto&& maybeExpired : parseContacts(contacts, context.mRecord->getConfig().messageExpiresName())) {
-				    insertIfActive(maybeExpired);
+		    auto parsed = parseContacts(contacts, context.mRecord->getConfig().messageExpiresName());
+		    if (mRecordCache && !context.mFromReplica) {
+			    vector<ExtendedContact> copies{};
+			    copies.reserve(parsed.size());
+			    for (const auto& contact : parsed) {
+				    copies.emplace_back(*contact);
 			    }
+			    mRecordCache->insert(record->getKey().asString(), std::move(copies), context.mCacheGeneration);
+		    }
+		    if (0 < contacts.size()) {
+			    insertActiveContacts(*record, std::move(parsed));
 			    if (listener) listener->onRecordFound(record);
 		    } else {
 			    // Anchor WKADREGMIGDELREC
@@ -497,11 +744,13 @@ void RegistrarDbRedisAsync::handleFetch(redis::async::Reply reply, const RedisRe
 	    },
 
 	    // doFetchInstance (contact matching a given gruu)
-	    [&context, &recordName, &insertIfActive, listener, &record](const reply::String& contact) {
+	    [&context, &recordName, listener, &record](const reply::String& contact) {
 		    const auto& gruu = context.mUniqueIdToFetch;
 		    SLOGD << "GOT " << recordName << " for gruu " << gruu << " --> " << contact;
-		    insertIfActive(
+		    vector<unique_ptr<ExtendedContact>> contacts{};
+		    contacts.push_back(
 		        make_unique<ExtendedContact>(gruu.c_str(), contact.data(), record->getConfig().messageExpiresName()));
+		    insertActiveContacts(*record, std::move(contacts));
 		    if (listener) listener->onRecordFound(record);
 	    },
 	    [&context, &recordName, listener](const reply::Nil&) {
@@ -518,15 +767,28 @@ void RegistrarDbRedisAsync::handleFetch(redis::async::Reply reply, const RedisRe
 
 void RegistrarDbRedisAsync::doFetch(const SipUri& url, const shared_ptr<ContactUpdateListener>& listener) {
 	// fetch all the contacts in the AOR (HGETALL) and call the onRecordFound of the listener
+	// This is a read-only command, which may be sent to a replica.
+	auto context = std::make_unique<RedisRegisterContext>(this, url, listener, mRecordConfig);
+	const auto& key = context->mRecord->getKey();
+	if (const auto* cached = mRecordCache ? mRecordCache->find(key.asString()) : nullptr) {
+		SLOGD << "Fetching fs:" << key << " [" << context->token << "] from the Record cache";
+		vector<unique_ptr<ExtendedContact>> contacts{};
+		contacts.reserve(cached->size());
+		for (const auto& contact : *cached) {
+			contacts.push_back(make_unique<ExtendedContact>(contact));
+		}
+		insertActiveContacts(*context->mRecord, std::move(contacts));
+		if (listener) listener->onRecordFound(context->mRecord);
+		return;
+	}
+
 	const Session::Ready* cmdSession;
-	if (!(cmdSession = mRedisClient.tryGetCmdSession())) {
+	if (!(cmdSession = mRedisClient.tryGetReadSession(&context->mFromReplica))) {
 		if (listener) listener->onError(SipStatus(SIP_500_INTERNAL_SERVER_ERROR));
 		return;
 	}
 
-	auto context = std::make_unique<RedisRegisterContext>(this, url, listener, mRecordConfig);
-
-	const auto& key = context->mRecord->getKey();
+	if (mRecordCache) context->mCacheGeneration = mRecordCache->generation();
 	SLOGD << "Fetching fs:" << key << " [" << context->token << "]";
 	cmdSession->timedCommand(
 	    {"HGETALL", key.toRedisKey()},
@@ -537,22 +799,55 @@ void RegistrarDbRedisAsync::doFetchInstance(const SipUri& url,
                                             const string& uniqueId,
                                             const shared_ptr<ContactUpdateListener>& listener) {
 	// fetch only the contact in the AOR (HGET) and call the onRecordFound of the listener
+	// This is a read-only command, which may be sent to a replica.
+	auto context = std::make_unique<RedisRegisterContext>(this, url, listener, mRecordConfig);
+	context->mUniqueIdToFetch = uniqueId;
+
+	const auto& recordKey = context->mRecord->getKey();
+	if (const auto* cached = mRecordCache ? mRecordCache->find(recordKey.asString()) : nullptr) {
+		SLOGD << "Fetching fs:" << recordKey << " [" << context->token << "] contact matching unique id " << uniqueId
+		      << " from the Record cache";
+		const auto match = find_if(cached->cbegin(), cached->cend(),
+		                           [&uniqueId](const auto& contact) { return contact.mKey.str() == uniqueId; });
+		if (match == cached->cend()) {
+			if (listener) listener->onRecordFound(nullptr);
+			return;
+		}
+		vector<unique_ptr<ExtendedContact>> contacts{};
+		contacts.push_back(make_unique<ExtendedContact>(*match));
+		insertActiveContacts(*context->mRecord, std::move(contacts));
+		if (listener) listener->onRecordFound(context->mRecord);
+		return;
+	}
+
 	const Session::Ready* cmdSession;
-	if (!(cmdSession = mRedisClient.tryGetCmdSession())) {
+	if (!(cmdSession = mRedisClient.tryGetReadSession())) {
 		if (listener) listener->onError(SipStatus(SIP_500_INTERNAL_SERVER_ERROR));
 		return;
 	}
 
-	auto context = std::make_unique<RedisRegisterContext>(this, url, listener, mRecordConfig);
-	context->mUniqueIdToFetch = uniqueId;
-
-	const auto& recordKey = context->mRecord->getKey();
 	SLOGD << "Fetching fs:" << recordKey << " [" << context->token << "] contact matching unique id " << uniqueId;
 	cmdSession->timedCommand(
 	    {"HGET", recordKey.toRedisKey(), uniqueId},
 	    [context = std::move(context), this](Session&, Reply reply) { handleFetch(reply, *context); });
 }
 
+struct RegistrarDbRedisAsync::ExpiringContactsQuery {
+	time_t startTimestamp;
+	float threshold;
+	std::string messageExpiresName;
+	std::function<void(std::vector<ExtendedContact>&&)> callback;
+	// Upper bound of the expiration times of the contacts that may have passed the threshold of their lifetime.
+	time_t maxExpireTime = 0;
+	// Where the next page starts: the score and the member of the last member read, or the excluded lower bound of the
+	// range and an empty member for the first page.
+	std::string lastScore{};
+	std::string lastMember{};
+	// Members to skip when more than a page of members have the last score.
+	size_t skip = 0;
+	std::vector<ExtendedContact> expiringContacts{};
+};
+
 void RegistrarDbRedisAsync::fetchExpiringContacts(
     time_t startTimestamp, float threshold, std::function<void(std::vector<ExtendedContact>&&)>&& callback) const {
 	const Session::Ready* cmdSession;
@@ -561,24 +856,186 @@ void RegistrarDbRedisAsync::fetchExpiringContacts(
 		return;
 	}
 
-	FETCH_EXPIRING_CONTACTS_SCRIPT.call(
-	    *cmdSession,
-	    {
-	        std::to_string(startTimestamp),
-	        std::to_string(threshold),
-	    },
-	    [callback = std::move(callback), msgExpiresName = mRecordConfig.messageExpiresName()](Session&, Reply reply) {
-		    if (const auto* array = std::get_if<reply::Array>(&reply)) {
-			    std::vector<ExtendedContact> expiringContacts{};
-			    expiringContacts.reserve(array->size());
-			    for (const auto contact : *array) {
-				    expiringContacts.emplace_back("", std::get<reply::String>(contact).data(), msgExpiresName);
+	auto query = make_shared<ExpiringContactsQuery>(ExpiringContactsQuery{
+	    startTimestamp,
+	    threshold,
+	    mRecordConfig.messageExpiresName(),
+	    std::move(callback),
+	});
+	query->lastScore = "(" + to_string(startTimestamp);
+
+	// Forget about contacts, and lifetimes of contacts, that have expired since they were indexed.
+	const auto now = to_string(std::min(startTimestamp, getCurrentTime()));
+	for (const auto* index : {kExpiringContactsIndex, kContactLifetimesIndex}) {
+		redis::ArgsPacker pruneArgs{"ZREMRANGEBYSCORE", index, "-inf", now};
+		cmdSession->timedCommand(pruneArgs, logErrorReply(pruneArgs));
+	}
+
+	// A contact registered for L seconds passes the threshold T of its lifetime when it has less than (1 - T) * L
+	// seconds left, so only contacts expiring before startTimestamp + (1 - T) * max(L) have to be examined. Lifetimes
+	// are the members of their index, there are only a few of them.
+	cmdSession->timedCommand({"ZRANGE", kContactLifetimesIndex, "0", "-1"}, [query](Session& session, Reply reply) {
+		const auto* array = std::get_if<reply::Array>(&reply);
+		const Session::Ready* cmdSession = std::get_if<Session::Ready>(&session.getState());
+		if (array == nullptr || cmdSession == nullptr) {
+			SLOGE << "Fetch expiring contacts: unexpected reply fetching the lifetimes: " << StreamableVariant(reply);
+			return;
+		}
+		long maxLifetime = 0;
+		for (const auto& element : *array) {
+			if (const auto* lifetime = std::get_if<reply::String>(&element)) {
+				maxLifetime = std::max(maxLifetime, std::atol(std::string(*lifetime).c_str()));
+			}
+		}
+		if (maxLifetime == 0) {
+			query->callback({});
+			return;
+		}
+		query->maxExpireTime = query->startTimestamp + time_t((1 - query->threshold) * maxLifetime) + 1;
+		fetchExpiringContactsPage(*cmdSession, query);
+	});
+}
+
+void RegistrarDbRedisAsync::fetchExpiringContactsPage(const Session::Ready& cmdSession,
+                                                      const shared_ptr<ExpiringContactsQuery>& query) {
+	// Pages are read from the last member read rather than from an offset in the range, which would be shifted by the
+	// members added and removed in between.
+	redis::ArgsPacker pageArgs{"ZRANGEBYSCORE", kExpiringContactsIndex,       query->lastScore,
+	                           to_string(query->maxExpireTime), "WITHSCORES", "LIMIT",
+	                           to_string(query->skip),          to_string(kExpiringContactsPageSize)};
+	cmdSession.timedCommand(pageArgs, [query](Session& session, Reply reply) {
+		const auto* array = std::get_if<reply::Array>(&reply);
+		const Session::Ready* cmdSession = std::get_if<Session::Ready>(&session.getState());
+		if (array == nullptr || cmdSession == nullptr) {
+			SLOGE << "Fetch expiring contacts: unexpected reply reading the expiry index: " << StreamableVariant(reply);
+			return;
+		}
+		const auto isLastPage = array->size() < 2 * size_t(kExpiringContactsPageSize);
+		vector<string> recordKeys{kExpiringContactsIndex};
+		vector<string> uniqueIds{};
+		string lastScore{}, lastMember{};
+		for (const auto& [memberElement, scoreElement] : array->pairwise()) {
+			const auto* member = std::get_if<reply::String>(&memberElement);
+			const auto* score = std::get_if<reply::String>(&scoreElement);
+			if (member == nullptr || score == nullptr) continue;
+			lastMember = *member;
+			lastScore = *score;
+			// Members with the same score are sorted lexicographically.
+			const auto alreadyRead = lastScore == query->lastScore && lastMember <= query->lastMember;
+			if (!query->lastMember.empty() && alreadyRead) continue;
+			const auto separator = lastMember.find('\n');
+			if (separator == string::npos) continue;
+			recordKeys.push_back(lastMember.substr(0, separator));
+			uniqueIds.push_back(lastMember.substr(separator + 1));
+		}
+		if (recordKeys.size() == 1 && !isLastPage) {
+			// The whole page had the last score and had already been read.
+			query->skip += kExpiringContactsPageSize;
+			fetchExpiringContactsPage(*cmdSession, query);
+			return;
+		}
+		if (!lastMember.empty()) {
+			query->lastScore = std::move(lastScore);
+			query->lastMember = std::move(lastMember);
+			query->skip = 0;
+		}
+		if (recordKeys.size() == 1) {
+			query->callback(std::move(query->expiringContacts));
+			return;
+		}
+
+		FETCH_EXPIRING_CONTACTS_SCRIPT.call(
+		    *cmdSession, recordKeys, uniqueIds, [query, isLastPage](Session& session, Reply reply) {
+			    const auto* contacts = std::get_if<reply::Array>(&reply);
+			    if (contacts == nullptr) {
+				    SLOGE << "Fetch expiring contacts script returned unexpected reply: " << StreamableVariant(reply);
+				    return;
+			    }
+			    for (const auto& element : *contacts) {
+				    const auto* contactStr = std::get_if<reply::String>(&element);
+				    if (contactStr == nullptr) continue;
+				    ExtendedContact contact{"", contactStr->data(), query->messageExpiresName};
+				    if (!hasPushParams(contact)) continue;
+				    const auto expires = contact.getSipExpires().count();
+				    const auto thresholdTime = contact.getRegisterTime() + long(query->threshold * expires);
+				    if (thresholdTime < query->startTimestamp && query->startTimestamp < contact.getSipExpireTime()) {
+					    query->expiringContacts.emplace_back(std::move(contact));
+				    }
+			    }
+
+			    if (isLastPage) {
+				    query->callback(std::move(query->expiringContacts));
+				    return;
+			    }
+			    const Session::Ready* cmdSession = std::get_if<Session::Ready>(&session.getState());
+			    if (cmdSession == nullptr) {
+				    SLOGW << "Redis session not ready. Aborting fetch of expiring contacts.";
+				    return;
 			    }
-			    callback(std::move(expiringContacts));
+			    fetchExpiringContactsPage(*cmdSession, query);
+		    });
+	});
+}
+
+void RegistrarDbRedisAsync::backfillExpiringContactsIndex() {
+	const Session::Ready* cmdSession;
+	if (mBackfillingExpiringContactsIndex || !(cmdSession = mRedisClient.tryGetCmdSession())) return;
+
+	mBackfillingExpiringContactsIndex = true;
+	cmdSession->timedCommand({"EXISTS", kExpiringContactsIndexBackfilled}, [this](Session& session, Reply reply) {
+		const auto* exists = std::get_if<reply::Integer>(&reply);
+		const auto* cmdSession = std::get_if<Session::Ready>(&session.getState());
+		if (exists == nullptr || *exists != 0 || cmdSession == nullptr) {
+			mBackfillingExpiringContactsIndex = false;
+			return;
+		}
+		SLOGI << "Adding the contacts of the Records written before the expiry index existed to the index";
+		backfillExpiringContactsIndex(*cmdSession, "0");
+	});
+}
+
+void RegistrarDbRedisAsync::backfillExpiringContactsIndex(const Session::Ready& cmdSession, const string& cursor) {
+	// SCAN, unlike KEYS, only blocks Redis for a few keys at a time.
+	cmdSession.timedCommand(
+	    {"SCAN", cursor, "MATCH", "fs:*", "COUNT", to_string(kExpiringContactsPageSize)},
+	    [this](Session& session, Reply reply) {
+		    const auto* array = std::get_if<reply::Array>(&reply);
+		    const auto* cmdSession = std::get_if<Session::Ready>(&session.getState());
+		    const reply::Array* keys = nullptr;
+		    string nextCursor{};
+		    if (array != nullptr && array->size() == 2) {
+			    const auto cursorElement = (*array)[0];
+			    const auto keysElement = (*array)[1];
+			    if (const auto* cursor = std::get_if<reply::String>(&cursorElement)) nextCursor = *cursor;
+			    keys = std::get_if<reply::Array>(&keysElement);
+		    }
+		    if (nextCursor.empty() || keys == nullptr || cmdSession == nullptr) {
+			    SLOGE << "Unexpected reply scanning the Records to fill the expiry index, will retry on next "
+			             "connection: "
+			          << StreamableVariant(reply);
+			    mBackfillingExpiringContactsIndex = false;
 			    return;
 		    }
 
-		    SLOGE << "Fetch expiring contacts script returned unexpected reply: " << StreamableVariant(reply);
+		    vector<string> scriptKeys{kExpiringContactsIndex, kContactLifetimesIndex};
+		    for (const auto& element : *keys) {
+			    if (const auto* key = std::get_if<reply::String>(&element)) scriptKeys.emplace_back(*key);
+		    }
+		    if (2 < scriptKeys.size()) {
+			    BACKFILL_EXPIRING_CONTACTS_SCRIPT.call(*cmdSession, scriptKeys, {to_string(getCurrentTime())},
+			                                           [](Session&, Reply reply) {
+				                                           if (auto* err = std::get_if<reply::Error>(&reply)) {
+					                                           SLOGW << "Failed to fill the expiry index: " << *err;
+				                                           }
+			                                           });
+		    }
+		    if (nextCursor != "0") {
+			    backfillExpiringContactsIndex(*cmdSession, nextCursor);
+			    return;
+		    }
+		    cmdSession->timedCommand({"SET", kExpiringContactsIndexBackfilled, "1"},
+		                             [this](Session&, Reply) { mBackfillingExpiringContactsIndex = false; });
+		    SLOGI << "Expiry index filled with the contacts of the Records written before it existed";
 	    });
 }
 
@@ -38,6 +38,7 @@
 #include "registrar/binding-parameters.hh"
 #include "registrar/change-set.hh"
 #include "registrar/extended-contact.hh"
+#include "registrar/record-cache.hh"
 #include "registrar/record.hh"
 #include "registrar/registrar-db.hh"
 
@@ -63,6 +64,9 @@ struct RedisRegisterContext {
 	MsgSip mMsg;
 	BindingParameters mBindingParameters;
 	std::string mUniqueIdToFetch;
+	std::uint64_t mCacheGeneration = 0; // Generation of the Record cache when the fetch was sent.
+	// The fetch was sent to a replica, its reply may miss the last writes and must not be cached.
+	bool mFromReplica = false;
 
 	template <typename T>
 	RedisRegisterContext(RegistrarDbRedisAsync* s,
@@ -94,13 +98,18 @@ public:
 	 * @param notifyContact The second parameter is the unique ID of the contact within the AoR. A `std::nullopt` value
 	 * indicates that the Redis subscription received an unprocessable message. This should never happen under any
 	 * circumstances, see REDISPUBSUBFORMAT.
+	 * @param recordCache When supplied, fetched Records are kept in this cache and served from it until they are
+	 * modified. Modifications made by other instances are only seen if Redis sends keyspace notifications for hashes
+	 * and generic commands ('notify-keyspace-events' containing 'K' or 'E', 'h' and 'g'), otherwise cached Records may
+	 * be stale until they expire from the cache.
 	 */
 	RegistrarDbRedisAsync(const sofiasip::SuRoot& root,
 	                      const Record::Config& recordConfig,
 	                      LocalRegExpire& localRegExpire,
 	                      const redis::async::RedisParameters& params,
 	                      std::function<void(const Record::Key&, std::optional<std::string_view>)> notifyContact,
-	                      std::function<void(bool)> notifyState);
+	                      std::function<void(bool)> notifyState,
+	                      std::unique_ptr<RecordCache>&& recordCache = nullptr);
 
 	void fetchExpiringContacts(time_t startTimestamp,
 	                           float threshold,
@@ -115,6 +124,9 @@ public:
 	const redis::async::RedisClient& getRedisClient() const {
 		return mRedisClient;
 	}
+	const RecordCache* getRecordCache() const {
+		return mRecordCache.get();
+	}
 
 	static void forceDisconnectForTest(RegistrarDbRedisAsync& thiz);
 
@@ -135,17 +147,37 @@ public:
 	void publish(const Record::Key& topic, const std::string& uid) override;
 
 private:
+	struct ExpiringContactsQuery;
+
 	static void sBindRetry(void* ud) noexcept;
+	static void fetchExpiringContactsPage(const redis::async::Session::Ready&,
+	                                      const std::shared_ptr<ExpiringContactsQuery>&);
 	void setWritable(bool value);
 
+	void fetchAndBind(const redis::async::Session::Ready&, std::unique_ptr<RedisRegisterContext>&&);
+	/* Bind in a single round trip with BIND_CONTACTS_SCRIPT. Falls back to fetchAndBind() when the script can't. */
+	void bindServerSide(const redis::async::Session::Ready&,
+	                    std::unique_ptr<RedisRegisterContext>&&,
+	                    std::list<std::unique_ptr<ExtendedContact>>&&);
 	void serializeAndSendToRedis(RedisRegisterContext&, redis::async::Session::CommandCallback&&);
+	/* Add the commands keeping the expiry index of push-capable contacts up to date to the current transaction. */
+	void updateExpiringContactsIndex(const redis::async::Session::Ready&, const RedisRegisterContext&);
+	/* Add the contacts of the Records written before the expiry index existed to it, once per database. */
+	void backfillExpiringContactsIndex();
+	void backfillExpiringContactsIndex(const redis::async::Session::Ready&, const std::string& cursor);
 	void subscribe(std::string_view topic);
 	void subscribeToKeyExpiration();
+	void subscribeToKeyChanges();
+	void invalidateCachedRecord(std::string_view redisKey);
+	static void insertActiveContacts(Record&, std::vector<std::unique_ptr<ExtendedContact>>&&);
 	static std::vector<std::unique_ptr<ExtendedContact>> parseContacts(const redis::reply::ArrayOfPairs&,
 	                                                                   const std::string& messageExpiresName);
 
 	/* callbacks */
 	void handleBind(redis::async::Reply, std::unique_ptr<RedisRegisterContext>&&);
+	void handleServerSideBind(redis::async::Session&,
+	                          redis::async::Reply,
+	                          std::unique_ptr<RedisRegisterContext>&&);
 	void handleClear(redis::async::Reply, const RedisRegisterContext&);
 	void handleFetch(redis::async::Reply, const RedisRegisterContext&);
 	void handlePublish(std::string_view, redis::async::Reply);
@@ -160,7 +192,10 @@ private:
 	LocalRegExpire& mLocalRegExpire;
 	std::function<void(const Record::Key&, std::optional<std::string_view>)> mNotifyContactListener;
 	std::function<void(bool)> mNotifyStateListener;
+	std::unique_ptr<RecordCache> mRecordCache;
+	bool mServerSideBind;
 	bool mWritable{};
+	bool mBackfillingExpiringContactsIndex{};
 };
 
 } // namespace flexisip
@@ -18,6 +18,8 @@
 
 #include "inject-context.hh"
 
+#include <algorithm>
+
 #include "flexisip/fork-context/fork-context.hh"
 
 using namespace std;
@@ -37,3 +39,34 @@ bool InjectContext::isExpired() const {
 void InjectContext::setMaxRequestRetentionTime(milliseconds maxRequestRetentionTime) {
 	InjectContext::sMaxRequestRetentionTime = maxRequestRetentionTime;
 }
+
+void InjectContextQueue::push(const shared_ptr<ForkContext>& fork) {
+	const auto it = mContexts.emplace(mContexts.end(), fork);
+	if (auto [entry, inserted] = mIndex.try_emplace(fork->getPtrForEquality(), IndexEntry{it, 1}); !inserted) {
+		entry->second.count++;
+	}
+}
+
+InjectContext* InjectContextQueue::find(const shared_ptr<ForkContext>& fork) {
+	const auto entry = mIndex.find(fork->getPtrForEquality());
+	return entry != mIndex.end() ? &*entry->second.first : nullptr;
+}
+
+void InjectContextQueue::remove(const shared_ptr<ForkContext>& fork) {
+	if (const auto entry = mIndex.find(fork->getPtrForEquality()); entry != mIndex.end()) {
+		erase(entry->second.first);
+	}
+}
+
+void InjectContextQueue::erase(ContextList::iterator it) {
+	if (const auto entry = mIndex.find(it->mFork->getPtrForEquality()); entry != mIndex.end()) {
+		if (--entry->second.count == 0) {
+			mIndex.erase(entry);
+		} else if (entry->second.first == it) {
+			// Only when a fork was added several times for the same contact: index its next context.
+			entry->second.first = find_if(next(it), mContexts.end(),
+			                              [&it](const auto& context) { return context.isEqual(it->mFork); });
+		}
+	}
+	mContexts.erase(it);
+}
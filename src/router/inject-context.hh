@@ -19,8 +19,10 @@
 #pragma once
 
 #include <chrono>
+#include <list>
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 namespace flexisip {
 
@@ -32,6 +34,7 @@ class RequestSipEvent;
  */
 class InjectContext {
 	friend class ScheduleInjector;
+	friend class InjectContextQueue;
 
 public:
 	explicit InjectContext(const std::shared_ptr<ForkContext>& fork) : mFork{fork} {};
@@ -49,4 +52,44 @@ private:
 	std::chrono::steady_clock::time_point mCreationDate = std::chrono::steady_clock::now();
 };
 
+/**
+ * InjectContexts of one contact and one priority, in injection order, indexed by ForkContext so that finding or
+ * removing the context of a fork doesn't walk the queue.<br>
+ * The index relies on ForkContext::getPtrForEquality() being stable during the life of a ForkContext.
+ */
+class InjectContextQueue {
+public:
+	void push(const std::shared_ptr<ForkContext>& fork);
+	/**
+	 * @return the first context of the fork, or nullptr if there is none.
+	 */
+	InjectContext* find(const std::shared_ptr<ForkContext>& fork);
+	/**
+	 * Remove the first context of the fork, if any.
+	 */
+	void remove(const std::shared_ptr<ForkContext>& fork);
+
+	bool empty() const {
+		return mContexts.empty();
+	}
+	InjectContext& front() {
+		return mContexts.front();
+	}
+	void popFront() {
+		erase(mContexts.begin());
+	}
+
+private:
+	using ContextList = std::list<InjectContext>;
+	struct IndexEntry {
+		ContextList::iterator first; // The first context of the fork in the queue.
+		size_t count;
+	};
+
+	void erase(ContextList::iterator it);
+
+	ContextList mContexts{};
+	std::unordered_map<const ForkContext*, IndexEntry> mIndex{};
+};
+
 } // namespace flexisip
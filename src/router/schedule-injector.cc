@@ -43,12 +43,8 @@ void ScheduleInjector::injectRequestEvent(const std::shared_ptr<RequestSipEvent>
 		return;
 	}
 
-	auto& contactInjectContexts = contactMapEntry->second;
-
-	if (const auto& it = find_if(contactInjectContexts.begin(), contactInjectContexts.end(),
-	                             [&fork](const auto& i) { return i.isEqual(fork); });
-	    it != contactInjectContexts.end()) {
-		it->waitForInject = ev;
+	if (auto* injectContext = contactMapEntry->second.find(fork)) {
+		injectContext->waitForInject = ev;
 	} else {
 		// This should not happen, but we prefer to send in wrong order than not at all.
 		SLOGE << "ScheduleInjector::injectRequestEvent. ForkContext[" << fork->getPtrForEquality() << "], CallID ["
@@ -70,37 +66,37 @@ void ScheduleInjector::startInject(const std::string& contactId) {
 		}
 
 		auto& contactInjectContexts = contactMapEntry->second;
-		auto it = contactInjectContexts.begin();
-		while (it != contactInjectContexts.end()) {
-			if (it->waitForInject) {
-				mModule->injectRequestEvent(it->waitForInject);
-				it = contactInjectContexts.erase(it);
-			} else if (it->isExpired()) {
-				SLOGE << "ScheduleInjector::startInject. ForkContext[" << it->mFork->getPtrForEquality()
+		while (!contactInjectContexts.empty()) {
+			auto& injectContext = contactInjectContexts.front();
+			if (injectContext.waitForInject) {
+				mModule->injectRequestEvent(injectContext.waitForInject);
+				contactInjectContexts.popFront();
+			} else if (injectContext.isExpired()) {
+				SLOGE << "ScheduleInjector::startInject. ForkContext[" << injectContext.mFork->getPtrForEquality()
 				      << "], is expired and is not waiting for inject, removing.";
-				it = contactInjectContexts.erase(it);
+				contactInjectContexts.popFront();
 			} else {
-				SLOGT << "ScheduleInjector::startInject : blocked by fork [" << it->mFork->getPtrForEquality() << "]";
-				break;
+				SLOGT << "ScheduleInjector::startInject : blocked by fork ["
+				      << injectContext.mFork->getPtrForEquality() << "]";
+				return;
 			}
 		}
-		if (it != contactInjectContexts.end()) {
-			break;
-		}
+		// By key: injecting may have added contexts for other contacts and invalidated the iterator.
+		injectMap.erase(contactId);
 	}
 }
 
 void ScheduleInjector::addContext(const shared_ptr<ForkContext>& fork, const string& contactId) {
 	SLOGT << "ScheduleInjector::addContext. ForkContext[" << fork->getPtrForEquality() << "]";
 	startInject(contactId);
-	getMapFromPriority(fork->getMsgPriority())[contactId].emplace_back(fork);
+	getMapFromPriority(fork->getMsgPriority())[contactId].push(fork);
 }
 
 void ScheduleInjector::addContext(const vector<shared_ptr<ForkContext>>& forks, const string& contactId) {
 	startInject(contactId);
 	for (const auto& fork : forks) {
 		SLOGT << "ScheduleInjector::addContext. ForkContext[" << fork->getPtrForEquality() << "]";
-		getMapFromPriority(fork->getMsgPriority())[contactId].emplace_back(fork);
+		getMapFromPriority(fork->getMsgPriority())[contactId].push(fork);
 	}
 }
 
@@ -110,12 +106,7 @@ void ScheduleInjector::removeContext(const shared_ptr<ForkContext>& fork, const
 	auto& injectMap = getMapFromPriority(currentPriority);
 
 	if (const auto& contactMapEntry = injectMap.find(contactId); contactMapEntry != injectMap.end()) {
-		auto& contactInjectContexts = contactMapEntry->second;
-		const auto& it = find_if(contactInjectContexts.begin(), contactInjectContexts.end(),
-		                         [&fork](const auto& i) { return i.isEqual(fork); });
-		if (it != contactInjectContexts.end()) {
-			contactInjectContexts.erase(it);
-		}
+		contactMapEntry->second.remove(fork);
 	}
 
 	startInject(contactId);
@@ -18,15 +18,15 @@
 
 #pragma once
 
-#include <map>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "inject-context.hh"
 #include "injector.hh"
 
 namespace flexisip {
 
-class InjectContext;
-
 /**
  * An injector that sort message by priority and then keep them in order.
  *
@@ -39,8 +39,7 @@ class InjectContext;
  * determine InjectContext priority.
  */
 class ScheduleInjector : public Injector {
-	using InjectListType = std::list<InjectContext>;
-	using InjectContextMap = std::map<std::string, InjectListType>;
+	using InjectContextMap = std::unordered_map<std::string, InjectContextQueue>;
 
 public:
 	explicit ScheduleInjector(Module* module) : Injector(module){};
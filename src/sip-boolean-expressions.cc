@@ -27,102 +27,103 @@ namespace flexisip {
 
 shared_ptr<SipBooleanExpressionBuilder> SipBooleanExpressionBuilder::sInstance;
 
-static inline string stringFromC(const char* s) {
-	return s ? string(s) : string();
+static inline string_view viewFromC(const char* s) {
+	return s ? string_view(s) : string_view();
 }
 
+/*
+ * Most variables are read in place from the sip_t structure (see ViewVariable) so that evaluating an expression does
+ * not copy the fields of the message. Only computed values remain plain variables.
+ */
 static ExpressionRules<sip_t> rules = {
     {
-        {"direction", [](const sip_t& sip) -> string { return sip.sip_request != nullptr ? "request" : "response"; }},
+        {"call-id.hash",
+         [](const sip_t& sip) -> string { return sip.sip_call_id ? to_string(sip.sip_call_id->i_hash) : string(); }},
+        {"status.code",
+         [](const sip_t& sip) -> string { return sip.sip_status ? to_string(sip.sip_status->st_status) : string(); }},
+    },
+    {
+        {"is_request", [](const sip_t& sip) -> bool { return sip.sip_request != nullptr; }},
+        {"is_response", [](const sip_t& sip) -> bool { return sip.sip_request == nullptr; }},
+    },
+    {
+        {"direction",
+         [](const sip_t& sip) -> string_view { return sip.sip_request != nullptr ? "request" : "response"; }},
 
         {"request.method-name",
-         [](const sip_t& sip) -> string {
-	         return stringFromC((sip.sip_request && sip.sip_request->rq_method_name) ? sip.sip_request->rq_method_name
-	                                                                                 : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_request ? sip.sip_request->rq_method_name : nullptr);
          }},
         {"request.method",
-         [](const sip_t& sip) -> string {
-	         return stringFromC((sip.sip_request && sip.sip_request->rq_method_name) ? sip.sip_request->rq_method_name
-	                                                                                 : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_request ? sip.sip_request->rq_method_name : nullptr);
          }},
         {"request.uri.domain",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_request ? sip.sip_request->rq_url->url_host : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_request ? sip.sip_request->rq_url->url_host : nullptr);
          }},
         {"request.uri.user",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_request ? sip.sip_request->rq_url->url_user : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_request ? sip.sip_request->rq_url->url_user : nullptr);
          }},
         {"request.uri.params",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_request ? sip.sip_request->rq_url->url_params : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_request ? sip.sip_request->rq_url->url_params : nullptr);
          }},
 
         {"from.uri.domain",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_from ? sip.sip_from->a_url->url_host : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_from ? sip.sip_from->a_url->url_host : nullptr);
          }},
         {"from.uri.user",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_from ? sip.sip_from->a_url->url_user : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_from ? sip.sip_from->a_url->url_user : nullptr);
          }},
         {"from.uri.params",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_from ? sip.sip_from->a_url->url_params : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_from ? sip.sip_from->a_url->url_params : nullptr);
          }},
 
         {"to.uri.domain",
-         [](const sip_t& sip) -> string { return stringFromC(sip.sip_to ? sip.sip_to->a_url->url_host : nullptr); }},
+         [](const sip_t& sip) -> string_view { return viewFromC(sip.sip_to ? sip.sip_to->a_url->url_host : nullptr); }},
         {"to.uri.user",
-         [](const sip_t& sip) -> string { return stringFromC(sip.sip_to ? sip.sip_to->a_url->url_user : nullptr); }},
+         [](const sip_t& sip) -> string_view { return viewFromC(sip.sip_to ? sip.sip_to->a_url->url_user : nullptr); }},
         {"to.uri.params",
-         [](const sip_t& sip) -> string { return stringFromC(sip.sip_to ? sip.sip_to->a_url->url_params : nullptr); }},
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_to ? sip.sip_to->a_url->url_params : nullptr);
+         }},
 
         {"contact.uri.domain",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_contact ? sip.sip_contact->m_url->url_host : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_contact ? sip.sip_contact->m_url->url_host : nullptr);
          }},
         {"contact.uri.user",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_contact ? sip.sip_contact->m_url->url_user : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_contact ? sip.sip_contact->m_url->url_user : nullptr);
          }},
         {"contact.uri.params",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_contact ? sip.sip_contact->m_url->url_params : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_contact ? sip.sip_contact->m_url->url_params : nullptr);
          }},
 
         {"user-agent",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_user_agent ? sip.sip_user_agent->g_string : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_user_agent ? sip.sip_user_agent->g_string : nullptr);
          }},
 
         {"call-id",
-         [](const sip_t& sip) -> string { return stringFromC(sip.sip_call_id ? sip.sip_call_id->i_id : nullptr); }},
-        {"call-id.hash",
-         [](const sip_t& sip) -> string {
-	         ostringstream ostr;
-	         if (sip.sip_call_id) ostr << sip.sip_call_id->i_hash;
-	         return ostr.str();
-         }},
+         [](const sip_t& sip) -> string_view { return viewFromC(sip.sip_call_id ? sip.sip_call_id->i_id : nullptr); }},
 
         {"status.phrase",
-         [](const sip_t& sip) -> string { return stringFromC(sip.sip_status ? sip.sip_status->st_phrase : nullptr); }},
-        {"status.code",
-         [](const sip_t& sip) -> string {
-	         ostringstream ostr;
-	         if (sip.sip_status) ostr << sip.sip_status->st_status;
-	         return ostr.str();
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_status ? sip.sip_status->st_phrase : nullptr);
          }},
 
         {"content-type",
-         [](const sip_t& sip) -> string {
-	         return stringFromC(sip.sip_content_type ? sip.sip_content_type->c_type : nullptr);
+         [](const sip_t& sip) -> string_view {
+	         return viewFromC(sip.sip_content_type ? sip.sip_content_type->c_type : nullptr);
          }},
     },
-    {
-        {"is_request", [](const sip_t& sip) -> bool { return sip.sip_request != nullptr; }},
-        {"is_response", [](const sip_t& sip) -> bool { return sip.sip_request == nullptr; }},
-    },
 };
 
 SipBooleanExpressionBuilder::SipBooleanExpressionBuilder() : BooleanExpressionBuilder<sip_t>(rules) {
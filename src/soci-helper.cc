@@ -20,6 +20,8 @@
 #include "flexisip/logmanager.hh"
 #include "soci-helper.hh"
 
+#include <cctype>
+
 using namespace std;
 
 namespace flexisip{
@@ -84,4 +86,19 @@ void SociHelper::reconnectSession(soci::session &session) {
 	}
 }
 
+string suffixPlaceholders(const string& rowTemplate, const string& suffix) {
+	string row{};
+	for (size_t i = 0; i < rowTemplate.size(); ++i) {
+		row += rowTemplate[i];
+		if (rowTemplate[i] != ':') continue;
+		for (; i + 1 < rowTemplate.size(); ++i) {
+			const auto next = static_cast<unsigned char>(rowTemplate[i + 1]);
+			if (!isalnum(next) && next != '_') break;
+			row += rowTemplate[i + 1];
+		}
+		row += suffix;
+	}
+	return row;
+}
+
 }
@@ -24,6 +24,8 @@
 #include "flexisip/logmanager.hh"
 
 #include <chrono>
+#include <string>
+#include <vector>
 
 namespace flexisip{
 
@@ -54,5 +56,56 @@ private:
 	soci::connection_pool &mPool;
 };
 
+// Limits of a multi-row statement, so it stays far below the max_allowed_packet of the server.
+constexpr size_t kMaxRowsPerStatement = 100;
+constexpr size_t kMaxBytesPerStatement = 1024 * 1024;
+
+// Append suffix to every ":placeholder" of rowTemplate, to bind the values of several rows in one statement.
+std::string suffixPlaceholders(const std::string& rowTemplate, const std::string& suffix);
+
+/**
+ * Run "head rowTemplate, rowTemplate, ... tail" for all the rows, by chunks of kMaxRowsPerStatement rows or
+ * kMaxBytesPerStatement bytes. bind(statement, row, suffix) binds the values of a row and returns their size.
+ * afterStatement(firstRow, rowCount) is called after each statement with the indexes of the rows it contained.
+ */
+template <typename Row, typename Binder, typename AfterStatement>
+void executeMultiRow(soci::session& sql,
+                     const std::string& head,
+                     const std::string& rowTemplate,
+                     const std::string& tail,
+                     const std::vector<Row>& rows,
+                     const Binder& bind,
+                     const AfterStatement& afterStatement) {
+	auto row = rows.cbegin();
+	while (row != rows.cend()) {
+		soci::statement st{sql};
+		auto query = head;
+		const auto firstRow = static_cast<size_t>(row - rows.cbegin());
+		size_t rowCount = 0;
+		size_t byteCount = 0;
+		for (; row != rows.cend() && rowCount < kMaxRowsPerStatement && byteCount < kMaxBytesPerStatement; ++row) {
+			const auto suffix = std::to_string(rowCount);
+			query += (rowCount++ == 0 ? "" : ", ") + suffixPlaceholders(rowTemplate, suffix);
+			byteCount += bind(st, *row, suffix);
+		}
+		query += tail;
+		st.alloc();
+		st.prepare(query);
+		st.define_and_bind();
+		st.execute(true);
+		afterStatement(firstRow, rowCount);
+	}
+}
+
+template <typename Row, typename Binder>
+void executeMultiRow(soci::session& sql,
+                     const std::string& head,
+                     const std::string& rowTemplate,
+                     const std::string& tail,
+                     const std::vector<Row>& rows,
+                     const Binder& bind) {
+	executeMultiRow(sql, head, rowTemplate, tail, rows, bind, [](size_t, size_t) {});
+}
+
 } //end of namespace
 
@@ -0,0 +1,80 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace flexisip {
+
+/**
+ * Unbounded lock-free queue with any number of producers and a single consumer.
+ *
+ * push() may be called from any thread, while pop() must always be called from the same (consumer) thread. Neither of
+ * them ever blocks, which makes this queue suitable to hand over work to a thread running a real-time loop.
+ *
+ * @tparam T type of the elements, which must be default-constructible and movable.
+ */
+template <typename T>
+class MpscQueue {
+public:
+	MpscQueue() : mHead(new Node{}), mTail(mHead.load(std::memory_order_relaxed)) {
+	}
+	~MpscQueue() {
+		T value{};
+		while (pop(value)) {
+		}
+		delete mTail;
+	}
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	void push(T value) {
+		auto* node = new Node{std::move(value), nullptr};
+		auto* previous = mHead.exchange(node, std::memory_order_acq_rel);
+		// Between the exchange and this store, the consumer sees the queue as shorter than it is, which is harmless.
+		previous->next.store(node, std::memory_order_release);
+	}
+
+	/**
+	 * Must only be called from the consumer thread.
+	 * @return false if the queue is empty.
+	 */
+	bool pop(T& value) {
+		auto* tail = mTail;
+		auto* next = tail->next.load(std::memory_order_acquire);
+		if (next == nullptr) return false;
+		value = std::move(next->value);
+		// The popped node becomes the new stub.
+		mTail = next;
+		delete tail;
+		return true;
+	}
+
+private:
+	struct Node {
+		T value{};
+		std::atomic<Node*> next{nullptr};
+	};
+
+	std::atomic<Node*> mHead; // Last pushed node, written by producers.
+	Node* mTail;              // Stub node preceding the next element to pop, only accessed by the consumer.
+};
+
+} // namespace flexisip
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include <sofia-sip/su_wait.h>
@@ -65,12 +66,17 @@ public:
 		return mTimeoutTimer;
 	}
 
+	std::chrono::steady_clock::time_point getCreationTime() const {
+		return mCreationTime;
+	}
+
 private:
 	std::shared_ptr<HttpRequest> mRequest;
 	std::shared_ptr<HttpResponse> mResponse;
 	sofiasip::Timer mTimeoutTimer;
 	OnResponseCb mOnResponseCb;
 	OnErrorCb mOnErrorCb;
+	std::chrono::steady_clock::time_point mCreationTime{std::chrono::steady_clock::now()};
 };
 
 } /* namespace flexisip */
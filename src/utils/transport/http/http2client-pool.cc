@@ -0,0 +1,162 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "http2client-pool.hh"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include "flexisip/logmanager.hh"
+
+using namespace std;
+
+namespace flexisip {
+
+Http2ClientPool::Http2ClientPool(sofiasip::SuRoot& root, ClientFactory&& factory, unsigned maxConnections)
+    : mFactory(std::move(factory)), mMaxConnections(max(maxConnections, 1u)),
+      mReplacementTimer(root, sReplacementDelay) {
+	ostringstream os{};
+	os << "Http2ClientPool[" << this << "]";
+	mLogPrefix = os.str();
+
+	// The first connection is created right away so that configuration errors (e.g. invalid certificate) are reported
+	// to the caller.
+	mHost = addClient()->getHost();
+	SLOGD << mLogPrefix << ": up to " << mMaxConnections << " connection(s) to [" << mHost << "]";
+}
+
+Http2ClientPool::~Http2ClientPool() {
+	// The clients may outlive the pool if they are in the middle of a callback.
+	for (const auto& client : mClients) {
+		client->setOnConnectionLostCb(nullptr);
+	}
+}
+
+void Http2ClientPool::send(const shared_ptr<Http2Client::HttpRequest>& request,
+                           const Http2Client::OnResponseCb& onResponseCb,
+                           const Http2Client::OnErrorCb& onErrorCb) {
+	pickClient()->send(request, onResponseCb, onErrorCb);
+}
+
+bool Http2ClientPool::isIdle() const {
+	return all_of(mClients.cbegin(), mClients.cend(), [](const auto& client) { return client->isIdle(); });
+}
+
+void Http2ClientPool::setRequestTimeout(chrono::seconds requestTimeout) {
+	mRequestTimeout = requestTimeout;
+	for (const auto& client : mClients) {
+		client->setRequestTimeout(requestTimeout);
+	}
+}
+
+void Http2ClientPool::enableInsecureTestMode() {
+	mInsecureTestMode = true;
+	for (const auto& client : mClients) {
+		client->enableInsecureTestMode();
+	}
+}
+
+vector<Http2ClientPool::ConnectionStats> Http2ClientPool::getStats() const {
+	vector<ConnectionStats> stats{};
+	stats.reserve(mClients.size());
+	for (const auto& client : mClients) {
+		stats.push_back({
+		    .state = client->getState(),
+		    .activeStreams = client->getActiveStreamCount(),
+		    .pendingRequests = client->getPendingRequestCount(),
+		    .maxConcurrentStreams = client->getMaxConcurrentStreams(),
+		    .latency = client->getLatencyStats(),
+		});
+	}
+	return stats;
+}
+
+shared_ptr<Http2Client> Http2ClientPool::pickClient() {
+	// Connected clients first, then the ones with the fewest requests in progress.
+	const auto load = [](const shared_ptr<Http2Client>& client) {
+		return make_pair(client->getState() != Http2Client::State::Connected,
+		                 client->getActiveStreamCount() + client->getPendingRequestCount());
+	};
+	auto best = *min_element(mClients.cbegin(), mClients.cend(),
+	                         [&load](const auto& lhs, const auto& rhs) { return load(lhs) < load(rhs); });
+
+	const auto [notConnected, requestCount] = load(best);
+	if (!isNearlySaturated(*best, requestCount) || mClients.size() >= mMaxConnections) return best;
+
+	// All the connections are close to their limit of concurrent streams: open a new one in the background.
+	shared_ptr<Http2Client> newClient{};
+	try {
+		newClient = addClient();
+	} catch (const exception& e) {
+		SLOGW << mLogPrefix << ": failed to create a new connection: " << e.what();
+		return best;
+	}
+	SLOGD << mLogPrefix << ": all connections are nearly saturated, opening connection #" << mClients.size();
+	if (notConnected) return newClient;
+	newClient->connect();
+	return best;
+}
+
+bool Http2ClientPool::isNearlySaturated(const Http2Client& client, size_t requestCount) {
+	auto maxStreams = client.getState() == Http2Client::State::Connected ? client.getMaxConcurrentStreams() : nullopt;
+	// nghttp2 reports no limit until the SETTINGS frame of the server is received.
+	if (!maxStreams || *maxStreams == numeric_limits<uint32_t>::max()) maxStreams = sDefaultMaxConcurrentStreams;
+	return *maxStreams - *maxStreams / sSaturationMarginDivisor <= requestCount;
+}
+
+shared_ptr<Http2Client> Http2ClientPool::addClient() {
+	auto client = mFactory();
+	if (mRequestTimeout) client->setRequestTimeout(*mRequestTimeout);
+	if (mInsecureTestMode) client->enableInsecureTestMode();
+	client->setOnConnectionLostCb([this, weakClient = weak_ptr<Http2Client>{client}](bool hadRequests) {
+		onConnectionLost(weakClient, hadRequests);
+	});
+	mClients.push_back(client);
+	return client;
+}
+
+void Http2ClientPool::onConnectionLost(const weak_ptr<Http2Client>& lostClient, bool hadRequests) {
+	// A connection that wasn't in use will be established again on demand.
+	if (!hadRequests) return;
+
+	mLostClients.push_back(lostClient);
+	if (!mReplacementTimer.isRunning()) mReplacementTimer.set([this] { replaceLostClients(); });
+}
+
+void Http2ClientPool::replaceLostClients() {
+	for (const auto& weakClient : mLostClients) {
+		const auto client = weakClient.lock();
+		// Skip the clients that reconnected on their own in the meantime.
+		if (!client || client->getState() != Http2Client::State::Disconnected) continue;
+		SLOGD << mLogPrefix << ": replacing lost connection of Http2Client[" << client.get() << "]";
+		client->connect();
+	}
+	mLostClients.clear();
+}
+
+ostream& operator<<(ostream& os, const Http2ClientPool::ConnectionStats& stats) noexcept {
+	os << "state=" << stats.state << ", streams=" << stats.activeStreams << "/";
+	if (stats.maxConcurrentStreams) os << *stats.maxConcurrentStreams;
+	else os << "?";
+	return os << ", pending=" << stats.pendingRequests << ", responses=" << stats.latency.responseCount
+	          << ", latency(avg/last/max)=" << stats.latency.averageLatency.count() << "/"
+	          << stats.latency.lastLatency.count() << "/" << stats.latency.maxLatency.count() << "us";
+}
+
+} // namespace flexisip
@@ -0,0 +1,134 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <flexisip/sofia-wrapper/su-root.hh>
+#include <flexisip/sofia-wrapper/timer.hh>
+
+#include "http2client.hh"
+
+namespace flexisip {
+
+/**
+ * A pool of HTTP/2 connections to a same remote host.
+ * Each connection is handled by an Http2Client. Requests are sent over the least loaded connection, and a new
+ * connection is opened in the background once all existing ones are close to the maximum number of concurrent streams
+ * allowed by the server, as long as the maximum number of connections isn't reached.
+ * A connection that is lost while carrying requests (network error, GOAWAY...) is established again in the background
+ * so that the following requests don't have to wait for it.
+ */
+class Http2ClientPool {
+public:
+	using ClientFactory = std::function<std::shared_ptr<Http2Client>()>;
+
+	/**
+	 * Occupancy and latency of one connection of the pool.
+	 */
+	struct ConnectionStats {
+		Http2Client::State state{Http2Client::State::Disconnected};
+		size_t activeStreams{0};
+		size_t pendingRequests{0};
+		std::optional<uint32_t> maxConcurrentStreams{};
+		Http2Client::LatencyStats latency{};
+	};
+
+	/**
+	 * @param root the main loop of the connections.
+	 * @param factory function creating a new (disconnected) Http2Client to the remote host.
+	 * @param maxConnections maximum number of simultaneous connections. Values lesser than 1 are treated as 1.
+	 */
+	Http2ClientPool(sofiasip::SuRoot& root, ClientFactory&& factory, unsigned maxConnections = 1);
+	~Http2ClientPool();
+	Http2ClientPool(const Http2ClientPool&) = delete;
+	Http2ClientPool& operator=(const Http2ClientPool&) = delete;
+
+	/**
+	 * Send the request over the least loaded connection. See Http2Client::send().
+	 */
+	void send(const std::shared_ptr<Http2Client::HttpRequest>& request,
+	          const Http2Client::OnResponseCb& onResponseCb,
+	          const Http2Client::OnErrorCb& onErrorCb);
+
+	bool isIdle() const;
+
+	/**
+	 * Set the request timeout of all the current and future connections. See Http2Client::setRequestTimeout().
+	 */
+	void setRequestTimeout(std::chrono::seconds requestTimeout);
+	void enableInsecureTestMode();
+
+	/**
+	 * Value to put in the 'host' header of the requests.
+	 */
+	const std::string& getHost() const {
+		return mHost;
+	}
+
+	unsigned getMaxConnections() const {
+		return mMaxConnections;
+	}
+	const std::vector<std::shared_ptr<Http2Client>>& getClients() const {
+		return mClients;
+	}
+	std::vector<ConnectionStats> getStats() const;
+
+private:
+	std::shared_ptr<Http2Client> pickClient();
+	std::shared_ptr<Http2Client> addClient();
+	// Whether requestCount requests in progress bring the client close to its limit of concurrent streams.
+	static bool isNearlySaturated(const Http2Client& client, size_t requestCount);
+	void onConnectionLost(const std::weak_ptr<Http2Client>& lostClient, bool hadRequests);
+	void replaceLostClients();
+
+	ClientFactory mFactory;
+	unsigned mMaxConnections;
+	std::string mHost{};
+	std::vector<std::shared_ptr<Http2Client>> mClients{};
+	std::vector<std::weak_ptr<Http2Client>> mLostClients{};
+	sofiasip::Timer mReplacementTimer;
+	std::optional<std::chrono::seconds> mRequestTimeout{};
+	bool mInsecureTestMode{false};
+	std::string mLogPrefix{};
+
+	/**
+	 * Delay before replacing a lost connection, so that a server which is down isn't flooded with connection
+	 * attempts.
+	 */
+	static constexpr std::chrono::milliseconds sReplacementDelay{1000};
+	/**
+	 * Limit of concurrent streams assumed while the one of the server isn't known, or when it has none. It is the
+	 * minimum value recommended by RFC 9113.
+	 */
+	static constexpr uint32_t sDefaultMaxConcurrentStreams{100};
+	// A connection is nearly saturated when less than 1/sSaturationMarginDivisor of its streams are free.
+	static constexpr uint32_t sSaturationMarginDivisor{10};
+};
+
+std::ostream& operator<<(std::ostream& os, const Http2ClientPool::ConnectionStats& stats) noexcept;
+
+} // namespace flexisip
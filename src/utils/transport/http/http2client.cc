@@ -38,6 +38,13 @@ string Http2Client::BadStateError::formatWhatArg(State state) noexcept {
 	return string{"bad state ["} + to_string(unsigned(state)) + "]";
 }
 
+void Http2Client::LatencyStats::addSample(chrono::microseconds latency) noexcept {
+	averageLatency = responseCount == 0 ? latency : averageLatency + (latency - averageLatency) / 8;
+	lastLatency = latency;
+	maxLatency = max(maxLatency, latency);
+	responseCount++;
+}
+
 Http2Client::Http2Client(sofiasip::SuRoot& root,
                          decltype(mConn)&& connection,
                          decltype(mAuthManager)&& authManager,
@@ -151,6 +158,10 @@ void Http2Client::send(const shared_ptr<HttpRequest>& request,
 	SLOGD << logPrefix << ": request[" << request << "] submitted";
 }
 
+void Http2Client::connect() {
+	if (mState == State::Disconnected) tlsConnect();
+}
+
 void Http2Client::tlsConnect() {
 	if (mState != State::Disconnected) {
 		throw BadStateError(mState);
@@ -168,8 +179,10 @@ void Http2Client::onTlsConnectCb() {
 	if (mConn->isConnected()) {
 		http2Setup();
 	} else {
+		const auto hadRequests = !mPendingHttpContexts.empty();
 		discardAllPendingRequests();
 		setState(State::Disconnected);
+		if (mOnConnectionLostCb) mOnConnectionLostCb(hadRequests);
 	}
 }
 
@@ -235,7 +248,7 @@ void Http2Client::http2Setup() {
 	int status;
 	if ((status = mSessionSettings.submitTo(session)) != 0) {
 		SLOGE << mLogPrefix << ": submitting settings failed [status=" << to_string(status) << "]";
-		disconnect();
+		onConnectionLost();
 		return;
 	}
 
@@ -359,12 +372,12 @@ int Http2Client::onPollInCb(su_root_magic_t*, su_wait_t* w, su_wakeup_arg_t* arg
 
 	if (w->revents & SU_WAIT_HUP) {
 		SLOGD << thiz->mLogPrefix << ": peer has hung up";
-		thiz->disconnect();
+		thiz->onConnectionLost();
 		return 0;
 	}
 	if (w->revents & SU_WAIT_ERR) {
 		SLOGE << thiz->mLogPrefix << ": socket error";
-		thiz->disconnect();
+		thiz->onConnectionLost();
 		return 0;
 	}
 
@@ -372,13 +385,13 @@ int Http2Client::onPollInCb(su_root_magic_t*, su_wait_t* w, su_wakeup_arg_t* arg
 	if (status < 0) {
 		SLOGE << thiz->mLogPrefix << ": error while receiving HTTP2 data[" << nghttp2_strerror(status)
 		      << "]. Disconnecting";
-		thiz->disconnect();
+		thiz->onConnectionLost();
 		return 0;
 	}
 	if (thiz->mLastSID >= 0) {
 		SLOGD << thiz->mLogPrefix << ": closing connection after receiving GOAWAY frame. Last processed stream is ["
 		      << thiz->mLastSID << "]";
-		thiz->disconnect();
+		thiz->onConnectionLost();
 	}
 	return 0;
 }
@@ -400,6 +413,8 @@ void Http2Client::onStreamClosed([[maybe_unused]] nghttp2_session& session,
 				context->getResponse()->getStatusCode(); // throw an exception if the status code is invalid.
 				SLOGD << logPrefix << ": response received for HttpRequest[" << context->getRequest() << "]:\n"
 				      << context->getResponse()->toString();
+				const auto latency = chrono::steady_clock::now() - context->getCreationTime();
+				mLatencyStats.addSample(chrono::duration_cast<chrono::microseconds>(latency));
 				context->getOnResponseCb()(context->getRequest(), context->getResponse());
 				mActiveHttpContexts.erase(contextMapIterator);
 			} catch (const runtime_error& e) {
@@ -454,6 +469,12 @@ void Http2Client::disconnect() {
 	setState(State::Disconnected);
 }
 
+void Http2Client::onConnectionLost() {
+	const auto hadRequests = !isIdle();
+	disconnect();
+	if (mOnConnectionLostCb) mOnConnectionLostCb(hadRequests);
+}
+
 void Http2Client::onConnectionIdle() noexcept {
 	SLOGD << mLogPrefix << ": connection is idle";
 	disconnect();
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <list>
@@ -71,6 +72,21 @@ public:
 		std::array<nghttp2_settings_entry, 1> mSettings;
 	};
 
+	/**
+	 * Round-trip statistics of the requests answered over the connection.
+	 */
+	struct LatencyStats {
+		uint64_t responseCount{0};
+		std::chrono::microseconds lastLatency{0};
+		// Exponentially weighted moving average, with a 1/8 weight for each new sample (as for TCP's SRTT).
+		std::chrono::microseconds averageLatency{0};
+		std::chrono::microseconds maxLatency{0};
+
+		void addSample(std::chrono::microseconds latency) noexcept;
+	};
+
+	using OnConnectionLostCb = std::function<void(bool hadRequests)>;
+
 	template <typename... Args>
 	static std::shared_ptr<Http2Client> make(Args&&... args) {
 		// new because make_shared need a public constructor.
@@ -99,6 +115,16 @@ public:
 
 	void onTlsConnectCb();
 
+	/**
+	 * Establish the connection ahead of the first request. Does nothing if the client is already connected or
+	 * connecting.
+	 */
+	void connect();
+
+	State getState() const {
+		return mState;
+	}
+
 	std::string getHost() const {
 		return mConn->getPort() == "443" ? mConn->getHost() : mConn->getHost() + ":" + mConn->getPort();
 	}
@@ -143,6 +169,38 @@ public:
 		return nghttp2_session_get_remote_window_size(mHttpSession.get());
 	}
 
+	/**
+	 * Number of requests submitted to the server and not answered yet.
+	 */
+	size_t getActiveStreamCount() const {
+		return mActiveHttpContexts.size();
+	}
+	/**
+	 * Number of requests waiting for the connection to be established.
+	 */
+	size_t getPendingRequestCount() const {
+		return mPendingHttpContexts.size();
+	}
+	/**
+	 * Maximum number of concurrent streams announced by the server, or std::nullopt while not connected.
+	 */
+	std::optional<uint32_t> getMaxConcurrentStreams() const {
+		if (!mHttpSession) return std::nullopt;
+		return nghttp2_session_get_remote_settings(mHttpSession.get(), NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+	}
+	const LatencyStats& getLatencyStats() const {
+		return mLatencyStats;
+	}
+
+	/**
+	 * Set a callback called when the connection fails to be established or is lost because of a network error or a
+	 * GOAWAY from the server. It is not called when the connection is closed because of inactivity.
+	 * hadRequests tells whether requests were pending or waiting for a response at that time.
+	 */
+	void setOnConnectionLostCb(const OnConnectionLostCb& onConnectionLostCb) {
+		mOnConnectionLostCb = onConnectionLostCb;
+	}
+
 private:
 	struct NgHttp2SessionDeleter {
 		void operator()(nghttp2_session* ptr) const noexcept {
@@ -201,6 +259,8 @@ private:
 	void tlsConnect();
 	void http2Setup();
 	void disconnect();
+	// Disconnect after a failure and notify the OnConnectionLostCb
+	void onConnectionLost();
 
 	int sendAll() {
 		return nghttp2_session_send(mHttpSession.get());
@@ -238,6 +298,9 @@ private:
 	 */
 	std::chrono::seconds mRequestTimeout{30};
 
+	LatencyStats mLatencyStats{};
+	OnConnectionLostCb mOnConnectionLostCb{};
+
 	/**
 	 * Delay (in second) before the connection with the distant HTTP2 server is closed because of inactivity.
 	 */
@@ -16,6 +16,8 @@
  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
+
 #include <net-snmp/net-snmp-config.h>
 #include <net-snmp/net-snmp-includes.h>
 
@@ -24,10 +26,12 @@
 
 #include <bctoolbox/ownership.hh>
 
+#include <flexisip/expressionparser-impl.cc>
 #include <flexisip/sip-boolean-expressions.hh>
 
 #include "conditional-routes.hh"
 #include "tester.hh"
+#include "utils/test-patterns/test.hh"
 #include "utils/test-suite.hh"
 
 using namespace flexisip;
@@ -251,6 +255,69 @@ static void invalid_expressions(void){
 	
 }
 
+static void constant_operands(void) {
+	// Comparisons between constants are evaluated at parsing time.
+	auto expr = SipBooleanExpressionBuilder::get().parse("'jehan' in 'jehan-mac jehan'");
+	BC_HARD_ASSERT(dynamic_pointer_cast<ConstantBooleanExpression<sip_t>>(expr) != nullptr);
+	BC_ASSERT_TRUE(expr->eval(getRequest()));
+	expr = SipBooleanExpressionBuilder::get().parse("'jehan-mac' contains 'mac' && 'a' != 'a'");
+	BC_ASSERT_FALSE(expr->eval(getRequest()));
+
+	// Constant lists are split once, values must still be compared entirely.
+	expr = SipBooleanExpressionBuilder::get().parse("from.uri.user in '  jehan  jehan-mac-mini jehan-mac '");
+	BC_ASSERT_TRUE(expr->eval(getRequest()));
+	expr = SipBooleanExpressionBuilder::get().parse("from.uri.user nin 'jehan jehan-mac-mini'");
+	BC_ASSERT_TRUE(expr->eval(getRequest()));
+	expr = SipBooleanExpressionBuilder::get().parse("request.uri.user in ''");
+	BC_ASSERT_FALSE(expr->eval(getRequest()));
+
+	// Computed variables are compared as before.
+	expr = SipBooleanExpressionBuilder::get().parse("status.code in '180 183'");
+	BC_ASSERT_TRUE(expr->eval(getResponse()));
+	BC_ASSERT_FALSE(expr->eval(getRequest()));
+}
+
+/*
+ * Compares the evaluation time of an expression on variables read in place from the sip_t structure, with the same
+ * expression on variables copied on each evaluation. Timings are only logged, as they depend on the machine.
+ */
+static void evaluation_benchmark(void) {
+	static const auto toString = [](const char* s) { return s ? string(s) : string(); };
+	ExpressionRules<sip_t> copyingRules = {
+	    {
+	        {"request.method",
+	         [](const sip_t& sip) { return toString(sip.sip_request ? sip.sip_request->rq_method_name : nullptr); }},
+	        {"from.uri.user", [](const sip_t& sip) { return toString(sip.sip_from->a_url->url_user); }},
+	        {"from.uri.domain", [](const sip_t& sip) { return toString(sip.sip_from->a_url->url_host); }},
+	        {"user-agent",
+	         [](const sip_t& sip) { return toString(sip.sip_user_agent ? sip.sip_user_agent->g_string : nullptr); }},
+	    },
+	    {},
+	};
+	BooleanExpressionBuilder<sip_t> copyingBuilder{copyingRules};
+	const string expression = "request.method == 'REGISTER' && from.uri.domain regex '.*linphone.*' && "
+	                          "(from.uri.user in 'jehan-kevin jehan-patrick jehan-mac') && "
+	                          "user-agent contains 'Linphone'";
+	const auto copying = copyingBuilder.parse(expression);
+	const auto inPlace = SipBooleanExpressionBuilder::get().parse(expression);
+
+	const auto measure = [](BooleanExpression<sip_t>& expr, const sip_t& sip, int& matches) {
+		const auto start = chrono::steady_clock::now();
+		for (int i = 0; i < 20000; ++i) {
+			if (expr.eval(sip)) ++matches;
+		}
+		return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+	};
+	int copyingMatches = 0, inPlaceMatches = 0;
+	const auto copyingTime = measure(*copying, getRequest(), copyingMatches);
+	const auto inPlaceTime = measure(*inPlace, getRequest(), inPlaceMatches);
+
+	BC_ASSERT_CPP_EQUAL(inPlaceMatches, 20000);
+	BC_ASSERT_CPP_EQUAL(inPlaceMatches, copyingMatches);
+	SLOGD << __FUNCTION__ << " - 20000 evaluations with copied values: " << copyingTime << "us, read in place: "
+	      << inPlaceTime << "us";
+}
+
 string serializeRoute(const sip_route_t *route){
 	string ret;
 	size_t len;
@@ -309,6 +376,8 @@ TestSuite _("Boolean expressions",
              TEST_NO_TAG("Basic message inspection", basic_message_inspection),
              TEST_NO_TAG("More complex expressions", complex_expressions),
              TEST_NO_TAG("Invalid expressions", invalid_expressions),
+             TEST_NO_TAG("Constant operands", constant_operands),
+             TEST_NO_TAG("Evaluation benchmark", evaluation_benchmark),
              TEST_NO_TAG("Route-condition map", route_condition_map)},
             Hooks()
                 .beforeSuite([] {
@@ -16,10 +16,12 @@
     along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <optional>
 #include <random>
+#include <set>
 
 #include <soci/session.h>
 #include <utility>
@@ -208,6 +210,130 @@ void forkMessageContextSociRepositoryFullLoadMysqlUnitTests() {
 	}
 }
 
+/**
+ * Fork messages are browsed page by page, and restored at startup in the background, without blocking the main loop.
+ */
+void forkMessagesAreRestoredPageByPage() {
+	forceSociRepositoryInstantiation();
+	const auto& repository = ForkMessageContextSociRepository::getInstance();
+	const auto expiration = time(nullptr) + 3600;
+	set<string> insertedUuids{};
+	for (int i = 0; i < 10; i++) {
+		auto fakeDbObject =
+		    ForkMessageContextDb{1.52, 5, false, *gmtime(&expiration), rawRequest, MsgSipPriority::Urgent};
+		fakeDbObject.dbKeys = vector<string>{"key" + to_string(i % 3), "key" + to_string(i)};
+		insertedUuids.insert(repository->saveForkMessageContext(fakeDbObject));
+	}
+
+	const auto lastUuid = repository->findLastForkMessageUuid();
+	BC_ASSERT_TRUE(insertedUuids.count(lastUuid) == 1);
+	// Saved after the restoration started, so not restored.
+	auto laterDbObject = ForkMessageContextDb{1.52, 5, false, *gmtime(&expiration), rawRequest, MsgSipPriority::Urgent};
+	laterDbObject.dbKeys = vector<string>{"key0"};
+	const auto laterUuid = repository->saveForkMessageContext(laterDbObject);
+
+	set<string> pagedUuids{};
+	string afterUuid{};
+	int pageCount = 0;
+	for (auto page = repository->findForkMessagePage(afterUuid, lastUuid, 3); !page.empty();
+	     page = repository->findForkMessagePage(afterUuid, lastUuid, 3)) {
+		pageCount++;
+		BC_ASSERT_TRUE(page.size() <= 3);
+		for (const auto& dbFork : page) {
+			BC_ASSERT_CPP_EQUAL(dbFork.dbKeys.size(), 2);
+			BC_ASSERT_TRUE(dbFork.msgPriority == MsgSipPriority::Urgent);
+			auto expirationDate = dbFork.expirationDate;
+			BC_ASSERT_CPP_EQUAL(timegm(&expirationDate), expiration);
+			pagedUuids.insert(dbFork.uuid);
+			afterUuid = dbFork.uuid;
+		}
+	}
+	BC_ASSERT_CPP_EQUAL(pageCount, 4);
+	// Each message is found once.
+	BC_ASSERT_TRUE(pagedUuids == insertedUuids);
+	repository->deleteByUuid(laterUuid);
+
+	Server server{{
+	    {"module::Registrar/reg-domains", "sip.test.org"},
+	    {"module::Router/fork-late", "true"},
+	    {"module::Router/message-fork-late", "true"},
+	    {"module::Router/message-database-enabled", "true"},
+	    {"module::Router/message-database-backend", "mysql"},
+	    {"module::Router/message-database-connection-string", mysqlServer->connectionString()},
+	    {"module::Router/message-database-restore-page-size", "3"},
+	}};
+	server.start();
+	const auto& moduleRouter = dynamic_pointer_cast<ModuleRouter>(server.getAgent()->findModule("Router"));
+	BC_HARD_ASSERT(moduleRouter != nullptr);
+	// Nothing is restored until the main loop runs.
+	BC_ASSERT_CPP_EQUAL(moduleRouter->mStats.mCountMessageProxyForks->start->read(), 0);
+
+	CoreAssert asserter{server};
+	asserter
+	    .wait([&moduleRouter] {
+		    return LOOP_ASSERTION(moduleRouter->mStats.mCountMessageProxyForks->start->read() == 10);
+	    })
+	    .assert_passed();
+	BC_ASSERT_CPP_EQUAL(moduleRouter->mStats.mCountMessageProxyForks->finish->read(), 0);
+	// Restored messages stay in DB until one of their recipients registers.
+	BC_ASSERT_CPP_EQUAL(repository->findAllForkMessage().size(), 10);
+}
+
+/**
+ * With write-behind, queued writes are written together, and a message deleted before being written is never written.
+ */
+void writeBehindQueueBatchesAndCoalescesWrites() {
+	forceSociRepositoryInstantiation();
+	const auto& repository = ForkMessageContextSociRepository::getInstance();
+	const auto root = make_shared<sofiasip::SuRoot>();
+	// Long enough for all the writes below to be queued before the scheduled flush.
+	repository->setWriteBehind(root, 1s, 100);
+	const auto expiration = time(nullptr) + 3600;
+	atomic_int savedCount{0};
+	atomic_int notSavedCount{0};
+	const auto onSaved = [&savedCount, &notSavedCount](bool saved) { (saved ? savedCount : notSavedCount)++; };
+
+	vector<string> uuids{};
+	for (int i = 0; i < 5; i++) {
+		auto fakeDbObject =
+		    ForkMessageContextDb{1.52, 5, false, *gmtime(&expiration), rawRequest, MsgSipPriority::NonUrgent};
+		fakeDbObject.dbKeys = vector<string>{"key" + to_string(i), "sharedKey"};
+		fakeDbObject.dbBranches = vector<BranchInfoDb>{{"contactUid", 4.0, rawRequest, rawResponse, 1}};
+		uuids.push_back(ForkMessageContextSociRepository::generateUuid());
+		repository->queueSave(uuids.back(), fakeDbObject, true, onSaved);
+	}
+	// Delivered before being written.
+	repository->queueDelete(uuids[0]);
+	// Updated before being written.
+	auto updatedDbObject = ForkMessageContextDb{2, 10, false, *gmtime(&expiration), rawRequest, MsgSipPriority::Urgent};
+	updatedDbObject.dbKeys = vector<string>{"key1", "sharedKey"};
+	updatedDbObject.dbBranches = vector<BranchInfoDb>{{"contactUid", 1.0, rawRequest, rawResponse, 2}};
+	repository->queueSave(uuids[1], updatedDbObject, false, onSaved);
+
+	BC_ASSERT_CPP_EQUAL(repository->findAllForkMessage().size(), 0);
+	repository->flushWriteBehindQueue();
+	BC_ASSERT_CPP_EQUAL(savedCount.load(), 5);
+	BC_ASSERT_CPP_EQUAL(notSavedCount.load(), 1);
+	BC_ASSERT_CPP_EQUAL(repository->findAllForkMessage().size(), 4);
+	const auto updatedFork = repository->findForkMessageByUuid(uuids[1]);
+	BC_ASSERT_CPP_EQUAL(updatedFork.deliveredCount, 10);
+	BC_ASSERT_CPP_EQUAL(updatedFork.dbKeys.size(), 2);
+	BC_HARD_ASSERT_CPP_EQUAL(updatedFork.dbBranches.size(), 1);
+	BC_ASSERT_CPP_EQUAL(updatedFork.dbBranches[0].clearedCount, 2);
+
+	// Already written, so really deleted.
+	repository->queueDelete(uuids[2]);
+	repository->flushWriteBehindQueue();
+	BC_ASSERT_CPP_EQUAL(repository->findAllForkMessage().size(), 3);
+
+	// The first queued operation arms the timer, which flushes the queue from the main loop.
+	repository->queueDelete(uuids[3]);
+	CoreAssert asserter{*root};
+	BC_ASSERT_TRUE(asserter.waitUntil(3s, [&repository] { return repository->findAllForkMessage().size() == 2; }));
+
+	repository->setWriteBehind(root, 0ms, 1);
+}
+
 /**
  * Send a message to a client with one idle device, to force the message to be saved in DB.
  * At this point we assert that the message saved in DB is the same as the one sent.
@@ -866,6 +992,8 @@ TestSuite _("ForkContext::mysql",
                 CLASSY_TEST(forkMessageContextSociRepositoryMysqlUnitTests),
                 CLASSY_TEST(forkMessageContextWithBranchesSociRepositoryMysqlUnitTests),
                 CLASSY_TEST(forkMessageContextSociRepositoryFullLoadMysqlUnitTests),
+                CLASSY_TEST(forkMessagesAreRestoredPageByPage),
+                CLASSY_TEST(writeBehindQueueBatchesAndCoalescesWrites),
                 CLASSY_TEST(globalTest),
                 CLASSY_TEST(globalTestMultipleDevices),
                 CLASSY_TEST(testDBAccessOptimization),
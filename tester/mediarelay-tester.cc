@@ -443,6 +443,79 @@ void early_media_bidirectional_video() {
 	    .assert_passed();
 }
 
+/*
+ * Test that media is relayed with both event loop backends of the relay threads.
+ */
+void callRelayedWithPollingBackend(const string& backend) {
+	auto config = map<string, string>{{"module::MediaRelay/polling-backend", backend}};
+	config.merge(map<string, string>{CONFIG});
+	Server server(config);
+	server.start();
+	ClientBuilder builder{*server.getAgent()};
+	auto caller = builder.build("sip:caller@sip.example.org");
+	auto callee = builder.build("sip:callee@sip.example.org");
+
+	// CoreClient::call() makes sure that media is sent and received on both ends.
+	BC_HARD_ASSERT(caller.call(callee) != nullptr);
+	BC_ASSERT(caller.endCurrentCall(callee));
+}
+
+void call_relayed_with_poll_backend() {
+	callRelayedWithPollingBackend("poll");
+}
+
+void call_relayed_with_epoll_backend() {
+	callRelayedWithPollingBackend("epoll");
+}
+
+/*
+ * Test that media is relayed when all calls share the same relay sockets.
+ */
+void call_relayed_with_shared_sockets() {
+	auto config = map<string, string>{
+	    {"module::MediaRelay/shared-sockets", "2"},
+	    {"module::MediaRelay/sdp-port-range-min", "47320"},
+	    {"module::MediaRelay/sdp-port-range-max", "47330"},
+	};
+	config.merge(map<string, string>{CONFIG});
+	Server server(config);
+	server.start();
+	ClientBuilder builder{*server.getAgent()};
+	auto caller = builder.build("sip:caller@sip.example.org");
+	auto callee = builder.build("sip:callee@sip.example.org");
+	auto otherCaller = builder.build("sip:other-caller@sip.example.org");
+	auto otherCallee = builder.build("sip:other-callee@sip.example.org");
+
+	// Both calls use the same two port pairs, CoreClient::call() makes sure that media is sent and received on both
+	// ends.
+	BC_HARD_ASSERT(caller.call(callee) != nullptr);
+	BC_HARD_ASSERT(otherCaller.call(otherCallee) != nullptr);
+	BC_ASSERT(caller.endCurrentCall(callee));
+	BC_ASSERT(otherCaller.endCurrentCall(otherCallee));
+}
+
+/*
+ * Relay two calls with pinned relay threads. Channels are registered and unregistered through the lock-free queue of
+ * their relay thread, so the second call also checks that the first one left the relay in a consistent state.
+ */
+void call_relayed_with_sharded_relay() {
+	auto config = map<string, string>{
+	    {"module::MediaRelay/sharded-relay", "true"},
+	    {"module::MediaRelay/polling-backend", "epoll"},
+	};
+	config.merge(map<string, string>{CONFIG});
+	Server server(config);
+	server.start();
+	ClientBuilder builder{*server.getAgent()};
+	auto caller = builder.build("sip:caller@sip.example.org");
+	auto callee = builder.build("sip:callee@sip.example.org");
+
+	for (int i = 0; i < 2; ++i) {
+		BC_HARD_ASSERT(caller.call(callee) != nullptr);
+		BC_ASSERT(caller.endCurrentCall(callee));
+	}
+}
+
 namespace {
 TestSuite _("MediaRelay",
             {
@@ -452,6 +525,10 @@ TestSuite _("MediaRelay",
                 CLASSY_TEST(address_masquerading_in_sdp_with_call_update),
                 CLASSY_TEST(early_media_video_sendrecv_takeover),
                 CLASSY_TEST(early_media_bidirectional_video),
+                CLASSY_TEST(call_relayed_with_poll_backend),
+                CLASSY_TEST(call_relayed_with_epoll_backend),
+                CLASSY_TEST(call_relayed_with_shared_sockets),
+                CLASSY_TEST(call_relayed_with_sharded_relay),
             });
 }
 
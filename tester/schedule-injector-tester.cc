@@ -75,6 +75,72 @@ public:
 		return std::make_shared<FakeModule>(nullptr, nullptr);
 	}
 };
+/**
+ * ForkContext doing nothing, cheap enough to queue hundreds of thousands of them.
+ */
+class StubForkContext : public ForkContext {
+public:
+	StubForkContext(const shared_ptr<RequestSipEvent>& event, MsgSipPriority priority)
+	    : mEvent{event}, mPriority{priority} {
+	}
+
+	shared_ptr<BranchInfo> addBranch(const shared_ptr<RequestSipEvent>&, const shared_ptr<ExtendedContact>&) override {
+		return nullptr;
+	}
+	bool allCurrentBranchesAnswered(FinalStatusMode) const override {
+		return true;
+	}
+	bool hasNextBranches() const override {
+		return false;
+	}
+	void processInternalError(int, const char*) override {
+	}
+	void start() override {
+	}
+	void addKey(const string&) override {
+	}
+	const vector<string>& getKeys() const override {
+		return mKeys;
+	}
+	void onNewRegister(const SipUri&, const string&, const shared_ptr<ExtendedContact>&) override {
+	}
+	void onCancel(const shared_ptr<RequestSipEvent>&) override {
+	}
+	void onResponse(const shared_ptr<BranchInfo>&, const shared_ptr<ResponseSipEvent>&) override {
+	}
+	const shared_ptr<RequestSipEvent>& getEvent() override {
+		return mEvent;
+	}
+	const shared_ptr<ForkContextConfig>& getConfig() const override {
+		return mConfig;
+	}
+	bool isFinished() const override {
+		return false;
+	}
+	shared_ptr<BranchInfo> checkFinished() override {
+		return nullptr;
+	}
+	MsgSipPriority getMsgPriority() const override {
+		return mPriority;
+	}
+	const ForkContext* getPtrForEquality() const override {
+		return this;
+	}
+	void onPushSent(PushNotificationContext&, bool) noexcept override {
+	}
+
+protected:
+	const char* getClassName() const override {
+		return "StubForkContext";
+	}
+
+private:
+	shared_ptr<RequestSipEvent> mEvent;
+	MsgSipPriority mPriority;
+	vector<string> mKeys{};
+	shared_ptr<ForkContextConfig> mConfig{};
+};
+
 class ScheduleInjectorTest : public AgentTest {
 public:
 	void onAgentConfiguration(ConfigManager& cfg) override {
@@ -322,6 +388,56 @@ public:
 	}
 };
 
+/*
+ * Queue 100k messages for one contact and mark them ready to inject from the last one to the first one, so that
+ * finding each of them would walk the whole queue without the index. The queue is drained when the first one is
+ * ready. Timings are only logged, as they depend on the machine.
+ */
+class DrainBenchmarkTest : public ScheduleInjectorTest {
+public:
+	void testExec() override {
+		static constexpr auto kForkCount = 100000;
+		InjectContext::setMaxRequestRetentionTime(1h);
+		// Queued for mUuid, only its event is shared by all the stubs.
+		const auto event = this->addFork(MsgSipPriority::Normal)->getEvent();
+		const string contact{"drain-benchmark"};
+		vector<shared_ptr<ForkContext>> forks{};
+		forks.reserve(kForkCount);
+		for (auto i = 0; i < kForkCount; ++i) {
+			forks.push_back(make_shared<StubForkContext>(event, MsgSipPriority::Normal));
+		}
+
+		const auto start = steady_clock::now();
+		mInjector->addContext(forks, contact);
+		const auto queued = steady_clock::now();
+		for (auto it = forks.rbegin(); it != prev(forks.rend()); ++it) {
+			mInjector->injectRequestEvent(event, *it, contact);
+		}
+		BC_HARD_ASSERT(mStubModule->mOrderedInjectedRequests.empty());
+		mInjector->injectRequestEvent(event, forks.front(), contact);
+		const auto drained = steady_clock::now();
+
+		BC_ASSERT_CPP_EQUAL(mStubModule->mOrderedInjectedRequests.size(), size_t(kForkCount));
+		SLOGD << "DrainBenchmarkTest - " << kForkCount << " forks queued in "
+		      << duration_cast<milliseconds>(queued - start).count() << "ms, drained in "
+		      << duration_cast<milliseconds>(drained - queued).count() << "ms";
+
+		// Removal in reverse order doesn't walk the queue either.
+		for (auto& fork : forks) {
+			mInjector->addContext(fork, contact);
+		}
+		for (auto it = forks.rbegin(); it != forks.rend(); ++it) {
+			mInjector->removeContext(*it, contact);
+		}
+		BC_ASSERT_CPP_EQUAL(mStubModule->mOrderedInjectedRequests.size(), size_t(kForkCount));
+		// Nothing left to block the contact.
+		const auto fork = make_shared<StubForkContext>(event, MsgSipPriority::Normal);
+		mInjector->addContext(fork, contact);
+		mInjector->injectRequestEvent(event, fork, contact);
+		BC_ASSERT_CPP_EQUAL(mStubModule->mOrderedInjectedRequests.size(), size_t(kForkCount) + 1);
+	}
+};
+
 auto _ = [] {
 	// Work around because TEST_NO_TAG macro can't handle ",".
 	using TwoListTestEU = TwoListTest<MsgSipPriority::Emergency, MsgSipPriority::Urgent>;
@@ -346,6 +462,7 @@ auto _ = [] {
 	    TEST_NO_TAG("Test that remove restart injection of waiting forks.", run<NonBlockingRemoveScheduleInjectorTest>),
 	    TEST_NO_TAG("Test borderline cases (bad contactID, double remove...)", run<BorderLineCasesTest>),
 	    TEST_NO_TAG("Test that expired InjectContext are ignored", run<InjectContextExpiredTest>),
+	    TEST_NO_TAG("Drain 100k queued messages", run<DrainBenchmarkTest>),
 	};
 	static test_suite_t scheduleInjectorSuite = {"Schedule injector suite",        nullptr, nullptr, nullptr, nullptr,
 	                                             sizeof(tests) / sizeof(tests[0]), tests};
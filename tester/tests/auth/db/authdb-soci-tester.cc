@@ -29,6 +29,7 @@
 #include <flexisip/module.hh>
 
 #include "tester.hh"
+#include "utils/core-assert.hh"
 #include "utils/server/mysql-server.hh"
 #include "utils/string-utils.hh"
 #include "utils/test-patterns/test.hh"
@@ -107,12 +108,7 @@ static const char none[] = R"SQL(
 	UNION SELECT "domain-stand-in", "authid-stand-in";
 )SQL";
 
-template <typename Backend, const char request[]>
-void customPasswordRequestParamInjection() {
-	Backend backend{};
-	const auto injectedPassword = tester::randomString(0x10);
-	std::string empty{};
-	RootConfigStruct configRoot{"flexisip-tester", "Fake configuration for testing purposes", {}, empty};
+void declareConfig(RootConfigStruct& configRoot) {
 	for (const auto& init : ConfigManager::defaultInit()) {
 		init(configRoot);
 	}
@@ -124,6 +120,15 @@ void customPasswordRequestParamInjection() {
 			moduleInfo->declareConfig(configRoot);
 		}
 	}
+}
+
+template <typename Backend, const char request[]>
+void customPasswordRequestParamInjection() {
+	Backend backend{};
+	const auto injectedPassword = tester::randomString(0x10);
+	std::string empty{};
+	RootConfigStruct configRoot{"flexisip-tester", "Fake configuration for testing purposes", {}, empty};
+	declareConfig(configRoot);
 	const auto& authModuleConfig = *configRoot.get<GenericStruct>("module::Authentication");
 	authModuleConfig.get<ConfigInt>("soci-poolsize")->set("1");
 	authModuleConfig.get<ConfigString>("soci-password-request")->set(request);
@@ -154,6 +159,93 @@ void customPasswordRequestParamInjection() {
 	}
 }
 
+/*
+ * Concurrent requests for the same user are answered by a single query.
+ */
+void coalescedPasswordRequests() {
+	SqliteBackend backend{};
+	std::string empty{};
+	RootConfigStruct configRoot{"flexisip-tester", "Fake configuration for testing purposes", {}, empty};
+	declareConfig(configRoot);
+	const auto& authModuleConfig = *configRoot.get<GenericStruct>("module::Authentication");
+	authModuleConfig.get<ConfigInt>("soci-poolsize")->set("1");
+	authModuleConfig.get<ConfigString>("soci-password-request")->set("SELECT :id, 'SHA-DDOCK'");
+	backend.setConfig(authModuleConfig);
+	SociAuthDB authDb{configRoot};
+
+	std::vector<PasswordRequestListener> listeners(5);
+	for (auto& listener : listeners) {
+		authDb.getPasswordFromBackend("alice", "domain-stand-in", "authid-stand-in", &listener);
+	}
+	PasswordRequestListener otherUser{};
+	authDb.getPasswordFromBackend("bob", "domain-stand-in", "authid-stand-in", &otherUser);
+
+	for (auto& listener : listeners) {
+		auto future = listener.getFuture();
+		BC_HARD_ASSERT_TRUE(future.wait_for(1s) == std::future_status::ready);
+		const auto [result, passwords] = future.get();
+		BC_ASSERT_CPP_EQUAL(result, AuthDbResult::PASSWORD_FOUND);
+		BC_HARD_ASSERT_CPP_EQUAL(passwords.size(), 1);
+		BC_ASSERT_CPP_EQUAL(passwords[0].pass, "alice");
+	}
+	auto future = otherUser.getFuture();
+	BC_HARD_ASSERT_TRUE(future.wait_for(1s) == std::future_status::ready);
+	const auto [result, passwords] = future.get();
+	BC_HARD_ASSERT_CPP_EQUAL(passwords.size(), 1);
+	BC_ASSERT_CPP_EQUAL(passwords[0].pass, "bob");
+}
+
+static const char batchRequest[] = R"SQL(
+	WITH accounts(login, domain, password) AS (
+		VALUES ('alice', 'example.org', 'ALICE-PASS'), ('bob', 'example.org', 'bob-pass'), ('bob', 'other.org', 'x')
+	)
+	SELECT login, domain, password, 'SHA-DDOCK' FROM accounts WHERE login IN (:ids);
+)SQL";
+
+/*
+ * Requests received within 'soci-password-batch-delay' are resolved by a single 'soci-password-batch-request'.
+ */
+void batchedPasswordRequests() {
+	SqliteBackend backend{};
+	std::string empty{};
+	RootConfigStruct configRoot{"flexisip-tester", "Fake configuration for testing purposes", {}, empty};
+	declareConfig(configRoot);
+	const auto& authModuleConfig = *configRoot.get<GenericStruct>("module::Authentication");
+	authModuleConfig.get<ConfigInt>("soci-poolsize")->set("1");
+	authModuleConfig.get<ConfigString>("soci-password-batch-request")->set(batchRequest);
+	authModuleConfig.get<ConfigDuration<std::chrono::milliseconds>>("soci-password-batch-delay")->set("50");
+	backend.setConfig(authModuleConfig);
+	const auto root = std::make_shared<sofiasip::SuRoot>();
+	SociAuthDB authDb{configRoot, root};
+
+	PasswordRequestListener alice{}, aliceAgain{}, bob{}, carol{}, quoted{}, injected{};
+	authDb.getPasswordFromBackend("alice", "example.org", "alice", &alice);
+	authDb.getPasswordFromBackend("alice", "example.org", "alice", &aliceAgain);
+	authDb.getPasswordFromBackend("bob", "example.org", "bob", &bob);
+	authDb.getPasswordFromBackend("carol", "example.org", "carol", &carol);
+	authDb.getPasswordFromBackend("o'neil", "example.org", "o'neil", &quoted);
+	// Users are bound as parameters, they cannot alter the request.
+	authDb.getPasswordFromBackend("x\\') OR 1=1 --", "example.org", "x", &injected);
+
+	const auto expect = [&root](PasswordRequestListener& listener, AuthDbResult expected, const std::string& pass) {
+		auto future = listener.getFuture();
+		BC_HARD_ASSERT_TRUE(
+		    CoreAssert{*root}.wait([&future] { return future.wait_for(0s) == std::future_status::ready; }));
+		const auto [result, passwords] = future.get();
+		BC_ASSERT_CPP_EQUAL(result, expected);
+		if (pass.empty()) return;
+		BC_HARD_ASSERT_CPP_EQUAL(passwords.size(), 1);
+		BC_ASSERT_CPP_EQUAL(passwords[0].pass, pass);
+		BC_ASSERT_CPP_EQUAL(passwords[0].algo, "SHA-DDOCK");
+	};
+	expect(alice, AuthDbResult::PASSWORD_FOUND, "alice-pass");
+	expect(aliceAgain, AuthDbResult::PASSWORD_FOUND, "alice-pass");
+	expect(bob, AuthDbResult::PASSWORD_FOUND, "bob-pass");
+	expect(carol, AuthDbResult::PASSWORD_NOT_FOUND, "");
+	expect(quoted, AuthDbResult::PASSWORD_NOT_FOUND, "");
+	expect(injected, AuthDbResult::PASSWORD_NOT_FOUND, "");
+}
+
 namespace {
 TestSuite _("SociAuthDB",
             {
@@ -165,6 +257,8 @@ TestSuite _("SociAuthDB",
                 CLASSY_TEST((customPasswordRequestParamInjection<MySqlBackend, domain>)),
                 CLASSY_TEST((customPasswordRequestParamInjection<MySqlBackend, authId>)),
                 CLASSY_TEST((customPasswordRequestParamInjection<MySqlBackend, none>)),
+                CLASSY_TEST(coalescedPasswordRequests),
+                CLASSY_TEST(batchedPasswordRequests),
             },
             Hooks().afterSuite([] {
 	            sMysqlSuiteServer = std::nullopt;
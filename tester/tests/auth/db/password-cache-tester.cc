@@ -0,0 +1,128 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "auth/db/authdb.hh"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flexisip/configmanager.hh"
+
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace flexisip::tester {
+
+namespace {
+
+const vector<passwd_algo_t> kPasswords{{"hash", "MD5"}};
+constexpr time_t kNow = 1'000'000;
+
+void validAndExpired() {
+	PasswordCache cache{0, 0s};
+	vector<passwd_algo_t> found{};
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow) == PasswordCache::Result::MISSING);
+
+	cache.insert("alice#alice", "example.org", kPasswords, kNow + 10);
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow) == PasswordCache::Result::VALID);
+	BC_HARD_ASSERT_CPP_EQUAL(found.size(), 1);
+	BC_ASSERT_CPP_EQUAL(found[0].pass, "hash");
+	// Keys are scoped by domain.
+	BC_ASSERT(cache.find("alice#alice", "example.com", found, kNow) == PasswordCache::Result::MISSING);
+
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow + 10) == PasswordCache::Result::EXPIRED);
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow) == PasswordCache::Result::MISSING);
+	BC_ASSERT_CPP_EQUAL(cache.size(), 0);
+}
+
+void refreshAhead() {
+	PasswordCache cache{0, 60s};
+	vector<passwd_algo_t> found{};
+	cache.insert("alice#alice", "example.org", kPasswords, kNow + 100);
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow) == PasswordCache::Result::VALID);
+
+	// Reported once, the caller is expected to fetch it again.
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow + 50) == PasswordCache::Result::EXPIRING);
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow + 51) == PasswordCache::Result::VALID);
+
+	// Until it is updated.
+	cache.insert("alice#alice", "example.org", kPasswords, kNow + 200);
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow + 100) == PasswordCache::Result::VALID);
+	BC_ASSERT(cache.find("alice#alice", "example.org", found, kNow + 150) == PasswordCache::Result::EXPIRING);
+}
+
+void leastRecentlyUsedEviction() {
+	StatCounter64 evictions{"evictions", "", 0};
+	PasswordCache cache{64, 0s, &evictions};
+	for (int i = 0; i < 1000; ++i) {
+		cache.insert("user-" + to_string(i), "example.org", kPasswords, kNow + 10);
+	}
+	const auto size = cache.size();
+	BC_ASSERT(size <= 64);
+	BC_ASSERT(0 < size);
+	BC_ASSERT_CPP_EQUAL(evictions.read(), 1000 - size);
+
+	// The most recently inserted entry is always kept.
+	vector<passwd_algo_t> found{};
+	BC_ASSERT(cache.find("user-999", "example.org", found, kNow) == PasswordCache::Result::VALID);
+}
+
+// The entries are split across shards, the limit is still reached exactly when it is not a multiple of their count.
+void maxSizeNotMultipleOfShardCount() {
+	PasswordCache cache{70, 0s};
+	for (int i = 0; i < 1000; ++i) {
+		cache.insert("user-" + to_string(i), "example.org", kPasswords, kNow + 10);
+	}
+	BC_ASSERT_CPP_EQUAL(cache.size(), 70);
+}
+
+void concurrentAccess() {
+	PasswordCache cache{0, 0s};
+	vector<thread> threads{};
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&cache, t] {
+			vector<passwd_algo_t> found{};
+			for (int i = 0; i < 1000; ++i) {
+				const auto key = "user-" + to_string(t) + "-" + to_string(i);
+				cache.insert(key, "example.org", kPasswords, kNow + 10);
+				cache.find(key, "example.org", found, kNow);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	BC_ASSERT_CPP_EQUAL(cache.size(), 4000);
+}
+
+TestSuite _("PasswordCache",
+            {
+                CLASSY_TEST(validAndExpired),
+                CLASSY_TEST(refreshAhead),
+                CLASSY_TEST(leastRecentlyUsedEviction),
+                CLASSY_TEST(maxSizeNotMultipleOfShardCount),
+                CLASSY_TEST(concurrentAccess),
+            });
+
+} // namespace
+} // namespace flexisip::tester
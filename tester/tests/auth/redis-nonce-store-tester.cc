@@ -0,0 +1,127 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "auth/redis-nonce-store.hh"
+
+#include <optional>
+#include <string>
+
+#include "flexisip/sofia-wrapper/su-root.hh"
+
+#include "utils/core-assert.hh"
+#include "utils/redis-sync-access.hh"
+#include "utils/server/redis-server.hh"
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace flexisip::tester {
+
+namespace {
+using namespace redis::async;
+
+struct NcCheck {
+	int previousNc;
+	bool accepted;
+};
+
+/*
+ * A nonce issued by one proxy is accepted once per nonce count by another one, and expires in Redis.
+ */
+void nonceSharedBetweenProxies() {
+	RedisServer redis{};
+	sofiasip::SuRoot root{};
+	const RedisParameters params{
+	    .domain = "localhost",
+	    .port = redis.port(),
+	    .mSlaveCheckTimeout = 60s,
+	    .mSubSessionKeepAliveTimeout = 60s,
+	};
+	RedisNonceStore issuer{root, params};
+	RedisNonceStore other{root, params};
+	issuer.setNonceExpires(60);
+	other.setNonceExpires(60);
+	CoreAssert asserter{root};
+	auto ctx = RedisSyncContext(redisConnect("localhost", params.port));
+
+	issuer.insert("the-nonce");
+	asserter
+	    .iterateUpTo(
+	        10,
+	        [&ctx] {
+		        const auto reply = ctx.command("GET fs-nonce:the-nonce");
+		        FAIL_IF(reply->type != REDIS_REPLY_STRING);
+		        return LOOP_ASSERTION(reply->str == "0"s);
+	        },
+	        1s)
+	    .assert_passed();
+	const auto ttl = ctx.command("TTL fs-nonce:the-nonce");
+	BC_HARD_ASSERT_CPP_EQUAL(ttl->type, REDIS_REPLY_INTEGER);
+	BC_ASSERT(0 < ttl->integer && ttl->integer <= 60);
+
+	const auto check = [&asserter](RedisNonceStore& store, const string& nonce, int nc) {
+		optional<NcCheck> result{};
+		store.checkAndUpdateNc(nonce, nc, [&result](int previousNc, bool accepted) {
+			result = NcCheck{previousNc, accepted};
+		});
+		asserter.iterateUpTo(10, [&result] { return LOOP_ASSERTION(result.has_value()); }, 1s).assert_passed();
+		return *result;
+	};
+
+	auto result = check(other, "the-nonce", 1);
+	BC_ASSERT_CPP_EQUAL(result.previousNc, 0);
+	BC_ASSERT(result.accepted);
+	BC_ASSERT_CPP_EQUAL(ctx.command("GET fs-nonce:the-nonce")->str, "1"s);
+	// Replayed nonce count.
+	result = check(other, "the-nonce", 1);
+	BC_ASSERT_CPP_EQUAL(result.previousNc, 1);
+	BC_ASSERT(!result.accepted);
+	result = check(other, "the-nonce", 2);
+	BC_ASSERT(result.accepted);
+	// The nonce count last used with the other proxy is rejected by the issuer, despite its near-cache.
+	result = check(issuer, "the-nonce", 2);
+	BC_ASSERT_CPP_EQUAL(result.previousNc, 2);
+	BC_ASSERT(!result.accepted);
+	result = check(issuer, "the-nonce", 3);
+	BC_ASSERT(result.accepted);
+	result = check(other, "the-nonce", 3);
+	BC_ASSERT(!result.accepted);
+
+	// Never issued.
+	result = check(other, "unknown-nonce", 1);
+	BC_ASSERT_CPP_EQUAL(result.previousNc, -1);
+	BC_ASSERT(!result.accepted);
+
+	other.erase("the-nonce");
+	asserter
+	    .iterateUpTo(
+	        10,
+	        [&ctx] { return LOOP_ASSERTION(ctx.command("EXISTS fs-nonce:the-nonce")->integer == 0); },
+	        1s)
+	    .assert_passed();
+}
+
+TestSuite _("RedisNonceStore",
+            {
+                CLASSY_TEST(nonceSharedBetweenProxies),
+            });
+
+} // namespace
+} // namespace flexisip::tester
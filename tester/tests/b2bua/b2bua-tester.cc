@@ -24,6 +24,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
 
 #include "linphone++/enums.hh"
 #include <linphone++/linphone.hh>
@@ -381,6 +382,116 @@ void userAgentParameterConfiguration() {
 	}
 }
 
+/**
+ * Media port ranges are split between the cores of the server, and its configuration is checked when it runs several.
+ */
+void severalCoresConfiguration() {
+	BC_ASSERT(b2bua::shardPortRange(0, 0, 1, 4) == make_pair(0, 0));
+	BC_ASSERT(b2bua::shardPortRange(1024, 1033, 0, 1) == make_pair(1024, 1033));
+	BC_ASSERT(b2bua::shardPortRange(1024, 1033, 0, 3) == make_pair(1024, 1026));
+	BC_ASSERT(b2bua::shardPortRange(1024, 1033, 1, 3) == make_pair(1027, 1029));
+	// The last core gets the remainder.
+	BC_ASSERT(b2bua::shardPortRange(1024, 1033, 2, 3) == make_pair(1030, 1033));
+	BC_ASSERT_THROWN(b2bua::shardPortRange(1024, 1025, 0, 3), BadConfiguration);
+	BC_ASSERT_THROWN(b2bua::shardPortRange(12345, 12345, 0, 2), BadConfiguration);
+
+	for (const auto* callId : {"call-id-1", "call-id-2", "call-id-3"}) {
+		BC_ASSERT(b2bua::shardOf(callId, 4) < 4);
+		BC_ASSERT_CPP_EQUAL(b2bua::shardOf(callId, 4), b2bua::shardOf(callId, 4));
+		BC_ASSERT_CPP_EQUAL(b2bua::shardOf(callId, 1), 0u);
+	}
+
+	const auto getServerConfig = [](const B2buaAndProxyServer& b2bua) {
+		return b2bua.getAgent()->getConfigManager().getRoot()->get<GenericStruct>("b2bua-server");
+	};
+	{
+		B2buaAndProxyServer b2bua{"", false};
+		getServerConfig(b2bua)->get<ConfigInt>("nb-cores")->set("0");
+		BC_ASSERT_THROWN(b2bua.startB2bua(), BadConfiguration);
+	}
+	{
+		B2buaAndProxyServer b2bua{"", false};
+		getServerConfig(b2bua)->get<ConfigInt>("nb-cores")->set("2");
+		getServerConfig(b2bua)->get<ConfigString>("application")->set("sip-bridge");
+		BC_ASSERT_THROWN(b2bua.startB2bua(), BadConfiguration);
+	}
+	// Core N listens on the configured port + N, which can't be chosen by the kernel.
+	{
+		B2buaAndProxyServer b2bua{"", false};
+		getServerConfig(b2bua)->get<ConfigInt>("nb-cores")->set("2");
+		getServerConfig(b2bua)->get<ConfigString>("transport")->set("sip:127.0.0.1:0;transport=tcp");
+		BC_ASSERT_THROWN(b2bua.startB2bua(), BadConfiguration);
+	}
+}
+
+/**
+ * Calls are dispatched by the proxy between the cores of the server, by hash of their Call-ID. Each core bridges the
+ * calls it receives, from its own thread, and the CANCEL of a call reaches the core that handles its INVITE.
+ */
+void severalCores() {
+	constexpr auto basePort = 6367;
+	B2buaAndProxyServer server{{
+	    {"global/transports", "sip:127.0.0.1:0;transport=tcp"},
+	    {"b2bua-server/transport", "sip:127.0.0.1:" + to_string(basePort) + ";transport=tcp"},
+	    {"b2bua-server/application", "trenscrypter"},
+	    {"b2bua-server/nb-cores", "2"},
+	    {"module::Registrar/enabled", "true"},
+	    {"module::Registrar/reg-domains", "sip.example.org"},
+	    {"module::B2bua/enabled", "true"},
+	    {"module::MediaRelay/enabled", "false"},
+	}};
+
+	ClientBuilder builder{*server.getAgent()};
+	auto caller = builder.build("sip:caller@sip.example.org");
+	auto callee = builder.build("sip:callee@sip.example.org");
+	CoreAssert asserter{server, caller, callee};
+
+	// Each core bridges a call, then has one cancelled.
+	bool bridged[2]{}, cancelled[2]{};
+	for (auto callCount = 0; callCount < 32; ++callCount) {
+		if (bridged[0] && bridged[1] && cancelled[0] && cancelled[1]) break;
+
+		const ClientCall callerCall{caller.invite(callee)};
+		callee.hasReceivedCallFrom(caller, asserter).hard_assert_passed();
+		const auto shard = b2bua::shardOf(ClientCall::getLinphoneCall(callerCall)->getCallLog()->getCallId(), 2);
+		const auto calleeCall = callee.getCurrentCall().value();
+		// The outgoing leg is placed by the core that received the INVITE.
+		BC_ASSERT_CPP_EQUAL(ClientCall::getLinphoneCall(calleeCall)->getRemoteContactAddress()->getPort(),
+		                    basePort + static_cast<int>(shard));
+
+		if (!bridged[shard]) {
+			calleeCall.accept();
+			asserter
+			    .iterateUpTo(
+			        0x20,
+			        [&callerCall, &calleeCall]() {
+				        FAIL_IF(callerCall.getState() != linphone::Call::State::StreamsRunning);
+				        FAIL_IF(calleeCall.getState() != linphone::Call::State::StreamsRunning);
+				        return ASSERTION_PASSED();
+			        },
+			        2s)
+			    .hard_assert_passed();
+			BC_HARD_ASSERT(callee.endCurrentCall(caller));
+			bridged[shard] = true;
+			continue;
+		}
+
+		callerCall.terminate();
+		asserter
+		    .iterateUpTo(
+		        0x20,
+		        [&callerCall, &calleeCall]() {
+			        FAIL_IF(callerCall.getState() != linphone::Call::State::Released);
+			        FAIL_IF(calleeCall.getState() != linphone::Call::State::Released);
+			        return ASSERTION_PASSED();
+		        },
+		        2s)
+		    .hard_assert_passed();
+		cancelled[shard] = true;
+	}
+	BC_ASSERT(bridged[0] && bridged[1] && cancelled[0] && cancelled[1]);
+}
+
 void videoRejectedByCallee() {
 	// Initialize and start the proxy and B2bua server
 	B2buaAndProxyServer server{"config/flexisip_b2bua.conf"};
@@ -1235,6 +1346,8 @@ TestSuite _{
         CLASSY_TEST(usesAORButNotContact),
         CLASSY_TEST(userAgentHeader),
         CLASSY_TEST(userAgentParameterConfiguration),
+        CLASSY_TEST(severalCoresConfiguration),
+        CLASSY_TEST(severalCores),
         CLASSY_TEST(videoRejectedByCallee),
         CLASSY_TEST(pauseWithAudioInactive),
         CLASSY_TEST(answerToPauseWithAudioInactive),
@@ -0,0 +1,157 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "b2bua/trenscrypter-rule-matcher.hh"
+
+#include <chrono>
+#include <optional>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "flexisip/logmanager.hh"
+
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+using namespace std;
+
+namespace flexisip::tester {
+namespace {
+
+using namespace b2bua::trenscrypter;
+
+void literalAffixes() {
+	const auto assertAffixes = [](string_view pattern, string_view prefix, string_view suffix, bool uriParameters) {
+		const auto affixes = RuleMatcher::literalAffixes(pattern);
+		BC_ASSERT_CPP_EQUAL(affixes.prefix, prefix);
+		BC_ASSERT_CPP_EQUAL(affixes.suffix, suffix);
+		BC_ASSERT_CPP_EQUAL(affixes.uriParameters, uriParameters);
+	};
+	assertAffixes(R"(.*@sip\.example\.org)", "", "@sip.example.org", false);
+	assertAffixes(R"(.*zrtp@sip\.example\.org(;.*)?)", "", "zrtp@sip.example.org", true);
+	assertAffixes(R"(^sip:alice@.*$)", "sip:alice@", "", false);
+	// A quantified literal is not part of the prefix, unless it is required at least once.
+	assertAffixes("sip:ab*c", "sip:a", "c", false);
+	assertAffixes("sip:a+b", "sip:a", "b", false);
+	// Escaped letters are character classes.
+	assertAffixes(R"(sip:\d+@sip\.example\.org\s)", "sip:", "", false);
+	assertAffixes(R"(a\$)", "a$", "a$", false);
+	assertAffixes("sip:alice@[a-z]+", "sip:alice@", "", false);
+	assertAffixes("sip:alice@example.org|sip:bob@example.org", "", "", false);
+}
+
+// The first matching rule is found, as with a linear scan.
+void firstMatchingRule() {
+	RuleMatcher matcher{};
+	matcher.add(R"(.*dtls@sip\.example\.org)");
+	matcher.add(R"(sip:alice@.*)");
+	matcher.add(R"(.*@sip\.example\.org(;.*)?)");
+	matcher.add(R"(.*@sip\.secure-example\.org)");
+	BC_ASSERT_THROWN(matcher.add("sip:(unbalanced"), regex_error);
+	BC_ASSERT_CPP_EQUAL(matcher.size(), 4u);
+
+	BC_ASSERT(matcher.match("sip:user-dtls@sip.example.org") == 0u);
+	BC_ASSERT(matcher.match("sip:alice@sip.example.org") == 1u);
+	BC_ASSERT(matcher.match("sip:bob@sip.example.org") == 2u);
+	BC_ASSERT(matcher.match("sip:bob@sip.example.org;gr=urn:uuid:1234;transport=tcp") == 2u);
+	BC_ASSERT(matcher.match("sip:bob@sip.secure-example.org") == 3u);
+	BC_ASSERT(matcher.match("sip:bob@sip.secure-example.org;gr=1234") == nullopt);
+	BC_ASSERT(matcher.match("sip:bob@sip.unknown.org") == nullopt);
+
+	// Results are cached.
+	const auto regexMatchCount = matcher.getRegexMatchCount();
+	BC_ASSERT(matcher.match("sip:bob@sip.example.org") == 2u);
+	BC_ASSERT(matcher.match("sip:bob@sip.unknown.org") == nullopt);
+	BC_ASSERT_CPP_EQUAL(matcher.getRegexMatchCount(), regexMatchCount);
+}
+
+/**
+ * Thousands of rules of various shapes, applied on thousands of URIs. Results must be the ones of a linear scan of
+ * the regular expressions, in a fraction of its time.
+ */
+void benchmark() {
+	constexpr auto ruleCount = 2000;
+	constexpr auto uriCount = 3000;
+	constexpr auto linearScanCount = 200;
+
+	RuleMatcher matcher{};
+	vector<regex> rules{};
+	for (auto i = 0; i < ruleCount; ++i) {
+		const auto index = to_string(i);
+		string pattern{};
+		switch (i % 4) {
+			case 0:
+				pattern = R"(.*@domain)" + index + R"(\.example\.org(;.*)?)";
+				break;
+			case 1:
+				pattern = "sip:user" + index + "@.*";
+				break;
+			case 2:
+				pattern = R"(.*zrtp@domain)" + to_string(i % 50) + R"(\.example\.org)";
+				break;
+			default:
+				pattern = "sip:[a-z]+" + index + R"(@domain\d+\.example\.org)";
+		}
+		matcher.add(pattern);
+		rules.emplace_back(pattern);
+	}
+	mt19937 random{0x5eed};
+	vector<string> uris{};
+	for (auto i = 0; i < uriCount; ++i) {
+		uris.push_back("sip:user" + to_string(random() % ruleCount) + (i % 3 == 0 ? "zrtp" : "") + "@domain" +
+		               to_string(random() % ruleCount) + ".example.org" + (i % 5 == 0 ? ";gr=1234;transport=tcp" : ""));
+	}
+
+	const auto matcherStart = chrono::steady_clock::now();
+	vector<optional<size_t>> results{};
+	for (const auto& uri : uris) {
+		results.push_back(matcher.match(uri));
+	}
+	const auto matcherTime = chrono::steady_clock::now() - matcherStart;
+
+	const auto linearScanStart = chrono::steady_clock::now();
+	for (auto i = 0; i < linearScanCount; ++i) {
+		optional<size_t> expected{};
+		for (size_t rule = 0; rule < rules.size(); ++rule) {
+			if (regex_match(uris[i], rules[rule])) {
+				expected = rule;
+				break;
+			}
+		}
+		BC_ASSERT(results[i] == expected);
+	}
+	const auto linearScanTime = chrono::steady_clock::now() - linearScanStart;
+
+	const auto matcherTimePerUri = chrono::duration<double, micro>(matcherTime).count() / uriCount;
+	const auto linearScanTimePerUri = chrono::duration<double, micro>(linearScanTime).count() / linearScanCount;
+	SLOGI << "RuleMatcher: " << matcherTimePerUri << "us per URI, linear scan: " << linearScanTimePerUri
+	      << "us per URI, " << matcher.getRegexMatchCount() << " regular expressions run";
+	BC_ASSERT(matcherTimePerUri < linearScanTimePerUri);
+}
+
+TestSuite _("b2bua::trenscrypter::RuleMatcher",
+            {
+                CLASSY_TEST(literalAffixes),
+                CLASSY_TEST(firstMatchingRule),
+                CLASSY_TEST(benchmark),
+            });
+
+} // namespace
+} // namespace flexisip::tester
@@ -0,0 +1,131 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "callstore.hh"
+
+#include <memory>
+#include <string>
+
+#include "flexisip/sofia-wrapper/msg-sip.hh"
+
+#include "utils/server/proxy-server.hh"
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+using namespace std;
+
+namespace flexisip::tester {
+
+namespace {
+
+MsgSip makeRequest(const string& method,
+                   const string& callId,
+                   const string& fromTag,
+                   const string& toTag = "",
+                   const string& branch = "z9hG4bK.request") {
+	return MsgSip{0, method + " sip:callee@sip.example.org SIP/2.0\r\n"
+	                     "Via: SIP/2.0/UDP 10.0.0.1:5060;branch=" + branch + "\r\n"
+	                     "From: <sip:caller@sip.example.org>;tag=" + fromTag + "\r\n"
+	                     "To: <sip:callee@sip.example.org>" + (toTag.empty() ? "" : ";tag=" + toTag) + "\r\n"
+	                     "Call-ID: " + callId + "\r\n"
+	                     "CSeq: 20 " + method + "\r\n"
+	                     "Content-Length: 0\r\n\r\n"};
+}
+
+MsgSip makeOk(const string& callId, const string& fromTag, const string& toTag, const string& branch) {
+	return MsgSip{0, "SIP/2.0 200 Ok\r\n"
+	                 "Via: SIP/2.0/UDP 10.0.0.1:5060;branch=" + branch + "\r\n"
+	                 "From: <sip:caller@sip.example.org>;tag=" + fromTag + "\r\n"
+	                 "To: <sip:callee@sip.example.org>;tag=" + toTag + "\r\n"
+	                 "Call-ID: " + callId + "\r\n"
+	                 "CSeq: 20 INVITE\r\n"
+	                 "Content-Length: 0\r\n\r\n"};
+}
+
+/*
+ * Store two calls, establish the dialog of one of them with a 200 Ok and check that in-dialog requests are matched to
+ * the right call, whatever the direction of the request, until the call is removed.
+ */
+void findCallsByCallIdAndDialog() {
+	Server proxy{};
+	proxy.start();
+	auto* agent = proxy.getAgent().get();
+	CallStore store{};
+
+	auto invite = makeRequest("INVITE", "first-call-id", "caller-tag", "", "z9hG4bK.first-invite");
+	auto firstCall = make_shared<CallContextBase>(invite.getSip());
+	store.store(firstCall);
+	auto otherInvite = makeRequest("INVITE", "second-call-id", "other-caller-tag");
+	auto secondCall = make_shared<CallContextBase>(otherInvite.getSip());
+	store.store(secondCall);
+	BC_ASSERT_CPP_EQUAL(store.size(), 2);
+
+	// Not established yet: only a Call-ID match is possible.
+	BC_ASSERT(store.find(agent, otherInvite.getSip(), true) == secondCall);
+	auto unknown = makeRequest("INVITE", "unknown-call-id", "caller-tag");
+	BC_ASSERT(store.find(agent, unknown.getSip(), true) == nullptr);
+
+	auto ok = makeOk("first-call-id", "caller-tag", "callee-tag", "z9hG4bK.first-invite");
+	BC_ASSERT(store.find(agent, ok.getSip()) == firstCall);
+	BC_ASSERT(firstCall->isDialogEstablished());
+
+	auto byeFromCaller = makeRequest("BYE", "first-call-id", "caller-tag", "callee-tag");
+	BC_ASSERT(store.findEstablishedDialog(agent, byeFromCaller.getSip()) == firstCall);
+	auto byeFromCallee = makeRequest("BYE", "first-call-id", "callee-tag", "caller-tag");
+	BC_ASSERT(store.findEstablishedDialog(agent, byeFromCallee.getSip()) == firstCall);
+	auto byeWithWrongTag = makeRequest("BYE", "first-call-id", "caller-tag", "wrong-tag");
+	BC_ASSERT(store.findEstablishedDialog(agent, byeWithWrongTag.getSip()) == nullptr);
+	auto byeWithWrongCallId = makeRequest("BYE", "second-call-id", "caller-tag", "callee-tag");
+	BC_ASSERT(store.findEstablishedDialog(agent, byeWithWrongCallId.getSip()) == nullptr);
+
+	store.remove(firstCall);
+	BC_ASSERT_CPP_EQUAL(store.size(), 1);
+	BC_ASSERT(store.findEstablishedDialog(agent, byeFromCaller.getSip()) == nullptr);
+	BC_ASSERT(store.find(agent, invite.getSip(), true) == nullptr);
+	BC_ASSERT(store.find(agent, otherInvite.getSip(), true) == secondCall);
+}
+
+/*
+ * Removing calls, whether explicitly or because of inactivity, must leave no stale entry in the indexes.
+ */
+void removeCallsSharingCallId() {
+	CallStore store{};
+	auto invite = makeRequest("INVITE", "shared-call-id", "caller-tag");
+	auto firstCall = make_shared<CallContextBase>(invite.getSip());
+	auto secondCall = make_shared<CallContextBase>(invite.getSip());
+	store.store(firstCall);
+	store.store(secondCall);
+
+	store.findAndRemoveExcept(nullptr, invite.getSip(), secondCall, true);
+	BC_ASSERT_CPP_EQUAL(store.size(), 1);
+	BC_ASSERT(store.find(nullptr, invite.getSip(), true) == secondCall);
+
+	store.removeAndDeleteInactives(-1);
+	BC_ASSERT_CPP_EQUAL(store.size(), 0);
+	BC_ASSERT(store.getList().empty());
+	BC_ASSERT(store.find(nullptr, invite.getSip(), true) == nullptr);
+}
+
+TestSuite _("CallStore",
+            {
+                CLASSY_TEST(findCallsByCallIdAndDialog),
+                CLASSY_TEST(removeCallsSharingCallId),
+            });
+
+} // namespace
+} // namespace flexisip::tester
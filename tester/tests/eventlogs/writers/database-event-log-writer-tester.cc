@@ -10,6 +10,7 @@
 
 #include "sofia-sip/sip.h"
 
+#include "flexisip/configmanager.hh"
 #include "flexisip/sofia-wrapper/msg-sip.hh"
 
 #include "eventlogs/events/eventlogs.hh"
@@ -54,8 +55,78 @@ void logMessage() {
 	BC_ASSERT_CPP_EQUAL(sip_from, "<msg-event-log-test-from@example.org>");
 }
 
+/*
+ * In batch mode, events are written by multi-row inserts, the specialized rows referencing the ids given by the
+ * database to the main rows. The last events, that don't fill a batch, are written after the max delay. Another writer
+ * of the same database, batching or not, can write at the same time.
+ */
+void logMessagesByBatches() {
+	MysqlServer db{};
+	sofiasip::MsgSip msg{};
+	msg.makeAndInsert<sofiasip::SipHeaderFrom>("batch-event-log-test-from@example.org");
+	msg.makeAndInsert<sofiasip::SipHeaderTo>("batch-event-log-test-to@example.org");
+	msg.makeAndInsert<sofiasip::SipHeaderUserAgent>("batch-event-log-test-user-agent");
+	msg.makeAndInsert<sofiasip::SipHeaderCallID>();
+	db.waitReady();
+	// Rows written before, by one transaction per event.
+	DataBaseEventLogWriter singleEventWriter{"mysql", db.connectionString(), 1, 1};
+	singleEventWriter.write(make_shared<MessageLog>(*msg.getSip()));
+	soci::session sql{"mysql", db.connectionString()};
+	int count = 0;
+	BcAssert asserter{};
+	asserter.addCustomIterate([]() { this_thread::sleep_for(10ms); });
+	asserter
+	    .iterateUpTo(10,
+	                 [&sql, &count] {
+		                 sql << "SELECT COUNT(*) FROM event_log", soci::into(count);
+		                 FAIL_IF(count != 1);
+		                 return ASSERTION_PASSED();
+	                 })
+	    .assert_passed();
+
+	const auto root = make_shared<sofiasip::SuRoot>();
+	StatCounter64 queued{"queued", "", 0}, flushed{"flushed", "", 1}, dropped{"dropped", "", 2};
+	DataBaseEventLogWriter logWriter{"mysql", db.connectionString(), 100, 2};
+	BC_HARD_ASSERT_CPP_EQUAL(logWriter.isReady(), true);
+	logWriter.enableBatching(root, 10, 100ms);
+	logWriter.setStatCounters(&queued, &flushed, &dropped);
+	StatCounter64 otherFlushed{"otherFlushed", "", 3};
+	DataBaseEventLogWriter otherWriter{"mysql", db.connectionString(), 100, 2};
+	otherWriter.enableBatching(root, 10, 100ms);
+	otherWriter.setStatCounters(nullptr, &otherFlushed, nullptr);
+	DataBaseEventLogWriter unbatchedWriter{"mysql", db.connectionString(), 100, 2};
+	for (auto i = 0; i < 25; ++i) {
+		logWriter.write(make_shared<MessageLog>(*msg.getSip()));
+		otherWriter.write(make_shared<MessageLog>(*msg.getSip()));
+		unbatchedWriter.write(make_shared<MessageLog>(*msg.getSip()));
+	}
+
+	asserter.addCustomIterate([&root]() { root->step(1ms); });
+	asserter
+	    .iterateUpTo(100,
+	                 [&flushed, &otherFlushed] {
+		                 FAIL_IF(flushed.read() != 25);
+		                 FAIL_IF(otherFlushed.read() != 25);
+		                 return ASSERTION_PASSED();
+	                 })
+	    .assert_passed();
+	BC_ASSERT_CPP_EQUAL(queued.read(), 0u);
+	BC_ASSERT_CPP_EQUAL(dropped.read(), 0u);
+	asserter
+	    .iterateUpTo(10,
+	                 [&sql, &count] {
+		                 sql << "SELECT COUNT(*) FROM event_log e JOIN event_message_log m ON m.id = e.id "
+		                        "WHERE e.user_agent = 'batch-event-log-test-user-agent'",
+		                     soci::into(count);
+		                 FAIL_IF(count != 76);
+		                 return ASSERTION_PASSED();
+	                 })
+	    .assert_passed();
+}
+
 TestSuite _("DataBaseEventLogWriter",
             {
                 CLASSY_TEST(logMessage),
+                CLASSY_TEST(logMessagesByBatches),
             });
 } // namespace
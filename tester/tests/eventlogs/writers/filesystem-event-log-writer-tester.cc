@@ -0,0 +1,105 @@
+/** Copyright (C) 2010-2024 Belledonne Communications SARL
+ *  SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "eventlogs/writers/filesystem-event-log-writer.hh"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "flexisip/sofia-wrapper/msg-sip.hh"
+
+#include "eventlogs/events/eventlogs.hh"
+#include "sofia-wrapper/sip-header-private.hh"
+#include "utils/asserts.hh"
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+#include "utils/tmp-dir.hh"
+
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace flexisip::tester {
+namespace {
+
+shared_ptr<MessageLog> makeMessageLog(const string& from) {
+	sofiasip::MsgSip msg{};
+	msg.makeAndInsert<sofiasip::SipHeaderFrom>(from);
+	msg.makeAndInsert<sofiasip::SipHeaderTo>("sip:recipient@example.org");
+	msg.makeAndInsert<sofiasip::SipHeaderCallID>();
+	return make_shared<MessageLog>(*msg.getSip());
+}
+
+// Number of lines of the log files of a directory.
+int countLines(const filesystem::path& directory) {
+	if (!filesystem::exists(directory)) return 0;
+	int count = 0;
+	for (const auto& file : filesystem::directory_iterator{directory}) {
+		ifstream stream{file.path()};
+		for (string line{}; getline(stream, line);) {
+			++count;
+		}
+	}
+	return count;
+}
+
+// Without background writer, each line is written by the calling thread.
+void linesAreWrittenByTheCallingThread() {
+	TmpDir dir{__func__};
+	FilesystemEventLogWriter writer{dir.path().string()};
+	BC_HARD_ASSERT(writer.isReady());
+
+	writer.write(makeMessageLog("sip:alice@example.org"));
+	writer.write(makeMessageLog("sip:alice@example.org"));
+
+	BC_ASSERT_CPP_EQUAL(countLines(dir.path() / "users/example.org/alice/messages"), 2);
+}
+
+/*
+ * The background writer appends the buffered lines every flush interval, when a file is evicted from the cache of
+ * open files, or when it is destroyed.
+ */
+void backgroundWriterBuffersLines() {
+	TmpDir dir{__func__};
+	const auto aliceLogs = dir.path() / "users/example.org/alice/messages";
+	const auto bobLogs = dir.path() / "users/example.org/bob/messages";
+	{
+		FilesystemEventLogWriter writer{dir.path().string()};
+		BC_HARD_ASSERT(writer.isReady());
+		writer.enableBackgroundWriter(1, 1h, 0ms);
+
+		for (auto i = 0; i < 3; ++i) {
+			writer.write(makeMessageLog("sip:alice@example.org"));
+		}
+		writer.write(makeMessageLog("sip:bob@example.org"));
+		BC_ASSERT_CPP_EQUAL(countLines(aliceLogs), 0);
+		BC_ASSERT_CPP_EQUAL(countLines(bobLogs), 0);
+	}
+	BC_ASSERT_CPP_EQUAL(countLines(aliceLogs), 3);
+	BC_ASSERT_CPP_EQUAL(countLines(bobLogs), 1);
+
+	FilesystemEventLogWriter writer{dir.path().string()};
+	writer.enableBackgroundWriter(10, 10ms, 10ms);
+	writer.write(makeMessageLog("sip:alice@example.org"));
+	BcAssert asserter{};
+	asserter.addCustomIterate([] { this_thread::sleep_for(10ms); });
+	asserter
+	    .iterateUpTo(100,
+	                 [&aliceLogs] {
+		                 FAIL_IF(countLines(aliceLogs) != 4);
+		                 return ASSERTION_PASSED();
+	                 })
+	    .assert_passed();
+}
+
+TestSuite _("FilesystemEventLogWriter",
+            {
+                CLASSY_TEST(linesAreWrittenByTheCallingThread),
+                CLASSY_TEST(backgroundWriterBuffersLines),
+            });
+
+} // namespace
+} // namespace flexisip::tester
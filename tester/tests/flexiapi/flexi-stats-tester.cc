@@ -18,6 +18,9 @@
 
 #include "flexiapi/flexi-stats.hh"
 
+#include <map>
+#include <memory>
+
 #include "flexisip/utils/sip-uri.hh"
 #include "lib/nlohmann-json-3-11-2/json.hpp"
 #include "utils/asserts.hh"
@@ -620,6 +623,172 @@ protected:
 	}
 };
 
+/**
+ * With batching enabled, the requests are sent together at the end of the batch window, and the updates of a call or a
+ * message are merged into the pending request that creates it.
+ */
+class BatchedRequestsTest : public Test {
+public:
+	void operator()() override {
+		HttpMock httpMock{{"/"}, &mRequestReceivedCount};
+		int port = httpMock.serveAsync();
+		BC_HARD_ASSERT_TRUE(port > -1);
+
+		const auto root = make_shared<sofiasip::SuRoot>();
+		FlexiStats flexiStats{*root, "127.0.0.1", to_string(port), "api/stats", "aRandomApiToken"};
+		flexiStats.enableBatching(root, 50ms, 100);
+
+		const ApiFormattedUri user1{*SipUri("sip:user1@domain.org").get()};
+		flexiStats.postCall(Call{"call-id",
+		                         *SipUri("sip:user@sip.linphone.org").get(),
+		                         user1,
+		                         CallDevices{{"device_id", nullopt}},
+		                         getTestDate()});
+		flexiStats.updateCallDeviceState("call-id", "device_id", CallDeviceState{getTestDate(), nullopt});
+		flexiStats.updateCallState("call-id", getTestDateAfter());
+		flexiStats.postMessage(Message{"message-id", *SipUri("sip:user@sip.linphone.org").get(),
+		                               ToParam{{user1, MessageDevices{{"device_id", nullopt}}}}, getTestDate(), false,
+		                               nullopt});
+		flexiStats.notifyMessageDeviceResponse("message-id", user1, "device_id",
+		                                       MessageDeviceResponse{200, getTestDateAfter()});
+		flexiStats.conferenceAddParticipantEvent("conference-id", user1,
+		                                         ParticipantEvent{ParticipantEventType::ADDED, getTestDate()});
+		flexiStats.conferenceAddParticipantEvent("conference-id", user1,
+		                                         ParticipantEvent{ParticipantEventType::LEFT, getTestDateAfter()});
+		BC_ASSERT_CPP_EQUAL(mRequestReceivedCount, 0);
+
+		BcAssert asserter{[&root] { root->step(1ms); }};
+		ASSERT_PASSED(asserter.iterateUpTo(
+		    0x100, [this] { return LOOP_ASSERTION(mRequestReceivedCount == 1); }, 1s));
+		// Nothing else is sent.
+		root->step(100ms);
+		httpMock.forceCloseServer();
+		root->step(10ms);
+		BC_HARD_ASSERT_CPP_EQUAL(mRequestReceivedCount, 1);
+
+		const auto actualRequest = httpMock.popRequestReceived();
+		BC_HARD_ASSERT(actualRequest != nullptr);
+		BC_ASSERT_CPP_EQUAL(actualRequest->method, "POST");
+		BC_ASSERT_CPP_EQUAL(actualRequest->path, "/api/stats/batch");
+		json actualJson;
+		try {
+			actualJson = json::parse(actualRequest->body);
+		} catch (const exception&) {
+			BC_FAIL("json::parse exception with received body");
+		}
+		auto expectedJson = R"(
+		[
+		  {
+			"method": "POST",
+			"path": "/api/stats/calls",
+			"body": {
+			  "id": "call-id",
+			  "from": "user@sip.linphone.org",
+			  "to": "user1@domain.org",
+			  "devices": {
+				"device_id": {
+				  "rang_at": "2017-07-21T17:32:28Z"
+				}
+			  },
+			  "initiated_at": "2017-07-21T17:32:28Z",
+			  "ended_at": "2017-07-21T18:32:28Z",
+			  "conference_id": null
+			}
+		  },
+		  {
+			"method": "POST",
+			"path": "/api/stats/messages",
+			"body": {
+			  "id": "message-id",
+			  "from": "user@sip.linphone.org",
+			  "to": {
+				"user1@domain.org": {
+				  "device_id": {
+					"last_status": 200,
+					"received_at": "2017-07-21T18:32:28Z"
+				  }
+				}
+			  },
+			  "sent_at": "2017-07-21T17:32:28Z",
+			  "encrypted": false,
+			  "conference_id": null
+			}
+		  },
+		  {
+			"method": "POST",
+			"path": "/api/stats/conferences/conference-id/participants/user1@domain.org/events",
+			"body": {
+			  "type": "added",
+			  "at": "2017-07-21T17:32:28Z"
+			}
+		  },
+		  {
+			"method": "POST",
+			"path": "/api/stats/conferences/conference-id/participants/user1@domain.org/events",
+			"body": {
+			  "type": "left",
+			  "at": "2017-07-21T18:32:28Z"
+			}
+		  }
+		]
+		)"_json;
+		BC_ASSERT_CPP_EQUAL(actualJson, expectedJson);
+	}
+
+private:
+	std::atomic_int mRequestReceivedCount = 0;
+};
+
+/**
+ * A server that doesn't know the batch endpoint receives the pending requests one by one instead.
+ */
+class BatchedRequestsFallbackTest : public Test {
+public:
+	void operator()() override {
+		// The batch endpoint is unknown to the server, that answers 404.
+		HttpMock httpMock{{"/api/stats/calls", "/api/stats/calls/"}, &mRequestReceivedCount};
+		int port = httpMock.serveAsync();
+		BC_HARD_ASSERT_TRUE(port > -1);
+
+		const auto root = make_shared<sofiasip::SuRoot>();
+		FlexiStats flexiStats{*root, "127.0.0.1", to_string(port), "api/stats", "aRandomApiToken"};
+		flexiStats.enableBatching(root, 10ms, 100);
+
+		flexiStats.updateCallState("call-id", getTestDateAfter());
+		flexiStats.updateCallDeviceState("call-id", "device_id", CallDeviceState{getTestDate(), nullopt});
+		const Terminated accepted{getTestDate(), TerminatedState::ACCEPTED};
+		flexiStats.updateCallDeviceState("call-id", "device_id", CallDeviceState{nullopt, accepted});
+
+		BcAssert asserter{[&root] { root->step(1ms); }};
+		ASSERT_PASSED(asserter.iterateUpTo(
+		    0x100, [this] { return LOOP_ASSERTION(mRequestReceivedCount == 2); }, 1s));
+		root->step(50ms);
+		httpMock.forceCloseServer();
+		root->step(10ms);
+		BC_HARD_ASSERT_CPP_EQUAL(mRequestReceivedCount, 2);
+
+		map<string, json> bodies{};
+		while (const auto request = httpMock.popRequestReceived()) {
+			BC_ASSERT_CPP_EQUAL(request->method, "PATCH");
+			bodies.emplace(request->path, json::parse(request->body));
+		}
+		BC_ASSERT_CPP_EQUAL(bodies.size(), 2);
+		BC_ASSERT_CPP_EQUAL(bodies["/api/stats/calls/call-id"], R"({"ended_at": "2017-07-21T18:32:28Z"})"_json);
+		BC_ASSERT_CPP_EQUAL(bodies["/api/stats/calls/call-id/devices/device_id"], R"(
+		{
+		  "rang_at": "2017-07-21T17:32:28Z",
+		  "invite_terminated": {
+			"at": "2017-07-21T17:32:28Z",
+			"state": "accepted"
+		  }
+		}
+		)"_json);
+	}
+
+private:
+	std::atomic_int mRequestReceivedCount = 0;
+};
+
 namespace {
 TestSuite _("FlexiStats client unit tests",
             {
@@ -639,6 +808,8 @@ TestSuite _("FlexiStats client unit tests",
                 CLASSY_TEST(NotifyConferenceEndedTest),
                 CLASSY_TEST(ConferenceAddParticipantEventTest),
                 CLASSY_TEST(ConferenceAddParticipantDeviceEventTest),
+                CLASSY_TEST(BatchedRequestsTest),
+                CLASSY_TEST(BatchedRequestsFallbackTest),
             });
 } // namespace
 
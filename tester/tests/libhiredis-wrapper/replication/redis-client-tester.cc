@@ -123,9 +123,57 @@ void autoReconnectToMaster() {
 	    .assert_passed();
 }
 
+/* Setup 2 Redis servers with authentication (1 master, 1 replica) and connect the RedisClient to the master with the
+ * read-from-replicas policy. Verify that reads are eventually sent to the replica, authenticated with the credentials
+ * of the master, while commands still go to the master.
+ */
+void readFromUpToDateReplica() {
+	const auto& auth = auth::Legacy{.password = "Replicas hear no evil"};
+	auto redisMaster = RedisServer({.requirepass = auth.password});
+	auto redisReplica = redisMaster.createReplica();
+	auto root = sofiasip::SuRoot();
+	const auto& params = RedisParameters{
+	    .domain = "127.0.0.1",
+	    .auth = auth,
+	    .port = redisMaster.port(),
+	    .mSlaveCheckTimeout = 1s,
+	    .useSlavesAsBackup = false,
+	    .mSubSessionKeepAliveTimeout = 60s,
+	    .readFromReplicas = true,
+	    .maxReplicaLag = 1024 * 1024,
+	};
+	auto listener = ClientListener();
+	auto client = RedisClient(root, params, SoftPtr<SessionListener>::fromObjectLivingLongEnough(listener));
+	auto asserter = CoreAssert(root);
+	BC_HARD_ASSERT(client.tryGetCmdSession() != nullptr);
+	asserter.iterateUpTo(10, [&listener]() { return LOOP_ASSERTION(listener.connected); }, 200ms).assert_passed();
+
+	// The replica is discovered, and connected to, on a periodic replication check.
+	auto fromReplica = false;
+	asserter
+	    .iterateUpTo(
+	        50,
+	        [&client, &fromReplica]() {
+		        return LOOP_ASSERTION(client.tryGetReadSession(&fromReplica) != client.tryGetCmdSession());
+	        },
+	        100ms)
+	    .assert_passed();
+	BC_ASSERT(fromReplica);
+
+	string role{};
+	client.tryGetReadSession()->command({"ROLE"}, [&role](const auto&, Reply reply) {
+		const auto* array = std::get_if<reply::Array>(&reply);
+		BC_HARD_ASSERT(array != nullptr);
+		role = std::get<reply::String>((*array)[0]);
+	});
+	asserter.iterateUpTo(5, [&role]() { return LOOP_ASSERTION(!role.empty()); }, 100ms).assert_passed();
+	BC_ASSERT_CPP_EQUAL(role, "slave");
+}
+
 TestSuite _("redis::async::RedisClient",
             {
                 CLASSY_TEST(autoReconnectToMaster),
+                CLASSY_TEST(readFromUpToDateReplica),
             });
 
 } // namespace
@@ -0,0 +1,138 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "presence/pidf-fast-parser.hh"
+
+#include <sstream>
+#include <string>
+
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+using namespace std;
+
+namespace flexisip::tester {
+namespace {
+
+constexpr auto kHeader = R"(<?xml version="1.0" encoding="UTF-8"?>
+<presence xmlns="urn:ietf:params:xml:ns:pidf" xmlns:dm="urn:ietf:params:xml:ns:pidf:data-model"
+          xmlns:rpid="urn:ietf:params:xml:ns:pidf:rpid" xmlns:op="urn:oma:xml:prs:pidf:oma-pres"
+          entity="sip:user@sip.example.org">)";
+
+string serialize(const Xsd::Pidf::Presence& presence) {
+	Xsd::XmlSchema::NamespaceInfomap map{};
+	map[""].name = "urn:ietf:params:xml:ns:pidf";
+	ostringstream out{};
+	Xsd::Pidf::serializePresence(out, presence, map);
+	return out.str();
+}
+
+/*
+ * Documents of the supported subset give the same result as the complete parser.
+ */
+void sameResultAsCompleteParser() {
+	const string documents[] = {
+	    string{kHeader} + R"(
+  <tuple id="qoica9">
+    <status><basic>open</basic></status>
+    <contact>sip:user@sip.example.org;gr=urn:uuid:1234</contact>
+    <timestamp>2024-03-01T10:15:30Z</timestamp>
+  </tuple>
+  <dm:person id="oqpd4">
+    <rpid:activities><rpid:away/><rpid:on-the-phone/></rpid:activities>
+    <dm:timestamp>2024-03-01T10:15:30.250+01:00</dm:timestamp>
+  </dm:person>
+</presence>)",
+	    string{kHeader} + R"(
+  <!-- Several tuples, notes and capabilities -->
+  <tuple id="t1">
+    <status>
+      <basic>closed</basic>
+    </status>
+    <note xml:lang="fr">Parti d&#233;jeuner &amp; revient</note>
+    <op:service-description>
+      <op:service-id>groupchat</op:service-id><op:version>1.1</op:version>
+    </op:service-description>
+    <op:service-description>
+      <op:service-id>ephemeral</op:service-id><op:version>1.0</op:version>
+    </op:service-description>
+  </tuple>
+  <tuple id="t2"><status/></tuple>
+  <note>Back &lt;soon&gt;</note>
+  <dm:person id="p1">
+    <dm:note>Meeting</dm:note>
+    <rpid:activities><rpid:unknown/></rpid:activities>
+  </dm:person>
+</presence>)",
+	    // Prefixed pidf elements
+	    R"(<p:presence xmlns:p='urn:ietf:params:xml:ns:pidf' entity='sip:user@sip.example.org'>
+  <p:tuple id='t1'><p:status><p:basic>open</p:basic></p:status></p:tuple>
+</p:presence>)",
+	};
+
+	for (const auto& document : documents) {
+		const auto fast = PidfFastParser::parse(document);
+		BC_HARD_ASSERT(fast != nullptr);
+		istringstream data{document};
+		const auto complete = Xsd::Pidf::parsePresence(data, Xsd::XmlSchema::Flags::dont_validate);
+		BC_ASSERT_CPP_EQUAL(serialize(*fast), serialize(*complete));
+	}
+}
+
+/*
+ * Documents outside of the supported subset, or not well-formed, are left to the complete parser.
+ */
+void unsupportedDocumentsAreRejected() {
+	const string tuple = R"(<tuple id="t1"><status><basic>open</basic></status></tuple>)";
+	const string documents[] = {
+	    // Unknown elements or attributes
+	    string{kHeader} + R"(<tuple id="t1"><status><basic>open</basic><ext xmlns="urn:x"/></status></tuple>)" +
+	        "</presence>",
+	    string{kHeader} + tuple.substr(0, tuple.size() - 8) + R"(<contact priority="0.8">sip:a@b</contact></tuple>)" +
+	        "</presence>",
+	    string{kHeader} + R"(<dm:person id="p1" foo="bar"/></presence>)",
+	    string{kHeader} + R"(<dm:person id="p1"><rpid:activities><rpid:other>x</rpid:other></rpid:activities>)"
+	                      "</dm:person></presence>",
+	    // Elements out of the schema order
+	    string{kHeader} + "<note>x</note>" + tuple + "</presence>",
+	    // Invalid values
+	    string{kHeader} + R"(<tuple id="t1"><status><basic>opened</basic></status></tuple></presence>)",
+	    string{kHeader} + tuple.substr(0, tuple.size() - 8) + "<timestamp>yesterday</timestamp></tuple></presence>",
+	    // Unsupported XML features
+	    string{kHeader} + "<note><![CDATA[x]]></note></presence>",
+	    R"(<?xml version="1.0" encoding="ISO-8859-1"?><presence xmlns="urn:ietf:params:xml:ns:pidf" entity="a"/>)",
+	    // Not a PIDF document, or not well-formed
+	    R"(<presence entity="sip:user@sip.example.org"/>)",
+	    string{kHeader} + tuple,
+	    string{kHeader} + tuple + "</presence><presence/>",
+	    "",
+	};
+
+	for (const auto& document : documents) {
+		BC_ASSERT(PidfFastParser::parse(document) == nullptr);
+	}
+}
+
+TestSuite _("PidfFastParser",
+            {
+                CLASSY_TEST(sameResultAsCompleteParser),
+                CLASSY_TEST(unsupportedDocumentsAreRejected),
+            });
+
+} // namespace
+} // namespace flexisip::tester
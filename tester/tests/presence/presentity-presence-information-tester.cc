@@ -0,0 +1,92 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "presence/presentity/presentity-presence-information.hh"
+
+#include <memory>
+#include <string>
+
+#include <belle-sip/belle-sip.h>
+
+#include "presence/presentity/presentity-manager.hh"
+#include "xml/data-model.hh"
+#include "xml/pidf+xml.hh"
+
+#include "utils/bellesip-utils.hh"
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+using namespace std;
+
+namespace flexisip::tester {
+namespace {
+
+/*
+ * The pidf of a presentity is serialized once and shared by all the notifications, until the presence information
+ * changes.
+ */
+void pidfIsSerializedOnlyWhenPresenceChanges() {
+	BellesipUtils utils{"127.0.0.1", BELLE_SIP_LISTENING_POINT_RANDOM_PORT, "tcp", [](int) {}};
+	auto* stack = belle_sip_provider_get_sip_stack(utils.getProvider());
+	StatCounter64 counter{"stub-name", "stub-help", 0xdead};
+	const auto stats = make_shared<StatPair>(&counter, &counter);
+	const PresenceStats presenceStats{stats, stats, stats, stats, stats, stats};
+	PresentityManager presentityManager{stack, presenceStats, 10};
+	auto* entity = belle_sip_uri_parse("sip:user@localhost");
+	auto* mainLoop = belle_sip_stack_get_main_loop(stack);
+	const auto presentity = PresentityPresenceInformation::make(entity, presentityManager, mainLoop, presenceStats, 10);
+	belle_sip_object_unref(entity);
+
+	presentity->setDefaultElement();
+	const auto* first = &presentity->getPidf(false);
+	BC_ASSERT_TRUE(first == &presentity->getPidf(false));
+	BC_ASSERT_CPP_EQUAL(presentity->getPidfSerializationCount(), 1u);
+	// Both variants are cached separately.
+	const auto extended = presentity->getPidf(true);
+	BC_ASSERT_CPP_EQUAL(presentity->getPidf(true), extended);
+	BC_ASSERT_CPP_EQUAL(presentity->getPidfSerializationCount(), 2u);
+
+	// A change of the presentity itself
+	presentity->addCapability("groupchat/1.1");
+	BC_ASSERT_TRUE(presentity->getPidf(false).find("groupchat") != string::npos);
+	BC_ASSERT_CPP_EQUAL(presentity->getPidfSerializationCount(), 3u);
+
+	// A change of the element map
+	Xsd::Pidf::Status status{};
+	status.setBasic(Xsd::Pidf::Basic("open"));
+	Xsd::Pidf::Presence::TupleSequence tuples{};
+	tuples.push_back(Xsd::Pidf::Tuple{status, "published-tuple"});
+	Xsd::DataModel::Person person{"published-person"};
+	const auto eTag = presentity->putTuples(tuples, person, 60);
+	BC_ASSERT_TRUE(presentity->getPidf(true).find("published-tuple") != string::npos);
+	BC_ASSERT_CPP_EQUAL(presentity->getPidfSerializationCount(), 4u);
+	presentity->getPidf(true);
+	BC_ASSERT_CPP_EQUAL(presentity->getPidfSerializationCount(), 4u);
+
+	presentity->removeTuplesForEtag(eTag);
+	BC_ASSERT_TRUE(presentity->getPidf(true).find("published-tuple") == string::npos);
+	BC_ASSERT_CPP_EQUAL(presentity->getPidfSerializationCount(), 5u);
+}
+
+const TestSuite _("PresentityPresenceInformation",
+                  {
+                      CLASSY_TEST(pidfIsSerializedOnlyWhenPresenceChanges),
+                  });
+
+} // namespace
+} // namespace flexisip::tester
@@ -0,0 +1,169 @@
+/** Copyright (C) 2010-2024 Belledonne Communications SARL
+ *  SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "pushnotification/generic/generic-http-client.hh"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "flexisip/configmanager.hh"
+#include "flexisip/sofia-wrapper/su-root.hh"
+
+#include "pushnotification/rfc8599-push-params.hh"
+#include "pushnotification/service.hh"
+#include "utils/core-assert.hh"
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+using namespace std;
+using namespace std::chrono_literals;
+using boost::asio::ip::tcp;
+
+namespace flexisip::tester {
+namespace {
+using namespace pushnotification;
+
+/**
+ * Minimal HTTP/1.1 server answering every request after a delay, and keeping the connections alive.
+ */
+class KeepAliveHttpServer {
+public:
+	explicit KeepAliveHttpServer(chrono::milliseconds responseDelay) : mResponseDelay{responseDelay} {
+		acceptNext();
+		mIoThread = thread{[this] { mIoContext.run(); }};
+	}
+	~KeepAliveHttpServer() {
+		mIoContext.stop();
+		mIoThread.join();
+		// The connections end when the client closes them.
+		for (auto& connectionThread : mConnectionThreads) {
+			connectionThread.join();
+		}
+	}
+
+	int getPort() const {
+		return mAcceptor.local_endpoint().port();
+	}
+
+	atomic_int mConnectionCount{0};
+	atomic_int mRequestCount{0};
+	atomic_int mMaxConcurrentRequests{0};
+
+private:
+	void acceptNext() {
+		mAcceptor.async_accept([this](const boost::system::error_code& error, tcp::socket socket) {
+			if (error) return;
+			mConnectionCount++;
+			lock_guard<mutex> lock{mMutex};
+			mConnectionThreads.emplace_back([this, socket = std::move(socket)]() mutable { serve(socket); });
+			acceptNext();
+		});
+	}
+
+	void serve(tcp::socket& socket) {
+		boost::asio::streambuf buffer{};
+		boost::system::error_code error{};
+		while (true) {
+			const auto size = boost::asio::read_until(socket, buffer, "\r\n\r\n", error);
+			if (error) return;
+			buffer.consume(size);
+			mRequestCount++;
+			const auto concurrentRequests = ++mConcurrentRequests;
+			auto max = mMaxConcurrentRequests.load();
+			while (max < concurrentRequests && !mMaxConcurrentRequests.compare_exchange_weak(max, concurrentRequests)) {
+			}
+			this_thread::sleep_for(mResponseDelay);
+			mConcurrentRequests--;
+			boost::asio::write(socket, boost::asio::buffer("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK"s), error);
+			if (error) return;
+		}
+	}
+
+	chrono::milliseconds mResponseDelay;
+	boost::asio::io_context mIoContext{};
+	tcp::acceptor mAcceptor{mIoContext, tcp::endpoint{boost::asio::ip::address_v4::loopback(), 0}};
+	thread mIoThread{};
+	mutex mMutex{};
+	vector<thread> mConnectionThreads{};
+	atomic_int mConcurrentRequests{0};
+};
+
+// In non-blocking mode, requests are sent from the main loop over at most 'maxConcurrentRequests' keep-alive
+// connections. Requests that can't be sent right away are queued.
+void requestsAreSentConcurrentlyOverKeepAliveConnections() {
+	KeepAliveHttpServer server{100ms};
+	const auto root = make_shared<sofiasip::SuRoot>();
+	StatCounter64 sent{"sent", "", 0}, failed{"failed", "", 1};
+	StatCounter64 queueSize{"queueSize", "", 2}, queueTime{"queueTime", "", 3}, dequeued{"dequeued", "", 4};
+	Service service{root, 10};
+	service.setStatCounters(&failed, &sent);
+	service.setQueueStatCounters(&queueSize, &queueTime, &dequeued);
+	service.setupGenericClient(sofiasip::Url{"http://127.0.0.1:" + to_string(server.getPort()) + "/push/$type"},
+	                           Method::HttpGet, Protocol::Http, 2);
+
+	auto pushInfo = make_shared<PushInfo>();
+	pushInfo->addDestination(make_shared<RFC8599PushParams>("fcm", "", ""));
+	vector<shared_ptr<Request>> requests{};
+	for (auto i = 0; i < 5; ++i) {
+		requests.push_back(service.makeRequest(PushType::Background, pushInfo));
+		service.sendPush(requests.back());
+	}
+	// Two requests are in progress, the others wait for a free connection.
+	BC_ASSERT_CPP_EQUAL(queueSize.read(), 3u);
+
+	CoreAssert asserter{root};
+	asserter.iterateUpTo(0x100, [&service] { return LOOP_ASSERTION(service.isIdle()); }, 3s).assert_passed();
+
+	for (const auto& request : requests) {
+		BC_ASSERT_TRUE(request->getState() == Request::State::Successful);
+	}
+	BC_ASSERT_CPP_EQUAL(server.mConnectionCount.load(), 2);
+	BC_ASSERT_CPP_EQUAL(server.mRequestCount.load(), 5);
+	BC_ASSERT_CPP_EQUAL(server.mMaxConcurrentRequests.load(), 2);
+	BC_ASSERT_CPP_EQUAL(sent.read(), 5u);
+	BC_ASSERT_CPP_EQUAL(failed.read(), 0u);
+	BC_ASSERT_CPP_EQUAL(queueSize.read(), 0u);
+	BC_ASSERT_CPP_EQUAL(dequeued.read(), 5u);
+	// Three requests waited for at least one response delay.
+	BC_ASSERT_TRUE(300 <= queueTime.read());
+}
+
+void responseLength() {
+	auto keepAlive = true;
+	BC_ASSERT_CPP_EQUAL(AsyncHttpTransport::responseLength("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n", keepAlive), 0u);
+	BC_ASSERT_CPP_EQUAL(AsyncHttpTransport::responseLength("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nO", keepAlive),
+	                    0u);
+
+	const auto withLength = "HTTP/1.1 200 OK\r\ncontent-length:  2\r\n\r\nOKHTTP/1.1"s;
+	BC_ASSERT_CPP_EQUAL(AsyncHttpTransport::responseLength(withLength, keepAlive), withLength.size() - 8);
+	BC_ASSERT_TRUE(keepAlive);
+
+	const auto noContent = "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n"s;
+	BC_ASSERT_CPP_EQUAL(AsyncHttpTransport::responseLength(noContent, keepAlive), noContent.size());
+	BC_ASSERT_FALSE(keepAlive);
+
+	const auto chunked = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n4\r\nWiki\r\n0\r\n\r\n"s;
+	BC_ASSERT_CPP_EQUAL(AsyncHttpTransport::responseLength(chunked, keepAlive), chunked.size());
+	BC_ASSERT_CPP_EQUAL(AsyncHttpTransport::responseLength(chunked.substr(0, chunked.size() - 2), keepAlive), 0u);
+
+	BC_ASSERT_CPP_EQUAL(AsyncHttpTransport::responseLength("HTTP/1.1 200 OK\r\n\r\nUntil close", keepAlive),
+	                    string_view::npos);
+	BC_ASSERT_FALSE(keepAlive);
+}
+
+TestSuite _("pushnotification::GenericHttpClient",
+            {
+                CLASSY_TEST(requestsAreSentConcurrentlyOverKeepAliveConnections),
+                CLASSY_TEST(responseLength),
+            });
+
+} // namespace
+} // namespace flexisip::tester
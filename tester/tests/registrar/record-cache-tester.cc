@@ -0,0 +1,150 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "registrar/record-cache.hh"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flexisip/configmanager.hh"
+
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace flexisip::tester {
+
+namespace {
+
+vector<ExtendedContact> makeContacts(const string& user) {
+	vector<ExtendedContact> contacts{};
+	contacts.emplace_back(SipUri{"sip:" + user + "@192.0.2.1:5060"}, "", "message-expires");
+	return contacts;
+}
+
+void hitsAndMisses() {
+	StatCounter64 hits{"hits", "", 0}, misses{"misses", "", 1}, evictions{"evictions", "", 2};
+	RecordCache cache{10, 1min, {&hits, &misses, &evictions}};
+
+	BC_ASSERT(cache.find("alice@example.org") == nullptr);
+	cache.insert("alice@example.org", makeContacts("alice"), cache.generation());
+	const auto* cached = cache.find("alice@example.org");
+	BC_HARD_ASSERT(cached != nullptr);
+	BC_ASSERT_CPP_EQUAL(cached->size(), 1);
+	BC_ASSERT_CPP_EQUAL(SipUri{cached->front().mSipContact->m_url}.getUser(), "alice");
+
+	BC_ASSERT_CPP_EQUAL(hits.read(), 1);
+	BC_ASSERT_CPP_EQUAL(misses.read(), 1);
+	BC_ASSERT_CPP_EQUAL(evictions.read(), 0);
+}
+
+void invalidation() {
+	RecordCache cache{10, 1min};
+	cache.insert("alice@example.org", makeContacts("alice"), cache.generation());
+	cache.insert("bob@example.org", makeContacts("bob"), cache.generation());
+
+	// A fetch is sent, then the Record is modified before the reply is received: the reply must not be cached.
+	const auto generation = cache.generation();
+	cache.invalidate("alice@example.org");
+	BC_ASSERT(cache.find("alice@example.org") == nullptr);
+	BC_ASSERT(cache.find("bob@example.org") != nullptr);
+	cache.insert("alice@example.org", makeContacts("alice"), generation);
+	BC_ASSERT(cache.find("alice@example.org") == nullptr);
+
+	// The modification of another Record does not prevent the reply from being cached.
+	const auto carolGeneration = cache.generation();
+	cache.invalidate("bob@example.org");
+	cache.insert("carol@example.org", makeContacts("carol"), carolGeneration);
+	BC_ASSERT(cache.find("carol@example.org") != nullptr);
+
+	const auto clearGeneration = cache.generation();
+	cache.clear();
+	BC_ASSERT_CPP_EQUAL(cache.size(), 0);
+	cache.insert("carol@example.org", makeContacts("carol"), clearGeneration);
+	BC_ASSERT(cache.find("carol@example.org") == nullptr);
+}
+
+// Only the last invalidated keys are remembered, fetches sent before a forgotten invalidation are not cached.
+void forgottenInvalidations() {
+	RecordCache cache{2, 1min};
+	const auto generation = cache.generation();
+	cache.invalidate("alice@example.org");
+	const auto bobGeneration = cache.generation();
+	cache.invalidate("bob@example.org");
+	cache.invalidate("carol@example.org");
+
+	cache.insert("dave@example.org", makeContacts("dave"), generation);
+	BC_ASSERT(cache.find("dave@example.org") == nullptr);
+	cache.insert("dave@example.org", makeContacts("dave"), bobGeneration);
+	BC_ASSERT(cache.find("dave@example.org") != nullptr);
+	cache.insert("bob@example.org", makeContacts("bob"), bobGeneration);
+	BC_ASSERT(cache.find("bob@example.org") == nullptr);
+}
+
+void leastRecentlyUsedEviction() {
+	StatCounter64 evictions{"evictions", "", 0};
+	RecordCache cache{2, 1min, {nullptr, nullptr, &evictions}};
+	cache.insert("alice@example.org", makeContacts("alice"), cache.generation());
+	cache.insert("bob@example.org", makeContacts("bob"), cache.generation());
+	// Use alice, so that bob is the least recently used.
+	BC_ASSERT(cache.find("alice@example.org") != nullptr);
+
+	cache.insert("carol@example.org", makeContacts("carol"), cache.generation());
+
+	BC_ASSERT_CPP_EQUAL(cache.size(), 2);
+	BC_ASSERT(cache.find("bob@example.org") == nullptr);
+	BC_ASSERT(cache.find("alice@example.org") != nullptr);
+	BC_ASSERT(cache.find("carol@example.org") != nullptr);
+	BC_ASSERT_CPP_EQUAL(evictions.read(), 1);
+}
+
+void expiration() {
+	StatCounter64 evictions{"evictions", "", 0};
+	RecordCache cache{10, 10ms, {nullptr, nullptr, &evictions}};
+	cache.insert("alice@example.org", makeContacts("alice"), cache.generation());
+	BC_ASSERT(cache.find("alice@example.org") != nullptr);
+
+	this_thread::sleep_for(20ms);
+
+	BC_ASSERT(cache.find("alice@example.org") == nullptr);
+	BC_ASSERT_CPP_EQUAL(cache.size(), 0);
+	BC_ASSERT_CPP_EQUAL(evictions.read(), 1);
+}
+
+void disabled() {
+	RecordCache cache{0, 1min};
+	cache.insert("alice@example.org", makeContacts("alice"), cache.generation());
+	BC_ASSERT(cache.find("alice@example.org") == nullptr);
+}
+
+TestSuite _("RecordCache",
+            {
+                CLASSY_TEST(hitsAndMisses),
+                CLASSY_TEST(invalidation),
+                CLASSY_TEST(forgottenInvalidations),
+                CLASSY_TEST(leastRecentlyUsedEviction),
+                CLASSY_TEST(expiration),
+                CLASSY_TEST(disabled),
+            });
+
+} // namespace
+} // namespace flexisip::tester
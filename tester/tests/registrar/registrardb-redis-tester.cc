@@ -19,6 +19,7 @@
 #include <chrono>
 #include <memory>
 #include <optional>
+#include <set>
 
 #include <sys/resource.h>
 
@@ -34,6 +35,7 @@
 #include "registrar/registrar-db.hh"
 #include "registrardb-redis.hh"
 #include "utils/asserts.hh"
+#include "utils/contact-inserter.hh"
 #include "utils/core-assert.hh"
 #include "utils/override-static.hh"
 #include "utils/redis-sync-access.hh"
@@ -445,9 +447,228 @@ void connection_failure() {
 	BC_ASSERT_TRUE(asserter.iterateUpTo(1, [&finished = listener->finished] { return finished; }));
 }
 
+std::shared_ptr<Record> fetchRecord(RegistrarDb& registrar, CoreAssert<>& asserter, const SipUri& aor) {
+	const auto listener = std::make_shared<SuccessfulBindListener>();
+	registrar.fetch(aor, listener);
+	asserter.iterateUpTo(10, [&listener] { return LOOP_ASSERTION(listener->mRecord != nullptr); }).assert_passed();
+	BC_HARD_ASSERT(listener->mRecord != nullptr);
+	return listener->mRecord;
+}
+
+/**
+ * With the Record cache enabled, a second fetch of the same AoR is answered without querying Redis. The cached Record
+ * is dropped when it is modified, either through this server or directly in Redis (keyspace notifications enabled).
+ */
+void record_cache() {
+	RedisServer redis{};
+	Server proxyServer{{
+	    {"module::Registrar/db-implementation", "redis"},
+	    {"module::Registrar/redis-server-domain", "localhost"},
+	    {"module::Registrar/redis-server-port", std::to_string(redis.port())},
+	    {"module::Registrar/redis-record-cache-size", "10"},
+	    {"module::Registrar/redis-record-cache-ttl", "60000"},
+	}};
+	proxyServer.start();
+	CoreAssert asserter{proxyServer};
+	auto& registrar = proxyServer.getAgent()->getRegistrarDb();
+	const auto* registrarConf =
+	    proxyServer.getAgent()->getConfigManager().getRoot()->get<GenericStruct>("module::Registrar");
+	const auto* hits = registrarConf->getStat("count-record-cache-hits");
+	const auto* misses = registrarConf->getStat("count-record-cache-misses");
+	asserter.iterateUpTo(10, [&registrar] { return LOOP_ASSERTION(registrar.isWritable()); }).assert_passed();
+	RedisSyncContext ctx = redisConnect("localhost", redis.port());
+	{
+		const auto reply = ctx.command("CONFIG SET notify-keyspace-events Eghx");
+		BC_ASSERT_CPP_EQUAL(reply->type, REDIS_REPLY_STATUS);
+	}
+	const auto aor = "sip:cached@example.org";
+	ContactInserter inserter{registrar};
+	inserter.setAor(aor).setExpire(1min).insert({"sip:cached@192.0.2.1"});
+	asserter.iterateUpTo(10, [&inserter] { return LOOP_ASSERTION(inserter.finished()); }).assert_passed();
+	const auto fetchContactCount = [&registrar, &asserter, &aor] {
+		return fetchRecord(registrar, asserter, SipUri(aor))->count();
+	};
+
+	BC_ASSERT_CPP_EQUAL(fetchContactCount(), 1);
+	BC_ASSERT_CPP_EQUAL(misses->read(), 1);
+	BC_ASSERT_CPP_EQUAL(fetchContactCount(), 1);
+	BC_ASSERT_CPP_EQUAL(hits->read(), 1);
+
+	// Modified through this server
+	inserter.insert({"sip:cached@192.0.2.2"});
+	asserter.iterateUpTo(10, [&inserter] { return LOOP_ASSERTION(inserter.finished()); }).assert_passed();
+	BC_ASSERT_CPP_EQUAL(fetchContactCount(), 2);
+	// The metadata of the server-side bind is not written when it is disabled.
+	{
+		const auto metadataKey = "fs-meta:" + Record::Key(SipUri(aor), registrar.useGlobalDomain()).asString();
+		const auto reply = ctx.command("EXISTS %s", metadataKey.c_str());
+		BC_ASSERT_CPP_EQUAL(reply->integer, 0);
+	}
+	BC_ASSERT_CPP_EQUAL(misses->read(), 2);
+	BC_ASSERT_CPP_EQUAL(fetchContactCount(), 2);
+
+	// Modified by someone else
+	ctx.command("DEL %s", Record::Key(SipUri(aor), registrar.useGlobalDomain()).toRedisKey().c_str());
+	asserter.iterateUpTo(10, [&fetchContactCount] { return LOOP_ASSERTION(fetchContactCount() == 0); }, 100ms)
+	    .assert_passed();
+}
+
+/**
+ * Contacts identified by a unique id are bound server-side. Records holding contacts without metadata (i.e. written by
+ * a previous version) and contacts without unique id go through the regular bind, which also writes the metadata.
+ */
+void server_side_bind() {
+	RedisServer redis{};
+	Server proxyServer{{
+	    {"module::Registrar/db-implementation", "redis"},
+	    {"module::Registrar/redis-server-domain", "localhost"},
+	    {"module::Registrar/redis-server-port", std::to_string(redis.port())},
+	    {"module::Registrar/redis-server-side-bind", "true"},
+	}};
+	proxyServer.start();
+	CoreAssert asserter{proxyServer};
+	auto& registrar = proxyServer.getAgent()->getRegistrarDb();
+	asserter.iterateUpTo(10, [&registrar] { return LOOP_ASSERTION(registrar.isWritable()); }).assert_passed();
+	RedisSyncContext ctx = redisConnect("localhost", redis.port());
+	const SipUri aor{"sip:server-side@example.org"};
+	const auto metadataKey = "fs-meta:" + Record::Key(aor, registrar.useGlobalDomain()).asString();
+	const auto metadataCount = [&ctx, &metadataKey] {
+		const auto reply = ctx.command("HLEN %s", metadataKey.c_str());
+		return reply->type == REDIS_REPLY_INTEGER ? reply->integer : -1;
+	};
+	ContactInserter inserter{registrar, std::make_shared<AcceptUpdatesListener>()};
+	inserter.setAor(aor).setExpire(1min).withUniqueId(true);
+
+	inserter.insert({"sip:server-side@192.0.2.1", "device-a"});
+	asserter.iterateUpTo(10, [&inserter] { return LOOP_ASSERTION(inserter.finished()); }).assert_passed();
+	BC_ASSERT_CPP_EQUAL(fetchRecord(registrar, asserter, aor)->count(), 1);
+	BC_ASSERT_CPP_EQUAL(metadataCount(), 1);
+
+	// Same unique id: the contact is updated
+	inserter.insert({"sip:server-side@192.0.2.2", "device-a"});
+	asserter.iterateUpTo(10, [&inserter] { return LOOP_ASSERTION(inserter.finished()); }).assert_passed();
+	{
+		const auto record = fetchRecord(registrar, asserter, aor);
+		BC_HARD_ASSERT_CPP_EQUAL(record->count(), 1);
+		BC_ASSERT_CPP_EQUAL((*record->getExtendedContacts().begin())->urlAsString(), "sip:server-side@192.0.2.2");
+	}
+
+	// Record written without metadata
+	ctx.command("DEL %s", metadataKey.c_str());
+	inserter.insert({"sip:server-side@192.0.2.3", "device-b"});
+	asserter.iterateUpTo(10, [&inserter] { return LOOP_ASSERTION(inserter.finished()); }).assert_passed();
+	BC_ASSERT_CPP_EQUAL(fetchRecord(registrar, asserter, aor)->count(), 2);
+	BC_ASSERT_CPP_EQUAL(metadataCount(), 2);
+
+	// Contact without unique id
+	inserter.withUniqueId(false).insert({"sip:server-side@192.0.2.4"});
+	asserter.iterateUpTo(10, [&inserter] { return LOOP_ASSERTION(inserter.finished()); }).assert_passed();
+	BC_ASSERT_CPP_EQUAL(fetchRecord(registrar, asserter, aor)->count(), 3);
+	BC_ASSERT_CPP_EQUAL(metadataCount(), 3);
+
+	// Unregistration
+	inserter.setExpire(0s).withUniqueId(true).insert({"sip:server-side@192.0.2.2", "device-a"});
+	asserter
+	    .iterateUpTo(
+	        10, [&] { return LOOP_ASSERTION(fetchRecord(registrar, asserter, aor)->count() == 2); }, 100ms)
+	    .assert_passed();
+	BC_ASSERT_CPP_EQUAL(metadataCount(), 2);
+}
+
+/**
+ * Contacts with push parameters are indexed by expiration time. fetchExpiringContacts() only reads the part of the
+ * index where contacts may have passed the threshold of their lifetime, one page at a time, and the contacts of the
+ * Records written before the index existed are added to it on connection.
+ */
+void expiring_contacts_index() {
+	constexpr auto index = "fs-index:push-contacts-by-expiry";
+	constexpr auto lifetimes = "fs-index:push-contact-lifetimes";
+	constexpr auto backfilled = "fs-index:push-contacts-by-expiry:backfilled";
+	RedisServer redis{};
+	Server proxyServer{{
+	    {"module::Registrar/db-implementation", "redis"},
+	    {"module::Registrar/redis-server-domain", "localhost"},
+	    {"module::Registrar/redis-server-port", std::to_string(redis.port())},
+	}};
+	proxyServer.start();
+	CoreAssert asserter{proxyServer};
+	auto& registrar = proxyServer.getAgent()->getRegistrarDb();
+	asserter.iterateUpTo(10, [&registrar] { return LOOP_ASSERTION(registrar.isWritable()); }).assert_passed();
+	RedisSyncContext ctx = redisConnect("localhost", redis.port());
+	const auto fetchExpiringContacts = [&registrar, &asserter](time_t startTimestamp) {
+		std::optional<std::vector<ExtendedContact>> contacts{};
+		registrar.fetchExpiringContacts(startTimestamp, 0.5,
+		                                [&contacts](auto&& fetched) { contacts = std::move(fetched); });
+		asserter.iterateUpTo(50, [&contacts] { return LOOP_ASSERTION(contacts.has_value()); }).assert_passed();
+		std::multiset<std::string> urls{};
+		if (!contacts) return urls;
+		for (const auto& contact : *contacts) {
+			urls.emplace(contact.urlAsString());
+		}
+		return urls;
+	};
+	const auto isIndexed = [&ctx](const std::string& set, const std::string& member) {
+		return ctx.command("ZSCORE %s %s", set.c_str(), member.c_str())->type != REDIS_REPLY_NIL;
+	};
+
+	const auto now = getCurrentTime();
+	const std::string shortUrl{"sip:short@192.0.2.1;pn-provider=fake"};
+	const std::string longUrl{"sip:long@192.0.2.1;pn-provider=fake"};
+	ContactInserter inserter{registrar};
+	inserter.withUniqueId(true);
+	inserter.setAor("sip:short@example.org").setExpire(1min).insert({shortUrl});
+	inserter.setAor("sip:long@example.org").setExpire(1h).insert({longUrl});
+	inserter.setAor("sip:no-push@example.org").setExpire(1min).insert({"sip:no-push@192.0.2.1"});
+	asserter.iterateUpTo(10, [&inserter] { return LOOP_ASSERTION(inserter.finished()); }).assert_passed();
+
+	BC_ASSERT(fetchExpiringContacts(now + 10).empty());
+	BC_ASSERT(fetchExpiringContacts(now + 40) == std::multiset<std::string>{shortUrl});
+	BC_ASSERT(fetchExpiringContacts(now + 1900) == std::multiset<std::string>{longUrl});
+
+	// Lifetimes of contacts that have all expired no longer widen the range to read
+	ctx.command("ZADD %s %lld 86400", lifetimes, static_cast<long long>(now - 1));
+	fetchExpiringContacts(now + 40);
+	BC_ASSERT(!isIndexed(lifetimes, "86400"));
+
+	// More contacts expiring at the same time than a page holds, and an index member whose contact is gone
+	const auto longKey = Record::Key(SipUri("sip:long@example.org"), registrar.useGlobalDomain()).toRedisKey();
+	const auto longRecord = ctx.command("HGETALL %s", longKey.c_str());
+	BC_HARD_ASSERT_CPP_EQUAL(longRecord->elements, 2);
+	const std::string uid = longRecord->element[0]->str;
+	const std::string serializedContact = longRecord->element[1]->str;
+	const std::string expireTime = ctx.command("ZSCORE %s %s", index, (longKey + '\n' + uid).c_str())->str;
+	constexpr auto copyCount = 1200;
+	for (auto i = 0; i < copyCount; ++i) {
+		const auto key = "fs:copy-" + std::to_string(i) + "@example.org";
+		ctx.command("HSET %s %s %s", key.c_str(), uid.c_str(), serializedContact.c_str());
+		ctx.command("ZADD %s %s %s", index, expireTime.c_str(), (key + '\n' + uid).c_str());
+	}
+	const std::string goneMember{"fs:gone@example.org\ngone-uid"};
+	ctx.command("ZADD %s %s %s", index, expireTime.c_str(), goneMember.c_str());
+	BC_ASSERT_CPP_EQUAL(fetchExpiringContacts(now + 1900).count(longUrl), copyCount + 1);
+	BC_ASSERT(!isIndexed(index, goneMember));
+
+	// Records written before the index existed
+	ctx.command("DEL %s %s %s", index, lifetimes, backfilled);
+	BC_ASSERT(fetchExpiringContacts(now + 40).empty());
+	const auto* backend = dynamic_cast<const RegistrarDbRedisAsync*>(&registrar.getRegistrarBackend());
+	BC_HARD_ASSERT(backend != nullptr);
+	RegistrarDbRedisAsync::forceDisconnectForTest(const_cast<RegistrarDbRedisAsync&>(*backend));
+	registrar.fetch(SipUri("sip:short@example.org"), nullptr);
+	asserter
+	    .iterateUpTo(
+	        20, [&ctx] { return LOOP_ASSERTION(ctx.command("EXISTS %s", backfilled)->integer == 1); }, 100ms)
+	    .assert_passed();
+	BC_ASSERT(fetchExpiringContacts(now + 40) == std::multiset<std::string>{shortUrl});
+	BC_ASSERT_CPP_EQUAL(fetchExpiringContacts(now + 1900).count(longUrl), copyCount + 1);
+}
+
 TestSuite edgeCases("RegistrarDbRedis-EdgeCases",
                     {
                         CLASSY_TEST(connection_failure),
+                        CLASSY_TEST(record_cache),
+                        CLASSY_TEST(server_side_bind),
+                        CLASSY_TEST(expiring_contacts_index),
                     });
 } // namespace
 } // namespace flexisip::tester::registrardb_redis
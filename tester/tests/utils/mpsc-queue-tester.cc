@@ -0,0 +1,88 @@
+/*
+    Flexisip, a flexible SIP proxy server with media capabilities.
+    Copyright (C) 2010-2024 Belledonne Communications SARL, All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <thread>
+#include <vector>
+
+#include "utils/thread/mpsc-queue.hh"
+
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+
+namespace flexisip::tester {
+
+using namespace std;
+
+void popFromEmptyQueue() {
+	MpscQueue<int> queue{};
+	int value = 0;
+
+	BC_ASSERT_FALSE(queue.pop(value));
+	queue.push(42);
+	BC_ASSERT_TRUE(queue.pop(value));
+	BC_ASSERT_CPP_EQUAL(value, 42);
+	BC_ASSERT_FALSE(queue.pop(value));
+}
+
+/**
+ * Several threads push concurrently, check that every element is popped once, and in order for each producer.
+ */
+void concurrentProducers() {
+	constexpr int producerCount = 4;
+	constexpr int elementsPerProducer = 10000;
+	MpscQueue<pair<int, int>> queue{};
+
+	vector<thread> producers{};
+	for (int producer = 0; producer < producerCount; ++producer) {
+		producers.emplace_back([&queue, producer] {
+			for (int i = 0; i < elementsPerProducer; ++i) {
+				queue.push({producer, i});
+			}
+		});
+	}
+
+	vector<int> lastPopped(producerCount, -1);
+	int popped = 0;
+	bool inOrder = true;
+	while (popped < producerCount * elementsPerProducer) {
+		pair<int, int> element{};
+		if (!queue.pop(element)) {
+			this_thread::yield();
+			continue;
+		}
+		inOrder = inOrder && element.second == lastPopped[element.first] + 1;
+		lastPopped[element.first] = element.second;
+		popped++;
+	}
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	BC_ASSERT_TRUE(inOrder);
+	pair<int, int> element{};
+	BC_ASSERT_FALSE(queue.pop(element));
+}
+
+namespace {
+TestSuite _("MpscQueue",
+            {
+                CLASSY_TEST(popFromEmptyQueue),
+                CLASSY_TEST(concurrentProducers),
+            });
+} // namespace
+} // namespace flexisip::tester
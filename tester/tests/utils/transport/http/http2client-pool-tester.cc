@@ -0,0 +1,114 @@
+/** Copyright (C) 2010-2024 Belledonne Communications SARL
+ *  SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utils/transport/http/http2client-pool.hh"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "flexisip/sofia-wrapper/su-root.hh"
+
+#include "utils/core-assert.hh"
+#include "utils/http-mock/http-mock.hh"
+#include "utils/test-patterns/test.hh"
+#include "utils/test-suite.hh"
+#include "utils/transport/http/http-headers.hh"
+
+using namespace std::string_literals;
+using namespace std::chrono_literals;
+
+namespace flexisip::tester {
+using namespace http_mock;
+
+namespace {
+
+// Requests go over the least loaded connection, and new connections are only opened when all the existing ones are
+// close to the limit of concurrent streams of the server, up to the maximum.
+void requestsAreSpreadOverConnections() {
+	sofiasip::SuRoot root{};
+	HttpMock httpMock{{"/"}};
+	const auto portInt = httpMock.serveAsync();
+	BC_HARD_ASSERT_TRUE(portInt > -1);
+	const auto port = std::to_string(portInt);
+	Http2ClientPool pool{root, [&root, port] { return Http2Client::make(root, "127.0.0.1", port); }, 2};
+	const auto request = std::make_shared<Http2Client::HttpRequest>(
+	    HttpHeaders{
+	        {":method"s, "POST"s},
+	        {":scheme", "https"},
+	        {":authority", "127.0.0.1:" + port},
+	        {":path", "/"},
+	    },
+	    "Pooled request");
+	auto responseCount = 0;
+	const auto onResponse = [&responseCount](const auto&, const auto&) { responseCount++; };
+	const auto onError = [](const auto&) { BC_FAIL("Unexpected error"); };
+	CoreAssert asserter{root};
+
+	pool.send(request, onResponse, onError);
+	asserter.iterateUpTo(0x20, [&responseCount] { return LOOP_ASSERTION(responseCount == 1); }, 2s).assert_passed();
+	BC_HARD_ASSERT_CPP_EQUAL(pool.getClients().size(), 1u);
+	const auto first = pool.getClients()[0];
+	const auto maxConcurrentStreams = first->getMaxConcurrentStreams();
+	BC_HARD_ASSERT_TRUE(maxConcurrentStreams.has_value());
+	const auto streamLimit = static_cast<int>(*maxConcurrentStreams);
+
+	// A few requests in progress are not enough to open a new connection.
+	pool.send(request, onResponse, onError);
+	pool.send(request, onResponse, onError);
+	BC_ASSERT_CPP_EQUAL(first->getActiveStreamCount(), 2u);
+	BC_ASSERT_CPP_EQUAL(pool.getClients().size(), 1u);
+	asserter.iterateUpTo(0x20, [&responseCount] { return LOOP_ASSERTION(responseCount == 3); }, 2s).assert_passed();
+
+	// Nearly saturated connection: a second one is opened in the background, requests are still sent over the first
+	// one until it is connected.
+	for (auto i = 0; i < streamLimit / 2; ++i) {
+		pool.send(request, onResponse, onError);
+	}
+	BC_ASSERT_CPP_EQUAL(pool.getClients().size(), 1u);
+	for (auto i = streamLimit / 2; i < streamLimit; ++i) {
+		pool.send(request, onResponse, onError);
+	}
+	BC_HARD_ASSERT_CPP_EQUAL(pool.getClients().size(), 2u);
+	const auto second = pool.getClients()[1];
+	BC_ASSERT_TRUE(second->isIdle());
+	asserter
+	    .iterateUpTo(
+	        0x20,
+	        [&responseCount, &second, streamLimit] {
+		        FAIL_IF(responseCount != 3 + streamLimit);
+		        return LOOP_ASSERTION(second->getState() == Http2Client::State::Connected);
+	        },
+	        2s)
+	    .assert_passed();
+
+	pool.send(request, onResponse, onError);
+	pool.send(request, onResponse, onError);
+	BC_ASSERT_CPP_EQUAL(first->getActiveStreamCount(), 1u);
+	BC_ASSERT_CPP_EQUAL(second->getActiveStreamCount(), 1u);
+	BC_ASSERT_CPP_EQUAL(pool.getClients().size(), 2u);
+	asserter
+	    .iterateUpTo(
+	        0x20, [&responseCount, streamLimit] { return LOOP_ASSERTION(responseCount == 5 + streamLimit); }, 2s)
+	    .assert_passed();
+
+	const auto stats = pool.getStats();
+	BC_HARD_ASSERT_CPP_EQUAL(stats.size(), 2u);
+	BC_ASSERT_CPP_EQUAL(stats[0].latency.responseCount, 4u + streamLimit);
+	BC_ASSERT_CPP_EQUAL(stats[1].latency.responseCount, 1u);
+	for (const auto& connectionStats : stats) {
+		BC_ASSERT_CPP_EQUAL(connectionStats.activeStreams, 0u);
+		BC_ASSERT_TRUE(connectionStats.maxConcurrentStreams.has_value());
+		BC_ASSERT_TRUE(0us < connectionStats.latency.averageLatency);
+		BC_ASSERT_TRUE(connectionStats.latency.averageLatency <= connectionStats.latency.maxLatency);
+	}
+}
+
+TestSuite _("Http2ClientPool",
+            {
+                CLASSY_TEST(requestsAreSpreadOverConnections),
+            });
+
+} // namespace
+} // namespace flexisip::tester